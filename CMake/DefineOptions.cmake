@@ -34,6 +34,11 @@ option(
 option(WITH_LOGGING_TIMING_DATA
        "Build with logging all Add and Erase Segment calls." OFF)
 
+# Turn this option on to store each NoteData track in a sorted vector instead
+# of a map.
+option(WITH_FLAT_NOTEDATA
+       "Build with NoteData tracks stored in sorted vectors." OFF)
+
 if(NOT MSVC)
   # Change this number to utilize a different number of jobs for building
   # FFMPEG.
@@ -11,4 +11,9 @@ return Def.ActorFrame {
 		Font="Common Normal",
 		InitCommand=cmd(x,SCREEN_CENTER_X-250;y,SCREEN_CENTER_Y;zoom,1;halign,0;vertspacing,8);
 	};
+
+	Def.InputLatencyList {
+		Font="Common Normal",
+		InitCommand=cmd(x,SCREEN_RIGHT-20;y,SCREEN_TOP+80;zoom,0.6;halign,1;valign,0),
+	};
 };
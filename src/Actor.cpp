@@ -13,6 +13,7 @@
 #include "LightsManager.h" // for NUM_CabinetLight
 #include "ActorUtil.h"
 #include "Preference.h"
+#include "RageProfiler.h"
 #include <typeinfo>
 
 static Preference<bool> g_bShowMasks("ShowMasks", false);
@@ -381,6 +382,7 @@ void Actor::Draw()
 	{
 		return; // early abort
 	}
+	PROFILE_SCOPE_TYPE( ProfileZone_ActorDraw, *this );
 	if(m_FakeParent)
 	{
 		if(!m_FakeParent->m_bVisible || m_FakeParent->m_fHibernateSecondsLeft > 0
@@ -871,6 +873,7 @@ void Actor::Update( float fDeltaTime )
 {
 //	LOG->Trace( "Actor::Update( %f )", fDeltaTime );
 	ASSERT_M( fDeltaTime >= 0, ssprintf("DeltaTime: %f",fDeltaTime) );
+	PROFILE_SCOPE_TYPE( ProfileZone_ActorUpdate, *this );
 
 	if( m_fHibernateSecondsLeft > 0 )
 	{
@@ -0,0 +1,468 @@
+#include "global.h"
+#include "AudioAnalysisCache.h"
+#include "Preference.h"
+#include "RageFile.h"
+#include "RageLog.h"
+#include "RageSoundReader_FileReader.h"
+#include "RageUtil.h"
+#include "Song.h"
+#include "SongCacheIndex.h"
+
+#include <cstring>
+
+AudioAnalysisCache *AUDIOANALYSIS = nullptr;	// global and accessible from anywhere in our program
+
+static Preference<bool> g_bAnalyzeMusicInBackground( "AnalyzeMusicInBackground", true );
+
+/* Layout of an analysis file:
+ *
+ *   "SMAA" <uint32 ANALYSIS_VERSION> <uint32 source hash> <float loudness>
+ *   <uint32 blocks> <blocks bytes of peaks> <blocks bytes of RMS> <blocks bytes of onsets>
+ *
+ * Numbers are in native byte order, like the song cache. */
+static const char ANALYSIS_MAGIC[4] = { 'S', 'M', 'A', 'A' };
+/** @brief Bump this when the layout or the analysis changes. */
+static const uint32_t ANALYSIS_VERSION = 1;
+
+/* Levels are kept from -60dB to 0dB; 0 means quieter than that. */
+static const float LEVEL_RANGE_DB = 60.0f;
+
+static uint8_t LevelToByte( float fLevel )
+{
+	if( fLevel <= 0 )
+		return 0;
+	float fDB = 20 * log10f( fLevel );
+	return (uint8_t) clamp( (int) lrintf((fDB + LEVEL_RANGE_DB) * 255 / LEVEL_RANGE_DB), 0, 255 );
+}
+
+static float ByteToLevel( uint8_t iByte )
+{
+	if( iByte == 0 )
+		return 0;
+	return powf( 10, (iByte * LEVEL_RANGE_DB / 255 - LEVEL_RANGE_DB) / 20 );
+}
+
+static float EnergyToDB( double fEnergy )
+{
+	return fEnergy > 0? float(10 * log10(fEnergy)):-1000.0f;
+}
+
+bool AudioAnalysis::Analyze( const RString &sPath, RString &sError )
+{
+	m_Peak.clear();
+	m_RMS.clear();
+	m_Onset.clear();
+	m_fLoudness = -70;
+	m_iSourceHash = GetHashForFile( sPath );
+
+	RageSoundReader *pReader = RageSoundReader_FileReader::OpenFile( sPath, sError );
+	if( pReader == nullptr )
+		return false;
+
+	const int iRate = pReader->GetSampleRate();
+	const int iChannels = pReader->GetNumChannels();
+
+	/* Mean square of each block, and of its first difference, which is
+	 * mostly the high frequencies, where drums and other onsets stand out. */
+	vector<float> aEnergy, aHighEnergy;
+
+	float fPeak = 0;
+	double fSumSquares = 0, fHighSumSquares = 0;
+	float fLastMono = 0;
+	int iBlockFrames = 0;
+	int64_t iFrame = 0;
+	int64_t iBlockEnd = iRate / BLOCKS_PER_SECOND;
+
+	auto FinishBlock = [&]()
+	{
+		double fEnergy = fSumSquares / (iBlockFrames * iChannels);
+		m_Peak.push_back( LevelToByte(fPeak) );
+		m_RMS.push_back( LevelToByte(float(sqrt(fEnergy))) );
+		aEnergy.push_back( float(fEnergy) );
+		aHighEnergy.push_back( float(fHighSumSquares / iBlockFrames) );
+
+		fPeak = 0;
+		fSumSquares = fHighSumSquares = 0;
+		iBlockFrames = 0;
+		// Round block boundaries, so blocks don't drift at rates like 22050.
+		iBlockEnd = (int64_t(m_Peak.size()) + 1) * iRate / BLOCKS_PER_SECOND;
+	};
+
+	vector<float> aBuf( 4096 * iChannels );
+	for(;;)
+	{
+		int iGot = pReader->RetriedRead( &aBuf[0], 4096 );
+		if( iGot == RageSoundReader::END_OF_FILE )
+			break;
+		if( iGot < 0 )
+		{
+			sError = pReader->GetError();
+			delete pReader;
+			return false;
+		}
+
+		const float *p = &aBuf[0];
+		for( int i = 0; i < iGot; ++i )
+		{
+			float fMono = 0;
+			for( int c = 0; c < iChannels; ++c, ++p )
+			{
+				fPeak = max( fPeak, fabsf(*p) );
+				fSumSquares += *p * *p;
+				fMono += *p;
+			}
+			fMono /= iChannels;
+			float fHigh = fMono - fLastMono;
+			fLastMono = fMono;
+			fHighSumSquares += fHigh * fHigh;
+
+			++iBlockFrames;
+			if( ++iFrame == iBlockEnd )
+				FinishBlock();
+		}
+	}
+	if( iBlockFrames != 0 )
+		FinishBlock();
+	delete pReader;
+
+	/* Onset strength: the rise in high frequency energy from the last block,
+	 * in dB, ignoring anything too quiet to hear. */
+	vector<float> aOnsets( aHighEnergy.size(), 0.0f );
+	float fMaxOnset = 0;
+	for( size_t i = 1; i < aHighEnergy.size(); ++i )
+	{
+		if( aHighEnergy[i] < 1e-7f )
+			continue;
+		float fRise = EnergyToDB( aHighEnergy[i] ) - EnergyToDB( max(aHighEnergy[i-1], 1e-7f) );
+		aOnsets[i] = max( fRise, 0.0f );
+		fMaxOnset = max( fMaxOnset, aOnsets[i] );
+	}
+	m_Onset.resize( aOnsets.size() );
+	for( size_t i = 0; i < aOnsets.size(); ++i )
+		m_Onset[i] = (uint8_t) (fMaxOnset > 0? lrintf(aOnsets[i] / fMaxOnset * 255):0);
+
+	/* Loudness, gated like BS.1770: 400ms windows every 100ms, dropping
+	 * windows under -70dB, then windows 10dB under the average of the rest. */
+	const int WINDOW_BLOCKS = BLOCKS_PER_SECOND * 4 / 10;
+	const int STEP_BLOCKS = BLOCKS_PER_SECOND / 10;
+	vector<double> aWindows;
+	for( size_t i = 0; i + WINDOW_BLOCKS <= aEnergy.size(); i += STEP_BLOCKS )
+	{
+		double fTotal = 0;
+		for( int j = 0; j < WINDOW_BLOCKS; ++j )
+			fTotal += aEnergy[i+j];
+		fTotal /= WINDOW_BLOCKS;
+		if( EnergyToDB(fTotal) > -70 )
+			aWindows.push_back( fTotal );
+	}
+	if( !aWindows.empty() )
+	{
+		double fTotal = 0;
+		for (double f : aWindows)
+			fTotal += f;
+		const float fGate = EnergyToDB( fTotal / aWindows.size() ) - 10;
+
+		fTotal = 0;
+		int iCount = 0;
+		for (double f : aWindows)
+		{
+			if( EnergyToDB(f) <= fGate )
+				continue;
+			fTotal += f;
+			++iCount;
+		}
+		if( iCount != 0 )
+			m_fLoudness = EnergyToDB( fTotal / iCount );
+	}
+
+	return true;
+}
+
+bool AudioAnalysis::ReadFromFile( const RString &sPath )
+{
+	RageFile f;
+	if( !f.Open(sPath) )
+		return false;
+
+	RString sData;
+	if( f.Read(sData, f.GetFileSize()) != f.GetFileSize() )
+		return false;
+
+	const size_t iHeaderSize = sizeof(ANALYSIS_MAGIC) + 4*sizeof(uint32_t);
+	if( sData.size() < iHeaderSize || memcmp(sData.data(), ANALYSIS_MAGIC, sizeof(ANALYSIS_MAGIC)) )
+		return false;
+
+	const char *p = sData.data() + sizeof(ANALYSIS_MAGIC);
+	uint32_t iVersion, iBlocks;
+	memcpy( &iVersion, p, sizeof(iVersion) ); p += sizeof(iVersion);
+	memcpy( &m_iSourceHash, p, sizeof(m_iSourceHash) ); p += sizeof(m_iSourceHash);
+	memcpy( &m_fLoudness, p, sizeof(m_fLoudness) ); p += sizeof(m_fLoudness);
+	memcpy( &iBlocks, p, sizeof(iBlocks) ); p += sizeof(iBlocks);
+	if( iVersion != ANALYSIS_VERSION || sData.size() != iHeaderSize + size_t(iBlocks) * 3 )
+		return false;
+
+	m_Peak.assign( p, p + iBlocks ); p += iBlocks;
+	m_RMS.assign( p, p + iBlocks ); p += iBlocks;
+	m_Onset.assign( p, p + iBlocks );
+	return true;
+}
+
+bool AudioAnalysis::WriteToFile( const RString &sPath ) const
+{
+	const uint32_t iBlocks = m_Peak.size();
+	RString sData( ANALYSIS_MAGIC, sizeof(ANALYSIS_MAGIC) );
+	sData.append( (const char *) &ANALYSIS_VERSION, sizeof(ANALYSIS_VERSION) );
+	sData.append( (const char *) &m_iSourceHash, sizeof(m_iSourceHash) );
+	sData.append( (const char *) &m_fLoudness, sizeof(m_fLoudness) );
+	sData.append( (const char *) &iBlocks, sizeof(iBlocks) );
+	sData.append( m_Peak.begin(), m_Peak.end() );
+	sData.append( m_RMS.begin(), m_RMS.end() );
+	sData.append( m_Onset.begin(), m_Onset.end() );
+
+	RageFile f;
+	if( !f.Open(sPath, RageFile::WRITE) )
+	{
+		LOG->Warn( "Couldn't open %s for writing: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+	if( f.Write(sData) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Error writing %s: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+	return true;
+}
+
+float AudioAnalysis::GetPeak( int iBlock ) const
+{
+	return ByteToLevel( m_Peak[iBlock] );
+}
+
+float AudioAnalysis::GetRMS( int iBlock ) const
+{
+	return ByteToLevel( m_RMS[iBlock] );
+}
+
+float AudioAnalysis::GetOnset( int iBlock ) const
+{
+	return m_Onset[iBlock] / 255.0f;
+}
+
+void AudioAnalysis::GetEnvelope( float fStartSecond, float fEndSecond, int iPoints,
+	vector<float> *pPeak, vector<float> *pRMS, vector<float> *pOnset ) const
+{
+	if( pPeak )
+		pPeak->assign( iPoints, 0.0f );
+	if( pRMS )
+		pRMS->assign( iPoints, 0.0f );
+	if( pOnset )
+		pOnset->assign( iPoints, 0.0f );
+
+	const float fBlocksPerPoint = (fEndSecond - fStartSecond) * BLOCKS_PER_SECOND / max( iPoints, 1 );
+	for( int i = 0; i < iPoints; ++i )
+	{
+		int iFirst = (int) floorf( fStartSecond * BLOCKS_PER_SECOND + i * fBlocksPerPoint );
+		int iLast = (int) floorf( fStartSecond * BLOCKS_PER_SECOND + (i+1) * fBlocksPerPoint );
+		iLast = max( iLast, iFirst+1 );	// every point gets at least one block
+		iFirst = max( iFirst, 0 );
+		iLast = min( iLast, GetNumBlocks() );
+		if( iFirst >= iLast )
+			continue;
+
+		float fPeak = 0, fEnergy = 0, fOnset = 0;
+		for( int b = iFirst; b < iLast; ++b )
+		{
+			fPeak = max( fPeak, GetPeak(b) );
+			fEnergy += GetRMS(b) * GetRMS(b);
+			fOnset = max( fOnset, GetOnset(b) );
+		}
+		if( pPeak )
+			(*pPeak)[i] = fPeak;
+		if( pRMS )
+			(*pRMS)[i] = sqrtf( fEnergy / (iLast - iFirst) );
+		if( pOnset )
+			(*pOnset)[i] = fOnset;
+	}
+}
+
+AudioAnalysisCache::AudioAnalysisCache():
+	m_Event("AudioAnalysis"), m_iPauseCount(0), m_bShutdown(false)
+{
+	m_WorkerThread.SetName( "Audio analysis" );
+	m_WorkerThread.Create( WorkerThread_Start, this );
+}
+
+AudioAnalysisCache::~AudioAnalysisCache()
+{
+	m_Event.Lock();
+	m_bShutdown = true;
+	m_Event.Broadcast();
+	m_Event.Unlock();
+	m_WorkerThread.Wait();
+}
+
+RString AudioAnalysisCache::GetCachePath( const RString &sMusicPath )
+{
+	return SongCacheIndex::GetCacheFilePath( "Analysis", sMusicPath );
+}
+
+bool AudioAnalysisCache::HasFailed( const RString &sMusicPath, unsigned iSourceHash ) const
+{
+	std::map<RString, unsigned>::const_iterator it = m_Failed.find( sMusicPath );
+	return it != m_Failed.end() && it->second == iSourceHash;
+}
+
+bool AudioAnalysisCache::Get( const RString &sMusicPath, AudioAnalysis &out )
+{
+	const unsigned iSourceHash = GetHashForFile( sMusicPath );
+	{
+		LockMut( m_Event );
+		if( sMusicPath == m_sLastPath && m_Last.GetSourceHash() == iSourceHash )
+		{
+			out = m_Last;
+			return true;
+		}
+
+		// Don't decode a file that can't be analyzed again until it changes.
+		if( HasFailed(sMusicPath, iSourceHash) )
+			return false;
+	}
+
+	AudioAnalysis analysis;
+	if( !analysis.ReadFromFile(GetCachePath(sMusicPath)) || analysis.GetSourceHash() != iSourceHash )
+	{
+		Queue( sMusicPath, true );
+		return false;
+	}
+
+	LockMut( m_Event );
+	m_sLastPath = sMusicPath;
+	m_Last = analysis;
+	out = analysis;
+	return true;
+}
+
+bool AudioAnalysisCache::IsAnalyzed( const RString &sMusicPath )
+{
+	AudioAnalysis analysis;
+	return Get( sMusicPath, analysis );
+}
+
+void AudioAnalysisCache::QueueSongs( const vector<Song *> &apSongs )
+{
+	if( !g_bAnalyzeMusicInBackground )
+		return;
+	for (Song const *pSong : apSongs)
+	{
+		if( pSong->HasMusic() )
+			Queue( pSong->GetMusicPath(), false );
+	}
+}
+
+void AudioAnalysisCache::Queue( const RString &sMusicPath, bool bUrgent )
+{
+	LockMut( m_Event );
+	if( !m_Queued.insert(sMusicPath).second )
+	{
+		if( !bUrgent )
+			return;
+		// Move it to the front.
+		std::deque<RString>::iterator it = find( m_Queue.begin(), m_Queue.end(), sMusicPath );
+		if( it != m_Queue.end() )
+			m_Queue.erase( it );
+	}
+
+	if( bUrgent )
+		m_Queue.push_front( sMusicPath );
+	else
+		m_Queue.push_back( sMusicPath );
+	m_Event.Broadcast();
+}
+
+void AudioAnalysisCache::Pause()
+{
+	LockMut( m_Event );
+	++m_iPauseCount;
+}
+
+void AudioAnalysisCache::Unpause()
+{
+	LockMut( m_Event );
+	ASSERT( m_iPauseCount > 0 );
+	if( --m_iPauseCount == 0 )
+		m_Event.Broadcast();
+}
+
+void AudioAnalysisCache::WorkerThread()
+{
+	m_Event.Lock();
+	while( !m_bShutdown )
+	{
+		if( m_Queue.empty() || m_iPauseCount != 0 )
+		{
+			m_Event.Wait();
+			continue;
+		}
+
+		RString sMusicPath = m_Queue.front();
+		m_Queue.pop_front();
+		m_Event.Unlock();
+
+		/* Most files queued at startup were analyzed on an earlier run. */
+		const RString sCachePath = GetCachePath( sMusicPath );
+		const unsigned iSourceHash = GetHashForFile( sMusicPath );
+		AudioAnalysis analysis;
+		bool bFailed = false;
+		if( !analysis.ReadFromFile(sCachePath) || analysis.GetSourceHash() != iSourceHash )
+		{
+			// Skip files that haven't changed since they failed.
+			m_Event.Lock();
+			bFailed = HasFailed( sMusicPath, iSourceHash );
+			m_Event.Unlock();
+
+			RString sError;
+			if( !bFailed && analysis.Analyze(sMusicPath, sError) )
+			{
+				analysis.WriteToFile( sCachePath );
+			}
+			else if( !bFailed )
+			{
+				LOG->Trace( "Couldn't analyze \"%s\": %s", sMusicPath.c_str(), sError.c_str() );
+				bFailed = true;
+			}
+		}
+
+		m_Event.Lock();
+		m_Queued.erase( sMusicPath );
+		if( bFailed )
+			m_Failed[sMusicPath] = iSourceHash;
+		else
+			m_Failed.erase( sMusicPath );
+	}
+	m_Event.Unlock();
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -0,0 +1,137 @@
+/* AudioAnalysisCache - Envelopes and onsets of music files, worked out once and kept on disk. */
+
+#ifndef AUDIO_ANALYSIS_CACHE_H
+#define AUDIO_ANALYSIS_CACHE_H
+
+#include "RageThreads.h"
+
+#include <deque>
+#include <map>
+#include <set>
+
+class Song;
+
+/**
+ * @brief What's known about the sound of a music file, without decoding it.
+ *
+ * The file is split into blocks of 1/BLOCKS_PER_SECOND seconds.  Each block
+ * has a peak and RMS level, from 0 to 1, and an onset strength: how much
+ * louder its high frequencies got than in the block before, from 0 to 1,
+ * relative to the strongest onset in the file. */
+class AudioAnalysis
+{
+public:
+	static const int BLOCKS_PER_SECOND = 100;
+
+	AudioAnalysis(): m_fLoudness(-70), m_iSourceHash(0) { }
+
+	/** @brief Decode and analyze a music file.  This takes a while. */
+	bool Analyze( const RString &sPath, RString &sError );
+	bool ReadFromFile( const RString &sPath );
+	bool WriteToFile( const RString &sPath ) const;
+
+	int GetNumBlocks() const { return m_Peak.size(); }
+	float GetSeconds() const { return float(GetNumBlocks()) / BLOCKS_PER_SECOND; }
+	float GetPeak( int iBlock ) const;
+	float GetRMS( int iBlock ) const;
+	float GetOnset( int iBlock ) const;
+	/** @brief The gated loudness of the whole file, in dB below full scale.
+	 * This isn't frequency weighted, so it's only close to LUFS. */
+	float GetLoudness() const { return m_fLoudness; }
+	/** @brief The hash of the music file this was made from. */
+	unsigned GetSourceHash() const { return m_iSourceHash; }
+
+	/**
+	 * @brief Summarize fStartSecond to fEndSecond in iPoints points: the
+	 * highest peak, the RMS and the strongest onset of the blocks in each.
+	 * Any of the outputs may be null. */
+	void GetEnvelope( float fStartSecond, float fEndSecond, int iPoints,
+		vector<float> *pPeak, vector<float> *pRMS, vector<float> *pOnset ) const;
+
+private:
+	/* Levels are stored in 8 bits on a dB scale; onsets are linear. */
+	vector<uint8_t> m_Peak;
+	vector<uint8_t> m_RMS;
+	vector<uint8_t> m_Onset;
+	float m_fLoudness;
+	unsigned m_iSourceHash;
+};
+
+/**
+ * @brief Analyzes music files on a background thread and keeps the results in
+ * the cache directory, so sync tools, the editor and themes can use them
+ * without decoding anything. */
+class AudioAnalysisCache
+{
+public:
+	AudioAnalysisCache();
+	~AudioAnalysisCache();
+
+	/**
+	 * @brief Get the analysis of a music file.
+	 *
+	 * If it hasn't been analyzed, or the file changed since, return false
+	 * and analyze it ahead of everything else queued.  A file that couldn't
+	 * be analyzed isn't tried again until it changes. */
+	bool Get( const RString &sMusicPath, AudioAnalysis &out );
+	bool IsAnalyzed( const RString &sMusicPath );
+
+	/** @brief Analyze the music of these songs, if it isn't already. */
+	void QueueSongs( const vector<Song *> &apSongs );
+
+	/** @brief Stop starting new files, eg. during gameplay, so the decoding
+	 * doesn't compete with it.  A file already being analyzed is finished.
+	 * Pauses nest; analysis resumes once each Pause has had its Unpause. */
+	void Pause();
+	void Unpause();
+
+private:
+	static RString GetCachePath( const RString &sMusicPath );
+	void Queue( const RString &sMusicPath, bool bUrgent );
+	bool HasFailed( const RString &sMusicPath, unsigned iSourceHash ) const;
+
+	static int WorkerThread_Start( void *p ) { ((AudioAnalysisCache *) p)->WorkerThread(); return 0; }
+	void WorkerThread();
+
+	RageThread m_WorkerThread;
+	RageEvent m_Event;	// protects everything below
+	std::deque<RString> m_Queue;
+	std::set<RString> m_Queued;
+	int m_iPauseCount;
+	bool m_bShutdown;
+	/* Files that couldn't be analyzed -> their hash when they were tried. */
+	std::map<RString, unsigned> m_Failed;
+
+	/* The last analysis read from disk, for callers that ask every frame. */
+	RString m_sLastPath;
+	AudioAnalysis m_Last;
+};
+
+extern AudioAnalysisCache *AUDIOANALYSIS;	// global and accessible from anywhere in our program
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
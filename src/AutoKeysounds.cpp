@@ -30,6 +30,7 @@
 #include "RageSoundManager.h"
 #include "RageLog.h"
 #include "RageSoundReader_FileReader.h"
+#include "RageSoundKeysoundBank.h"
 
 
 void AutoKeysounds::Load( PlayerNumber pn, const NoteData& ndAutoKeysoundsOnly )
@@ -45,6 +46,15 @@ void AutoKeysounds::LoadAutoplaySoundsInto( RageSoundReader_Chain *pChain )
 	Song* pSong = GAMESTATE->m_pCurSong;
 	RString sSongDir = pSong->GetSongDir();
 
+	/* Share decoded keysounds with the players.  The chain's readers keep
+	 * the bank loaded for as long as they need it. */
+	vector<RString> asKeysoundPaths;
+	for (RString const &sFile : pSong->m_vsKeysoundFile)
+		asKeysoundPaths.push_back( sSongDir + sFile );
+	RageSoundKeysoundBank *pBank = asKeysoundPaths.empty()? nullptr: RageSoundKeysoundBank::Get( asKeysoundPaths );
+	/* Each keysound's index in the chain; -2 if it isn't loaded into it yet. */
+	vector<int> aiChainIndex( asKeysoundPaths.size(), -2 );
+
 	/*
 	 * Add all current autoplay sounds in both players to the chain.
 	 */
@@ -84,21 +94,30 @@ void AutoKeysounds::LoadAutoplaySoundsInto( RageSoundReader_Chain *pChain )
 					continue;
 
 				ASSERT( tn[pn].type == TapNoteType_AutoKeysound );
-				if( tn[pn].iKeysoundIndex >= 0 )
+				const int iKeysound = tn[pn].iKeysoundIndex;
+				if( iKeysound >= 0 && iKeysound < (int) asKeysoundPaths.size() )
 				{
-					RString sKeysoundFilePath = sSongDir + pSong->m_vsKeysoundFile[tn[pn].iKeysoundIndex];
 					float fSeconds = GAMESTATE->m_pCurSteps[pn]->GetTimingData()->GetElapsedTimeFromBeatNoOffset( NoteRowToBeat(iRow) ) + SOUNDMAN->GetPlayLatency();
 
 					float fPan = 0;
 					// If two players are playing, pan the keysounds to each player's respective side
 					if( GAMESTATE->GetNumPlayersEnabled() == 2 )
 						fPan = (pn == PLAYER_1)? -1.0f:+1.0f;
-					int iIndex = pChain->LoadSound( sKeysoundFilePath );
+					int &iIndex = aiChainIndex[iKeysound];
+					if( iIndex == -2 )
+					{
+						if( pBank->IsLoaded(iKeysound) )
+							iIndex = pChain->LoadSound( pBank->MakeReader(iKeysound) );
+						else
+							iIndex = pChain->LoadSound( asKeysoundPaths[iKeysound] );
+					}
 					pChain->AddSound( iIndex, fSeconds, fPan );
 				}
 			}
 		}
 	}
+
+	RageSoundKeysoundBank::Release( pBank );
 }
 
 void AutoKeysounds::LoadTracks( const Song *pSong, RageSoundReader *&pShared, RageSoundReader *&pPlayer1, RageSoundReader *&pPlayer2 )
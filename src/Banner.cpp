@@ -24,6 +24,7 @@ ThemeMetric<float> SCROLL_SPEED_DIVISOR	("Banner","ScrollSpeedDivisor");
 Banner::Banner()
 {
 	m_bScrolling = false;
+	m_bAsyncLoad = false;
 	m_fPercentScrolling = 0;
 }
 
@@ -37,7 +38,10 @@ void Banner::Load( RageTextureID ID, bool bIsBanner )
 	}
 
 	if( bIsBanner )
+	{
 		ID = SongBannerTexture(ID);
+		ID.bAsync = m_bAsyncLoad;
+	}
 
 	m_fPercentScrolling = 0;
 	m_bScrolling = false;
@@ -47,6 +47,13 @@ public:
 	void LoadFallbackCharacterIcon();
 
 	void SetScrolling( bool bScroll, float Percent = 0 );
+	/**
+	 * @brief Decode song banners in the background, drawing nothing until
+	 *        they're ready.
+	 *
+	 * Only sizing done with ScaleToClipped is kept when the banner arrives;
+	 * anything else computed against the placeholder texture is lost. */
+	void SetAsyncLoad( bool b ) { m_bAsyncLoad = b; }
 	bool GetScrolling() const { return m_bScrolling; }
 	float ScrollingPercent() const { return m_fPercentScrolling; }
 
@@ -56,6 +63,7 @@ public:
 protected:
 	bool m_bScrolling;
 	float m_fPercentScrolling;
+	bool m_bAsyncLoad;
 };
 
 #endif
@@ -0,0 +1,267 @@
+#include "global.h"
+#include "Benchmark.h"
+#include "RageDisplay_Recording.h"
+#include "RageFile.h"
+#include "RageLog.h"
+#include "RageProfiler.h"
+#include "RageUtil.h"
+#include "Screen.h"
+#include "ScreenManager.h"
+#include "arch/ArchHooks/ArchHooks.h"
+
+static const int DEFAULT_FRAMES = 1000;
+static const RString DEFAULT_SCREEN = "ScreenGameplay";
+static const RString REPORT_PATH = "/Logs/benchmark.txt";
+
+typedef int RageDisplay_Recording::FrameStats::*FrameStat;
+static const struct
+{
+	const char *szName;
+	FrameStat pStat;
+} g_DrawStats[] = {
+	{ "Draw calls", &RageDisplay_Recording::FrameStats::iDrawCalls },
+	{ "Vertices", &RageDisplay_Recording::FrameStats::iVertices },
+	{ "Texture binds", &RageDisplay_Recording::FrameStats::iTextureBinds },
+	{ "State changes", &RageDisplay_Recording::FrameStats::iStateChanges },
+	{ "Redundant calls", &RageDisplay_Recording::FrameStats::iRedundantCalls },
+	{ "Texture uploads", &RageDisplay_Recording::FrameStats::iTextureUploads },
+};
+
+namespace
+{
+	enum State
+	{
+		/** @brief Waiting for the screen to come up. */
+		STATE_WAITING,
+		/** @brief The profiler was started this frame; it starts recording
+		 * with the next one. */
+		STATE_STARTING,
+		STATE_RECORDING,
+		STATE_DONE
+	};
+
+	bool g_bRunning = false;
+	State g_State = STATE_WAITING;
+	int g_iFramesToRecord = DEFAULT_FRAMES;
+	RString g_sScreen;
+	RString g_sTracePath;
+
+	vector<uint64_t> g_aFrameUsecs;
+	uint64_t g_iLastFrameStart = 0;
+	uint64_t g_iZoneUsecs[NUM_ProfileZone];
+
+	RageDisplay_Recording *g_pDisplay = nullptr;
+	int g_iDisplayFrames = 0;
+	int g_iDrawnFrames = 0;
+	int64_t g_iDrawStatTotals[ARRAYLEN(g_DrawStats)];
+	int g_iDrawStatMax[ARRAYLEN(g_DrawStats)];
+}
+
+void Benchmark::Init()
+{
+	RString sFrames;
+	if( !GetCommandlineArgument("benchmark", &sFrames) )
+		return;
+
+	g_bRunning = true;
+	if( !sFrames.empty() )
+	{
+		if( !IsAnInt(sFrames) || StringToInt(sFrames) <= 0 )
+			RageException::Throw( "Invalid argument \"--benchmark=%s\".", sFrames.c_str() );
+		g_iFramesToRecord = StringToInt( sFrames );
+	}
+
+	g_sScreen = DEFAULT_SCREEN;
+	GetCommandlineArgument( "benchmark-screen", &g_sScreen );
+	GetCommandlineArgument( "benchmark-trace", &g_sTracePath );
+
+	LOG->Info( "Benchmarking %i frames of %s", g_iFramesToRecord, g_sScreen.c_str() );
+}
+
+bool Benchmark::IsRunning()
+{
+	return g_bRunning;
+}
+
+const RString &Benchmark::GetScreen()
+{
+	return g_sScreen;
+}
+
+static RString FormatMsecs( double fUsecs )
+{
+	return ssprintf( "%.3fms", fUsecs / 1000 );
+}
+
+static void WriteReport( const RString &sReason )
+{
+	vector<RString> asLines;
+	const int iFrames = g_aFrameUsecs.size();
+	asLines.push_back( ssprintf("Benchmark of %s: %i frames on the %s renderer",
+		g_sScreen.c_str(), iFrames, DISPLAY->GetApiDescription().c_str()) );
+	if( !sReason.empty() )
+		asLines.push_back( sReason );
+
+	if( iFrames != 0 )
+	{
+		vector<uint64_t> aSorted = g_aFrameUsecs;
+		sort( aSorted.begin(), aSorted.end() );
+		uint64_t iTotal = 0;
+		for (uint64_t iUsecs : aSorted)
+			iTotal += iUsecs;
+		asLines.push_back( "" );
+		asLines.push_back( ssprintf("Frame time: mean %s, median %s, 99th percentile %s, max %s",
+			FormatMsecs(double(iTotal) / iFrames).c_str(),
+			FormatMsecs(aSorted[iFrames/2]).c_str(),
+			FormatMsecs(aSorted[min(iFrames-1, iFrames*99/100)]).c_str(),
+			FormatMsecs(aSorted.back()).c_str()) );
+
+		asLines.push_back( "" );
+		asLines.push_back( "CPU time per frame by zone:" );
+		FOREACH_ENUM( ProfileZone, z )
+		{
+			asLines.push_back( ssprintf("  %-24s %s", ProfileZoneToString(z).c_str(),
+				FormatMsecs(double(g_iZoneUsecs[z]) / iFrames).c_str()) );
+		}
+
+		vector<RageProfiler::ActorTypeSample> aTypes;
+		RageProfiler::GetActorTypeTimes( aTypes );
+		asLines.push_back( "" );
+		asLines.push_back( "CPU time per frame by actor type, not counting children:" );
+		asLines.push_back( ssprintf("  %-40s %10s %10s %9s %9s", "", "update", "draw", "updates", "draws") );
+		for (RageProfiler::ActorTypeSample const &t : aTypes)
+		{
+			asLines.push_back( ssprintf("  %-40s %10s %10s %9.1f %9.1f", t.sType.c_str(),
+				FormatMsecs(double(t.iUpdateUsecs) / iFrames).c_str(),
+				FormatMsecs(double(t.iDrawUsecs) / iFrames).c_str(),
+				double(t.iUpdates) / iFrames, double(t.iDraws) / iFrames) );
+		}
+	}
+
+	if( g_iDrawnFrames != 0 )
+	{
+		asLines.push_back( "" );
+		asLines.push_back( ssprintf("Per drawn frame, over %i frames:", g_iDrawnFrames) );
+		for( unsigned i = 0; i < ARRAYLEN(g_DrawStats); ++i )
+		{
+			asLines.push_back( ssprintf("  %-24s mean %.1f, max %i", g_DrawStats[i].szName,
+				double(g_iDrawStatTotals[i]) / g_iDrawnFrames, g_iDrawStatMax[i]) );
+		}
+	}
+
+	RageFile f;
+	if( !f.Open(REPORT_PATH, RageFile::WRITE) )
+		LOG->Warn( "Couldn't write benchmark report \"%s\": %s", REPORT_PATH.c_str(), f.GetError().c_str() );
+	for (RString const &sLine : asLines)
+	{
+		LOG->Info( "%s", sLine.c_str() );
+		if( f.IsOpen() )
+			f.PutLine( sLine );
+	}
+}
+
+static void Finish( const RString &sReason )
+{
+	g_State = STATE_DONE;
+	if( g_pDisplay != nullptr )
+		g_pDisplay->CloseTrace();
+	WriteReport( sReason );
+	RageProfiler::SetTimeActorTypes( false );
+	RageProfiler::SetEnabled( false );
+	ArchHooks::SetUserQuit();
+}
+
+void Benchmark::Update()
+{
+	if( !g_bRunning || g_State == STATE_DONE )
+		return;
+
+	Screen *pScreen = SCREENMAN != nullptr? SCREENMAN->GetTopScreen():nullptr;
+	if( pScreen == nullptr )
+		return;
+	if( pScreen->GetName() != g_sScreen )
+	{
+		Finish( ssprintf("%s was replaced by %s before the benchmark finished.",
+			g_sScreen.c_str(), pScreen->GetName().c_str()) );
+		return;
+	}
+
+	switch( g_State )
+	{
+	case STATE_WAITING:
+		RageProfiler::SetEnabled( true );
+		RageProfiler::SetTimeActorTypes( true );
+		ZERO( g_iZoneUsecs );
+		g_aFrameUsecs.reserve( g_iFramesToRecord );
+		g_State = STATE_STARTING;
+		return;
+
+	case STATE_STARTING:
+		// The profiler's first frame starts now; so does the display's.
+		g_pDisplay = dynamic_cast<RageDisplay_Recording *>( DISPLAY );
+		if( g_pDisplay != nullptr )
+		{
+			g_iDisplayFrames = g_pDisplay->GetNumFrames();
+			if( !g_sTracePath.empty() )
+				g_pDisplay->OpenTrace( g_sTracePath );
+		}
+		ZERO( g_iDrawStatTotals );
+		ZERO( g_iDrawStatMax );
+		g_State = STATE_RECORDING;
+		return;
+
+	default:
+		break;
+	}
+
+	RageProfiler::FrameSample s;
+	if( RageProfiler::GetLastFrame(s) && s.iStartUsecs != g_iLastFrameStart )
+	{
+		g_iLastFrameStart = s.iStartUsecs;
+		g_aFrameUsecs.push_back( s.iLengthUsecs );
+		FOREACH_ENUM( ProfileZone, z )
+			g_iZoneUsecs[z] += s.iZoneUsecs[z];
+	}
+
+	// Frames that drew nothing, like the first update of a screen, don't
+	// reach the display.
+	if( g_pDisplay != nullptr && g_pDisplay->GetNumFrames() != g_iDisplayFrames )
+	{
+		g_iDisplayFrames = g_pDisplay->GetNumFrames();
+		++g_iDrawnFrames;
+		const RageDisplay_Recording::FrameStats &stats = g_pDisplay->GetLastFrameStats();
+		for( unsigned i = 0; i < ARRAYLEN(g_DrawStats); ++i )
+		{
+			g_iDrawStatTotals[i] += stats.*g_DrawStats[i].pStat;
+			g_iDrawStatMax[i] = max( g_iDrawStatMax[i], stats.*g_DrawStats[i].pStat );
+		}
+	}
+
+	if( int(g_aFrameUsecs.size()) >= g_iFramesToRecord )
+		Finish( RString() );
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -0,0 +1,57 @@
+/* Benchmark - Run one screen headless for a number of frames and report where the time went. */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/**
+ * @brief Measure what a screen costs on the CPU, with no GPU needed.
+ *
+ * Run with --benchmark[=frames] to draw with the recording renderer, start
+ * on --benchmark-screen (ScreenGameplay by default) and time the given number
+ * of frames once it's up (1000 by default).  The chart and mods are set up
+ * as usual with --player and --mode, eg.
+ *
+ * --benchmark=2000 --player=1
+ * --mode="playmode,regular;style,single;song,Group/Song;steps,Hard;mod,1.5x"
+ *
+ * The report of frame times, time per zone and per type of actor, and draw
+ * call stats is written to the log and to Logs/benchmark.txt, and then the
+ * game quits.  --benchmark-trace=path also writes every draw and state call
+ * to a trace file; see RageDisplay_Recording. */
+namespace Benchmark
+{
+	/** @brief Read the command line.  Call before the display is created. */
+	void Init();
+	bool IsRunning();
+	const RString &GetScreen();
+
+	/** @brief Call once per frame, after RageProfiler::BeginFrame. */
+	void Update();
+}
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -55,6 +55,7 @@ list(APPEND SM_DATA_NOTEDATA_SRC
             "NoteDataWithScoring.cpp")
 
 list(APPEND SM_DATA_NOTEDATA_HPP
+            "FlatTrackMap.h"
             "NoteData.h"
             "NoteDataUtil.h"
             "NoteDataWithScoring.h")
@@ -125,6 +126,7 @@ source_group("Data Structures\\\\Score Keepers"
 
 list(APPEND SM_DATA_SONG_SRC
             "Song.cpp"
+            "SongCacheBlob.cpp"
             "SongCacheIndex.cpp"
             "SongOptions.cpp"
             "SongPosition.cpp"
@@ -132,6 +134,7 @@ list(APPEND SM_DATA_SONG_SRC
 
 list(APPEND SM_DATA_SONG_HPP
             "Song.h"
+            "SongCacheBlob.h"
             "SongCacheIndex.h"
             "SongOptions.h"
             "SongPosition.h"
@@ -162,6 +165,7 @@ source_group("Data Structures\\\\Steps and Styles"
 list(APPEND SM_DATA_REST_SRC
             "AdjustSync.cpp"
             "Attack.cpp"
+            "AudioAnalysisCache.cpp"
             "AutoKeysounds.cpp"
             "BackgroundUtil.cpp"
             "ImageCache.cpp"
@@ -200,12 +204,14 @@ list(APPEND SM_DATA_REST_SRC
             "PlayerState.cpp"
             "Preference.cpp"
             "Profile.cpp"
+            "ProfileSaveQueue.cpp"
             "RadarValues.cpp"
             "RandomSample.cpp"
             "SampleHistory.cpp"
             "ScreenDimensions.cpp"
             "SoundEffectControl.cpp"
             "StageStats.cpp"
+            "StatsJournal.cpp"
             "TimingData.cpp"
             "TimingSegments.cpp"
             "TitleSubstitution.cpp")
@@ -213,6 +219,7 @@ list(APPEND SM_DATA_REST_SRC
 list(APPEND SM_DATA_REST_HPP
             "AdjustSync.h"
             "Attack.h"
+            "AudioAnalysisCache.h"
             "AutoKeysounds.h"
             "BackgroundUtil.h"
             "ImageCache.h"
@@ -252,6 +259,7 @@ list(APPEND SM_DATA_REST_HPP
             "PlayerState.h"
             "Preference.h"
             "Profile.h"
+            "ProfileSaveQueue.h"
             "RadarValues.h"
             "RandomSample.h"
             "SampleHistory.h"
@@ -259,6 +267,7 @@ list(APPEND SM_DATA_REST_HPP
             "SoundEffectControl.h"
             "SubscriptionManager.h"
             "StageStats.h"
+            "StatsJournal.h"
             "ThemeMetric.h"
             "TimingData.h"
             "TimingSegments.h"
@@ -1,4 +1,5 @@
 list(APPEND SMDATA_GLOBAL_FILES_SRC
+            "Benchmark.cpp"
             "GameLoop.cpp"
             "global.cpp"
             "SpecialFiles.cpp"
@@ -6,6 +7,7 @@ list(APPEND SMDATA_GLOBAL_FILES_SRC
             "${SM_SRC_DIR}/generated/verstub.cpp")
 
 list(APPEND SMDATA_GLOBAL_FILES_HPP
+            "Benchmark.h"
             "generated/config.hpp"
             "GameLoop.h"
             "global.h"
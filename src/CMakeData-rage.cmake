@@ -28,6 +28,7 @@ list(APPEND SMDATA_RAGE_MISC_SRC
             "RageInputDevice.cpp"
             "RageLog.cpp"
             "RageMath.cpp"
+            "RageProfiler.cpp"
             "RageTypes.cpp"
             "RageThreads.cpp"
             "RageTimer.cpp")
@@ -38,6 +39,7 @@ list(APPEND SMDATA_RAGE_MISC_HPP
             "RageInputDevice.h"
             "RageLog.h"
             "RageMath.h"
+            "RageProfiler.h"
             "RageTypes.h"
             "RageThreads.h"
             "RageTimer.h")
@@ -51,6 +53,7 @@ list(APPEND SMDATA_RAGE_GRAPHICS_SRC
             "RageBitmapTexture.cpp"
             "RageDisplay.cpp"
             "RageDisplay_Null.cpp"
+            "RageDisplay_Recording.cpp"
             "RageDisplay_OGL.cpp"
             "RageDisplay_OGL_Helpers.cpp"
             "RageModelGeometry.cpp"
@@ -78,6 +81,7 @@ list(APPEND SMDATA_RAGE_GRAPHICS_HPP
             "RageBitmapTexture.h"
             "RageDisplay.h"
             "RageDisplay_Null.h"
+            "RageDisplay_Recording.h"
             "RageDisplay_OGL.h"
             "RageDisplay_OGL_Helpers.h"
             "RageModelGeometry.h"
@@ -153,8 +157,10 @@ source_group("Rage\\\\File"
 
 list(APPEND SMDATA_RAGE_SOUND_SRC
             "RageSound.cpp"
+            "RageSoundKeysoundBank.cpp"
             "RageSoundManager.cpp"
             "RageSoundMixBuffer.cpp"
+            "RageSoundMixKernels.cpp"
             "RageSoundPosMap.cpp"
             "RageSoundReader.cpp"
             "RageSoundReader_Chain.cpp"
@@ -166,6 +172,7 @@ list(APPEND SMDATA_RAGE_SOUND_SRC
             "RageSoundReader_Pan.cpp"
             "RageSoundReader_PitchChange.cpp"
             "RageSoundReader_PostBuffering.cpp"
+            "RageSoundReader_Prefetched.cpp"
             "RageSoundReader_Preload.cpp"
             "RageSoundReader_Resample_Good.cpp"
             "RageSoundReader_SpeedChange.cpp"
@@ -176,8 +183,10 @@ list(APPEND SMDATA_RAGE_SOUND_SRC
 
 list(APPEND SMDATA_RAGE_SOUND_HPP
             "RageSound.h"
+            "RageSoundKeysoundBank.h"
             "RageSoundManager.h"
             "RageSoundMixBuffer.h"
+            "RageSoundMixKernels.h"
             "RageSoundPosMap.h"
             "RageSoundReader.h"
             "RageSoundReader_Chain.h"
@@ -190,6 +199,7 @@ list(APPEND SMDATA_RAGE_SOUND_HPP
             "RageSoundReader_Pan.h"
             "RageSoundReader_PitchChange.h"
             "RageSoundReader_PostBuffering.h"
+            "RageSoundReader_Prefetched.h"
             "RageSoundReader_Preload.h"
             "RageSoundReader_Resample_Good.h"
             "RageSoundReader_SpeedChange.h"
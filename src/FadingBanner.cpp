@@ -27,6 +27,9 @@ FadingBanner::FadingBanner()
 	for( int i=0; i<NUM_BANNERS; i++ )
 	{
 		m_Banner[i].SetName( "Banner" );
+		// Don't hitch the music wheel decoding banners; show them when ready.
+		// They're only sized with ScaleToClipped, which survives that.
+		m_Banner[i].SetAsyncLoad( true );
 		ActorUtil::LoadAllCommandsAndOnCommand( m_Banner[i], "FadingBanner" );
 		this->AddChild( &m_Banner[i] );
 	}
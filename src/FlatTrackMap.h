@@ -0,0 +1,134 @@
+#ifndef FLAT_TRACK_MAP_H
+#define FLAT_TRACK_MAP_H
+
+#include "NoteTypes.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief The notes of one NoteData track, kept sorted by row in a vector.
+ *
+ * This has the part of the map<int,TapNote> interface that NoteData and its
+ * users rely on, so NoteData can use either one as its TrackMap.  Finding a
+ * note is a binary search over contiguous memory, and walking a track reads
+ * the notes in order instead of chasing tree nodes around the heap.  Notes
+ * are nearly always added in row order, which is an append.
+ *
+ * Unlike a map, adding or removing a note moves the notes after it, so it
+ * invalidates iterators into the track from that point on. */
+class FlatTrackMap
+{
+public:
+	typedef int key_type;
+	typedef TapNote mapped_type;
+	typedef std::pair<int, TapNote> value_type;
+	typedef std::vector<value_type>::size_type size_type;
+	typedef std::vector<value_type>::iterator iterator;
+	typedef std::vector<value_type>::const_iterator const_iterator;
+	typedef std::vector<value_type>::reverse_iterator reverse_iterator;
+	typedef std::vector<value_type>::const_reverse_iterator const_reverse_iterator;
+
+	iterator begin()				{ return m_vNotes.begin(); }
+	const_iterator begin() const			{ return m_vNotes.begin(); }
+	iterator end()					{ return m_vNotes.end(); }
+	const_iterator end() const			{ return m_vNotes.end(); }
+	reverse_iterator rbegin()			{ return m_vNotes.rbegin(); }
+	const_reverse_iterator rbegin() const		{ return m_vNotes.rbegin(); }
+	reverse_iterator rend()				{ return m_vNotes.rend(); }
+	const_reverse_iterator rend() const		{ return m_vNotes.rend(); }
+
+	bool empty() const				{ return m_vNotes.empty(); }
+	size_type size() const				{ return m_vNotes.size(); }
+	void clear()					{ m_vNotes.clear(); }
+	void reserve( size_type iSize )			{ m_vNotes.reserve( iSize ); }
+	void swap( FlatTrackMap &other )		{ m_vNotes.swap( other.m_vNotes ); }
+
+	iterator lower_bound( int iRow )		{ return std::lower_bound( m_vNotes.begin(), m_vNotes.end(), iRow, CompareRow() ); }
+	const_iterator lower_bound( int iRow ) const	{ return std::lower_bound( m_vNotes.begin(), m_vNotes.end(), iRow, CompareRow() ); }
+	iterator upper_bound( int iRow )		{ return std::upper_bound( m_vNotes.begin(), m_vNotes.end(), iRow, CompareRow() ); }
+	const_iterator upper_bound( int iRow ) const	{ return std::upper_bound( m_vNotes.begin(), m_vNotes.end(), iRow, CompareRow() ); }
+
+	iterator find( int iRow )
+	{
+		iterator it = lower_bound( iRow );
+		return (it != end() && it->first == iRow)? it:end();
+	}
+	const_iterator find( int iRow ) const
+	{
+		const_iterator it = lower_bound( iRow );
+		return (it != end() && it->first == iRow)? it:end();
+	}
+	size_type count( int iRow ) const		{ return find( iRow ) != end()? 1:0; }
+
+	TapNote &operator[]( int iRow )
+	{
+		return insert( value_type(iRow, TapNote()) ).first->second;
+	}
+
+	/** @brief Add a note, unless there's already one on its row. */
+	std::pair<iterator, bool> insert( const value_type &note )
+	{
+		// Notes are usually added in order, so check the end first.
+		if( m_vNotes.empty() || m_vNotes.back().first < note.first )
+		{
+			m_vNotes.push_back( note );
+			return std::make_pair( m_vNotes.end() - 1, true );
+		}
+		iterator it = lower_bound( note.first );
+		if( it != end() && it->first == note.first )
+			return std::make_pair( it, false );
+		return std::make_pair( m_vNotes.insert(it, note), true );
+	}
+
+	iterator erase( iterator it )			{ return m_vNotes.erase( it ); }
+	iterator erase( iterator first, iterator last )	{ return m_vNotes.erase( first, last ); }
+	size_type erase( int iRow )
+	{
+		iterator it = find( iRow );
+		if( it == end() )
+			return 0;
+		m_vNotes.erase( it );
+		return 1;
+	}
+
+	bool operator==( const FlatTrackMap &other ) const	{ return m_vNotes == other.m_vNotes; }
+	bool operator!=( const FlatTrackMap &other ) const	{ return m_vNotes != other.m_vNotes; }
+
+private:
+	struct CompareRow
+	{
+		bool operator()( const value_type &note, int iRow ) const { return note.first < iRow; }
+		bool operator()( int iRow, const value_type &note ) const { return iRow < note.first; }
+	};
+
+	std::vector<value_type> m_vNotes;
+};
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -5,6 +5,7 @@
 #include "RageLog.h"
 
 #include <map>
+#include <mutex>
 
 // Map from "&foo;" to a UTF-8 string.
 typedef map<RString, wchar_t, StdString::StdStringLessNoCase> aliasmap;
@@ -68,11 +69,8 @@ And here's one for a kanji page:
 
  */
 
-static void InitCharAliases()
+static void DoInitCharAliases()
 {
-	if(!CharAliases.empty())
-		return;
-
 	CharAliases["default"]		= FONT_DEFAULT_GLYPH;	// ?
 	CharAliases["invalid"]		= INVALID_CHAR;			// 0xFFFD
 
@@ -369,6 +367,13 @@ static void InitCharAliases()
 	}
 }
 
+/* Songs are loaded on several threads, and each can get here first. */
+static std::once_flag g_CharAliasesOnce;
+static void InitCharAliases()
+{
+	std::call_once( g_CharAliasesOnce, DoInitCharAliases );
+}
+
 // Replace all &markers; and &#NNNN;s with UTF-8.
 void FontCharAliases::ReplaceMarkers( RString &sText )
 {
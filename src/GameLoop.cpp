@@ -13,6 +13,7 @@
 #include "SongManager.h"
 #include "GameState.h"
 #include "MemoryCardManager.h"
+#include "ProfileManager.h"
 #include "ScreenManager.h"
 #include "InputFilter.h"
 #include "InputMapper.h"
@@ -20,6 +21,8 @@
 #include "LightsManager.h"
 #include "RageTimer.h"
 #include "RageInput.h"
+#include "RageProfiler.h"
+#include "Benchmark.h"
 
 static RageTimer g_GameplayTimer;
 
@@ -272,24 +275,25 @@ void GameLoop::UpdateAllButDraw(bool bRunningFromVBLANK)
 	fDeltaTime *= g_fUpdateRate;
 	
 	// Update SOUNDMAN early (before any RageSound::GetPosition calls), to flush position data.
-	SOUNDMAN->Update();
+	{ PROFILE_SCOPE( ProfileZone_SoundManager ); SOUNDMAN->Update(); }
 
 	/* Update song beat information -before- calling update on all the classes that
 	* depend on it. If you don't do this first, the classes are all acting on old
 	* information and will lag. (but no longer fatally, due to timestamping -glenn) */
-	SOUND->Update(fDeltaTime);
-	TEXTUREMAN->Update(fDeltaTime);
-	GAMESTATE->Update(fDeltaTime);
-	SCREENMAN->Update(fDeltaTime);
-	MEMCARDMAN->Update();
+	{ PROFILE_SCOPE( ProfileZone_GameSound ); SOUND->Update(fDeltaTime); }
+	{ PROFILE_SCOPE( ProfileZone_Textures ); TEXTUREMAN->Update(fDeltaTime); }
+	{ PROFILE_SCOPE( ProfileZone_GameState ); GAMESTATE->Update(fDeltaTime); }
+	{ PROFILE_SCOPE( ProfileZone_Screens ); SCREENMAN->Update(fDeltaTime); }
+	{ PROFILE_SCOPE( ProfileZone_MemoryCards ); MEMCARDMAN->Update(); PROFILEMAN->Update(); }
+	{ PROFILE_SCOPE( ProfileZone_Songs ); SONGMAN->Update(); }
 
 	/* Important: Process input AFTER updating game logic, or input will be
 	* acting on song beat from last frame */
-	HandleInputEvents(fDeltaTime);
+	{ PROFILE_SCOPE( ProfileZone_Input ); HandleInputEvents(fDeltaTime); }
 
 	//bandaid for low max audio sample counter
 	SOUNDMAN->low_sample_count_workaround();
-	LIGHTSMAN->Update(fDeltaTime);
+	{ PROFILE_SCOPE( ProfileZone_Lights ); LIGHTSMAN->Update(fDeltaTime); }
 	
 }
 
@@ -315,6 +319,8 @@ void GameLoop::RunGameLoop()
 
 		CheckFocus();
 
+		RageProfiler::BeginFrame();
+		Benchmark::Update();
 		UpdateAllButDraw(false);
 
 		if( INPUTMAN->DevicesChanged() )
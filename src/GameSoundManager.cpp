@@ -2,6 +2,7 @@
 #include "RageSoundManager.h"
 #include "GameSoundManager.h"
 #include "RageSound.h"
+#include "RageSoundReader_Prefetched.h"
 #include "RageLog.h"
 #include "RageUtil.h"
 #include "GameState.h"
@@ -20,6 +21,9 @@
 
 #include "arch/Sound/RageSoundDriver.h"
 
+#include <deque>
+#include <list>
+
 GameSoundManager *SOUND = nullptr;
 
 /*
@@ -78,8 +82,114 @@ struct MusicPlaying
 
 static MusicPlaying *g_Playing;
 
+/* Music being faded out by a cross fade.  Once it's silent, it's moved to
+ * g_MusicToDelete, and the music thread deletes it. */
+struct FadingMusic
+{
+	RageSound *m_pSound;
+	float m_fSpeed;
+};
+static vector<FadingMusic> g_FadingMusic;
+static vector<RageSound *> g_MusicToDelete;
+
 static RageThread MusicThread;
 
+/* Musics opened ahead of time by PrefetchMusic, most recently wanted first. */
+struct PrefetchedMusic
+{
+	PrefetchedMusic(): m_fStartSecond(0), m_pReader(nullptr) { }
+	bool Matches( const RString &sFile, float fStartSecond ) const
+	{
+		return m_sFile.EqualsNoCase( sFile ) && fabsf( m_fStartSecond - fStartSecond ) < 0.001f;
+	}
+
+	RString m_sFile;
+	float m_fStartSecond;
+	RageSoundReader_Prefetched *m_pReader;
+};
+
+/* Each one is about a megabyte. */
+static const unsigned MAX_PREFETCHED_MUSIC = 8;
+static const float PREFETCH_SECONDS = 3.0f;
+
+/* Lock this before touching anything below. */
+static RageEvent *g_PrefetchMutex;
+static RageThread PrefetchThread;
+static bool g_bPrefetchShutdown;
+static std::list<PrefetchedMusic> g_Prefetched;
+static std::deque<PrefetchedMusic> g_PrefetchQueue;
+/* The music being opened right now, if any. */
+static PrefetchedMusic g_Prefetching;
+
+static std::list<PrefetchedMusic>::iterator FindPrefetchedMusic( const RString &sFile, float fStartSecond )
+{
+	std::list<PrefetchedMusic>::iterator it;
+	for( it = g_Prefetched.begin(); it != g_Prefetched.end(); ++it )
+		if( it->Matches(sFile, fStartSecond) )
+			break;
+	return it;
+}
+
+static int PrefetchThread_start( void *p )
+{
+	g_PrefetchMutex->Lock();
+	while( !g_bPrefetchShutdown )
+	{
+		if( g_PrefetchQueue.empty() )
+		{
+			g_PrefetchMutex->Wait();
+			continue;
+		}
+
+		g_Prefetching = g_PrefetchQueue.front();
+		g_PrefetchQueue.pop_front();
+		PrefetchedMusic music = g_Prefetching;
+		g_PrefetchMutex->Unlock();
+
+		RString sError;
+		music.m_pReader = RageSoundReader_Prefetched::Open( music.m_sFile, music.m_fStartSecond, PREFETCH_SECONDS, sError );
+		if( music.m_pReader == nullptr )
+			LOG->Trace( "Couldn't prefetch \"%s\": %s", music.m_sFile.c_str(), sError.c_str() );
+
+		g_PrefetchMutex->Lock();
+		g_Prefetching = PrefetchedMusic();
+		if( music.m_pReader != nullptr )
+		{
+			g_Prefetched.push_front( music );
+			while( g_Prefetched.size() > MAX_PREFETCHED_MUSIC )
+			{
+				delete g_Prefetched.back().m_pReader;
+				g_Prefetched.pop_back();
+			}
+		}
+
+		/* Wake up TakePrefetchedMusic, if it's waiting for this one. */
+		g_PrefetchMutex->Broadcast();
+	}
+	g_PrefetchMutex->Unlock();
+
+	return 0;
+}
+
+/* Return the prefetched reader for a music, and forget it, or nullptr if it
+ * hasn't been prefetched. */
+static RageSoundReader *TakePrefetchedMusic( const RString &sFile, float fStartSecond )
+{
+	LockMut( *g_PrefetchMutex );
+
+	/* If it's being opened now, that'll finish sooner than opening it again. */
+	while( g_Prefetching.Matches(sFile, fStartSecond) )
+		g_PrefetchMutex->Wait();
+
+	std::list<PrefetchedMusic>::iterator it = FindPrefetchedMusic( sFile, fStartSecond );
+	if( it == g_Prefetched.end() )
+		return nullptr;
+
+	RageSoundReader *pReader = it->m_pReader;
+	g_Prefetched.erase( it );
+	return pReader;
+}
+
 vector<RString> g_SoundsToPlayOnce;
 vector<RString> g_SoundsToPlayOnceFromDir;
 vector<RString> g_SoundsToPlayOnceFromAnnouncer;
@@ -95,9 +205,11 @@ struct MusicToPlay
 	bool bForceLoop;
 	float fStartSecond, fLengthSeconds, fFadeInLengthSeconds, fFadeOutLengthSeconds;
 	bool bAlignBeat, bApplyMusicRate;
+	float fCrossFadeSeconds;
 	MusicToPlay()
 	{
 		HasTiming = false;
+		fCrossFadeSeconds = 0;
 	}
 };
 vector<MusicToPlay> g_MusicsToPlay;
@@ -132,7 +244,11 @@ static void StartMusic( MusicToPlay &ToPlay )
 		RageSound *pSound = new RageSound;
 		RageSoundLoadParams params;
 		params.m_bSupportRateChanging = ToPlay.bApplyMusicRate;
-		pSound->Load( ToPlay.m_sFile, false, &params );
+		RageSoundReader *pPrefetched = TakePrefetchedMusic( ToPlay.m_sFile, ToPlay.fStartSecond );
+		if( pPrefetched != nullptr )
+			pSound->Load( pPrefetched, ToPlay.m_sFile, &params );
+		else
+			pSound->Load( ToPlay.m_sFile, false, &params );
 		g_Mutex->Lock();
 
 		NewMusic = new MusicPlaying( pSound );
@@ -260,7 +376,7 @@ static void StartMusic( MusicToPlay &ToPlay )
 		RageSoundParams p;
 		p.m_StartSecond = ToPlay.fStartSecond;
 		p.m_LengthSeconds = ToPlay.fLengthSeconds;
-		p.m_fFadeInSeconds = ToPlay.fFadeInLengthSeconds;
+		p.m_fFadeInSeconds = max( ToPlay.fFadeInLengthSeconds, ToPlay.fCrossFadeSeconds );
 		p.m_fFadeOutSeconds = ToPlay.fFadeOutLengthSeconds;
 		p.m_StartTime = when;
 		if( ToPlay.bForceLoop )
@@ -270,6 +386,15 @@ static void StartMusic( MusicToPlay &ToPlay )
 	}
 
 	LockMut( *g_Mutex );
+	if( ToPlay.fCrossFadeSeconds > 0 && g_Playing->m_Music->IsPlaying() )
+	{
+		/* Leave the old music playing; Update will fade it out. */
+		FadingMusic fade;
+		fade.m_pSound = g_Playing->m_Music;
+		fade.m_fSpeed = fade.m_pSound->GetParams().m_Volume / ToPlay.fCrossFadeSeconds;
+		g_FadingMusic.push_back( fade );
+		g_Playing->m_Music = nullptr;
+	}
 	delete g_Playing;
 	g_Playing = NewMusic;
 }
@@ -333,7 +458,8 @@ static bool SoundWaiting()
 	return !g_SoundsToPlayOnce.empty() ||
 		!g_SoundsToPlayOnceFromDir.empty() ||
 		!g_SoundsToPlayOnceFromAnnouncer.empty() ||
-		!g_MusicsToPlay.empty();
+		!g_MusicsToPlay.empty() ||
+		!g_MusicToDelete.empty();
 }
 
 
@@ -348,8 +474,13 @@ static void StartQueuedSounds()
 	g_SoundsToPlayOnceFromAnnouncer.clear();
 	vector<MusicToPlay> aMusicsToPlay = g_MusicsToPlay;
 	g_MusicsToPlay.clear();
+	vector<RageSound *> apMusicToDelete = g_MusicToDelete;
+	g_MusicToDelete.clear();
 	g_Mutex->Unlock();
 
+	for( unsigned i = 0; i < apMusicToDelete.size(); ++i )
+		delete apMusicToDelete[i];
+
 	for( unsigned i = 0; i < aSoundsToPlayOnce.size(); ++i )
 		if( aSoundsToPlayOnce[i] != "" )
 			DoPlayOnce( aSoundsToPlayOnce[i] );
@@ -443,6 +574,11 @@ GameSoundManager::GameSoundManager()
 
 	g_UpdatingTimer = true;
 
+	g_PrefetchMutex = new RageEvent("GameSoundManager prefetch");
+	g_bPrefetchShutdown = false;
+	PrefetchThread.SetName( "Music prefetch thread" );
+	PrefetchThread.Create( PrefetchThread_start, this );
+
 	g_Shutdown = false;
 	MusicThread.SetName( "Music thread" );
 	MusicThread.Create( MusicThread_start, this );
@@ -471,6 +607,25 @@ GameSoundManager::~GameSoundManager()
 	MusicThread.Wait();
 	LOG->Trace("Music start thread shut down.");
 
+	g_PrefetchMutex->Lock();
+	g_bPrefetchShutdown = true;
+	g_PrefetchMutex->Broadcast();
+	g_PrefetchMutex->Unlock();
+	PrefetchThread.Wait();
+
+	for( std::list<PrefetchedMusic>::iterator it = g_Prefetched.begin(); it != g_Prefetched.end(); ++it )
+		delete it->m_pReader;
+	g_Prefetched.clear();
+	g_PrefetchQueue.clear();
+	SAFE_DELETE( g_PrefetchMutex );
+
+	for( unsigned i = 0; i < g_FadingMusic.size(); ++i )
+		delete g_FadingMusic[i].m_pSound;
+	g_FadingMusic.clear();
+	for( unsigned i = 0; i < g_MusicToDelete.size(); ++i )
+		delete g_MusicToDelete[i];
+	g_MusicToDelete.clear();
+
 	SAFE_DELETE( g_Playing );
 	SAFE_DELETE( g_Mutex );
 }
@@ -538,6 +693,23 @@ void GameSoundManager::Update( float fDeltaTime )
 
 	LockMut( *g_Mutex );
 
+	/* Fade out music that's being cross faded away from. */
+	for( unsigned i = 0; i < g_FadingMusic.size(); ++i )
+	{
+		RageSound *pSound = g_FadingMusic[i].m_pSound;
+		RageSoundParams p = pSound->GetParams();
+		fapproach( p.m_Volume, 0, fDeltaTime * g_FadingMusic[i].m_fSpeed );
+		pSound->SetParams( p );
+		if( p.m_Volume > 0 && pSound->IsPlaying() )
+			continue;
+
+		/* Stopping a sound can take a while, so let the music thread do it. */
+		g_MusicToDelete.push_back( pSound );
+		g_FadingMusic.erase( g_FadingMusic.begin() + i );
+		--i;
+		g_Mutex->Broadcast();
+	}
+
 	{
 		/* Duration of the fade-in and fade-out: */
 		//const float fFadeInSpeed = 1.5f;
@@ -745,6 +917,7 @@ void GameSoundManager::PlayMusic( PlayMusicParams params, PlayMusicParams Fallba
 	ToPlay.fFadeOutLengthSeconds = params.fFadeOutLengthSeconds;
 	ToPlay.bAlignBeat = params.bAlignBeat;
 	ToPlay.bApplyMusicRate = params.bApplyMusicRate;
+	ToPlay.fCrossFadeSeconds = params.fCrossFadeSeconds;
 
 	/* Add the MusicToPlay to the g_MusicsToPlay queue. */
 	g_Mutex->Lock();
@@ -753,6 +926,43 @@ void GameSoundManager::PlayMusic( PlayMusicParams params, PlayMusicParams Fallba
 	g_Mutex->Unlock();
 }
 
+void GameSoundManager::PrefetchMusic( const vector<PlayMusicParams> &aParams )
+{
+	LockMut( *g_PrefetchMutex );
+	g_PrefetchQueue.clear();
+
+	if( aParams.empty() )
+	{
+		for( std::list<PrefetchedMusic>::iterator it = g_Prefetched.begin(); it != g_Prefetched.end(); ++it )
+			delete it->m_pReader;
+		g_Prefetched.clear();
+		return;
+	}
+
+	/* Move the ones we already have to the front, the nearest first, so they're
+	 * the last to be dropped to make room for the rest. */
+	for( int i = (int) aParams.size() - 1; i >= 0; --i )
+	{
+		std::list<PrefetchedMusic>::iterator it = FindPrefetchedMusic( aParams[i].sFile, aParams[i].fStartSecond );
+		if( it != g_Prefetched.end() )
+			g_Prefetched.splice( g_Prefetched.begin(), g_Prefetched, it );
+	}
+
+	for( unsigned i = 0; i < aParams.size() && i < MAX_PREFETCHED_MUSIC; ++i )
+	{
+		if( aParams[i].sFile.empty() || g_Prefetching.Matches(aParams[i].sFile, aParams[i].fStartSecond) )
+			continue;
+		if( FindPrefetchedMusic(aParams[i].sFile, aParams[i].fStartSecond) != g_Prefetched.end() )
+			continue;
+
+		PrefetchedMusic music;
+		music.m_sFile = aParams[i].sFile;
+		music.m_fStartSecond = aParams[i].fStartSecond;
+		g_PrefetchQueue.push_back( music );
+	}
+	g_PrefetchMutex->Broadcast();
+}
+
 void GameSoundManager::DimMusic( float fVolume, float fDurationSeconds )
 {
 	LockMut( *g_Mutex );
@@ -29,6 +29,7 @@ public:
 			fFadeOutLengthSeconds = 0;
 			bAlignBeat = true;
 			bApplyMusicRate = false;
+			fCrossFadeSeconds = 0;
 		}
 
 		RString sFile;
@@ -40,6 +41,9 @@ public:
 		float fFadeOutLengthSeconds;
 		bool bAlignBeat;
 		bool bApplyMusicRate;
+		/* If nonzero, fade out the music that's playing over this long, and
+		 * fade this in, instead of cutting straight from one to the other. */
+		float fCrossFadeSeconds;
 	};
 	void PlayMusic( PlayMusicParams params, PlayMusicParams FallbackMusicParams = PlayMusicParams() );
 	void PlayMusic( 
@@ -53,6 +57,11 @@ public:
 		bool align_beat = true,
 		bool bApplyMusicRate = false );
 	void StopMusic() { PlayMusic(""); }
+	/* Open the files and decode the first few seconds from fStartSecond in the
+	 * background, nearest to being played first, so PlayMusic can start them
+	 * without waiting on the disk.  This replaces whatever is still queued from
+	 * the last call; an empty list also frees everything prefetched. */
+	void PrefetchMusic( const vector<PlayMusicParams> &aParams );
 	void DimMusic( float fVolume, float fDurationSeconds );
 	RString GetMusicPath() const;
 	void Flush();
@@ -643,7 +643,7 @@ void GameState::SavePlayerProfile( PlayerNumber pn )
 		MEMCARDMAN->MountCard( pn );
 	PROFILEMAN->SaveProfile( pn );
 	if( bWasMemoryCard )
-		MEMCARDMAN->UnmountCard( pn );
+		MEMCARDMAN->UnmountCardWhenSaved( pn );
 }
 
 bool GameState::HaveProfileToLoad()
@@ -2335,6 +2335,12 @@ void GameState::StoreRankingName( PlayerNumber pn, RString sName )
 		m_vpsNamesThatWereFilled.push_back( aFeats[i].pStringToFill );
 	}
 
+	// The journals only hold new scores, not names filled in afterwards.
+	if( !aFeats.empty() )
+	{
+		PROFILEMAN->GetMachineProfile()->InvalidateStatsJournal();
+		PROFILEMAN->GetProfile( pn )->InvalidateStatsJournal();
+	}
 
 	Profile *pProfile = PROFILEMAN->GetMachineProfile();
 
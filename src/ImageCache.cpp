@@ -17,11 +17,20 @@
 #include "RageSurfaceUtils_Dither.h"
 #include "RageSurfaceUtils_Zoom.h"
 #include "SpecialFiles.h"
+#include "RageThreads.h"
+#include "RageUtil_BackgroundLoader.h"
 
 #include "Banner.h"
 
+#include <thread>
+
 static Preference<bool> g_bPalettedImageCache( "PalettedImageCache", false );
 
+/* Songs may be loaded from several threads at once (see SongLoadThreads),
+ * and each of them can cache and preload images.  This protects
+ * g_ImagePathToImage and ImageData while they do. */
+static RageMutex g_ImageCacheMutex( "ImageCache" );
+
 /* Neither a global or a file scope static can be used for this because
  * the order of initialization of nonlocal objects is unspecified. */
 //const RString IMAGE_CACHE_INDEX = SpecialFiles::CACHE_DIR + "images.cache";
@@ -57,9 +66,26 @@ RString ImageCache::GetImageCachePath( RString sImageDir ,RString sImagePath )
 	return SongCacheIndex::GetCacheFilePath( sImageDir, sImagePath );
 }
 
+namespace
+{
+	class LoadCachedImageJob: public BackgroundLoader::Job
+	{
+	public:
+		LoadCachedImageJob( const RString &sImagePath, const RString &sCachePath ):
+			m_sImagePath(sImagePath), m_sCachePath(sCachePath), m_pImage(nullptr) { }
+		~LoadCachedImageJob() { delete m_pImage; }
+		void Load() { m_pImage = RageSurfaceUtils::LoadSurface( m_sCachePath ); }
+
+		RString m_sImagePath;
+		RString m_sCachePath;
+		RageSurface *m_pImage;
+	};
+}
+
 /* If in on-demand mode, load all cached images.  This must be fast, so
  * cache files will not be created if they don't exist; that should be done
- * by CacheImage or LoadImage on startup. */
+ * by CacheImage or LoadImage on startup.  The files are read on as many
+ * threads as there are CPUs. */
 void ImageCache::Demand( RString sImageDir )
 {
 	++g_iDemandRefcount;
@@ -69,6 +95,7 @@ void ImageCache::Demand( RString sImageDir )
 	if( PREFSMAN->m_ImageCache != IMGCACHE_LOW_RES_LOAD_ON_DEMAND )
 		return;
 
+	BackgroundLoader loader( "ImageCache", max(1, (int) std::thread::hardware_concurrency()) );
 	FOREACH_CONST_Child( &ImageData, p )
 	{
 		RString sImagePath = p->GetName();
@@ -76,14 +103,18 @@ void ImageCache::Demand( RString sImageDir )
 		if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
 			continue; /* already loaded */
 
-		const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
-		RageSurface *pImage = RageSurfaceUtils::LoadSurface( sCachePath );
-		if( pImage == nullptr )
+		loader.Queue( new LoadCachedImageJob(sImagePath, GetImageCachePath(sImageDir,sImagePath)) );
+	}
+
+	while( BackgroundLoader::Job *p = loader.WaitForFinished() )
+	{
+		LoadCachedImageJob *pJob = static_cast<LoadCachedImageJob *>( p );
+		if( pJob->m_pImage != nullptr ) /* null if it doesn't exist */
 		{
-			continue; /* doesn't exist */
+			g_ImagePathToImage[pJob->m_sImagePath] = pJob->m_pImage;
+			pJob->m_pImage = nullptr;
 		}
-
-		g_ImagePathToImage[sImagePath] = pImage;
+		delete pJob;
 	}
 }
 
@@ -112,6 +143,8 @@ void ImageCache::LoadImage( RString sImageDir, RString sImagePath )
 	    PREFSMAN->m_ImageCache != IMGCACHE_LOW_RES_LOAD_ON_DEMAND )
 		return;
 
+	LockMut( g_ImageCacheMutex );
+
 	/* Load it. */
 	const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
 
@@ -342,6 +375,8 @@ void ImageCache::CacheImage( RString sImageDir, RString sImagePath )
 	if( !DoesFileExist(sImagePath) )
 		return;
 
+	LockMut( g_ImageCacheMutex );
+
 	const RString sCachePath = GetImageCachePath(sImageDir, sImagePath);
 
 	/* Check the full file hash.  If it's the loaded and identical, don't recache. */
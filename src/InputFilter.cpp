@@ -93,6 +93,11 @@ namespace
 
 	DeviceInputList g_CurrentState;
 	set<DeviceInput> g_DisableRepeat;
+
+	/* Latency histogram buckets, in seconds.  Presses slower than the last
+	 * one are counted in an extra bucket.  Also protected by queuemutex. */
+	const float g_fLatencyBuckets[] = { 0.0005f, 0.001f, 0.002f, 0.004f, 0.008f, 0.016f, 0.032f };
+	int g_iLatencyCounts[ARRAYLEN(g_fLatencyBuckets)+1];
 }
 
 /* Some input devices require debouncing. Do this on both press and release.
@@ -215,6 +220,12 @@ void InputFilter::ButtonPressed( const DeviceInput &di )
 	{
 		bs.m_BeingHeld = Down;
 		bs.m_BeingHeldTime = di.ts;
+
+		const float fLatency = now - di.ts;
+		unsigned iBucket = 0;
+		while( iBucket < ARRAYLEN(g_fLatencyBuckets) && fLatency > g_fLatencyBuckets[iBucket] )
+			++iBucket;
+		++g_iLatencyCounts[iBucket];
 	}
 
 	// Try to report presses immediately.
@@ -465,6 +476,25 @@ void InputFilter::GetPressedButtons( vector<DeviceInput> &array ) const
 	array = g_CurrentState;
 }
 
+void InputFilter::GetLatencyHistogram( vector<InputLatencyBucket> &aBucketsOut ) const
+{
+	LockMut(*queuemutex);
+	aBucketsOut.clear();
+	for( unsigned i = 0; i < ARRAYLEN(g_iLatencyCounts); ++i )
+	{
+		InputLatencyBucket b;
+		b.fMaxSeconds = i < ARRAYLEN(g_fLatencyBuckets)? g_fLatencyBuckets[i]:-1;
+		b.iCount = g_iLatencyCounts[i];
+		aBucketsOut.push_back( b );
+	}
+}
+
+void InputFilter::ResetLatencyHistogram()
+{
+	LockMut(*queuemutex);
+	ZERO( g_iLatencyCounts );
+}
+
 void InputFilter::UpdateCursorLocation(float _fX, float _fY)
 {
 	m_MouseCoords.fX = _fX;
@@ -44,6 +44,15 @@ struct MouseCoordinates
 	float fZ;
 };
 
+/** @brief How many presses and releases reached InputFilter within a given
+ * time of the driver's timestamp. */
+struct InputLatencyBucket
+{
+	/** @brief The upper end of the bucket, or -1 for everything slower. */
+	float fMaxSeconds;
+	int iCount;
+};
+
 class RageMutex;
 struct ButtonState;
 class InputFilter
@@ -73,6 +82,11 @@ public:
 	void GetInputEvents( vector<InputEvent> &aEventOut );
 	void GetPressedButtons( vector<DeviceInput> &array ) const;
 
+	/* How long presses and releases took to get from the driver's timestamp
+	 * to here, for checking input drivers in ScreenTestInput. */
+	void GetLatencyHistogram( vector<InputLatencyBucket> &aBucketsOut ) const;
+	void ResetLatencyHistogram();
+
 	// cursor
 	void UpdateCursorLocation(float _fX, float _fY);
 	void UpdateMouseWheel(float _fZ);
@@ -12,6 +12,7 @@
 #include "RageTypes.h"
 #include "MessageManager.h"
 #include "ver.h"
+#include "RageProfiler.h"
 
 #include <sstream> // conversion for lua functions.
 #include <csetjmp>
@@ -835,7 +836,11 @@ bool LuaHelpers::RunScriptOnStack( Lua *L, RString &Error, int Args, int ReturnV
 	lua_insert( L, ErrFunc );
 
 	// evaluate
-	int ret = lua_pcall( L, Args, ReturnValues, ErrFunc );
+	int ret;
+	{
+		PROFILE_SCOPE( ProfileZone_Lua );
+		ret = lua_pcall( L, Args, ReturnValues, ErrFunc );
+	}
 	if( ret )
 	{
 		if(ReportError)
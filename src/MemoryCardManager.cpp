@@ -11,6 +11,8 @@
 #include "RageUtil_WorkerThread.h"
 #include "arch/MemoryCard/MemoryCardDriver_Null.h"
 #include "LuaManager.h"
+#include "ProfileManager.h"
+#include "ProfileSaveQueue.h"
 
 MemoryCardManager*	MEMCARDMAN = nullptr;	// global and accessible from anywhere in our program
 
@@ -273,6 +275,7 @@ MemoryCardManager::MemoryCardManager()
 	{
 		m_bCardLocked[p] = false;
 		m_bMounted[p] = false;
+		m_bUnmountWhenSaved[p] = false;
 		m_State[p] = MemoryCardState_NoCard;
 	}
 	
@@ -309,6 +312,12 @@ MemoryCardManager::~MemoryCardManager()
 
 void MemoryCardManager::Update()
 {
+	FOREACH_PlayerNumber( pn )
+	{
+		if( m_bUnmountWhenSaved[pn] && !PROFILEMAN->GetSaveQueue()->IsSaving(MEM_CARD_MOUNT_POINT[pn]) )
+			UnmountCard( pn );
+	}
+
 	vector<UsbStorageDevice> vOld;
 	
 	vOld = m_vStorageDevices;	// copy
@@ -584,6 +593,13 @@ bool MemoryCardManager::MountCard( PlayerNumber pn, int iTimeout )
 		return false;
 	ASSERT( !m_Device[pn].IsBlank() );
 
+	// It's still mounted from the last save; just keep it that way.
+	if( m_bUnmountWhenSaved[pn] )
+	{
+		m_bUnmountWhenSaved[pn] = false;
+		return true;
+	}
+
 	// Pause the mounting thread when we mount the first drive.
 	bool bStartingMemoryCardAccess = true;
 	FOREACH_PlayerNumber( p )
@@ -634,6 +650,14 @@ bool MemoryCardManager::MountCard( PlayerNumber pn, const UsbStorageDevice &d, i
 	return MountCard( pn, iTimeout );
 }
 
+/* Called when finished saving a profile to a memory card.  The card is unmounted
+ * by Update once the save is written. */
+void MemoryCardManager::UnmountCardWhenSaved( PlayerNumber pn )
+{
+	if( m_bMounted[pn] )
+		m_bUnmountWhenSaved[pn] = true;
+}
+
 /* Called when finished accessing a memory card.  If writes have been performed,
  * will block until flushed. */
 void MemoryCardManager::UnmountCard( PlayerNumber pn )
@@ -645,6 +669,10 @@ void MemoryCardManager::UnmountCard( PlayerNumber pn )
 	if( !m_bMounted[pn] )
 		return;
 
+	// Don't pull the card out from under a profile save.
+	m_bUnmountWhenSaved[pn] = false;
+	PROFILEMAN->GetSaveQueue()->Wait( MEM_CARD_MOUNT_POINT[pn] );
+
 	// Leave our own filesystem drivers mounted.  Unmount the kernel mount.
 	g_pWorker->Unmount( &m_Device[pn] );
 
@@ -28,6 +28,9 @@ public:
 	bool MountCard( PlayerNumber pn, int iTimeout = 10 );
 	bool MountCard( PlayerNumber pn, const UsbStorageDevice &d, int iTimeout = 10 );
 	void UnmountCard( PlayerNumber pn );
+	/* Unmount the card once the profile saves to it have been written, from
+	 * Update, instead of waiting for them. */
+	void UnmountCardWhenSaved( PlayerNumber pn );
 
 	bool IsMounted( PlayerNumber pn ) const { return m_bMounted[pn]; }
 
@@ -62,6 +65,7 @@ protected:
 
 	bool	m_bCardLocked[NUM_PLAYERS];
 	bool	m_bMounted[NUM_PLAYERS];	// card is currently mounted
+	bool	m_bUnmountWhenSaved[NUM_PLAYERS];
 
 	UsbStorageDevice m_Device[NUM_PLAYERS];	// device in the memory card slot, blank if none
 	UsbStorageDevice m_FinalDevice[NUM_PLAYERS];	// device in the memory card slot when we finalized, blank if none
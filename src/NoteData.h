@@ -2,6 +2,9 @@
 #define NOTE_DATA_H
 
 #include "NoteTypes.h"
+#if defined(WITH_FLAT_NOTEDATA)
+#include "FlatTrackMap.h"
+#endif
 #include <map>
 #include <set>
 #include <iterator>
@@ -27,11 +30,17 @@
 class NoteData
 {
 public:
+#if defined(WITH_FLAT_NOTEDATA)
+	/* Each track is a sorted vector.  Adding or removing a note invalidates
+	 * the iterators after it in that track; see FlatTrackMap. */
+	typedef FlatTrackMap TrackMap;
+#else
 	typedef map<int,TapNote> TrackMap;
-	typedef map<int,TapNote>::iterator iterator;
-	typedef map<int,TapNote>::const_iterator const_iterator;
-	typedef map<int,TapNote>::reverse_iterator reverse_iterator;
-	typedef map<int,TapNote>::const_reverse_iterator const_reverse_iterator;
+#endif
+	typedef TrackMap::iterator iterator;
+	typedef TrackMap::const_iterator const_iterator;
+	typedef TrackMap::reverse_iterator reverse_iterator;
+	typedef TrackMap::const_reverse_iterator const_reverse_iterator;
 
 	NoteData(): m_TapNotes() {}
 
@@ -188,7 +197,9 @@ public:
 
 	inline iterator FindTapNote( unsigned iTrack, int iRow )	{ return m_TapNotes[iTrack].find( iRow ); }
 	inline const_iterator FindTapNote( unsigned iTrack, int iRow ) const { return m_TapNotes[iTrack].find( iRow ); }
-	void RemoveTapNote( unsigned iTrack, iterator it )		{ m_TapNotes[iTrack].erase( it ); }
+	/** @brief Remove a note, returning the one after it.  Use the returned
+	 * iterator to keep going; with WITH_FLAT_NOTEDATA, it++ isn't safe. */
+	iterator RemoveTapNote( unsigned iTrack, iterator it )		{ return m_TapNotes[iTrack].erase( it ); }
 
 	/**
 	 * @brief Return an iterator range for [rowBegin,rowEnd).
@@ -248,19 +248,19 @@ static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sS
 	for( int t=0; t<out.GetNumTracks(); t++ )
 	{
 		NoteData::iterator begin = out.begin( t );
-		NoteData::iterator lEnd = out.end( t );
-		while( begin != lEnd )
+		while( begin != out.end(t) )
 		{
-			NoteData::iterator next = Increment( begin );
 			const TapNote &tn = begin->second;
 			if( tn.type == TapNoteType_HoldHead && tn.iDuration == MAX_NOTE_ROW )
 			{
 				int iRow = begin->first;
 				LOG->UserLog( "", "", "While loading .sm/.ssc note data, there was an unmatched 2 at beat %f", NoteRowToBeat(iRow) );
-				out.RemoveTapNote( t, begin );
+				begin = out.RemoveTapNote( t, begin );
+			}
+			else
+			{
+				++begin;
 			}
-
-			begin = next;
 		}
 	}
 	out.RevalidateATIs(vector<int>(), false);
@@ -321,23 +321,22 @@ void NoteDataUtil::InsertHoldTails( NoteData &inout )
 {
 	for( int t=0; t < inout.GetNumTracks(); t++ )
 	{
-		NoteData::iterator begin = inout.begin(t), end = inout.end(t);
-
-		for( ; begin != end; ++begin )
+		// Walk by row, not by iterator: adding a tail may move the notes
+		// after it.
+		FOREACH_NONEMPTY_ROW_IN_TRACK( inout, t, iRow )
 		{
-			int iRow = begin->first;
-			const TapNote &tn = begin->second;
+			const TapNote &tn = inout.GetTapNote( t, iRow );
 			if( tn.type != TapNoteType_HoldHead )
 				continue;
 
 			TapNote tail = tn;
 			tail.type = TapNoteType_HoldTail;
 
-			/* If iDuration is 0, we'd end up overwriting the head with the tail
-			 * (and invalidating our iterator). Empty hold notes aren't valid. */
+			/* If iDuration is 0, we'd end up overwriting the head with the tail.
+			 * Empty hold notes aren't valid. */
 			ASSERT( tn.iDuration != 0 );
 
-			inout.SetTapNote( t, iRow + tn.iDuration, tail );
+			inout.SetTapNote( t, iRow + tail.iDuration, tail );
 		}
 	}
 }
@@ -430,6 +429,200 @@ void NoteDataUtil::GetSMNoteDataString( const NoteData &in, RString &sRet )
 	}
 }
 
+/* Packed note data is, after a version byte, the number of tracks, and then
+ * for each track the number of notes and the notes in order.  Numbers are
+ * varints.  Each note is:
+ *
+ *   the rows since the last note in the track (or since row 0)
+ *   a byte: the TapNoteType, PACKED_DURATION, PACKED_EXTRA
+ *   the hold length, if PACKED_DURATION
+ *   a byte of PACKED_EXTRA_* flags and the fields they flag, if PACKED_EXTRA
+ *
+ * so a tap is usually two bytes, and a hold three or four. */
+static const unsigned char PACKED_NOTE_DATA_VERSION = 1;
+static const unsigned char PACKED_TYPE_MASK = 0x0F;
+static const unsigned char PACKED_DURATION = 0x10;
+static const unsigned char PACKED_EXTRA = 0x20;
+static const unsigned char PACKED_EXTRA_SUBTYPE = 0x01;
+static const unsigned char PACKED_EXTRA_KEYSOUND = 0x02;
+static const unsigned char PACKED_EXTRA_ATTACK = 0x04;
+static const unsigned char PACKED_EXTRA_SOURCE = 0x08;
+static const unsigned char PACKED_EXTRA_PLAYER = 0x10;
+
+static void PutVarint( RString &s, unsigned iVal )
+{
+	while( iVal >= 0x80 )
+	{
+		s.append( 1, char((iVal & 0x7F) | 0x80) );
+		iVal >>= 7;
+	}
+	s.append( 1, char(iVal) );
+}
+
+namespace
+{
+	struct PackedReader
+	{
+		PackedReader( const RString &s ): p((const unsigned char *) s.data()), pEnd(p + s.size()), bError(false) { }
+		const unsigned char *p, *pEnd;
+		bool bError;
+
+		unsigned char GetByte()
+		{
+			if( p == pEnd )
+			{
+				bError = true;
+				return 0;
+			}
+			return *p++;
+		}
+
+		unsigned GetVarint()
+		{
+			unsigned iVal = 0;
+			for( int iShift = 0; iShift < 32; iShift += 7 )
+			{
+				unsigned char c = GetByte();
+				iVal |= unsigned(c & 0x7F) << iShift;
+				if( !(c & 0x80) )
+					return iVal;
+			}
+			bError = true;
+			return 0;
+		}
+	};
+}
+
+void NoteDataUtil::GetPackedNoteData( const NoteData &in, RString &sRet )
+{
+	sRet = RString();
+	sRet.append( 1, char(PACKED_NOTE_DATA_VERSION) );
+	PutVarint( sRet, in.GetNumTracks() );
+	for( int t = 0; t < in.GetNumTracks(); ++t )
+	{
+		PutVarint( sRet, distance(in.begin(t), in.end(t)) );
+
+		int iLastRow = 0;
+		for( NoteData::const_iterator it = in.begin(t); it != in.end(t); ++it )
+		{
+			const TapNote &tn = it->second;
+			ASSERT( it->first >= iLastRow );
+			PutVarint( sRet, it->first - iLastRow );
+			iLastRow = it->first;
+
+			const TapNoteSubType DefaultSubType = tn.type == TapNoteType_HoldHead? TapNoteSubType_Hold:TapNoteSubType_Invalid;
+			unsigned char iExtra = 0;
+			if( tn.subType != DefaultSubType )
+				iExtra |= PACKED_EXTRA_SUBTYPE;
+			if( tn.iKeysoundIndex >= 0 )
+				iExtra |= PACKED_EXTRA_KEYSOUND;
+			if( tn.type == TapNoteType_Attack )
+				iExtra |= PACKED_EXTRA_ATTACK;
+			if( tn.source != TapNoteSource_Original )
+				iExtra |= PACKED_EXTRA_SOURCE;
+			if( tn.pn != PLAYER_INVALID )
+				iExtra |= PACKED_EXTRA_PLAYER;
+
+			unsigned char iType = tn.type;
+			if( tn.iDuration != 0 )
+				iType |= PACKED_DURATION;
+			if( iExtra != 0 )
+				iType |= PACKED_EXTRA;
+			sRet.append( 1, char(iType) );
+
+			if( iType & PACKED_DURATION )
+				PutVarint( sRet, tn.iDuration );
+			if( iExtra == 0 )
+				continue;
+
+			sRet.append( 1, char(iExtra) );
+			if( iExtra & PACKED_EXTRA_SUBTYPE )
+				PutVarint( sRet, tn.subType );
+			if( iExtra & PACKED_EXTRA_KEYSOUND )
+				PutVarint( sRet, tn.iKeysoundIndex );
+			if( iExtra & PACKED_EXTRA_ATTACK )
+			{
+				PutVarint( sRet, tn.sAttackModifiers.size() );
+				sRet.append( tn.sAttackModifiers );
+				char buf[sizeof(float)];
+				memcpy( buf, &tn.fAttackDurationSeconds, sizeof(buf) );
+				sRet.append( buf, sizeof(buf) );
+			}
+			if( iExtra & PACKED_EXTRA_SOURCE )
+				PutVarint( sRet, tn.source );
+			if( iExtra & PACKED_EXTRA_PLAYER )
+				PutVarint( sRet, tn.pn );
+		}
+	}
+}
+
+bool NoteDataUtil::LoadFromPackedNoteData( NoteData &out, const RString &sPacked )
+{
+	PackedReader r( sPacked );
+	out.ClearAll();
+	if( r.GetByte() != PACKED_NOTE_DATA_VERSION || int(r.GetVarint()) != out.GetNumTracks() )
+		return false;
+
+	for( int t = 0; t < out.GetNumTracks() && !r.bError; ++t )
+	{
+		const unsigned iNotes = r.GetVarint();
+		int iRow = 0;
+		for( unsigned i = 0; i < iNotes && !r.bError; ++i )
+		{
+			iRow += r.GetVarint();
+
+			TapNote tn;
+			const unsigned char iType = r.GetByte();
+			if( (iType & PACKED_TYPE_MASK) >= NUM_TapNoteType )
+			{
+				r.bError = true;
+				break;
+			}
+			tn.type = TapNoteType( iType & PACKED_TYPE_MASK );
+			if( tn.type == TapNoteType_HoldHead )
+				tn.subType = TapNoteSubType_Hold;
+			if( iType & PACKED_DURATION )
+				tn.iDuration = r.GetVarint();
+
+			if( iType & PACKED_EXTRA )
+			{
+				const unsigned char iExtra = r.GetByte();
+				if( iExtra & PACKED_EXTRA_SUBTYPE )
+					tn.subType = TapNoteSubType( r.GetVarint() );
+				if( iExtra & PACKED_EXTRA_KEYSOUND )
+					tn.iKeysoundIndex = r.GetVarint();
+				if( iExtra & PACKED_EXTRA_ATTACK )
+				{
+					const unsigned iLen = r.GetVarint();
+					if( r.bError || unsigned(r.pEnd - r.p) < iLen + sizeof(float) )
+					{
+						r.bError = true;
+						break;
+					}
+					tn.sAttackModifiers.assign( (const char *) r.p, iLen );
+					memcpy( &tn.fAttackDurationSeconds, r.p + iLen, sizeof(float) );
+					r.p += iLen + sizeof(float);
+				}
+				if( iExtra & PACKED_EXTRA_SOURCE )
+					tn.source = TapNoteSource( r.GetVarint() );
+				if( iExtra & PACKED_EXTRA_PLAYER )
+					tn.pn = PlayerNumber( r.GetVarint() );
+			}
+
+			out.SetTapNote( t, iRow, tn );
+		}
+	}
+
+	// Anything left over means the data isn't what we think it is.
+	if( r.bError || r.p != r.pEnd )
+	{
+		out.ClearAll();
+		return false;
+	}
+	out.RevalidateATIs( vector<int>(), false );
+	return true;
+}
+
 void NoteDataUtil::SplitCompositeNoteData( const NoteData &in, vector<NoteData> &out )
 {
 	if( !in.IsComposite() )
@@ -1333,7 +1526,7 @@ void NoteDataUtil::RemoveAllButPlayer( NoteData &inout, PlayerNumber pn )
 		while( i != inout.end(track) )
 		{
 			if( i->second.pn != pn && i->second.pn != PLAYER_INVALID )
-				inout.RemoveTapNote( track, i++ );
+				i = inout.RemoveTapNote( track, i );
 			else
 				++i;
 		}
@@ -2902,16 +3095,16 @@ void NoteDataUtil::DeleteRows( NoteData &nd, int iStartIndex, int iRowsToDelete
 
 void NoteDataUtil::RemoveAllTapsOfType( NoteData& ndInOut, TapNoteType typeToRemove )
 {
-	/* Be very careful when deleting the tap notes. Erasing elements from maps using
-	 * iterators invalidates only the iterator that is being erased. To that end,
-	 * increment the iterator before deleting the elment of the map.
+	/* Be very careful when deleting the tap notes. Erasing a note invalidates
+	 * its iterator (and, with WITH_FLAT_NOTEDATA, the ones after it), so carry
+	 * on from the iterator RemoveTapNote returns.
 	 */
 	for( int t=0; t<ndInOut.GetNumTracks(); t++ )
 	{
 		for( NoteData::iterator iter = ndInOut.begin(t); iter != ndInOut.end(t); )
 		{
 			if( iter->second.type == typeToRemove )
-				ndInOut.RemoveTapNote( t, iter++ );
+				iter = ndInOut.RemoveTapNote( t, iter );
 			else
 				++iter;
 		}
@@ -2927,7 +3120,7 @@ void NoteDataUtil::RemoveAllTapsExceptForType( NoteData& ndInOut, TapNoteType ty
 		for( NoteData::iterator iter = ndInOut.begin(t); iter != ndInOut.end(t); )
 		{
 			if( iter->second.type != typeToKeep )
-				ndInOut.RemoveTapNote( t, iter++ );
+				iter = ndInOut.RemoveTapNote( t, iter );
 			else
 				++iter;
 		}
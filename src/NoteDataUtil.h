@@ -27,6 +27,14 @@ namespace NoteDataUtil
 	NoteType GetSmallestNoteTypeInRange( const NoteData &nd, int iStartIndex, int iEndIndex );
 	void LoadFromSMNoteDataString( NoteData &out, const RString &sSMNoteData, bool bComposite );
 	void GetSMNoteDataString( const NoteData &in, RString &notes_out );
+	/**
+	 * @brief Pack NoteData into a compact binary string, for keeping charts
+	 * in memory.  This is much smaller than the SM text and faster to load,
+	 * but it isn't a file format: it may change between versions. */
+	void GetPackedNoteData( const NoteData &in, RString &sPackedOut );
+	/** @brief Load NoteData packed with GetPackedNoteData.  out must have its
+	 * tracks set.  Returns false, leaving out empty, if the data is damaged. */
+	bool LoadFromPackedNoteData( NoteData &out, const RString &sPacked );
 	void SplitCompositeNoteData( const NoteData &in, vector<NoteData> &out );
 	void CombineCompositeNoteData( NoteData &out, const vector<NoteData> &in );
 	/**
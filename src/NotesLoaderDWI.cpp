@@ -9,6 +9,7 @@
 #include "Steps.h"
 #include "GameInput.h"
 #include "NotesLoader.h"
+#include "RageThreads.h"
 #include "PrefsManager.h"
 #include "Difficulty.h"
 
@@ -17,6 +18,8 @@
 Difficulty DwiCompatibleStringToDifficulty( const RString& sDC );
 
 static std::map<int,int> g_mapDanceNoteToNoteDataColumn;
+/** @brief Guards g_mapDanceNoteToNoteDataColumn when songs load in parallel. */
+static RageMutex g_DanceNoteMapMutex( "DWILoader" );
 
 /** @brief The different types of core DWI arrows and pads. */
 enum DanceNotes
@@ -187,6 +190,7 @@ static StepsType GetTypeFromMode(const RString &mode)
 static NoteData ParseNoteData(RString &step1, RString &step2,
 			      Steps &out, const RString &path)
 {
+	LockMut( g_DanceNoteMapMutex );
 	g_mapDanceNoteToNoteDataColumn.clear();
 	switch( out.m_StepsType )
 	{
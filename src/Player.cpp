@@ -747,23 +747,14 @@ void Player::Load()
 	// a separate object, used alongside ScreenGameplay::m_pSoundMusic and ScreenEdit::m_pSoundMusic?)
 	// We don't have to load separate copies to set player fade: always make a copy, and set the
 	// fade on the copy.
+	// The decoded sounds themselves are shared through RageSoundKeysoundBank.
 	RString sSongDir = pSong->GetSongDir();
-	m_vKeysounds.resize( pSong->m_vsKeysoundFile.size() );
-
-	// parameters are invalid somehow... -aj
-	RageSoundLoadParams SoundParams;
-	SoundParams.m_bSupportPan = true;
+	vector<RString> asKeysoundPaths;
+	for (RString const &sFile : pSong->m_vsKeysoundFile)
+		asKeysoundPaths.push_back( sSongDir + sFile );
 
 	float fBalance = GameSoundManager::GetPlayerBalance( pn );
-	for( unsigned i=0; i<m_vKeysounds.size(); i++ )
-	{
-		RString sKeysoundFilePath = sSongDir + pSong->m_vsKeysoundFile[i];
-		RageSound& sound = m_vKeysounds[i];
-		if( sound.GetLoadedFilePath() != sKeysoundFilePath )
-			sound.Load( sKeysoundFilePath, true, &SoundParams );
-		sound.SetProperty( "Pan", fBalance );
-		sound.SetStopModeFromString( "stop" );
-	}
+	m_Keysounds.Load( asKeysoundPaths, fBalance );
 
 	if( m_pPlayerStageStats )
 		SendComboMessages( m_pPlayerStageStats->m_iCurCombo, m_pPlayerStageStats->m_iCurMissCombo );
@@ -1548,10 +1539,10 @@ void Player::UpdateHoldNotes( int iSongRow, float fDeltaTime, vector<TrackRowTap
 		{
 			float fVol = pVolume->Get();
 
-			if( tn.iKeysoundIndex >= 0 && tn.iKeysoundIndex < (int) m_vKeysounds.size() )
+			if( tn.iKeysoundIndex >= 0 && tn.iKeysoundIndex < m_Keysounds.GetNumSounds() )
 			{
 				float factor = (tn.subType == TapNoteSubType_Roll ? 2.0f * fLifeFraction : 10.0f * fLifeFraction - 8.5f);
-				m_vKeysounds[tn.iKeysoundIndex].SetProperty ("Volume", max(0.0f, min(1.0f, factor)) * fVol);
+				m_Keysounds.SetVolume( tn.iKeysoundIndex, max(0.0f, min(1.0f, factor)) * fVol );
 			}
 		}
 	}
@@ -2022,10 +2013,16 @@ void Player::ScoreAllActiveHoldsLetGo()
 	}
 }
 
+static float GetKeysoundVolume()
+{
+	Preference<float> *pVolume = Preference<float>::GetPreferenceByName("SoundVolume");
+	return pVolume->Get();
+}
+
 void Player::PlayKeysound( const TapNote &tn, TapNoteScore score )
 {
 	// tap note must have keysound
-	if( tn.iKeysoundIndex >= 0 && tn.iKeysoundIndex < (int) m_vKeysounds.size() )
+	if( tn.iKeysoundIndex >= 0 && tn.iKeysoundIndex < m_Keysounds.GetNumSounds() )
 	{
 		// handle a case for hold notes
 		if( tn.type == TapNoteType_HoldHead )
@@ -2038,7 +2035,7 @@ void Player::PlayKeysound( const TapNote &tn, TapNoteScore score )
 				if( tns != TNS_None && tns != TNS_Miss && score == TNS_None )
 				{
 					// the sound must also be already playing
-					if( m_vKeysounds[tn.iKeysoundIndex].IsPlaying() )
+					if( m_Keysounds.IsPlaying(tn.iKeysoundIndex) )
 					{
 						// if all of these conditions are met, don't play the sound.
 						return;
@@ -2046,10 +2043,7 @@ void Player::PlayKeysound( const TapNote &tn, TapNoteScore score )
 				}
 			}
 		}
-		m_vKeysounds[tn.iKeysoundIndex].Play(false);
-		Preference<float> *pVolume = Preference<float>::GetPreferenceByName("SoundVolume");
-		float fVol = pVolume->Get();
-		m_vKeysounds[tn.iKeysoundIndex].SetProperty ("Volume", fVol);
+		m_Keysounds.Play( tn.iKeysoundIndex, GetKeysoundVolume() );
 	}
 }
 
@@ -2653,6 +2647,7 @@ void Player::UpdateJudgedRows()
 	{
 		bAllJudged = true;
 		set<RageSound *> setSounds;
+		set<int> setKeysounds;
 		NoteData::all_tracks_iterator iter = *m_pIterUnjudgedMineRows;	// copy
 		int iLastSeenRow = -1;
 		for( ; !iter.IsAtEnd()  &&  iter.Row() <= iEndRow; ++iter )
@@ -2693,8 +2688,8 @@ void Player::UpdateJudgedRows()
 			if( m_pNoteField )
 				m_pNoteField->DidTapNote( iter.Track(), tn.result.tns, false );
 
-			if( tn.iKeysoundIndex >= 0 && tn.iKeysoundIndex < (int) m_vKeysounds.size() )
-				setSounds.insert( &m_vKeysounds[tn.iKeysoundIndex] );
+			if( tn.iKeysoundIndex >= 0 && tn.iKeysoundIndex < m_Keysounds.GetNumSounds() )
+				setKeysounds.insert( tn.iKeysoundIndex );
 			else if( g_bEnableMineSoundPlayback )
 				setSounds.insert( &m_soundMine );
 
@@ -2741,6 +2736,11 @@ void Player::UpdateJudgedRows()
 			sound->Stop();
 			sound->Play(false);
 		}
+		for (int iKeysound : setKeysounds)
+		{
+			m_Keysounds.Stop( iKeysound );
+			m_Keysounds.Play( iKeysound, GetKeysoundVolume() );
+		}
 	}
 }
 
@@ -5,6 +5,7 @@
 #include "HoldJudgment.h"
 #include "NoteDataWithScoring.h"
 #include "RageSound.h"
+#include "RageSoundKeysoundBank.h"
 #include "AttackDisplay.h"
 #include "NoteData.h"
 #include "ScreenMessage.h"
@@ -228,7 +229,7 @@ protected:
 
 	vector<bool>	m_vbFretIsDown;
 
-	vector<RageSound>	m_vKeysounds;
+	RageSoundKeysounds	m_Keysounds;
 
 	ThemeMetric<float>	GRAY_ARROWS_Y_STANDARD;
 	ThemeMetric<float>	GRAY_ARROWS_Y_REVERSE;
@@ -8,6 +8,7 @@
 #include "RageFile.h"
 #include "RageUtil.h"
 #include "RageLog.h"
+#include "RageSoundReader_Resample_Good.h"
 #include "SpecialFiles.h"
 
 //DEFAULTS_INI_PATH	= "Data/Defaults.ini";		// these can be overridden
@@ -274,9 +275,11 @@ PrefsManager::PrefsManager() :
 	m_sVideoRenderers		( "VideoRenderers",			"" ),	// StepMania.cpp sets these on first run:
 	m_bSmoothLines			( "SmoothLines",			true ),
 	m_iSoundWriteAhead		( "SoundWriteAhead",			0 ),
+	m_bSoundLowLatency		( "SoundLowLatency",			false ),
 	m_iSoundDevice			( "SoundDevice",			"" ),
 	m_iRageSoundSampleCountClamp	("RageSoundSampleCountClamp", 0), //some sound drivers mask the sample location number, the most popular number for this is 2^27, this causes lockup after ~50 minutes at 44.1khz sample rate
 	m_iSoundPreferredSampleRate	( "SoundPreferredSampleRate",		0 ),
+	m_iSoundResampleQuality		( "SoundResampleQuality",		RageSoundReader_Resample_Good::RESAMP_NORMAL ),
 	m_sLightsStepsDifficulty	( "LightsStepsDifficulty",		"hard,medium" ),
 	m_bAllowUnacceleratedRenderer	( "AllowUnacceleratedRenderer",		false ),
 	m_bThreadedInput		( "ThreadedInput",			true ),
@@ -301,9 +304,13 @@ PrefsManager::PrefsManager() :
 	m_bLogToDisk			( "LogToDisk",		true ),
 #if defined(DEBUG)
 	m_bForceLogFlush		( "ForceLogFlush",	true ),
-	m_bShowLogOutput		( "ShowLogOutput",	true ),
 #else
 	m_bForceLogFlush		( "ForceLogFlush",	false ),
+#endif
+	m_bAsyncLog			( "AsyncLog",		true ),
+#if defined(DEBUG)
+	m_bShowLogOutput		( "ShowLogOutput",	true ),
+#else
 	m_bShowLogOutput		( "ShowLogOutput",	false ),
 #endif
 	m_bLogSkips			( "LogSkips",		false ),
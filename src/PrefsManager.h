@@ -289,9 +289,11 @@ public:
 	Preference<RString>	m_sVideoRenderers; // StepMania.cpp sets these on first run based on the card
 	Preference<bool>	m_bSmoothLines;
 	Preference<int>	m_iSoundWriteAhead;
+	Preference<bool>	m_bSoundLowLatency;
 	Preference<RString>	m_iSoundDevice;
 	Preference<int> m_iRageSoundSampleCountClamp;
 	Preference<int>	m_iSoundPreferredSampleRate;
+	Preference<int>	m_iSoundResampleQuality;
 	Preference<RString>	m_sLightsStepsDifficulty;
 	Preference<bool>	m_bAllowUnacceleratedRenderer;
 	Preference<bool>	m_bThreadedInput;
@@ -316,6 +318,7 @@ public:
 	// Debug:
 	Preference<bool>	m_bLogToDisk;
 	Preference<bool>	m_bForceLogFlush;
+	Preference<bool>	m_bAsyncLog;
 	Preference<bool>	m_bShowLogOutput;
 	Preference<bool>	m_bLogSkips;
 	Preference<bool>	m_bLogCheckpoints;
@@ -14,6 +14,7 @@
 #include "ThemeManager.h"
 #include "CryptManager.h"
 #include "ProfileManager.h"
+#include "ProfileSaveQueue.h"
 #include "RageFile.h"
 #include "RageFileDriverDeflate.h"
 #include "RageFileManager.h"
@@ -30,6 +31,8 @@
 
 const RString STATS_XML            = "Stats.xml";
 const RString STATS_XML_GZ         = "Stats.xml.gz";
+/** @brief The scores added since STATS_XML was written. See StatsJournal. */
+const RString STATS_JOURNAL        = "Stats.journal";
 /** @brief The filename for where one can edit their personal profile information. */
 const RString EDITABLE_INI         = "Editable.ini";
 /** @brief A tiny file containing the type and list priority. */
@@ -45,11 +48,13 @@ const RString RIVAL_SUBDIR         = "Rivals/";
 
 ThemeMetric<bool> SHOW_COIN_DATA( "Profile", "ShowCoinData" );
 static Preference<bool> g_bProfileDataCompress( "ProfileDataCompress", false );
+static Preference<bool> g_bProfileScoreJournal( "ProfileScoreJournal", true );
 static ThemeMetric<RString> UNLOCK_AUTH_STRING( "Profile", "UnlockAuthString" );
 #define GUID_SIZE_BYTES 8
 
 #define MAX_EDITABLE_INI_SIZE_BYTES			2*1024		// 2KB
 #define MAX_PLAYER_STATS_XML_SIZE_BYTES                 100*1024*1024   // 100MB
+#define MAX_STATS_JOURNAL_SIZE_BYTES			1024*1024	// 1MB
 
 const int DEFAULT_WEIGHT_POUNDS	= 120;
 const float DEFAULT_BIRTH_YEAR= 1995;
@@ -134,6 +139,12 @@ void Profile::ClearStats()
 	m_sGuid = sGuid;
 }
 
+void Profile::InvalidateStatsJournal()
+{
+	m_Journal.Clear();
+	m_sStatsXmlDir = "";
+}
+
 RString Profile::MakeGuid()
 {
 	RString s;
@@ -604,6 +615,12 @@ Course *Profile::GetMostPopularCourse() const
 // Steps high scores
 void Profile::AddStepsHighScore( const Song* pSong, const Steps* pSteps, HighScore hs, int &iIndexOut )
 {
+	SongID songID;
+	songID.FromSong( pSong );
+	StepsID stepsID;
+	stepsID.FromSteps( pSteps );
+	m_Journal.AddStepsScore( songID, stepsID, hs );
+
 	GetStepsHighScoreList(pSong,pSteps).AddHighScore( hs, iIndexOut, IsMachine() );
 }
 
@@ -679,6 +696,12 @@ void Profile::IncrementStepsPlayCount( const Song* pSong, const Steps* pSteps )
 {
 	DateTime now = DateTime::GetNowDate();
 	GetStepsHighScoreList(pSong,pSteps).IncrementPlayCount( now );
+
+	SongID songID;
+	songID.FromSong( pSong );
+	StepsID stepsID;
+	stepsID.FromSteps( pSteps );
+	m_Journal.IncrementStepsPlayCount( songID, stepsID, now );
 }
 
 void Profile::GetGrades( const Song* pSong, StepsType st, int iCounts[NUM_Grade] ) const
@@ -709,6 +732,12 @@ void Profile::GetGrades( const Song* pSong, StepsType st, int iCounts[NUM_Grade]
 // Course high scores
 void Profile::AddCourseHighScore( const Course* pCourse, const Trail* pTrail, HighScore hs, int &iIndexOut )
 {
+	CourseID courseID;
+	courseID.FromCourse( pCourse );
+	TrailID trailID;
+	trailID.FromTrail( pTrail );
+	m_Journal.AddCourseScore( courseID, trailID, hs );
+
 	GetCourseHighScoreList(pCourse,pTrail).AddHighScore( hs, iIndexOut, IsMachine() );
 }
 
@@ -781,6 +810,12 @@ void Profile::IncrementCoursePlayCount( const Course* pCourse, const Trail* pTra
 {
 	DateTime now = DateTime::GetNowDate();
 	GetCourseHighScoreList(pCourse,pTrail).IncrementPlayCount( now );
+
+	CourseID courseID;
+	courseID.FromCourse( pCourse );
+	TrailID trailID;
+	trailID.FromTrail( pTrail );
+	m_Journal.IncrementCoursePlayCount( courseID, trailID, now );
 }
 
 void Profile::GetAllUsedHighScoreNames(std::set<RString>& names)
@@ -822,6 +857,7 @@ void Profile::GetAllUsedHighScoreNames(std::set<RString>& names)
 void Profile::MergeScoresFromOtherProfile(Profile* other, bool skip_totals,
 	RString const& from_dir, RString const& to_dir)
 {
+	InvalidateStatsJournal();
 	if(!skip_totals)
 	{
 #define MERGE_FIELD(field_name) field_name+= other->field_name;
@@ -1004,6 +1040,9 @@ void Profile::swap(Profile& other)
 	}
 	SWAP_STR_MEMBER(m_vScreenshots);
 	SWAP_STR_MEMBER(m_mapDayToCaloriesBurned);
+	SWAP_GENERAL(m_Journal);
+	SWAP_STR_MEMBER(m_sStatsXmlDir);
+	SWAP_STR_MEMBER(m_sStatsID);
 #undef SWAP_STR_MEMBER
 #undef SWAP_GENERAL
 #undef SWAP_ARRAY
@@ -1012,6 +1051,7 @@ void Profile::swap(Profile& other)
 // Category high scores
 void Profile::AddCategoryHighScore( StepsType st, RankingCategory rc, HighScore hs, int &iIndexOut )
 {
+	m_Journal.AddCategoryScore( st, rc, hs );
 	m_CategoryHighScores[st][rc].AddHighScore( hs, iIndexOut, IsMachine() );
 }
 
@@ -1037,6 +1077,7 @@ void Profile::IncrementCategoryPlayCount( StepsType st, RankingCategory rc )
 {
 	DateTime now = DateTime::GetNowDate();
 	m_CategoryHighScores[st][rc].IncrementPlayCount( now );
+	m_Journal.IncrementCategoryPlayCount( st, rc, now );
 }
 
 
@@ -1156,6 +1197,9 @@ ProfileLoadResult Profile::LoadAllFromDir( RString sDir, bool bRequireSignature
 
 	ASSERT( sDir.Right(1) == "/" );
 
+	// Don't read files that are still being written.
+	PROFILEMAN->GetSaveQueue()->Wait( sDir );
+
 	InitAll();
 
 	LoadTypeFromDir(sDir);
@@ -1305,7 +1349,34 @@ ProfileLoadResult Profile::LoadStatsFromDir(RString dir, bool require_signature)
 		return ProfileLoadResult_FailedTampered;
 	LOG->Trace("Done.");
 
-	return LoadStatsXmlFromNode(&xml);
+	ProfileLoadResult ret = LoadStatsXmlFromNode(&xml);
+	if(ret != ProfileLoadResult_Success)
+		return ret;
+
+	m_Journal.Clear();
+	m_sStatsXmlDir = dir;
+	m_sStatsID = "";
+	xml.GetAttrValue( "ID", m_sStatsID );
+
+	// Replay the scores saved since stats.xml was written.
+	RString sJournal = dir + STATS_JOURNAL;
+	if(IsAFile(sJournal))
+	{
+		if(require_signature && !CryptManager::VerifyFileWithFile(sJournal, sJournal+SIGNATURE_APPEND))
+		{
+			LuaHelpers::ReportScriptErrorFmt("The signature check for '%s' failed.  Its scores will be ignored.", sJournal.c_str());
+			m_sStatsXmlDir = "";
+		}
+		else
+		{
+			LOG->Trace("Loading %s", sJournal.c_str());
+			if(!StatsJournal::Replay(sJournal, m_sStatsID, *this))
+				m_sStatsXmlDir = "";
+			LOG->Trace("Done.");
+		}
+	}
+
+	return ret;
 }
 
 void Profile::LoadTypeFromDir(RString dir)
@@ -1390,7 +1461,7 @@ bool Profile::SaveAllToDir( RString sDir, bool bSignData ) const
 	// Save editable.ini
 	SaveEditableDataToDir( sDir );
 
-	bool bSaved = SaveStatsXmlToDir( sDir, bSignData );
+	bool bSaved = SaveStatsJournalToDir( sDir, bSignData ) || SaveStatsXmlToDir( sDir, bSignData );
 
 	SaveStatsWebPageToDir( sDir );
 
@@ -1440,50 +1511,169 @@ XNode *Profile::SaveStatsXmlCreateNode() const
 	return xml;
 }
 
+/* Everything but the scores, which go in the journal records before this. */
+XNode *Profile::SaveStatsJournalCreateNode() const
+{
+	XNode *xml = new XNode( "Stats" );
+
+	xml->AppendChild( SaveGeneralDataCreateNode() );
+	xml->AppendChild( SaveScreenshotDataCreateNode() );
+	xml->AppendChild( SaveCalorieDataCreateNode() );
+	if( SHOW_COIN_DATA.GetValue() && IsMachine() )
+		xml->AppendChild( SaveCoinDataCreateNode() );
+
+	return xml;
+}
+
+bool Profile::SaveStatsJournalToDir( RString sDir, bool bSignData ) const
+{
+	if( !g_bProfileScoreJournal )
+		return false;
+
+	RString sStatsDir = sDir + PROFILEMAN->GetStatsPrefix();
+
+	ProfileSaveQueue *pQueue = PROFILEMAN->GetSaveQueue();
+
+	/* The journal only makes sense on top of the stats.xml it was started
+	 * from.  If that isn't the one in sDir, or the last save there failed,
+	 * write stats.xml in full. */
+	if( m_sStatsXmlDir.empty() || m_sStatsXmlDir != sStatsDir )
+		return false;
+	if( pQueue->TakeFailure(sDir) )
+		return false;
+
+	/* If the last save is still being written, the files aren't there yet,
+	 * but they will be by the time this is written. */
+	RString sJournal = sStatsDir + STATS_JOURNAL;
+	if( !pQueue->IsSaving(sDir) )
+	{
+		RString fn = sStatsDir + (g_bProfileDataCompress? STATS_XML_GZ:STATS_XML);
+		if( !FILEMAN->IsAFile(fn) )
+			return false;
+		if( bSignData && !FILEMAN->IsAFile(fn+SIGNATURE_APPEND) )
+			return false;
+
+		/* Once the journal is big, replaying it takes longer than loading the
+		 * scores from stats.xml, so fold it in. */
+		if( FILEMAN->IsAFile(sJournal) && FILEMAN->GetFileSizeInBytes(sJournal) >= MAX_STATS_JOURNAL_SIZE_BYTES )
+			return false;
+	}
+
+	LOG->Trace( "SaveStatsJournalToDir: %s", sStatsDir.c_str() );
+	ProfileSave *pSave = new ProfileSave;
+	pSave->sProfileDir = sDir;
+	pSave->sStatsDir = sStatsDir;
+	pSave->pStats.reset( SaveStatsJournalCreateNode() );
+	pSave->bJournal = true;
+	pSave->sJournalRecords = m_Journal.TakePending();
+	pSave->sStatsID = m_sStatsID;
+	pSave->bSignData = bSignData;
+	pQueue->Add( pSave );
+
+	return true;
+}
+
 bool Profile::SaveStatsXmlToDir( RString sDir, bool bSignData ) const
 {
 	LOG->Trace( "SaveStatsXmlToDir: %s", sDir.c_str() );
-	unique_ptr<XNode> xml( SaveStatsXmlCreateNode() );
+	ProfileSave *pSave = new ProfileSave;
+	pSave->sProfileDir = sDir;
+	pSave->sStatsDir = sDir + PROFILEMAN->GetStatsPrefix();
+	pSave->pStats.reset( SaveStatsXmlCreateNode() );
+	pSave->bCompress = g_bProfileDataCompress;
+	pSave->bSignData = bSignData;
+
+	/* Every score will be in stats.xml, so start a new journal.  If the
+	 * write fails, the next save finds out from TakeFailure.  The new ID
+	 * keeps the old journal from being replayed over this stats.xml, if a
+	 * crash stops it from being removed. */
+	m_Journal.Clear();
+	m_sStatsXmlDir = pSave->sStatsDir;
+	m_sStatsID = MakeGuid();
+	pSave->pStats->AppendAttr( "ID", m_sStatsID );
+	PROFILEMAN->GetSaveQueue()->TakeFailure( sDir );
+	PROFILEMAN->GetSaveQueue()->Add( pSave );
+
+	return true;
+}
+
+/* This runs in ProfileSaveQueue's thread, so it mustn't touch the profile,
+ * or Lua. */
+bool Profile::WriteStats( const ProfileSave &save )
+{
+	const RString &sDir = save.sStatsDir;
+	const XNode *xml = save.pStats.get();
+
+	if( save.bJournal )
+	{
+		RString sJournal = sDir + STATS_JOURNAL;
+		if( !StatsJournal::AppendToFile(sJournal, save.sStatsID, save.sJournalRecords, xml) )
+			return false;
+
+		if( save.bSignData )
+			CryptManager::SignFileToFile( sJournal, sJournal+SIGNATURE_APPEND );
+		return true;
+	}
 
-	sDir= sDir + PROFILEMAN->GetStatsPrefix();
 	// Save stats.xml
-	RString fn = sDir + (g_bProfileDataCompress? STATS_XML_GZ:STATS_XML);
+	RString fn = sDir + (save.bCompress? STATS_XML_GZ:STATS_XML);
 
 	{
 		RString sError;
 		RageFile f;
-		if( !f.Open(fn, RageFile::WRITE) )
+		/* This is written beside the old file and renamed over it when
+		 * closed, so a crash leaves one or the other. */
+		if( !f.Open(fn, RageFile::WRITE|RageFile::SLOW_FLUSH) )
 		{
-			LuaHelpers::ReportScriptErrorFmt( "Couldn't open %s for writing: %s", fn.c_str(), f.GetError().c_str() );
+			LOG->Warn( "Couldn't open %s for writing: %s", fn.c_str(), f.GetError().c_str() );
 			return false;
 		}
+		f.EnableCRC32();
 
-		if( g_bProfileDataCompress )
+		if( save.bCompress )
 		{
 			RageFileObjGzip gzip( &f );
 			gzip.Start();
-			if( !XmlFileUtil::SaveToFile( xml.get(), gzip, "", false ) )
+			if( !XmlFileUtil::SaveToFile( xml, gzip, "", false ) )
 				return false;
 
 			if( gzip.Finish() == -1 )
 				return false;
-
-			/* After successfully saving STATS_XML_GZ, remove any stray STATS_XML. */
-			if( FILEMAN->IsAFile(sDir + STATS_XML) )
-				FILEMAN->Remove( sDir + STATS_XML );
 		}
 		else
 		{
-			if( !XmlFileUtil::SaveToFile( xml.get(), f, "", false ) )
+			if( !XmlFileUtil::SaveToFile( xml, f, "", false ) )
 				return false;
+		}
 
-			/* After successfully saving STATS_XML, remove any stray STATS_XML_GZ. */
-			if( FILEMAN->IsAFile(sDir + STATS_XML_GZ) )
-				FILEMAN->Remove( sDir + STATS_XML_GZ );
+		if( f.Flush() == -1 )
+		{
+			LOG->Warn( "Couldn't write %s: %s", fn.c_str(), f.GetError().c_str() );
+			return false;
+		}
+
+		uint32_t iCRC;
+		f.GetCRC32( &iCRC );
+		const int iSize = f.Tell();
+		f.Close();
+
+		/* The rename happens in Close, which can't fail.  If it didn't work
+		 * (say, a virus scanner had the old file open), the old file is still
+		 * there, and it doesn't have the scores in the journal. */
+		if( !FileHasContents(fn, iSize, iCRC) )
+		{
+			LOG->Warn( "Couldn't replace %s; keeping %s.", fn.c_str(), STATS_JOURNAL.c_str() );
+			return false;
 		}
 	}
 
-	if( bSignData )
+	/* After successfully saving one of STATS_XML and STATS_XML_GZ, remove
+	 * any stray copy of the other. */
+	const RString sOther = sDir + (save.bCompress? STATS_XML:STATS_XML_GZ);
+	if( FILEMAN->IsAFile(sOther) )
+		FILEMAN->Remove( sOther );
+
+	if( save.bSignData )
 	{
 		RString sStatsXmlSigFile = fn+SIGNATURE_APPEND;
 		CryptManager::SignFileToFile(fn, sStatsXmlSigFile);
@@ -1493,6 +1683,12 @@ bool Profile::SaveStatsXmlToDir( RString sDir, bool bSignData ) const
 		CryptManager::SignFileToFile(sStatsXmlSigFile, sDontShareFile);
 	}
 
+	/* Every score is in stats.xml now, so start a new journal. */
+	if( FILEMAN->IsAFile(sDir + STATS_JOURNAL) )
+		FILEMAN->Remove( sDir + STATS_JOURNAL );
+	if( FILEMAN->IsAFile(sDir + STATS_JOURNAL + SIGNATURE_APPEND) )
+		FILEMAN->Remove( sDir + STATS_JOURNAL + SIGNATURE_APPEND );
+
 	return true;
 }
 
@@ -2482,6 +2678,7 @@ XNode* Profile::SaveCoinDataCreateNode() const
 
 void Profile::MoveBackupToDir( RString sFromDir, RString sToDir )
 {
+	bool bMovedStats = true;
 	if( FILEMAN->IsAFile(sFromDir + STATS_XML) &&
 		FILEMAN->IsAFile(sFromDir+STATS_XML+SIGNATURE_APPEND) )
 	{
@@ -2494,6 +2691,25 @@ void Profile::MoveBackupToDir( RString sFromDir, RString sToDir )
 		FILEMAN->Move( sFromDir+STATS_XML_GZ,					sToDir+STATS_XML );
 		FILEMAN->Move( sFromDir+STATS_XML_GZ+SIGNATURE_APPEND,	sToDir+STATS_XML+SIGNATURE_APPEND );
 	}
+	else
+		bMovedStats = false;
+
+	/* The journal goes with the stats.xml it was started from.  Otherwise,
+	 * an old journal left in the backup would be replayed over the wrong
+	 * stats. */
+	if( bMovedStats && FILEMAN->IsAFile(sFromDir + STATS_JOURNAL) )
+	{
+		FILEMAN->Move( sFromDir+STATS_JOURNAL,					sToDir+STATS_JOURNAL );
+		if( FILEMAN->IsAFile(sFromDir + STATS_JOURNAL + SIGNATURE_APPEND) )
+			FILEMAN->Move( sFromDir+STATS_JOURNAL+SIGNATURE_APPEND,	sToDir+STATS_JOURNAL+SIGNATURE_APPEND );
+	}
+	else if( bMovedStats )
+	{
+		if( FILEMAN->IsAFile(sToDir + STATS_JOURNAL) )
+			FILEMAN->Remove( sToDir+STATS_JOURNAL );
+		if( FILEMAN->IsAFile(sToDir + STATS_JOURNAL + SIGNATURE_APPEND) )
+			FILEMAN->Remove( sToDir+STATS_JOURNAL+SIGNATURE_APPEND );
+	}
 
 	if( FILEMAN->IsAFile(sFromDir + EDITABLE_INI) )
 		FILEMAN->Move( sFromDir+EDITABLE_INI,				sToDir+EDITABLE_INI );
@@ -13,10 +13,12 @@
 #include "CourseUtil.h"	// for CourseID
 #include "TrailUtil.h"	// for TrailID
 #include "StyleUtil.h"	// for StyleID
+#include "StatsJournal.h"
 #include "LuaReference.h"
 #include "PlayerNumber.h"
 
 class XNode;
+struct ProfileSave;
 struct lua_State;
 class Character;
 
@@ -237,6 +239,14 @@ public:
 	 * save chain and keep this mutable. -Chris */
 	mutable RString m_sLastPlayedMachineGuid;
 	mutable DateTime m_LastPlayedDate;
+	/**
+	 * @brief The scores added since Stats.xml was written, where it was
+	 * written, and the ID it was written with.
+	 *
+	 * If m_sStatsXmlDir is empty, the next save writes Stats.xml in full. */
+	mutable StatsJournal m_Journal;
+	mutable RString m_sStatsXmlDir;
+	mutable RString m_sStatsID;
 	/* These stats count twice in the machine profile if two players are playing;
 	 * that's the only approach that makes sense for ByDifficulty and ByMeter. */
 	int m_iNumSongsPlayedByPlayMode[NUM_PlayMode];
@@ -384,6 +394,7 @@ public:
 		InitScreenshotData(); 
 		InitCalorieData();
 		ClearSongs();
+		InvalidateStatsJournal();
 	}
 	void InitEditableData(); 
 	void InitGeneralData(); 
@@ -393,6 +404,9 @@ public:
 	void InitScreenshotData(); 
 	void InitCalorieData(); 
 	void ClearStats();
+	/** @brief Scores were changed in a way the journal doesn't record, such
+	 * as entering a name, so write Stats.xml in full next time. */
+	void InvalidateStatsJournal();
 
 	void swap(Profile& other);
 
@@ -417,7 +431,12 @@ public:
 	void SaveTypeToDir(RString dir) const;
 	void SaveEditableDataToDir( RString sDir ) const;
 	bool SaveStatsXmlToDir( RString sDir, bool bSignData ) const;
+	bool SaveStatsJournalToDir( RString sDir, bool bSignData ) const;
 	XNode* SaveStatsXmlCreateNode() const;
+	XNode* SaveStatsJournalCreateNode() const;
+	/** @brief Write stats that SaveStatsXmlToDir or SaveStatsJournalToDir
+	 * queued.  This is called from ProfileSaveQueue's thread. */
+	static bool WriteStats( const ProfileSave &save );
 	XNode* SaveGeneralDataCreateNode() const;
 	XNode* SaveSongScoresCreateNode() const;
 	XNode* SaveCourseScoresCreateNode() const;
@@ -1,6 +1,8 @@
 #include "global.h"
 #include "ProfileManager.h"
 #include "Profile.h"
+#include "ProfileSaveQueue.h"
+#include "MessageManager.h"
 #include "RageUtil.h"
 #include "PrefsManager.h"
 #include "RageLog.h"
@@ -78,6 +80,7 @@ ProfileManager::ProfileManager()
 	m_pMachineProfile = new Profile;
 	FOREACH_PlayerNumber(pn)
 		m_pMemoryCardProfile[pn] = new Profile;
+	m_pSaveQueue = new ProfileSaveQueue;
 
 	// Register with Lua.
 	{
@@ -94,11 +97,36 @@ ProfileManager::~ProfileManager()
 	// Unregister with Lua.
 	LUA->UnsetGlobal( "PROFILEMAN" );
 
+	// Finish writing anything still queued.
+	SAFE_DELETE( m_pSaveQueue );
 	SAFE_DELETE( m_pMachineProfile );
 	FOREACH_PlayerNumber(pn)
 		SAFE_DELETE( m_pMemoryCardProfile[pn] );
 }
 
+void ProfileManager::Update()
+{
+	vector<ProfileSaveQueue::Finished> aFinished;
+	m_pSaveQueue->TakeFinished( aFinished );
+	if( aFinished.empty() )
+		return;
+
+	const int iRemaining = m_pSaveQueue->GetNumQueued();
+	for( ProfileSaveQueue::Finished const &f : aFinished )
+	{
+		Message msg( "ProfileSaved" );
+		msg.SetParam( "Directory", f.sProfileDir );
+		msg.SetParam( "Success", f.bSuccess );
+		msg.SetParam( "Remaining", iRemaining );
+		FOREACH_PlayerNumber( pn )
+		{
+			if( m_sProfileDir[pn] == f.sProfileDir )
+				msg.SetParam( "Player", pn );
+		}
+		MESSAGEMAN->Broadcast( msg );
+	}
+}
+
 void ProfileManager::Init()
 {
 	FOREACH_PlayerNumber( p )
@@ -363,6 +391,7 @@ bool ProfileManager::SaveProfile( PlayerNumber pn ) const
 	{
 		m_bNeedToBackUpLastLoad[pn] = false;
 		RString sBackupDir = m_sProfileDir[pn] + LAST_GOOD_SUBDIR;
+		m_pSaveQueue->Wait( m_sProfileDir[pn] );
 		Profile::MoveBackupToDir( m_sProfileDir[pn], sBackupDir );
 	}
 
@@ -626,6 +655,8 @@ bool ProfileManager::DeleteLocalProfile( RString sProfileID )
 	ASSERT( pProfile != nullptr );
 	RString sProfileDir = LocalProfileIDToDir( sProfileID );
 
+	m_pSaveQueue->Wait( sProfileDir );
+
 	// flush directory cache in an attempt to get this working
 	FILEMAN->FlushDirCache( sProfileDir );
 
@@ -1118,6 +1149,7 @@ public:
 	}
 	static int SaveProfile( T* p, lua_State *L ) { lua_pushboolean( L, p->SaveProfile(Enum::Check<PlayerNumber>(L, 1)) ); return 1; }
 	static int SaveLocalProfile( T* p, lua_State *L ) { lua_pushboolean( L, p->SaveLocalProfile(SArg(1)) ); return 1; }
+	static int IsSavingProfiles( T* p, lua_State *L ) { lua_pushboolean( L, p->GetSaveQueue()->IsSaving() ); return 1; }
 	static int ProfileFromMemoryCardIsNew( T* p, lua_State *L ) { lua_pushboolean( L, p->ProfileFromMemoryCardIsNew(Enum::Check<PlayerNumber>(L, 1)) ); return 1; }
 	static int GetSongNumTimesPlayed( T* p, lua_State *L )
 	{
@@ -1160,6 +1192,7 @@ public:
 		//
 		ADD_METHOD( SaveProfile );
 		ADD_METHOD( SaveLocalProfile );
+		ADD_METHOD( IsSavingProfiles );
 		ADD_METHOD( ProfileFromMemoryCardIsNew );
 		ADD_METHOD( GetSongNumTimesPlayed );
 		ADD_METHOD( GetLocalProfileIDs );
@@ -15,6 +15,7 @@ class Course;
 class Trail;
 struct HighScore;
 struct lua_State;
+class ProfileSaveQueue;
 /** @brief Interface to machine and memory card profiles. */
 class ProfileManager
 {
@@ -23,6 +24,8 @@ public:
 	~ProfileManager();
 
 	void Init();
+	/** @brief Send messages about finished profile saves. */
+	void Update();
 
 	bool FixedProfiles() const;	// If true, profiles shouldn't be added/deleted
 
@@ -53,6 +56,8 @@ public:
 	bool SaveProfile( PlayerNumber pn ) const;
 	bool SaveLocalProfile( RString sProfileID );
 	void UnloadProfile( PlayerNumber pn );
+	/* Profile saves are written in the background; see ProfileSaveQueue. */
+	ProfileSaveQueue *GetSaveQueue() { return m_pSaveQueue; }
 
 	void MergeLocalProfiles(RString const& from_id, RString const& to_id);
 	void MergeLocalProfileIntoMachine(RString const& from_id, bool skip_totals);
@@ -131,6 +136,7 @@ private:
 
 	Profile	*m_pMemoryCardProfile[NUM_PLAYERS];	// holds Profile for the currently inserted card
 	Profile *m_pMachineProfile;
+	ProfileSaveQueue *m_pSaveQueue;
 };
 
 extern ProfileManager*	PROFILEMAN;	// global and accessible from anywhere in our program
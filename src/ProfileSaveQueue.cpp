@@ -0,0 +1,163 @@
+#include "global.h"
+#include "ProfileSaveQueue.h"
+#include "Preference.h"
+#include "Profile.h"
+#include "RageLog.h"
+
+/* If disabled, saves are written before Add returns. */
+static Preference<bool> g_bProfileSaveInBackground( "ProfileSaveInBackground", true );
+
+ProfileSaveQueue::ProfileSaveQueue():
+	m_Event("ProfileSaveQueue"), m_bShutdown(false)
+{
+	m_WorkerThread.SetName( "Profile save" );
+	m_WorkerThread.Create( WorkerThread_Start, this );
+}
+
+ProfileSaveQueue::~ProfileSaveQueue()
+{
+	m_Event.Lock();
+	m_bShutdown = true;
+	m_Event.Broadcast();
+	m_Event.Unlock();
+	m_WorkerThread.Wait();
+}
+
+void ProfileSaveQueue::Add( ProfileSave *pSave )
+{
+	if( !g_bProfileSaveInBackground )
+	{
+		/* Don't write over saves that are still queued from before. */
+		Wait();
+		bool bSuccess = Profile::WriteStats( *pSave );
+		LockMut( m_Event );
+		SaveFinished( pSave, bSuccess );
+		return;
+	}
+
+	LockMut( m_Event );
+	m_Queue.push_back( pSave );
+	m_Event.Broadcast();
+}
+
+static bool IsInDir( const ProfileSave *pSave, const RString &sDir )
+{
+	return BeginsWith( pSave->sProfileDir, sDir );
+}
+
+bool ProfileSaveQueue::IsSaving( const RString &sDir )
+{
+	LockMut( m_Event );
+	for( ProfileSave const *pSave : m_Queue )
+		if( IsInDir(pSave, sDir) )
+			return true;
+	return false;
+}
+
+void ProfileSaveQueue::Wait( const RString &sDir )
+{
+	m_Event.Lock();
+	for(;;)
+	{
+		bool bSaving = false;
+		for( ProfileSave const *pSave : m_Queue )
+			if( IsInDir(pSave, sDir) )
+				bSaving = true;
+		if( !bSaving )
+			break;
+
+		LOG->Trace( "Waiting for profile saves to \"%s\"", sDir.c_str() );
+		m_Event.Wait();
+	}
+	m_Event.Unlock();
+}
+
+bool ProfileSaveQueue::TakeFailure( const RString &sProfileDir )
+{
+	LockMut( m_Event );
+	return m_Failed.erase( sProfileDir ) != 0;
+}
+
+void ProfileSaveQueue::TakeFinished( vector<Finished> &aOut )
+{
+	LockMut( m_Event );
+	aOut.clear();
+	aOut.swap( m_Finished );
+}
+
+int ProfileSaveQueue::GetNumQueued()
+{
+	LockMut( m_Event );
+	return m_Queue.size();
+}
+
+/* m_Event must be locked. */
+void ProfileSaveQueue::SaveFinished( ProfileSave *pSave, bool bSuccess )
+{
+	if( !bSuccess )
+	{
+		LOG->Warn( "Saving the profile in \"%s\" failed", pSave->sProfileDir.c_str() );
+		m_Failed.insert( pSave->sProfileDir );
+	}
+
+	Finished f;
+	f.sProfileDir = pSave->sProfileDir;
+	f.bSuccess = bSuccess;
+	m_Finished.push_back( f );
+	delete pSave;
+}
+
+void ProfileSaveQueue::WorkerThread()
+{
+	m_Event.Lock();
+	for(;;)
+	{
+		/* Finish writing everything before shutting down. */
+		if( m_Queue.empty() )
+		{
+			if( m_bShutdown )
+				break;
+			m_Event.Wait();
+			continue;
+		}
+
+		ProfileSave *pSave = m_Queue.front();
+		/* If an earlier save here failed, the end of the journal may be
+		 * garbage, so don't add to it.  The next save writes Stats.xml. */
+		const bool bSkip = pSave->bJournal && m_Failed.find(pSave->sProfileDir) != m_Failed.end();
+		m_Event.Unlock();
+
+		bool bSuccess = !bSkip && Profile::WriteStats( *pSave );
+
+		m_Event.Lock();
+		m_Queue.pop_front();
+		SaveFinished( pSave, bSuccess );
+		m_Event.Broadcast();
+	}
+	m_Event.Unlock();
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -0,0 +1,110 @@
+/* ProfileSaveQueue - Writes profile stats on a thread, so saving doesn't stall the game. */
+
+#ifndef PROFILE_SAVE_QUEUE_H
+#define PROFILE_SAVE_QUEUE_H
+
+#include "RageThreads.h"
+#include "XmlFile.h"
+
+#include <deque>
+#include <memory>
+#include <set>
+
+/** @brief The stats of a profile, ready to be written. */
+struct ProfileSave
+{
+	ProfileSave(): bJournal(false), bCompress(false), bSignData(false) { }
+
+	/* The profile's directory, and the directory its stats go in, with
+	 * the stats prefix. */
+	RString sProfileDir;
+	RString sStatsDir;
+	std::unique_ptr<XNode> pStats;
+	/* If set, append sJournalRecords and pStats to the journal, instead of
+	 * writing pStats to Stats.xml. */
+	bool bJournal;
+	RString sJournalRecords;
+	/* The ID of the Stats.xml the journal belongs to. */
+	RString sStatsID;
+	bool bCompress;
+	bool bSignData;
+};
+
+/**
+ * @brief Writes profile stats on a thread.
+ *
+ * Building the stats tree has to be done on the main thread, since the profile
+ * may change once we return, but the tree is a snapshot.  Encoding,
+ * compressing, signing and writing it, which can take seconds on a memory
+ * card, is done here.  Saves are written in the order they were added; each
+ * file is written beside the old one, flushed to disk and renamed over it.
+ *
+ * Only wait for saves where it matters, such as before unmounting a memory
+ * card or loading a profile that's being saved. */
+class ProfileSaveQueue
+{
+public:
+	ProfileSaveQueue();
+	/* Finishes every queued save. */
+	~ProfileSaveQueue();
+
+	void Add( ProfileSave *pSave );
+
+	/** @brief Return true if anything in sDir, or anywhere if sDir is empty,
+	 * is still being saved. */
+	bool IsSaving( const RString &sDir = "" );
+	void Wait( const RString &sDir = "" );
+
+	/** @brief Return true if a save to sProfileDir failed since the last
+	 * call.  Stats.xml and the journal may not match now. */
+	bool TakeFailure( const RString &sProfileDir );
+
+	struct Finished
+	{
+		RString sProfileDir;
+		bool bSuccess;
+	};
+	/** @brief Get the saves finished since the last call. */
+	void TakeFinished( vector<Finished> &aOut );
+	int GetNumQueued();
+
+private:
+	static int WorkerThread_Start( void *p ) { ((ProfileSaveQueue *) p)->WorkerThread(); return 0; }
+	void WorkerThread();
+	void SaveFinished( ProfileSave *pSave, bool bSuccess );
+
+	RageThread m_WorkerThread;
+	RageEvent m_Event;	// protects everything below
+	/* The front save stays here while it's being written. */
+	std::deque<ProfileSave *> m_Queue;
+	std::set<RString> m_Failed;
+	vector<Finished> m_Finished;
+	bool m_bShutdown;
+};
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
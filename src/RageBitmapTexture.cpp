@@ -37,10 +37,62 @@ static void GetResolutionFromFileName( RString sPath, int &iWidth, int &iHeight
 	iHeight = maybe_height;
 }
 
+/* The part of loading a bitmap that doesn't touch the display: reading the
+ * file, resizing, dithering and converting it to the format it'll be uploaded
+ * in.  Everything it needs from the display is looked up when the job is made,
+ * so Decode can run on the decode thread. */
+class RageBitmapTexture::DecodeJob: public RageTextureDecodeJob
+{
+public:
+	DecodeJob( RageBitmapTexture *pTexture );
+	~DecodeJob() { delete m_pImg; }
+	void Decode();
+	void Finish();
+
+private:
+	RageBitmapTexture *m_pTexture;
+	RageTextureID m_ID;
+	bool m_bScreenTexture;
+	int m_iMaxTextureSize;
+	bool m_bHighResolutionTextures;
+	bool m_bOddDimensionWarning;
+	bool m_bSupportsFormat[NUM_RagePixelFormat];
+	const RageDisplay::RagePixelFormatDesc *m_pFormatDesc[NUM_RagePixelFormat];
+
+	// Set by Decode:
+	RageSurface *m_pImg;
+	RString m_sError;
+	RString m_sHintString;
+	RagePixelFormat m_PixFmt;
+	int m_iSourceWidth, m_iSourceHeight;
+	int m_iImageWidth, m_iImageHeight;
+	int m_iTextureWidth, m_iTextureHeight;
+};
+
+RageBitmapTexture::DecodeJob::DecodeJob( RageBitmapTexture *pTexture ):
+	m_pTexture(pTexture), m_ID(pTexture->GetID()), m_pImg(nullptr),
+	m_PixFmt(RagePixelFormat_Invalid), m_iSourceWidth(0), m_iSourceHeight(0),
+	m_iImageWidth(0), m_iImageHeight(0), m_iTextureWidth(0), m_iTextureHeight(0)
+{
+	m_iMaxTextureSize = DISPLAY->GetMaxTextureSize();
+	m_bHighResolutionTextures = StepMania::GetHighResolutionTextures();
+	m_bOddDimensionWarning = TEXTUREMAN->GetOddDimensionWarning();
+	for( int i = 0; i < NUM_RagePixelFormat; ++i )
+	{
+		m_bSupportsFormat[i] = DISPLAY->SupportsTextureFormat( (RagePixelFormat) i );
+		m_pFormatDesc[i] = DISPLAY->GetPixelFormatDesc( (RagePixelFormat) i );
+	}
+
+	// The screen can only be read from here.
+	m_bScreenTexture = m_ID.filename == TEXTUREMAN->GetScreenTextureID().filename;
+	if( m_bScreenTexture )
+		m_pImg = TEXTUREMAN->GetScreenSurface();
+}
+
 RageBitmapTexture::RageBitmapTexture( RageTextureID name ) :
-	RageTexture( name ), m_uTexHandle(0)
+	RageTexture( name ), m_uTexHandle(0), m_pDecodeJob(nullptr)
 {
-	Create();
+	Create( name.bAsync );
 }
 
 RageBitmapTexture::~RageBitmapTexture()
@@ -48,10 +100,51 @@ RageBitmapTexture::~RageBitmapTexture()
 	Destroy();
 }
 
+/* Reloading happens when changing themes or texture preferences, where
+ * waiting for the texture is fine. */
 void RageBitmapTexture::Reload()
 {
 	Destroy();
-	Create();
+	Create( false );
+}
+
+void RageBitmapTexture::Create( bool bAsync )
+{
+	ASSERT( GetID().filename != "" );
+
+	DecodeJob *pJob = new DecodeJob( this );
+	if( !bAsync || GetID().filename == TEXTUREMAN->GetScreenTextureID().filename )
+	{
+		pJob->Decode();
+		pJob->Finish();
+		delete pJob;
+		return;
+	}
+
+	/* Stand in as an empty texture until the image is uploaded. */
+	m_iSourceWidth = m_iSourceHeight = 1;
+	m_iImageWidth = m_iImageHeight = 1;
+	m_iTextureWidth = m_iTextureHeight = 1;
+	CreateFrameRects();
+
+	m_pDecodeJob = pJob;
+	TEXTUREMAN->QueueDecode( pJob );
+}
+
+void RageBitmapTexture::FinishLoading()
+{
+	if( m_pDecodeJob != nullptr )
+		TEXTUREMAN->FinishDecode( m_pDecodeJob );
+}
+
+void RageBitmapTexture::Destroy()
+{
+	if( m_pDecodeJob != nullptr )
+	{
+		TEXTUREMAN->CancelDecode( m_pDecodeJob );
+		m_pDecodeJob = nullptr;
+	}
+	DISPLAY->DeleteTexture( m_uTexHandle );
 }
 
 /*
@@ -64,23 +157,15 @@ void RageBitmapTexture::Reload()
  * Dither forces dithering when loading 16-bit textures.
  * Stretch forces the loaded image to fill the texture completely.
  */
-void RageBitmapTexture::Create()
+void RageBitmapTexture::DecodeJob::Decode()
 {
-	RageTextureID actualID = GetID();
-
-	ASSERT( actualID.filename != "" );
+	RageTextureID &actualID = m_ID;
 
 	/* Load the image into a RageSurface. */
 	RString error;
-	RageSurface *pImg = nullptr;
-	if(actualID.filename == TEXTUREMAN->GetScreenTextureID().filename)
-	{
-		pImg= TEXTUREMAN->GetScreenSurface();
-	}
-	else
-	{
-		pImg= RageSurfaceUtils::LoadFile(actualID.filename, error);
-	}
+	if( !m_bScreenTexture )
+		m_pImg = RageSurfaceUtils::LoadFile( actualID.filename, error );
+	RageSurface *&pImg = m_pImg;
 
 	/* Tolerate corrupt/unknown images. */
 	if( pImg == nullptr )
@@ -88,7 +173,7 @@ void RageBitmapTexture::Create()
 		RString warning = ssprintf("RageBitmapTexture: Couldn't load %s: %s",
 			actualID.filename.c_str(), error.c_str());
 		LOG->Warn("%s", warning.c_str());
-		Dialog::OK(warning, "missing_texture");
+		m_sError = warning;
 		pImg = RageSurfaceUtils::MakeDummySurface( 64, 64 );
 		ASSERT( pImg != nullptr );
 	}
@@ -107,24 +192,24 @@ void RageBitmapTexture::Create()
 	}
 
 	// look in the file name for a format hints
-	RString sHintString = GetID().filename + actualID.AdditionalTextureHints;
-	sHintString.MakeLower();
+	m_sHintString = actualID.filename + actualID.AdditionalTextureHints;
+	m_sHintString.MakeLower();
 
-	if( sHintString.find("32bpp") != string::npos )			actualID.iColorDepth = 32;
-	else if( sHintString.find("16bpp") != string::npos )		actualID.iColorDepth = 16;
-	if( sHintString.find("dither") != string::npos )		actualID.bDither = true;
-	if( sHintString.find("stretch") != string::npos )		actualID.bStretch = true;
-	if( sHintString.find("mipmaps") != string::npos )		actualID.bMipMaps = true;
-	if( sHintString.find("nomipmaps") != string::npos )		actualID.bMipMaps = false;	// check for "nomipmaps" after "mipmaps"
+	if( m_sHintString.find("32bpp") != string::npos )			actualID.iColorDepth = 32;
+	else if( m_sHintString.find("16bpp") != string::npos )		actualID.iColorDepth = 16;
+	if( m_sHintString.find("dither") != string::npos )		actualID.bDither = true;
+	if( m_sHintString.find("stretch") != string::npos )		actualID.bStretch = true;
+	if( m_sHintString.find("mipmaps") != string::npos )		actualID.bMipMaps = true;
+	if( m_sHintString.find("nomipmaps") != string::npos )		actualID.bMipMaps = false;	// check for "nomipmaps" after "mipmaps"
 
 	/* If the image is marked grayscale, then use all bits not used for alpha
 	 * for the intensity.  This way, if an image has no alpha, you get an 8-bit
 	 * grayscale; if it only has boolean transparency, you get a 7-bit grayscale. */
-	if( sHintString.find("grayscale") != string::npos )		actualID.iGrayscaleBits = 8-actualID.iAlphaBits;
+	if( m_sHintString.find("grayscale") != string::npos )		actualID.iGrayscaleBits = 8-actualID.iAlphaBits;
 
 	/* This indicates that the only component in the texture is alpha; assume all
 	 * color is white. */
-	if( sHintString.find("alphamap") != string::npos )		actualID.iGrayscaleBits = 0;
+	if( m_sHintString.find("alphamap") != string::npos )		actualID.iGrayscaleBits = 0;
 
 	/* No iGrayscaleBits for images that are already paletted.  We don't support
 	 * that; and that hint is intended for use on images that are already grayscale,
@@ -133,7 +218,7 @@ void RageBitmapTexture::Create()
 		actualID.iGrayscaleBits = -1;
 
 	/* Cap the max texture size to the hardware max. */
-	actualID.iMaxSize = min( actualID.iMaxSize, DISPLAY->GetMaxTextureSize() );
+	actualID.iMaxSize = min( actualID.iMaxSize, m_iMaxTextureSize );
 
 	/* Save information about the source. */
 	m_iSourceWidth = pImg->w;
@@ -144,9 +229,9 @@ void RageBitmapTexture::Create()
 	m_iImageHeight = m_iSourceHeight;
 
 	/* if "doubleres" (high resolution) and we're not allowing high res textures, then image dimensions are half of the source */
-	if( sHintString.find("doubleres") != string::npos )
+	if( m_sHintString.find("doubleres") != string::npos )
 	{
-		if( !StepMania::GetHighResolutionTextures() )
+		if( !m_bHighResolutionTextures )
 		{
 			m_iImageWidth = m_iImageWidth / 2;
 			m_iImageHeight = m_iImageHeight / 2;
@@ -183,7 +268,7 @@ void RageBitmapTexture::Create()
 	if( pImg->w != m_iImageWidth || pImg->h != m_iImageHeight ) 
 		RageSurfaceUtils::Zoom( pImg, m_iImageWidth, m_iImageHeight );
 
-	if( actualID.iGrayscaleBits != -1 && DISPLAY->SupportsTextureFormat(RagePixelFormat_PAL) )
+	if( actualID.iGrayscaleBits != -1 && m_bSupportsFormat[RagePixelFormat_PAL] )
 	{
 		RageSurface *pGrayscale = RageSurfaceUtils::PalettizeToGrayscale( pImg, actualID.iGrayscaleBits, actualID.iAlphaBits );
 
@@ -192,10 +277,10 @@ void RageBitmapTexture::Create()
 	}
 
 	// Figure out which texture format we want the renderer to use.
-	RagePixelFormat pixfmt;
+	RagePixelFormat &pixfmt = m_PixFmt;
 
 	// If the source is palleted, always load as paletted if supported.
-	if( pImg->format->BitsPerPixel == 8 && DISPLAY->SupportsTextureFormat(RagePixelFormat_PAL) )
+	if( pImg->format->BitsPerPixel == 8 && m_bSupportsFormat[RagePixelFormat_PAL] )
 	{
 		pixfmt = RagePixelFormat_PAL;
 	}
@@ -232,10 +317,10 @@ void RageBitmapTexture::Create()
 	}
 
 	// Make we're using a supported format. Every card supports either RGBA8 or RGBA4.
-	if( !DISPLAY->SupportsTextureFormat(pixfmt) )
+	if( !m_bSupportsFormat[pixfmt] )
 	{
 		pixfmt = RagePixelFormat_RGBA8;
-		if( !DISPLAY->SupportsTextureFormat(pixfmt) )
+		if( !m_bSupportsFormat[pixfmt] )
 			pixfmt = RagePixelFormat_RGBA4;
 	}
 
@@ -248,7 +333,7 @@ void RageBitmapTexture::Create()
 		(pixfmt==RagePixelFormat_RGBA4 || pixfmt==RagePixelFormat_RGB5A1) )
 	{
 		// Dither down to the destination format.
-		const RageDisplay::RagePixelFormatDesc *pfd = DISPLAY->GetPixelFormatDesc(pixfmt);
+		const RageDisplay::RagePixelFormatDesc *pfd = m_pFormatDesc[pixfmt];
 		RageSurface *dst = CreateSurface( pImg->w, pImg->h, pfd->bpp,
 			pfd->masks[0], pfd->masks[1], pfd->masks[2], pfd->masks[3] );
 
@@ -265,10 +350,25 @@ void RageBitmapTexture::Create()
 	/* Scale up to the texture size, if needed. */
 	RageSurfaceUtils::ConvertSurface( pImg, m_iTextureWidth, m_iTextureHeight,
 		pImg->fmt.BitsPerPixel, pImg->fmt.Mask[0], pImg->fmt.Mask[1], pImg->fmt.Mask[2], pImg->fmt.Mask[3] );
-	
-	m_uTexHandle = DISPLAY->CreateTexture( pixfmt, pImg, actualID.bMipMaps );
+}
 
-	CreateFrameRects();
+void RageBitmapTexture::DecodeJob::Finish()
+{
+	m_pTexture->m_pDecodeJob = nullptr;
+
+	if( !m_sError.empty() )
+		Dialog::OK( m_sError, "missing_texture" );
+
+	m_pTexture->m_iSourceWidth = m_iSourceWidth;
+	m_pTexture->m_iSourceHeight = m_iSourceHeight;
+	m_pTexture->m_iImageWidth = m_iImageWidth;
+	m_pTexture->m_iImageHeight = m_iImageHeight;
+	m_pTexture->m_iTextureWidth = m_iTextureWidth;
+	m_pTexture->m_iTextureHeight = m_iTextureHeight;
+
+	m_pTexture->m_uTexHandle = DISPLAY->CreateTexture( m_PixFmt, m_pImg, m_ID.bMipMaps );
+
+	m_pTexture->CreateFrameRects();
 
 
 	{
@@ -276,7 +376,7 @@ void RageBitmapTexture::Create()
 		// Otherwise, pixel/texel alignment will be off.
 		int iDimensionMultiple = 2;
 
-		if( sHintString.find("doubleres") != string::npos )
+		if( m_sHintString.find("doubleres") != string::npos )
 		{
 			iDimensionMultiple = 4;
 		}
@@ -284,37 +384,37 @@ void RageBitmapTexture::Create()
 		bool bRunCheck = true;
 
 		// Don't check if the artist intentionally blanked the image by making it very tiny.
-		if( this->GetSourceWidth()<=iDimensionMultiple || this->GetSourceHeight()<=iDimensionMultiple )
+		if( m_pTexture->GetSourceWidth()<=iDimensionMultiple || m_pTexture->GetSourceHeight()<=iDimensionMultiple )
 			bRunCheck = false;
 
 		// HACK: Don't check song graphics. Many of them are weird dimensions.
-		if( !TEXTUREMAN->GetOddDimensionWarning() )
+		if( !m_bOddDimensionWarning )
 			bRunCheck = false;
 
 		// Don't check if this is the screen texture, the theme can't do anything
 		// about it. -Kyz
-		if(actualID == TEXTUREMAN->GetScreenTextureID())
+		if( m_bScreenTexture )
 		{
 			bRunCheck= false;
 		}
 
 		if( bRunCheck  )
 		{
-			float fFrameWidth = this->GetSourceWidth() / (float)this->GetFramesWide();
-			float fFrameHeight = this->GetSourceHeight() / (float)this->GetFramesHigh();
+			float fFrameWidth = m_pTexture->GetSourceWidth() / (float)m_pTexture->GetFramesWide();
+			float fFrameHeight = m_pTexture->GetSourceHeight() / (float)m_pTexture->GetFramesHigh();
 			float fBetterFrameWidth = ceilf(fFrameWidth/iDimensionMultiple) * iDimensionMultiple;
 			float fBetterFrameHeight = ceilf(fFrameHeight/iDimensionMultiple) * iDimensionMultiple;
-			float fBetterSourceWidth = this->GetFramesWide() * fBetterFrameWidth;
-			float fBetterSourceHeight = this->GetFramesHigh() * fBetterFrameHeight;
+			float fBetterSourceWidth = m_pTexture->GetFramesWide() * fBetterFrameWidth;
+			float fBetterSourceHeight = m_pTexture->GetFramesHigh() * fBetterFrameHeight;
 			if( fFrameWidth!=fBetterFrameWidth || fFrameHeight!=fBetterFrameHeight )
 			{
 				RString sWarning = ssprintf(
 					"The graphic '%s' has frame dimensions that aren't a multiple of %d.\n"
 					"The entire image is %dx%d and frame size is %.1fx%.1f.\n"
 					"Image quality will be much improved if you resize the graphic to %.0fx%.0f, which is a frame size of %.0fx%.0f.", 
-					actualID.filename.c_str(), 
+					m_ID.filename.c_str(), 
 					iDimensionMultiple,
-					this->GetSourceWidth(), this->GetSourceHeight(), 
+					m_pTexture->GetSourceWidth(), m_pTexture->GetSourceHeight(), 
 					fFrameWidth, fFrameHeight,
 					fBetterSourceWidth, fBetterSourceHeight,
 					fBetterFrameWidth, fBetterFrameHeight );
@@ -325,40 +425,36 @@ void RageBitmapTexture::Create()
 	}
 
 
-	delete pImg;
+	delete m_pImg;
+	m_pImg = nullptr;
 
 	// Check for hints that override the apparent "size".
-	GetResolutionFromFileName( actualID.filename, m_iSourceWidth, m_iSourceHeight );
+	GetResolutionFromFileName( m_ID.filename, m_pTexture->m_iSourceWidth, m_pTexture->m_iSourceHeight );
 
 	/* if "doubleres" (high resolution) then we want the image to appear in-game
 	 * with dimensions 1/2 of the source. So, cut down the source dimension here
 	 * after everything above is finished operating with the real image
 	 * source dimensions. */
-	if( sHintString.find("doubleres") != string::npos )
+	if( m_sHintString.find("doubleres") != string::npos )
 	{
-		m_iSourceWidth = m_iSourceWidth / 2;
-		m_iSourceHeight = m_iSourceHeight / 2;
+		m_pTexture->m_iSourceWidth = m_pTexture->m_iSourceWidth / 2;
+		m_pTexture->m_iSourceHeight = m_pTexture->m_iSourceHeight / 2;
 	}
 
 
 	RString sProperties;
-	sProperties += RagePixelFormatToString( pixfmt ) + " ";
-	if( actualID.iAlphaBits == 0 ) sProperties += "opaque ";
-	if( actualID.iAlphaBits == 1 ) sProperties += "matte ";
-	if( actualID.bStretch ) sProperties += "stretch ";
-	if( actualID.bDither ) sProperties += "dither ";
+	sProperties += RagePixelFormatToString( m_PixFmt ) + " ";
+	if( m_ID.iAlphaBits == 0 ) sProperties += "opaque ";
+	if( m_ID.iAlphaBits == 1 ) sProperties += "matte ";
+	if( m_ID.bStretch ) sProperties += "stretch ";
+	if( m_ID.bDither ) sProperties += "dither ";
 	sProperties.erase( sProperties.size()-1 );
 	//LOG->Trace( "RageBitmapTexture: Loaded '%s' (%ux%u); %s, source %d,%d;  image %d,%d.",
-	//	actualID.filename.c_str(), GetTextureWidth(), GetTextureHeight(),
-	//	sProperties.c_str(), m_iSourceWidth, m_iSourceHeight,
+	//	m_ID.filename.c_str(), GetTextureWidth(), GetTextureHeight(),
+	//	sProperties.c_str(), m_pTexture->m_iSourceWidth, m_pTexture->m_iSourceHeight,
 	//	m_iImageWidth, m_iImageHeight );
 }
 
-void RageBitmapTexture::Destroy()
-{
-	DISPLAY->DeleteTexture( m_uTexHandle );
-}
-
 /*
  * Copyright (c) 2001-2004 Chris Danford, Glenn Maynard
  * All rights reserved.
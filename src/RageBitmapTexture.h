@@ -14,11 +14,15 @@ public:
 	virtual void Invalidate() { m_uTexHandle = 0; /* don't Destroy() */}
 	virtual void Reload();
 	virtual uintptr_t GetTexHandle() const { return m_uTexHandle; };	// accessed by RageDisplay
+	virtual bool IsPending() const { return m_pDecodeJob != nullptr; }
+	virtual void FinishLoading();
 
 private:
-	void Create();	// called by constructor and Reload
+	class DecodeJob;
+	void Create( bool bAsync );	// called by constructor and Reload
 	void Destroy();
 	uintptr_t m_uTexHandle;	// treat as unsigned in OpenGL, IDirect3DTexture9* for D3D
+	DecodeJob *m_pDecodeJob;	// owned by TEXTUREMAN while pending
 };
 
 #endif
@@ -18,15 +18,19 @@
 // Statistics stuff
 RageTimer	g_LastCheckTimer;
 int		g_iNumVerts;
-int		g_iFPS, g_iVPF, g_iCFPS;
+int		g_iFPS, g_iVPF, g_iCFPS, g_iDPF, g_iBatchedDPF;
 
 int RageDisplay::GetFPS() const { return g_iFPS; }
 int RageDisplay::GetVPF() const { return g_iVPF; }
 int RageDisplay::GetCumFPS() const { return g_iCFPS; }
+int RageDisplay::GetDPF() const { return g_iDPF; }
+int RageDisplay::GetBatchedDPF() const { return g_iBatchedDPF; }
 
 static int g_iFramesRenderedSinceLastCheck,
 	   g_iFramesRenderedSinceLastReset,
 	   g_iVertsRenderedSinceLastCheck,
+	   g_iDrawsSinceLastCheck,
+	   g_iBatchedDrawsSinceLastCheck,
 	   g_iNumChecksSinceLastReset;
 static RageTimer g_LastFrameEndedAt( RageZeroTimer );
 
@@ -137,7 +141,10 @@ void RageDisplay::ProcessStatsOnFlip()
 		g_iCFPS = g_iFramesRenderedSinceLastReset / g_iNumChecksSinceLastReset;
 		g_iCFPS = lrintf( g_iCFPS / fActualTime );
 		g_iVPF = g_iVertsRenderedSinceLastCheck / g_iFramesRenderedSinceLastCheck;
+		g_iDPF = g_iDrawsSinceLastCheck / g_iFramesRenderedSinceLastCheck;
+		g_iBatchedDPF = g_iBatchedDrawsSinceLastCheck / g_iFramesRenderedSinceLastCheck;
 		g_iFramesRenderedSinceLastCheck = g_iVertsRenderedSinceLastCheck = 0;
+		g_iDrawsSinceLastCheck = g_iBatchedDrawsSinceLastCheck = 0;
 		if( LOG_FPS )
 		{
 			RString sStats = GetStats();
@@ -149,10 +156,11 @@ void RageDisplay::ProcessStatsOnFlip()
 
 void RageDisplay::ResetStats()
 {
-	g_iFPS = g_iVPF = 0;
+	g_iFPS = g_iVPF = g_iDPF = g_iBatchedDPF = 0;
 	g_iFramesRenderedSinceLastCheck = g_iFramesRenderedSinceLastReset = 0;
 	g_iNumChecksSinceLastReset = 0;
 	g_iVertsRenderedSinceLastCheck = 0;
+	g_iDrawsSinceLastCheck = g_iBatchedDrawsSinceLastCheck = 0;
 	g_LastCheckTimer.GetDeltaTime();
 }
 
@@ -164,6 +172,9 @@ RString RageDisplay::GetStats() const
 		s = "-- FPS\n-- av FPS\n-- VPF";
 
 	s = ssprintf( "%i FPS\n%i av FPS\n%i VPF", GetFPS(), GetCumFPS(), GetVPF() );
+	// Only renderers that batch draws have anything to show here.
+	if( GetBatchedDPF() )
+		s += ssprintf( "\n%i DPF (%i batched)", GetDPF() - GetBatchedDPF(), GetBatchedDPF() );
 
 //	#if defined(_WINDOWS)
 	s += "\n"+this->GetApiDescription();
@@ -189,7 +200,8 @@ void RageDisplay::BeginConcurrentRendering()
 	this->SetDefaultRenderStates();
 }
 
-void RageDisplay::StatsAddVerts( int iNumVertsRendered ) { g_iVertsRenderedSinceLastCheck += iNumVertsRendered; }
+void RageDisplay::StatsAddVerts( int iNumVertsRendered ) { g_iVertsRenderedSinceLastCheck += iNumVertsRendered; ++g_iDrawsSinceLastCheck; }
+void RageDisplay::StatsAddBatchedDraws( int iNumDraws ) { g_iBatchedDrawsSinceLastCheck += iNumDraws; }
 
 /* Draw a line as a quad.  GL_LINES with SmoothLines off can draw line
  * ends at odd angles--they're forced to axis-alignment regardless of the
@@ -394,10 +394,15 @@ public:
 	int GetFPS() const;
 	int GetVPF() const;
 	int GetCumFPS() const; // average FPS since last reset
+	/** @brief Draws requested per frame, before batching. */
+	int GetDPF() const;
+	/** @brief Draws per frame that were merged into another draw. */
+	int GetBatchedDPF() const;
 	virtual void ResetStats();
 	virtual void ProcessStatsOnFlip();
 	virtual RString GetStats() const;
 	void StatsAddVerts( int iNumVertsRendered );
+	void StatsAddBatchedDraws( int iNumDraws );
 
 	// World matrix stack functions.
 	void PushMatrix();
@@ -16,9 +16,11 @@ using namespace RageDisplay_Legacy_Helpers;
 #include "EnumHelper.h"
 #include "DisplaySpec.h"
 #include "LocalizedString.h"
+#include "Preference.h"
 
 #include "arch/LowLevelWindow/LowLevelWindow.h"
 
+#include <cstddef>
 #include <set>
 
 #if defined(WINDOWS)
@@ -70,6 +72,154 @@ static LowLevelWindow *g_pWind;
 static bool g_bInvertY = false;
 
 static void InvalidateObjects();
+static bool SetTextureUnit( TextureUnit tu );
+
+/* Quad batching.  Sprites and text draw a few quads at a time, and set the
+ * same render states before every draw.  Rather than drawing them right away,
+ * DrawQuadsInternal moves the quads into view space and holds on to them, and
+ * consecutive quads are drawn together from a streaming VBO once a render
+ * state really changes or something else is drawn.
+ *
+ * g_BatchState remembers the states actors set before each draw, so setting
+ * them to what they already are doesn't break up a batch.  Textures are bound
+ * lazily, since every sprite clears all texture units before setting its own.
+ * Anything else that touches GL state flushes the batch first. */
+static Preference<bool> g_bBatchQuads( "BatchQuads", true );
+
+struct BatchVertex
+{
+	float p[3];
+	float n[3];
+	GLubyte c[4];
+	float t[2];
+};
+
+/* Flush before the batch gets larger than this. */
+static const unsigned MAX_BATCH_VERTICES = 4096*4;
+
+static struct QuadBatch
+{
+	vector<BatchVertex> vVerts;
+	/* The number of DrawQuads calls in vVerts. */
+	int iNumDraws;
+	RageMatrix Projection;
+	RageMatrix Texture;
+	GLuint iBuffer;
+} g_QuadBatch;
+
+/* The GL state as last set.  Unknown states (-1, UNKNOWN_TEXTURE or
+ * X_Invalid) never match, so the next change is always sent. */
+static const uintptr_t UNKNOWN_TEXTURE = ~uintptr_t(0);
+static struct BatchState
+{
+	/* The textures asked for, and the textures actually bound and enabled. */
+	uintptr_t iTexture[NUM_TextureUnit];
+	uintptr_t iBoundTexture[NUM_TextureUnit];
+	int iTextureEnabled[NUM_TextureUnit];
+	TextureMode TexMode[NUM_TextureUnit];
+	/* Wrapping and filtering belong to the texture, not the unit; they're
+	 * only known while the texture they were set on is still bound. */
+	int iWrapping[NUM_TextureUnit];
+	int iFiltering[NUM_TextureUnit];
+	bool bSphereMapping[NUM_TextureUnit];
+	EffectMode Effect;
+	int iCelStage;
+	int iLighting;
+	BlendMode Blend;
+	int iZWrite;
+	ZTestMode ZTest;
+	float fZBias;
+	CullMode Cull;
+} g_BatchState;
+
+/* The texture unit glActiveTextureARB last selected. */
+static TextureUnit g_ActiveTextureUnit = TextureUnit_1;
+
+/* While another thread is rendering, nothing is batched or remembered. */
+static bool g_bConcurrentRendering = false;
+
+/* Something other than SetTexture bound textures. */
+static void ForgetBoundTextures()
+{
+	FOREACH_ENUM( TextureUnit, tu )
+	{
+		g_BatchState.iBoundTexture[tu] = UNKNOWN_TEXTURE;
+		g_BatchState.iWrapping[tu] = -1;
+		g_BatchState.iFiltering[tu] = -1;
+	}
+}
+
+/* We may be in a new context, so assume nothing. */
+static void ForgetBatchState()
+{
+	FOREACH_ENUM( TextureUnit, tu )
+	{
+		g_BatchState.iTexture[tu] = UNKNOWN_TEXTURE;
+		g_BatchState.iTextureEnabled[tu] = -1;
+		g_BatchState.TexMode[tu] = TextureMode_Invalid;
+		g_BatchState.bSphereMapping[tu] = false;
+	}
+	ForgetBoundTextures();
+	g_BatchState.Effect = EffectMode_Invalid;
+	g_BatchState.iCelStage = -1;
+	g_BatchState.iLighting = -1;
+	g_BatchState.Blend = BlendMode_Invalid;
+	g_BatchState.iZWrite = -1;
+	g_BatchState.ZTest = ZTestMode_Invalid;
+	g_BatchState.fZBias = -1;
+	g_BatchState.Cull = CullMode_Invalid;
+}
+
+/* True if quads are waiting to be drawn and state is already value, so
+ * setting it again can be skipped without breaking up the batch. */
+template<typename T>
+static bool IsBatchedState( const T &state, const T &value )
+{
+	return !g_QuadBatch.vVerts.empty() && state == value;
+}
+
+template<typename T>
+static void SetBatchState( T &state, const T &value )
+{
+	if (!g_bConcurrentRendering)
+		state = value;
+}
+
+/* Wrapping or filtering was set on the texture bound to the active unit,
+ * which may be bound to other units, too. */
+static void SetTextureParameterState( int (&aState)[NUM_TextureUnit], bool b )
+{
+	if (g_bConcurrentRendering)
+		return;
+
+	const uintptr_t iTexture = g_BatchState.iBoundTexture[g_ActiveTextureUnit];
+	FOREACH_ENUM( TextureUnit, tu )
+	{
+		if (g_BatchState.iBoundTexture[tu] == iTexture)
+			aState[tu] = -1;
+	}
+	aState[g_ActiveTextureUnit] = b;
+}
+
+static bool CanBatchQuads( const RageMatrix &modelView )
+{
+	if (!g_bBatchQuads || g_bConcurrentRendering)
+		return false;
+
+	/* Batched quads are drawn with an identity model view, so nothing that
+	 * looks at the model view or the normals can be on. */
+	if (g_BatchState.iLighting != 0 || g_BatchState.Effect != EffectMode_Normal || g_BatchState.iCelStage != 0)
+		return false;
+	FOREACH_ENUM( TextureUnit, tu )
+	{
+		if (g_BatchState.bSphereMapping[tu])
+			return false;
+	}
+
+	/* Only affine transforms are done on the CPU. */
+	return modelView.m[0][3] == 0 && modelView.m[1][3] == 0 &&
+		modelView.m[2][3] == 0 && modelView.m[3][3] == 1;
+}
 
 static RageDisplay::RagePixelFormatDesc PIXEL_FORMAT_DESC[NUM_RagePixelFormat] = {
 	{
@@ -264,6 +414,7 @@ RageDisplay_Legacy::RageDisplay_Legacy()
 	g_pWind = nullptr;
 	g_bTextureMatrixShader = 0;
     offscreenRenderTarget = nullptr;
+	ForgetBatchState();
 }
 
 RString GetInfoLog( GLhandleARB h )
@@ -562,6 +713,8 @@ RString RageDisplay_Legacy::Init( const VideoModeParams &p, bool bAllowUnacceler
 
 RageDisplay_Legacy::~RageDisplay_Legacy()
 {
+	g_QuadBatch.vVerts.clear();
+	g_QuadBatch.iBuffer = 0;
 	delete g_pWind;
 }
 
@@ -801,6 +954,9 @@ RString RageDisplay_Legacy::TryVideoMode( const VideoModeParams &p, bool &bNewDe
 
 		/* Recreate all vertex buffers. */
 		InvalidateObjects();
+		g_QuadBatch.vVerts.clear();
+		g_QuadBatch.iBuffer = 0;
+		ForgetBatchState();
 
 		InitShaders();
 	}
@@ -834,6 +990,7 @@ bool RageDisplay_Legacy::BeginFrame()
 	int fWidth = g_pWind->GetActualVideoModeParams().windowWidth;
 	int fHeight = g_pWind->GetActualVideoModeParams().windowHeight;
 
+	FlushQuadBatch();
 	glViewport( 0, 0, fWidth, fHeight );
 
 	glClearColor( 0,0,0,0 );
@@ -850,6 +1007,7 @@ bool RageDisplay_Legacy::BeginFrame()
 
 void RageDisplay_Legacy::EndFrame()
 {
+	FlushQuadBatch();
 	if (UseOffscreenRenderTarget())
 	{
 		offscreenRenderTarget->FinishRenderingTo();
@@ -866,6 +1024,7 @@ void RageDisplay_Legacy::EndFrame()
 							 static_cast<float> (GetActualVideoModeParams().height) / 2.f );
 		fullscreenSprite.Draw();
 		CameraPopMatrix();
+		FlushQuadBatch();
 	}
 
 	FrameLimitBeforeVsync( g_pWind->GetActualVideoModeParams().rate );
@@ -893,6 +1052,8 @@ RageSurface* RageDisplay_Legacy::CreateScreenshot()
 	int width = g_pWind->GetActualVideoModeParams().width;
 	int height = g_pWind->GetActualVideoModeParams().height;
 
+	FlushQuadBatch();
+
 	RageSurface *image = nullptr;
 	if (offscreenRenderTarget) {
 		RageSurface *raw = GetTexture(offscreenRenderTarget->GetTexHandle());
@@ -927,6 +1088,9 @@ RageSurface *RageDisplay_Legacy::GetTexture( uintptr_t iTexture )
 	if (iTexture == 0)
 		return nullptr; // XXX
 
+	FlushQuadBatch();
+	ForgetBoundTextures();
+
 	FlushGLErrors();
 
 	glBindTexture( GL_TEXTURE_2D, static_cast<GLuint>(iTexture) );
@@ -1005,9 +1169,8 @@ static void SetupVertices( const RageSpriteVertex v[], int iNumVerts )
 	glNormalPointer( GL_FLOAT, 0, Normal );
 }
 
-void RageDisplay_Legacy::SendCurrentMatrices()
+void RageDisplay_Legacy::GetCurrentMatrices( RageMatrix &projection, RageMatrix &modelView )
 {
-	RageMatrix projection;
 	RageMatrixMultiply( &projection, GetCentering(), GetProjectionTop() );
 
 	if (g_bInvertY)
@@ -1016,12 +1179,24 @@ void RageDisplay_Legacy::SendCurrentMatrices()
 		RageMatrixScale( &flip, +1, -1, +1 );
 		RageMatrixMultiply( &projection, &flip, &projection );
 	}
-	glMatrixMode( GL_PROJECTION );
-	glLoadMatrixf( (const float*)&projection );
 
 	// OpenGL has just "modelView", whereas D3D has "world" and "view"
-	RageMatrix modelView;
 	RageMatrixMultiply( &modelView, GetViewTop(), GetWorldTop() );
+}
+
+void RageDisplay_Legacy::SendCurrentMatrices()
+{
+	/* Everything but batched quads is drawn right away, after the quads
+	 * before it. */
+	FlushQuadBatch();
+	ApplyTextures();
+
+	RageMatrix projection, modelView;
+	GetCurrentMatrices( projection, modelView );
+
+	glMatrixMode( GL_PROJECTION );
+	glLoadMatrixf( (const float*)&projection );
+
 	glMatrixMode( GL_MODELVIEW );
 	glLoadMatrixf( (const float*)&modelView );
 
@@ -1029,6 +1204,108 @@ void RageDisplay_Legacy::SendCurrentMatrices()
 	glLoadMatrixf( (const float*)GetTextureTop() );
 }
 
+void RageDisplay_Legacy::FlushQuadBatch()
+{
+	if (g_QuadBatch.vVerts.empty())
+		return;
+
+	glMatrixMode( GL_PROJECTION );
+	glLoadMatrixf( (const float*)&g_QuadBatch.Projection );
+	glMatrixMode( GL_MODELVIEW );
+	glLoadIdentity();
+	glMatrixMode( GL_TEXTURE );
+	glLoadMatrixf( (const float*)&g_QuadBatch.Texture );
+
+	const GLsizei iStride = sizeof(BatchVertex);
+	const GLsizeiptrARB iSize = g_QuadBatch.vVerts.size() * sizeof(BatchVertex);
+	const char *pBase;
+	if (GLEW_ARB_vertex_buffer_object)
+	{
+		if (g_QuadBatch.iBuffer == 0)
+			glGenBuffersARB( 1, &g_QuadBatch.iBuffer );
+		glBindBufferARB( GL_ARRAY_BUFFER_ARB, g_QuadBatch.iBuffer );
+
+		/* Orphan the last batch's storage, so we don't wait for the GPU to
+		 * finish drawing from it. */
+		glBufferDataARB( GL_ARRAY_BUFFER_ARB, iSize, nullptr, GL_STREAM_DRAW_ARB );
+		glBufferSubDataARB( GL_ARRAY_BUFFER_ARB, 0, iSize, &g_QuadBatch.vVerts[0] );
+		pBase = nullptr;
+	}
+	else
+	{
+		pBase = reinterpret_cast<const char *>( &g_QuadBatch.vVerts[0] );
+	}
+
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glVertexPointer( 3, GL_FLOAT, iStride, pBase + offsetof(BatchVertex, p) );
+
+	glEnableClientState( GL_COLOR_ARRAY );
+	glColorPointer( 4, GL_UNSIGNED_BYTE, iStride, pBase + offsetof(BatchVertex, c) );
+
+	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+	glTexCoordPointer( 2, GL_FLOAT, iStride, pBase + offsetof(BatchVertex, t) );
+
+	if (GLEW_ARB_multitexture)
+	{
+		glClientActiveTextureARB( GL_TEXTURE1_ARB );
+		glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+		glTexCoordPointer( 2, GL_FLOAT, iStride, pBase + offsetof(BatchVertex, t) );
+		glClientActiveTextureARB( GL_TEXTURE0_ARB );
+	}
+
+	glEnableClientState( GL_NORMAL_ARRAY );
+	glNormalPointer( GL_FLOAT, iStride, pBase + offsetof(BatchVertex, n) );
+
+	glDrawArrays( GL_QUADS, 0, g_QuadBatch.vVerts.size() );
+	TurnOffHardwareVBO();
+
+	StatsAddBatchedDraws( g_QuadBatch.iNumDraws - 1 );
+	g_QuadBatch.vVerts.clear();
+	g_QuadBatch.iNumDraws = 0;
+}
+
+void RageDisplay_Legacy::ApplyTextures()
+{
+	/* SetTexture binds right away. */
+	if (g_bConcurrentRendering)
+		return;
+
+	FOREACH_ENUM( TextureUnit, tu )
+	{
+		const uintptr_t iTexture = g_BatchState.iTexture[tu];
+		if (iTexture == UNKNOWN_TEXTURE)
+			continue;
+
+		const bool bEnable = iTexture != 0;
+		const bool bBind = bEnable && g_BatchState.iBoundTexture[tu] != iTexture;
+		if (!bBind && g_BatchState.iTextureEnabled[tu] == int(bEnable))
+			continue;
+
+		/* This is what SetTexture used to do right away. */
+		FlushQuadBatch();
+		const TextureUnit OldUnit = g_ActiveTextureUnit;
+		if (!SetTextureUnit( tu ))
+			continue;
+		if (bEnable)
+		{
+			glEnable( GL_TEXTURE_2D );
+			if (bBind)
+			{
+				glBindTexture( GL_TEXTURE_2D, static_cast<GLuint>(iTexture) );
+				g_BatchState.iBoundTexture[tu] = iTexture;
+				g_BatchState.iWrapping[tu] = -1;
+				g_BatchState.iFiltering[tu] = -1;
+			}
+		}
+		else
+		{
+			glDisable( GL_TEXTURE_2D );
+		}
+		g_BatchState.iTextureEnabled[tu] = bEnable;
+		SetTextureUnit( OldUnit );
+	}
+}
+
 class RageCompiledGeometrySWOGL : public RageCompiledGeometry
 {
 public:
@@ -1482,11 +1759,55 @@ void RageDisplay_Legacy::DeleteCompiledGeometry( RageCompiledGeometry* p )
 
 void RageDisplay_Legacy::DrawQuadsInternal( const RageSpriteVertex v[], int iNumVerts )
 {
-	TurnOffHardwareVBO();
-	SendCurrentMatrices();
+	RageMatrix projection, modelView;
+	GetCurrentMatrices( projection, modelView );
+	if (!CanBatchQuads( modelView ))
+	{
+		TurnOffHardwareVBO();
+		SendCurrentMatrices();
 
-	SetupVertices( v, iNumVerts );
-	glDrawArrays( GL_QUADS, 0, iNumVerts );
+		SetupVertices( v, iNumVerts );
+		glDrawArrays( GL_QUADS, 0, iNumVerts );
+		return;
+	}
+
+	/* Textures set since the last quads break up the batch here. */
+	ApplyTextures();
+
+	const RageMatrix &texture = *GetTextureTop();
+	if (!g_QuadBatch.vVerts.empty() &&
+		(g_QuadBatch.vVerts.size() + iNumVerts > MAX_BATCH_VERTICES ||
+		 memcmp(&projection, &g_QuadBatch.Projection, sizeof(RageMatrix)) ||
+		 memcmp(&texture, &g_QuadBatch.Texture, sizeof(RageMatrix))))
+		FlushQuadBatch();
+
+	if (g_QuadBatch.vVerts.empty())
+	{
+		g_QuadBatch.Projection = projection;
+		g_QuadBatch.Texture = texture;
+	}
+
+	const float (&m)[4][4] = modelView.m;
+	const size_t iStart = g_QuadBatch.vVerts.size();
+	g_QuadBatch.vVerts.resize( iStart + iNumVerts );
+	for( int i = 0; i < iNumVerts; ++i )
+	{
+		const RageSpriteVertex &in = v[i];
+		BatchVertex &out = g_QuadBatch.vVerts[iStart + i];
+		out.p[0] = m[0][0]*in.p.x + m[1][0]*in.p.y + m[2][0]*in.p.z + m[3][0];
+		out.p[1] = m[0][1]*in.p.x + m[1][1]*in.p.y + m[2][1]*in.p.z + m[3][1];
+		out.p[2] = m[0][2]*in.p.x + m[1][2]*in.p.y + m[2][2]*in.p.z + m[3][2];
+		out.n[0] = in.n.x;
+		out.n[1] = in.n.y;
+		out.n[2] = in.n.z;
+		out.c[0] = in.c.r;
+		out.c[1] = in.c.g;
+		out.c[2] = in.c.b;
+		out.c[3] = in.c.a;
+		out.t[0] = in.t.x;
+		out.t[1] = in.t.y;
+	}
+	++g_QuadBatch.iNumDraws;
 }
 
 void RageDisplay_Legacy::DrawQuadStripInternal( const RageSpriteVertex v[], int iNumVerts )
@@ -1657,6 +1978,7 @@ static bool SetTextureUnit( TextureUnit tu )
 	if ((int) tu > g_iMaxTextureUnits)
 		return false;
 	glActiveTextureARB( enum_add2(GL_TEXTURE0_ARB, tu) );
+	g_ActiveTextureUnit = tu;
 	return true;
 }
 
@@ -1668,7 +1990,10 @@ void RageDisplay_Legacy::ClearAllTextures()
 	// HACK:  Reset the active texture to 0.
 	// TODO:  Change all texture functions to take a stage number.
 	if (GLEW_ARB_multitexture)
+	{
 		glActiveTextureARB(GL_TEXTURE0_ARB);
+		g_ActiveTextureUnit = TextureUnit_1;
+	}
 }
 
 int RageDisplay_Legacy::GetNumTextureUnits()
@@ -1684,6 +2009,13 @@ void RageDisplay_Legacy::SetTexture( TextureUnit tu, uintptr_t iTexture )
 	if (!SetTextureUnit( tu ))
 		return;
 
+	/* Bound by ApplyTextures when something is drawn. */
+	if (!g_bConcurrentRendering)
+	{
+		g_BatchState.iTexture[tu] = iTexture;
+		return;
+	}
+
 	if (iTexture)
 	{
 		glEnable( GL_TEXTURE_2D );
@@ -1700,6 +2032,11 @@ void RageDisplay_Legacy::SetTextureMode( TextureUnit tu, TextureMode tm )
 	if (!SetTextureUnit( tu ))
 		return;
 
+	if (IsBatchedState( g_BatchState.TexMode[tu], tm ))
+		return;
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.TexMode[tu], tm );
+
 	switch( tm )
 	{
 		case TextureMode_Modulate:
@@ -1715,6 +2052,7 @@ void RageDisplay_Legacy::SetTextureMode( TextureUnit tu, TextureMode tm )
 				/* This is changing blend state, instead of texture state, which
 				 * isn't great, but it's better than doing nothing. */
 				glBlendFunc( GL_SRC_ALPHA, GL_ONE );
+				SetBatchState( g_BatchState.Blend, BlendMode_Invalid );
 				return;
 			}
 
@@ -1738,6 +2076,13 @@ void RageDisplay_Legacy::SetTextureMode( TextureUnit tu, TextureMode tm )
 
 void RageDisplay_Legacy::SetTextureFiltering( TextureUnit tu, bool b )
 {
+	/* This sets the texture bound to the active unit, whichever one that is. */
+	ApplyTextures();
+	if (IsBatchedState( g_BatchState.iFiltering[g_ActiveTextureUnit], int(b) ))
+		return;
+	FlushQuadBatch();
+	SetTextureParameterState( g_BatchState.iFiltering, b );
+
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, b ? GL_LINEAR : GL_NEAREST);
 	
 	GLint iMinFilter;
@@ -1770,9 +2115,18 @@ void RageDisplay_Legacy::SetTextureFiltering( TextureUnit tu, bool b )
 
 void RageDisplay_Legacy::SetEffectMode( EffectMode effect )
 {
+	if (IsBatchedState( g_BatchState.Effect, effect ) && g_BatchState.iCelStage == 0)
+		return;
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.Effect, effect );
+	SetBatchState( g_BatchState.iCelStage, 0 );
+
 	if (!GLEW_ARB_fragment_program || !GLEW_ARB_shading_language_100 || !GLEW_ARB_shader_objects)
 		return;
 
+	/* The YUYV shader reads the bound texture's width. */
+	ApplyTextures();
+
 	GLhandleARB hShader = 0;
 	switch (effect)
 	{
@@ -1860,6 +2214,11 @@ bool RageDisplay_Legacy::IsEffectModeSupported( EffectMode effect )
 
 void RageDisplay_Legacy::SetBlendMode( BlendMode mode )
 {
+	if (IsBatchedState( g_BatchState.Blend, mode ))
+		return;
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.Blend, mode );
+
 	glEnable(GL_BLEND);
 
 	if (glBlendEquation != nullptr)
@@ -1941,6 +2300,7 @@ bool RageDisplay_Legacy::IsZTestEnabled() const
 
 void RageDisplay_Legacy::ClearZBuffer()
 {
+	FlushQuadBatch();
 	bool write = IsZWriteEnabled();
 	SetZWrite( true );
 	glClear( GL_DEPTH_BUFFER_BIT );
@@ -1949,11 +2309,21 @@ void RageDisplay_Legacy::ClearZBuffer()
 
 void RageDisplay_Legacy::SetZWrite( bool b )
 {
+	if (IsBatchedState( g_BatchState.iZWrite, int(b) ))
+		return;
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.iZWrite, int(b) );
+
 	glDepthMask( b );
 }
 
 void RageDisplay_Legacy::SetZBias( float f )
 {
+	if (IsBatchedState( g_BatchState.fZBias, f ))
+		return;
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.fZBias, f );
+
 	float fNear = SCALE( f, 0.0f, 1.0f, 0.05f, 0.0f );
 	float fFar = SCALE( f, 0.0f, 1.0f, 1.0f, 0.95f );
 
@@ -1962,6 +2332,11 @@ void RageDisplay_Legacy::SetZBias( float f )
 
 void RageDisplay_Legacy::SetZTestMode( ZTestMode mode )
 {
+	if (IsBatchedState( g_BatchState.ZTest, mode ))
+		return;
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.ZTest, mode );
+
 	glEnable( GL_DEPTH_TEST );
 	switch( mode )
 	{
@@ -1979,6 +2354,11 @@ void RageDisplay_Legacy::SetTextureWrapping( TextureUnit tu, bool b )
 	 * so we'll behave incorrectly if the same texture is used in more than one texture
 	 * unit simultaneously with different wrapping. */
 	SetTextureUnit( tu );
+	ApplyTextures();
+	if (IsBatchedState( g_BatchState.iWrapping[g_ActiveTextureUnit], int(b) ))
+		return;
+	FlushQuadBatch();
+	SetTextureParameterState( g_BatchState.iWrapping, b );
 	
 	GLenum mode = b ? GL_REPEAT : GL_CLAMP_TO_EDGE;
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, mode );
@@ -1998,6 +2378,7 @@ void RageDisplay_Legacy::SetMaterial(
 	// want Models to have basic color and transparency.
 	// We can do this fake lighting by setting the vertex color.
 	// XXX: unintended: SetLighting must be called before SetMaterial
+	FlushQuadBatch();
 	GLboolean bLighting;
 	glGetBooleanv( GL_LIGHTING, &bLighting );
 
@@ -2021,6 +2402,9 @@ void RageDisplay_Legacy::SetMaterial(
 
 void RageDisplay_Legacy::SetLighting( bool b )
 {
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.iLighting, int(b) );
+
 	if (b)
 		glEnable(GL_LIGHTING);
 	else
@@ -2029,6 +2413,7 @@ void RageDisplay_Legacy::SetLighting( bool b )
 
 void RageDisplay_Legacy::SetLightOff( int index )
 {
+	FlushQuadBatch();
 	glDisable( GL_LIGHT0+index );
 }
 
@@ -2041,6 +2426,7 @@ void RageDisplay_Legacy::SetLightDirectional(
 {
 	// Light coordinates are transformed by the modelview matrix, but
 	// we are being passed in world-space coords.
+	FlushQuadBatch();
 	glPushMatrix();
 	glLoadIdentity();
 
@@ -2056,6 +2442,11 @@ void RageDisplay_Legacy::SetLightDirectional(
 
 void RageDisplay_Legacy::SetCullMode( CullMode mode )
 {
+	if (IsBatchedState( g_BatchState.Cull, mode ))
+		return;
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.Cull, mode );
+
 	if (mode != CULL_NONE)
 		glEnable(GL_CULL_FACE);
 	switch( mode )
@@ -2087,12 +2478,17 @@ bool RageDisplay_Legacy::SupportsThreadedRendering()
 
 void RageDisplay_Legacy::BeginConcurrentRenderingMainThread()
 {
+	FlushQuadBatch();
+	ApplyTextures();
+	g_bConcurrentRendering = true;
 	g_pWind->BeginConcurrentRenderingMainThread();
 }
 
 void RageDisplay_Legacy::EndConcurrentRenderingMainThread()
 {
 	g_pWind->EndConcurrentRenderingMainThread();
+	g_bConcurrentRendering = false;
+	ForgetBoundTextures();
 }
 
 void RageDisplay_Legacy::BeginConcurrentRendering()
@@ -2111,6 +2507,10 @@ void RageDisplay_Legacy::DeleteTexture( uintptr_t iTexture )
 	if (iTexture == 0)
 		return;
 
+	/* Deleting a bound texture unbinds it. */
+	FlushQuadBatch();
+	ForgetBoundTextures();
+
 	if (g_mapRenderTargets.find(iTexture) != g_mapRenderTargets.end())
 	{
 		delete g_mapRenderTargets[iTexture];
@@ -2233,6 +2633,8 @@ uintptr_t RageDisplay_Legacy::CreateTexture(
 		}
 	}
 
+	FlushQuadBatch();
+	ForgetBoundTextures();
 	SetTextureUnit( TextureUnit_1 );
 
 	// allocate OpenGL texture resource
@@ -2414,6 +2816,8 @@ void RageDisplay_Legacy::UpdateTexture(
 	RageSurface* pImg,
 	int iXOffset, int iYOffset, int iWidth, int iHeight )
 {
+	FlushQuadBatch();
+	ForgetBoundTextures();
 	glBindTexture( GL_TEXTURE_2D, static_cast<GLuint>(iTexHandle) );
 
 	bool bFreeImg;
@@ -2586,6 +2990,9 @@ bool RageDisplay_Legacy::SupportsFullscreenBorderlessWindow() const
 
 uintptr_t RageDisplay_Legacy::CreateRenderTarget( const RenderTargetParam &param, int &iTextureWidthOut, int &iTextureHeightOut )
 {
+	FlushQuadBatch();
+	ForgetBoundTextures();
+
 	RenderTarget *pTarget;
 	if (GLEW_EXT_framebuffer_object)
 		pTarget = new RenderTarget_FramebufferObject;
@@ -2611,6 +3018,10 @@ uintptr_t RageDisplay_Legacy::GetRenderTarget()
 
 void RageDisplay_Legacy::SetRenderTarget( uintptr_t iTexture, bool bPreserveTexture )
 {
+	/* The render target may be in a different OpenGL context. */
+	FlushQuadBatch();
+	ForgetBatchState();
+
 	if (iTexture == 0)
 	{
 		g_bInvertY = false;
@@ -2680,11 +3091,13 @@ void RageDisplay_Legacy::SetPolygonMode(PolygonMode pm)
 	default:
 		FAIL_M(ssprintf("Invalid PolygonMode: %i", pm));
 	}
+	FlushQuadBatch();
 	glPolygonMode(GL_FRONT_AND_BACK, m);
 }
 
 void RageDisplay_Legacy::SetLineWidth(float fWidth)
 {
+	FlushQuadBatch();
 	glLineWidth(fWidth);
 }
 
@@ -2727,6 +3140,7 @@ RString RageDisplay_Legacy::GetTextureDiagnostics(unsigned iTexture) const
  */
 void RageDisplay_Legacy::SetAlphaTest(bool b)
 {
+	FlushQuadBatch();
 	// Previously this was 0.01, rather than 0x01.
 	glAlphaFunc(GL_GREATER, 0.00390625 /* 1/256 */);
 	if (b)
@@ -2794,6 +3208,9 @@ void RageDisplay_Legacy::SetSphereEnvironmentMapping(TextureUnit tu, bool b)
 	if (!SetTextureUnit(tu))
 		return;
 
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.bSphereMapping[tu], b );
+
 	if (b)
 	{
 		glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_SPHERE_MAP);
@@ -2812,6 +3229,10 @@ GLint iCelTexture1, iCelTexture2 = 0;
 
 void RageDisplay_Legacy::SetCelShaded( int stage )
 {
+	FlushQuadBatch();
+	SetBatchState( g_BatchState.iCelStage, stage == 1 || stage == 2? stage:0 );
+	SetBatchState( g_BatchState.Effect, EffectMode_Normal );
+
 	if (!GLEW_ARB_fragment_program && !GL_ARB_shading_language_100)
 		return; // not supported
 
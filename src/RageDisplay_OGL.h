@@ -133,6 +133,12 @@ protected:
 	bool SupportsSurfaceFormat( RagePixelFormat pixfmt );
 	
 	void SendCurrentMatrices();
+	void GetCurrentMatrices( RageMatrix &projection, RageMatrix &modelView );
+
+	/** @brief Draw the quads that DrawQuadsInternal has held back. */
+	void FlushQuadBatch();
+	/** @brief Bind the textures SetTexture asked for. */
+	void ApplyTextures();
 
 private:
 	RageTextureRenderTarget *offscreenRenderTarget;
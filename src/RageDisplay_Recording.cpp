@@ -0,0 +1,410 @@
+#include "global.h"
+
+#include "RageDisplay_Recording.h"
+#include "RageFile.h"
+#include "RageLog.h"
+#include "RageSurface.h"
+#include "RageUtil.h"
+
+/*
+ * A trace starts with "SMRT" and a version byte, currently 1.  Then each
+ * call is one TraceOp byte, followed by its arguments as unsigned LEB128
+ * varints:
+ *
+ * Draw calls: the number of vertices.  For compiled geometry, that's the
+ * vertices in the mesh drawn.
+ * CreateTexture, UpdateTexture: the texture handle, width and height.
+ * DeleteTexture: the texture handle.
+ * Texture: the texture unit and handle; 0 is no texture.
+ * TextureMode, TextureWrapping, TextureFiltering, SphereEnvironmentMapping:
+ * the texture unit and the value.
+ * LightOff: the light index.
+ * LightDirectional: the light index and a hash of its colors and direction.
+ * Material: a hash of its colors and shininess.
+ * ZBias, LineWidth: the bits of the float.
+ * Other state calls: the value.  ClearAllTextures, ClearZBuffer and EndFrame
+ * have no arguments.
+ *
+ * Every frame ends with EndFrame, so a trace cut short can still be read up
+ * to the last whole frame.
+ */
+static const uint8_t TRACE_VERSION = 1;
+static const uint64_t STATE_UNKNOWN = ~uint64_t(0);
+
+class RageCompiledGeometryRecording: public RageCompiledGeometry
+{
+public:
+	void Allocate( const vector<msMesh> & ) { }
+	void Change( const vector<msMesh> & ) { }
+	void Draw( int /* iMeshIndex */ ) const { }
+
+	int GetNumVertices( int iMeshIndex ) const { return m_vMeshInfo[iMeshIndex].iVertexCount; }
+};
+
+static uint32_t HashFloats( const float *p, int iCount, uint32_t iHash = 2166136261u )
+{
+	const uint8_t *pBytes = (const uint8_t *) p;
+	for( unsigned i = 0; i < iCount*sizeof(float); ++i )
+		iHash = (iHash ^ pBytes[i]) * 16777619u;
+	return iHash;
+}
+
+static uint32_t FloatBits( float f )
+{
+	uint32_t i;
+	memcpy( &i, &f, sizeof(i) );
+	return i;
+}
+
+RageDisplay_Recording::RageDisplay_Recording()
+{
+	LOG->MapLog( "renderer", "Current renderer: recording" );
+
+	ZERO( m_Frame );
+	ZERO( m_LastFrame );
+	m_iNumFrames = 0;
+	for( int op = 0; op < NUM_TraceOp; ++op )
+		for( int i = 0; i < MAX_STATE_INDEX; ++i )
+			m_LastState[op][i] = STATE_UNKNOWN;
+	m_bZWrite = false;
+	m_bZTest = false;
+	m_iNextTexture = 1;
+	m_pTrace = nullptr;
+}
+
+RageDisplay_Recording::~RageDisplay_Recording()
+{
+	CloseTrace();
+}
+
+bool RageDisplay_Recording::OpenTrace( const RString &sPath )
+{
+	CloseTrace();
+
+	m_pTrace = new RageFile;
+	if( !m_pTrace->Open(sPath, RageFile::WRITE) )
+	{
+		LOG->Warn( "Couldn't write draw trace \"%s\": %s", sPath.c_str(), m_pTrace->GetError().c_str() );
+		SAFE_DELETE( m_pTrace );
+		return false;
+	}
+
+	m_pTrace->Write( "SMRT" );
+	m_pTrace->Write( &TRACE_VERSION, 1 );
+	m_Trace.clear();
+	return true;
+}
+
+void RageDisplay_Recording::CloseTrace()
+{
+	if( m_pTrace == nullptr )
+		return;
+
+	// Whatever was recorded of the current frame is left out.
+	if( m_pTrace->Flush() == -1 )
+		LOG->Warn( "Couldn't write draw trace: %s", m_pTrace->GetError().c_str() );
+	SAFE_DELETE( m_pTrace );
+	m_Trace.clear();
+}
+
+void RageDisplay_Recording::RecordArg( uint64_t iArg )
+{
+	if( m_pTrace == nullptr )
+		return;
+	while( iArg >= 0x80 )
+	{
+		m_Trace.push_back( uint8_t(iArg) | 0x80 );
+		iArg >>= 7;
+	}
+	m_Trace.push_back( uint8_t(iArg) );
+}
+
+void RageDisplay_Recording::RecordDraw( TraceOp op, int iNumVerts )
+{
+	++m_Frame.iDrawCalls;
+	m_Frame.iVertices += iNumVerts;
+	RecordOp( op );
+	RecordArg( iNumVerts );
+}
+
+void RageDisplay_Recording::RecordState( TraceOp op, int iIndex, uint32_t iValue )
+{
+	uint64_t &iLast = m_LastState[op][min(iIndex, MAX_STATE_INDEX-1)];
+	if( iLast == iValue )
+		++m_Frame.iRedundantCalls;
+	else if( op == TraceOp_Texture )
+		++m_Frame.iTextureBinds;
+	else
+		++m_Frame.iStateChanges;
+	iLast = iValue;
+
+	RecordOp( op );
+	switch( op )
+	{
+	case TraceOp_Texture:
+	case TraceOp_TextureMode:
+	case TraceOp_TextureWrapping:
+	case TraceOp_TextureFiltering:
+	case TraceOp_SphereEnvironmentMapping:
+	case TraceOp_LightDirectional:
+		RecordArg( iIndex );
+		break;
+	case TraceOp_LightOff:
+		RecordArg( iIndex );
+		return;
+	default:
+		break;
+	}
+	RecordArg( iValue );
+}
+
+void RageDisplay_Recording::EndFrame()
+{
+	RecordOp( TraceOp_EndFrame );
+	if( m_pTrace != nullptr )
+	{
+		if( m_pTrace->Write(m_Trace.data(), m_Trace.size()) == -1 )
+		{
+			LOG->Warn( "Couldn't write draw trace: %s", m_pTrace->GetError().c_str() );
+			SAFE_DELETE( m_pTrace );
+		}
+		m_Trace.clear();
+	}
+
+	m_LastFrame = m_Frame;
+	ZERO( m_Frame );
+	++m_iNumFrames;
+
+	RageDisplay_Null::EndFrame();
+}
+
+void RageDisplay_Recording::SetBlendMode( BlendMode mode )
+{
+	RecordState( TraceOp_BlendMode, 0, mode );
+}
+
+uintptr_t RageDisplay_Recording::CreateTexture( RagePixelFormat /* pixfmt */, RageSurface *img, bool /* bGenerateMipMaps */ )
+{
+	const uintptr_t iTexHandle = m_iNextTexture++;
+	++m_Frame.iTextureUploads;
+	RecordOp( TraceOp_CreateTexture );
+	RecordArg( iTexHandle );
+	RecordArg( img->w );
+	RecordArg( img->h );
+	return iTexHandle;
+}
+
+void RageDisplay_Recording::UpdateTexture( uintptr_t iTexHandle, RageSurface * /* img */,
+	int /* xoffset */, int /* yoffset */, int width, int height )
+{
+	++m_Frame.iTextureUploads;
+	RecordOp( TraceOp_UpdateTexture );
+	RecordArg( iTexHandle );
+	RecordArg( width );
+	RecordArg( height );
+}
+
+void RageDisplay_Recording::DeleteTexture( uintptr_t iTexHandle )
+{
+	RecordOp( TraceOp_DeleteTexture );
+	RecordArg( iTexHandle );
+}
+
+void RageDisplay_Recording::ClearAllTextures()
+{
+	++m_Frame.iStateChanges;
+	for( int i = 0; i < MAX_STATE_INDEX; ++i )
+		m_LastState[TraceOp_Texture][i] = 0;
+	RecordOp( TraceOp_ClearAllTextures );
+}
+
+void RageDisplay_Recording::SetTexture( TextureUnit tu, uintptr_t iTexture )
+{
+	RecordState( TraceOp_Texture, tu, iTexture );
+}
+
+void RageDisplay_Recording::SetTextureMode( TextureUnit tu, TextureMode tm )
+{
+	RecordState( TraceOp_TextureMode, tu, tm );
+}
+
+void RageDisplay_Recording::SetTextureWrapping( TextureUnit tu, bool b )
+{
+	RecordState( TraceOp_TextureWrapping, tu, b );
+}
+
+void RageDisplay_Recording::SetTextureFiltering( TextureUnit tu, bool b )
+{
+	RecordState( TraceOp_TextureFiltering, tu, b );
+}
+
+void RageDisplay_Recording::SetZWrite( bool b )
+{
+	m_bZWrite = b;
+	RecordState( TraceOp_ZWrite, 0, b );
+}
+
+void RageDisplay_Recording::SetZBias( float f )
+{
+	RecordState( TraceOp_ZBias, 0, FloatBits(f) );
+}
+
+void RageDisplay_Recording::SetZTestMode( ZTestMode mode )
+{
+	m_bZTest = mode != ZTEST_OFF;
+	RecordState( TraceOp_ZTestMode, 0, mode );
+}
+
+void RageDisplay_Recording::ClearZBuffer()
+{
+	++m_Frame.iStateChanges;
+	RecordOp( TraceOp_ClearZBuffer );
+}
+
+void RageDisplay_Recording::SetCullMode( CullMode mode )
+{
+	RecordState( TraceOp_CullMode, 0, mode );
+}
+
+void RageDisplay_Recording::SetAlphaTest( bool b )
+{
+	RecordState( TraceOp_AlphaTest, 0, b );
+}
+
+void RageDisplay_Recording::SetMaterial(
+	const RageColor &emissive,
+	const RageColor &ambient,
+	const RageColor &diffuse,
+	const RageColor &specular,
+	float shininess )
+{
+	uint32_t iHash = HashFloats( emissive, 4 );
+	iHash = HashFloats( ambient, 4, iHash );
+	iHash = HashFloats( diffuse, 4, iHash );
+	iHash = HashFloats( specular, 4, iHash );
+	iHash = HashFloats( &shininess, 1, iHash );
+	RecordState( TraceOp_Material, 0, iHash );
+}
+
+void RageDisplay_Recording::SetLighting( bool b )
+{
+	RecordState( TraceOp_Lighting, 0, b );
+}
+
+void RageDisplay_Recording::SetLightOff( int index )
+{
+	// Turning a light off forgets what it was set to.
+	m_LastState[TraceOp_LightDirectional][min(index, MAX_STATE_INDEX-1)] = STATE_UNKNOWN;
+	RecordState( TraceOp_LightOff, index, 0 );
+}
+
+void RageDisplay_Recording::SetLightDirectional(
+	int index,
+	const RageColor &ambient,
+	const RageColor &diffuse,
+	const RageColor &specular,
+	const RageVector3 &dir )
+{
+	m_LastState[TraceOp_LightOff][min(index, MAX_STATE_INDEX-1)] = STATE_UNKNOWN;
+	uint32_t iHash = HashFloats( ambient, 4 );
+	iHash = HashFloats( diffuse, 4, iHash );
+	iHash = HashFloats( specular, 4, iHash );
+	iHash = HashFloats( dir, 3, iHash );
+	RecordState( TraceOp_LightDirectional, index, iHash );
+}
+
+void RageDisplay_Recording::SetSphereEnvironmentMapping( TextureUnit tu, bool b )
+{
+	RecordState( TraceOp_SphereEnvironmentMapping, tu, b );
+}
+
+void RageDisplay_Recording::SetCelShaded( int stage )
+{
+	RecordState( TraceOp_CelShaded, 0, stage );
+}
+
+void RageDisplay_Recording::SetPolygonMode( PolygonMode pm )
+{
+	RecordState( TraceOp_PolygonMode, 0, pm );
+}
+
+void RageDisplay_Recording::SetLineWidth( float fWidth )
+{
+	RecordState( TraceOp_LineWidth, 0, FloatBits(fWidth) );
+}
+
+RageCompiledGeometry* RageDisplay_Recording::CreateCompiledGeometry()
+{
+	return new RageCompiledGeometryRecording;
+}
+
+void RageDisplay_Recording::DeleteCompiledGeometry( RageCompiledGeometry *p )
+{
+	delete p;
+}
+
+void RageDisplay_Recording::DrawQuadsInternal( const RageSpriteVertex /* v */[], int iNumVerts )
+{
+	RecordDraw( TraceOp_DrawQuads, iNumVerts );
+}
+
+void RageDisplay_Recording::DrawQuadStripInternal( const RageSpriteVertex /* v */[], int iNumVerts )
+{
+	RecordDraw( TraceOp_DrawQuadStrip, iNumVerts );
+}
+
+void RageDisplay_Recording::DrawFanInternal( const RageSpriteVertex /* v */[], int iNumVerts )
+{
+	RecordDraw( TraceOp_DrawFan, iNumVerts );
+}
+
+void RageDisplay_Recording::DrawStripInternal( const RageSpriteVertex /* v */[], int iNumVerts )
+{
+	RecordDraw( TraceOp_DrawStrip, iNumVerts );
+}
+
+void RageDisplay_Recording::DrawTrianglesInternal( const RageSpriteVertex /* v */[], int iNumVerts )
+{
+	RecordDraw( TraceOp_DrawTriangles, iNumVerts );
+}
+
+void RageDisplay_Recording::DrawCompiledGeometryInternal( const RageCompiledGeometry *p, int iMeshIndex )
+{
+	const RageCompiledGeometryRecording *pGeometry = static_cast<const RageCompiledGeometryRecording *>( p );
+	RecordDraw( TraceOp_DrawCompiledGeometry, pGeometry->GetNumVertices(iMeshIndex) );
+}
+
+void RageDisplay_Recording::DrawLineStripInternal( const RageSpriteVertex /* v */[], int iNumVerts, float /* LineWidth */ )
+{
+	RecordDraw( TraceOp_DrawLineStrip, iNumVerts );
+}
+
+void RageDisplay_Recording::DrawSymmetricQuadStripInternal( const RageSpriteVertex /* v */[], int iNumVerts )
+{
+	RecordDraw( TraceOp_DrawSymmetricQuadStrip, iNumVerts );
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -0,0 +1,188 @@
+/* RageDisplay_Recording - Renderer that draws nothing, but records what it was asked to draw. */
+
+#ifndef RAGE_DISPLAY_RECORDING_H
+#define RAGE_DISPLAY_RECORDING_H
+
+#include "RageDisplay.h"
+#include "RageDisplay_Null.h"
+
+class RageFile;
+
+/**
+ * @brief A null renderer that counts every draw call, state change and
+ * texture bind, frame by frame.
+ *
+ * This measures what drawing costs on the CPU on machines with no GPU, and
+ * shows how well draws are batched.  While a trace is open, everything each
+ * frame does is also written to it, in the form described in
+ * RageDisplay_Recording.cpp. */
+class RageDisplay_Recording: public RageDisplay_Null
+{
+public:
+	struct FrameStats
+	{
+		int iDrawCalls;
+		int iVertices;
+		/** @brief SetTexture calls that changed the texture. */
+		int iTextureBinds;
+		/** @brief Other state calls that changed something. */
+		int iStateChanges;
+		/** @brief Texture and state calls that changed nothing. */
+		int iRedundantCalls;
+		/** @brief Textures created or updated. */
+		int iTextureUploads;
+	};
+
+	RageDisplay_Recording();
+	~RageDisplay_Recording();
+
+	virtual RString GetApiDescription() const { return "Recording"; }
+
+	/** @brief Start writing every frame to a trace file. */
+	bool OpenTrace( const RString &sPath );
+	void CloseTrace();
+
+	/** @brief The number of frames finished so far. */
+	int GetNumFrames() const { return m_iNumFrames; }
+	/** @brief The stats of the last finished frame. */
+	const FrameStats &GetLastFrameStats() const { return m_LastFrame; }
+
+	void EndFrame();
+	void SetBlendMode( BlendMode mode );
+	uintptr_t CreateTexture( RagePixelFormat pixfmt, RageSurface *img, bool bGenerateMipMaps );
+	void UpdateTexture( uintptr_t iTexHandle, RageSurface *img, int xoffset, int yoffset, int width, int height );
+	void DeleteTexture( uintptr_t iTexHandle );
+	void ClearAllTextures();
+	void SetTexture( TextureUnit tu, uintptr_t iTexture );
+	void SetTextureMode( TextureUnit tu, TextureMode tm );
+	void SetTextureWrapping( TextureUnit tu, bool b );
+	void SetTextureFiltering( TextureUnit tu, bool b );
+	bool IsZWriteEnabled() const { return m_bZWrite; }
+	bool IsZTestEnabled() const { return m_bZTest; }
+	void SetZWrite( bool b );
+	void SetZBias( float f );
+	void SetZTestMode( ZTestMode mode );
+	void ClearZBuffer();
+	void SetCullMode( CullMode mode );
+	void SetAlphaTest( bool b );
+	void SetMaterial(
+		const RageColor &emissive,
+		const RageColor &ambient,
+		const RageColor &diffuse,
+		const RageColor &specular,
+		float shininess );
+	void SetLighting( bool b );
+	void SetLightOff( int index );
+	void SetLightDirectional(
+		int index,
+		const RageColor &ambient,
+		const RageColor &diffuse,
+		const RageColor &specular,
+		const RageVector3 &dir );
+	void SetSphereEnvironmentMapping( TextureUnit tu, bool b );
+	void SetCelShaded( int stage );
+	void SetPolygonMode( PolygonMode pm );
+	void SetLineWidth( float fWidth );
+
+	RageCompiledGeometry* CreateCompiledGeometry();
+	void DeleteCompiledGeometry( RageCompiledGeometry *p );
+
+	/** @brief Everything that can be in a trace. */
+	enum TraceOp
+	{
+		TraceOp_EndFrame,
+		TraceOp_DrawQuads,
+		TraceOp_DrawQuadStrip,
+		TraceOp_DrawFan,
+		TraceOp_DrawStrip,
+		TraceOp_DrawTriangles,
+		TraceOp_DrawCompiledGeometry,
+		TraceOp_DrawLineStrip,
+		TraceOp_DrawSymmetricQuadStrip,
+		TraceOp_CreateTexture,
+		TraceOp_UpdateTexture,
+		TraceOp_DeleteTexture,
+		TraceOp_ClearAllTextures,
+		TraceOp_Texture,
+		TraceOp_TextureMode,
+		TraceOp_TextureWrapping,
+		TraceOp_TextureFiltering,
+		TraceOp_BlendMode,
+		TraceOp_ZWrite,
+		TraceOp_ZBias,
+		TraceOp_ZTestMode,
+		TraceOp_ClearZBuffer,
+		TraceOp_CullMode,
+		TraceOp_AlphaTest,
+		TraceOp_Material,
+		TraceOp_Lighting,
+		TraceOp_LightOff,
+		TraceOp_LightDirectional,
+		TraceOp_SphereEnvironmentMapping,
+		TraceOp_CelShaded,
+		TraceOp_PolygonMode,
+		TraceOp_LineWidth,
+		NUM_TraceOp
+	};
+
+protected:
+	void DrawQuadsInternal( const RageSpriteVertex v[], int iNumVerts );
+	void DrawQuadStripInternal( const RageSpriteVertex v[], int iNumVerts );
+	void DrawFanInternal( const RageSpriteVertex v[], int iNumVerts );
+	void DrawStripInternal( const RageSpriteVertex v[], int iNumVerts );
+	void DrawTrianglesInternal( const RageSpriteVertex v[], int iNumVerts );
+	void DrawCompiledGeometryInternal( const RageCompiledGeometry *p, int iMeshIndex );
+	void DrawLineStripInternal( const RageSpriteVertex v[], int iNumVerts, float LineWidth );
+	void DrawSymmetricQuadStripInternal( const RageSpriteVertex v[], int iNumVerts );
+
+private:
+	/* State is tracked per texture unit or light; indexes past this share
+	 * the last slot. */
+	static const int MAX_STATE_INDEX = 8;
+
+	void RecordDraw( TraceOp op, int iNumVerts );
+	void RecordState( TraceOp op, int iIndex, uint32_t iValue );
+	void RecordOp( TraceOp op ) { if( m_pTrace ) m_Trace.push_back( (uint8_t) op ); }
+	void RecordArg( uint64_t iArg );
+
+	FrameStats m_Frame;
+	FrameStats m_LastFrame;
+	int m_iNumFrames;
+
+	/* The last value set by each kind of state call, or STATE_UNKNOWN. */
+	uint64_t m_LastState[NUM_TraceOp][MAX_STATE_INDEX];
+	bool m_bZWrite;
+	bool m_bZTest;
+	uintptr_t m_iNextTexture;
+
+	RageFile *m_pTrace;
+	/* The frame so far, while a trace is open. */
+	vector<uint8_t> m_Trace;
+};
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -24,7 +24,11 @@ public:
 
 		/* Flush the file to disk on close.  Combined with not streaming, this results
 		 * in very safe writes, but is slow. */
-		SLOW_FLUSH	= 0x8
+		SLOW_FLUSH	= 0x8,
+
+		/* Write to the end of the existing file instead of replacing it.  Only
+		 * meaningful with STREAMED, since a safe write starts from an empty file. */
+		APPEND		= 0x10
 	};
 
 	RageFile();
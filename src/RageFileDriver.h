@@ -26,6 +26,14 @@ public:
 	/* Optional: Move to a different place, as if reconstructed with a different path. */
 	virtual bool Remount( const RString & /* sPath */ ) { return false; }
 
+	/* Optional: Start recording which directories under sPath change, down to
+	 * iDepth levels below it.  Return false if changes can't be tracked. */
+	virtual bool StartChangeJournal( const RString & /* sPath */, int /* iDepth */ ) { return false; }
+	/* Optional: Add the directories that changed since the journal was started
+	 * or last read, and forget them.  Return false if that isn't known, in which
+	 * case anything under sPath may have changed. */
+	virtual bool ReadChangeJournal( const RString & /* sPath */, vector<RString> & /* asChangedDirs */ ) { return false; }
+
 	/* Possible error returns from Open, in addition to standard errno.h values: */
 	enum { ERROR_WRITING_NOT_SUPPORTED = -1 };
 // protected:
@@ -42,9 +42,15 @@ static struct FileDriverEntry_DIRRO: public FileDriverEntry
 RageFileDriverDirect::RageFileDriverDirect( const RString &sRoot ):
 	RageFileDriver( new DirectFilenameDB(sRoot) )
 {
+	m_pJournal = nullptr;
 	Remount( sRoot );
 }
 
+RageFileDriverDirect::~RageFileDriverDirect()
+{
+	delete m_pJournal;
+}
+
 
 static RString MakeTempFilename( const RString &sPath )
 {
@@ -75,7 +81,10 @@ static RageFileObjDirect *MakeFileObjDirect( RString sPath, int iMode, int &iErr
 			sOut = MakeTempFilename(sPath);
 
 		/* Open a temporary file for writing. */
-		iFD = DoOpen( sOut, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666 );
+		if( (iMode & RageFile::STREAMED) && (iMode & RageFile::APPEND) )
+			iFD = DoOpen( sOut, O_BINARY|O_WRONLY|O_CREAT|O_APPEND, 0666 );
+		else
+			iFD = DoOpen( sOut, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666 );
 	}
 
 	if( iFD == -1 )
@@ -211,6 +220,9 @@ RageFileObjDirect *RageFileObjDirect::Copy() const
 
 bool RageFileDriverDirect::Remount( const RString &sPath )
 {
+	// The journal watches the old root, so it no longer means anything.
+	SAFE_DELETE( m_pJournal );
+
 	m_sRoot = sPath;
 	((DirectFilenameDB *) FDB)->SetRoot( sPath );
 
@@ -223,6 +235,39 @@ bool RageFileDriverDirect::Remount( const RString &sPath )
 	return true;
 }
 
+bool RageFileDriverDirect::StartChangeJournal( const RString &sPath, int iDepth )
+{
+	if( m_pJournal == nullptr )
+		m_pJournal = new DirectChangeJournal( m_sRoot, FDB );
+	return m_pJournal->Start( sPath, iDepth );
+}
+
+bool RageFileDriverDirect::ReadChangeJournal( const RString &sPath, vector<RString> &asChangedDirs )
+{
+	if( m_pJournal == nullptr )
+		return false;
+
+	/* The journal only knows about the path it was started on, or anything
+	 * below it. */
+	RString sLower = sPath;
+	sLower.MakeLower();
+	RString sJournaled = m_pJournal->GetPath();
+	sJournaled.MakeLower();
+	if( !BeginsWith(sLower, sJournaled) )
+		return false;
+
+	vector<RString> asDirs;
+	bool bRet = m_pJournal->Read( asDirs );
+	for( unsigned i = 0; i < asDirs.size(); ++i )
+	{
+		RString sDir = asDirs[i];
+		sDir.MakeLower();
+		if( BeginsWith(sDir, sLower) )
+			asChangedDirs.push_back( asDirs[i] );
+	}
+	return bRet;
+}
+
 /* The DIRRO driver is just like DIR, except writes are disallowed. */
 RageFileDriverDirectReadOnly::RageFileDriverDirectReadOnly( const RString &sRoot ):
 	RageFileDriverDirect( sRoot ) { }
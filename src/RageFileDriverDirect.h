@@ -4,19 +4,26 @@
 #include "RageFile.h"
 #include "RageFileDriver.h"
 
+class DirectChangeJournal;
+
 /** @brief File driver for accessing a regular filesystem. */
 class RageFileDriverDirect: public RageFileDriver
 {
 public:
 	RageFileDriverDirect( const RString &sRoot );
+	virtual ~RageFileDriverDirect();
 
 	RageFileBasic *Open( const RString &sPath, int iMode, int &iError );
 	bool Move( const RString &sOldPath, const RString &sNewPath );
 	bool Remove( const RString &sPath );
 	bool Remount( const RString &sPath );
+	bool StartChangeJournal( const RString &sPath, int iDepth );
+	bool ReadChangeJournal( const RString &sPath, vector<RString> &asChangedDirs );
 
 private:
 	RString m_sRoot;
+	/* Created by the first StartChangeJournal; only one path is journaled. */
+	DirectChangeJournal *m_pJournal;
 };
 
 class RageFileDriverDirectReadOnly: public RageFileDriverDirect
@@ -326,6 +326,266 @@ void DirectFilenameDB::PopulateFileSet( FileSet &fs, const RString &path )
 	}
 }
 
+#if defined(LINUX)
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+	IN_CLOSE_WRITE | IN_DELETE_SELF | IN_ONLYDIR;
+
+/* Describe the inotify limit behind iErr, ENOSPC or EMFILE, eg.
+ * "fs.inotify.max_user_watches (8192)". */
+static RString DescribeInotifyLimit( int iErr )
+{
+	const char *szLimit = iErr == ENOSPC? "max_user_watches":"max_user_instances";
+	RString sRet = ssprintf( "fs.inotify.%s", szLimit );
+
+	FILE *f = fopen( ssprintf("/proc/sys/fs/inotify/%s", szLimit).c_str(), "r" );
+	if( f != nullptr )
+	{
+		int iLimit;
+		if( fscanf(f, "%i", &iLimit) == 1 )
+			sRet += ssprintf( " (%i)", iLimit );
+		fclose( f );
+	}
+	return sRet;
+}
+#endif
+
+DirectChangeJournal::DirectChangeJournal( const RString &sRoot, FilenameDB *pDB ):
+	m_sRoot( sRoot ), m_pDB( pDB ), m_Mutex( "DirectChangeJournal" )
+{
+	// "/abcd/" -> "/abcd", like DirectFilenameDB::SetRoot.
+	m_sRoot.Replace( "\\", "/" );
+	if( m_sRoot.Right(1) == "/" )
+		m_sRoot.erase( m_sRoot.size()-1, 1 );
+
+	m_iDepth = 0;
+	m_iFD = -1;
+	m_bComplete = false;
+	m_iLimitError = 0;
+}
+
+DirectChangeJournal::~DirectChangeJournal()
+{
+	Stop();
+}
+
+void DirectChangeJournal::Stop()
+{
+#if defined(LINUX)
+	if( m_iFD != -1 )
+		close( m_iFD );
+#endif
+	m_iFD = -1;
+	m_Watches.clear();
+	m_asChanged.clear();
+}
+
+bool DirectChangeJournal::Start( const RString &sPath, int iDepth )
+{
+	LockMut( m_Mutex );
+	return StartLocked( sPath, iDepth );
+}
+
+bool DirectChangeJournal::StartLocked( const RString &sPath, int iDepth )
+{
+#if defined(LINUX)
+	RString sDir = sPath;
+	if( sDir.Right(1) != "/" )
+		sDir += "/";
+
+	if( m_iFD != -1 && m_bComplete && m_sPath == sDir && m_iDepth == iDepth )
+		return true;
+
+	Stop();
+	m_sPath = sDir;
+	m_iDepth = iDepth;
+	m_iLimitError = 0;
+	m_iFD = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if( m_iFD == -1 )
+	{
+		if( errno == EMFILE )
+		{
+			m_iLimitError = errno;
+			LOG->Warn( "inotify_init1: %s; changes under %s won't be noticed unless %s is raised",
+				strerror(errno), (m_sRoot + m_sPath).c_str(), DescribeInotifyLimit(errno).c_str() );
+		}
+		else
+			LOG->Warn( "inotify_init1: %s", strerror(errno) );
+		m_bComplete = false;
+		return false;
+	}
+
+	m_bComplete = true;
+	AddWatch( m_sPath, m_iDepth );
+	if( m_iLimitError != 0 )
+		GiveUp();
+	return m_bComplete;
+#else
+	return false;
+#endif
+}
+
+/* Stop watching once the system is out of watches.  The rest of the tree
+ * would fail the same way, and the watches already added can't tell us
+ * everything, so drop them rather than keep them from other programs.  Read
+ * reports changes as unknown until Start is called again. */
+void DirectChangeJournal::GiveUp()
+{
+#if defined(LINUX)
+	LOG->Warn( "Ran out of inotify resources watching %s: %s.  Raise %s to have changes "
+		"under it noticed; until then, the whole directory is rescanned.",
+		(m_sRoot + m_sPath).c_str(), strerror(m_iLimitError), DescribeInotifyLimit(m_iLimitError).c_str() );
+#endif
+	Stop();
+	m_bComplete = false;
+}
+
+void DirectChangeJournal::AddWatch( const RString &sDir, int iDepth )
+{
+#if defined(LINUX)
+	if( m_iLimitError != 0 )
+		return;
+
+	int iWD = inotify_add_watch( m_iFD, (m_sRoot + sDir).c_str(), WATCH_MASK );
+	if( iWD == -1 )
+	{
+		if( errno == ENOSPC )
+		{
+			// Warned about once, by GiveUp.
+			m_iLimitError = errno;
+			m_bComplete = false;
+		}
+		// A directory that's gone isn't a missed change.
+		else if( errno != ENOENT && errno != ENOTDIR )
+		{
+			LOG->Warn( "inotify_add_watch(%s): %s", (m_sRoot + sDir).c_str(), strerror(errno) );
+			m_bComplete = false;
+		}
+		return;
+	}
+
+	Watch &w = m_Watches[iWD];
+	w.sDir = sDir;
+	w.iDepth = iDepth;
+
+	if( iDepth == 0 )
+		return;
+
+	vector<RString> asSubdirs;
+	m_pDB->GetDirListing( sDir + "*", asSubdirs, true, false );
+	for( unsigned i = 0; i < asSubdirs.size() && m_iLimitError == 0; ++i )
+		AddWatch( sDir + asSubdirs[i] + "/", iDepth - 1 );
+#endif
+}
+
+void DirectChangeJournal::Changed( const RString &sDir )
+{
+	m_asChanged.insert( sDir );
+	m_pDB->FlushDir( sDir );
+}
+
+void DirectChangeJournal::ReadEvents()
+{
+#if defined(LINUX)
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	for(;;)
+	{
+		ssize_t iGot = read( m_iFD, buf, sizeof(buf) );
+		if( iGot <= 0 )
+		{
+			if( iGot == -1 && errno != EAGAIN && errno != EINTR )
+			{
+				LOG->Warn( "Reading inotify events: %s", strerror(errno) );
+				m_bComplete = false;
+			}
+			if( iGot == -1 && errno == EINTR )
+				continue;
+			return;
+		}
+
+		for( char *p = buf; p < buf + iGot; )
+		{
+			const struct inotify_event *ev = (const struct inotify_event *) p;
+			p += sizeof(struct inotify_event) + ev->len;
+
+			if( ev->mask & IN_Q_OVERFLOW )
+			{
+				m_bComplete = false;
+				continue;
+			}
+
+			std::map<int, Watch>::iterator it = m_Watches.find( ev->wd );
+			if( it == m_Watches.end() )
+				continue;
+			if( ev->mask & IN_IGNORED )
+			{
+				m_Watches.erase( it );
+				continue;
+			}
+
+			const Watch w = it->second;
+			Changed( w.sDir );
+			if( !(ev->mask & IN_ISDIR) || ev->len == 0 )
+				continue;
+
+			const RString sSubdir = w.sDir + ev->name + "/";
+			Changed( sSubdir );
+
+			if( ev->mask & (IN_CREATE|IN_MOVED_TO) )
+			{
+				if( w.iDepth > 0 )
+					AddWatch( sSubdir, w.iDepth - 1 );
+			}
+			else if( ev->mask & IN_MOVED_FROM )
+			{
+				/* The watches below a directory follow it when it's moved, and
+				 * would keep reporting its old path, so drop them. */
+				for( std::map<int, Watch>::iterator sub = m_Watches.begin(); sub != m_Watches.end(); )
+				{
+					if( BeginsWith(sub->second.sDir, sSubdir) )
+					{
+						inotify_rm_watch( m_iFD, sub->first );
+						m_Watches.erase( sub++ );
+					}
+					else
+						++sub;
+				}
+			}
+		}
+	}
+#endif
+}
+
+bool DirectChangeJournal::Read( vector<RString> &asChangedDirs )
+{
+	LockMut( m_Mutex );
+	if( m_iFD == -1 )
+		return false;
+
+	ReadEvents();
+	asChangedDirs.insert( asChangedDirs.end(), m_asChanged.begin(), m_asChanged.end() );
+	m_asChanged.clear();
+	if( m_iLimitError != 0 )
+	{
+		// A new directory took the last watch.  Starting over would too.
+		GiveUp();
+		return false;
+	}
+	if( m_bComplete )
+		return true;
+
+	/* Some changes were missed, so the caller has to look at everything.
+	 * Start over, so the next read is good again.  If starting over doesn't
+	 * work either, the problem won't go away by itself, so stop until Start
+	 * is called again, rather than retry and warn on every read. */
+	const RString sPath = m_sPath;
+	if( !StartLocked(sPath, m_iDepth) )
+		Stop();
+	return false;
+}
+
 /*
  * Copyright (c) 2003-2005 Glenn Maynard, Chris Danford, Renaud Lepage
  * All rights reserved.
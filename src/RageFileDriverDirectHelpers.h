@@ -38,6 +38,58 @@ protected:
 	RString root;
 };
 
+#include "RageThreads.h"
+#include <map>
+#include <set>
+
+/* Records which directories under a path change, using inotify where it's
+ * available.  Every change also flushes the changed directory from the
+ * FilenameDB, so the next listing sees it without flushing everything else.
+ *
+ * Changes made while the game isn't running aren't seen; the journal only
+ * covers the time since Start. */
+class DirectChangeJournal
+{
+public:
+	DirectChangeJournal( const RString &sRoot, FilenameDB *pDB );
+	~DirectChangeJournal();
+
+	/* Watch sPath and directories up to iDepth levels below it. */
+	bool Start( const RString &sPath, int iDepth );
+	/* Add the directories that changed since the last call.  Return false
+	 * if some changes may have been missed. */
+	bool Read( vector<RString> &asChangedDirs );
+	RString GetPath() const { return m_sPath; }
+
+private:
+	bool StartLocked( const RString &sPath, int iDepth );
+	void Stop();
+	void GiveUp();
+	void AddWatch( const RString &sDir, int iDepth );
+	void ReadEvents();
+	void Changed( const RString &sDir );
+
+	RString m_sRoot;
+	FilenameDB *m_pDB;
+	RageMutex m_Mutex;
+
+	RString m_sPath;
+	int m_iDepth;
+	int m_iFD;
+	/* False if changes may have been missed since Start. */
+	bool m_bComplete;
+	/* The errno from running out of inotify watches or instances, or 0. */
+	int m_iLimitError;
+
+	struct Watch
+	{
+		RString sDir;
+		int iDepth;
+	};
+	std::map<int, Watch> m_Watches;
+	std::set<RString> m_asChanged;
+};
+
 #endif
 
 /*
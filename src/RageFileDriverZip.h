@@ -17,6 +17,10 @@ public:
 	RageFileBasic *Open( const RString &sPath, int iMode, int &iErr );
 	void FlushDirCache( const RString &sPath );
 
+	/* The contents of a loaded archive never change. */
+	bool StartChangeJournal( const RString & /* sPath */, int /* iDepth */ ) { return true; }
+	bool ReadChangeJournal( const RString & /* sPath */, vector<RString> & /* asChangedDirs */ ) { return true; }
+
 	void DeleteFileWhenFinished() { m_bFileOwned = true; }
 
 	/* Lower-level access: */
@@ -280,6 +280,9 @@ public:
 	}
 	/* Never flush FDB, except in LoadFromDrivers. */
 	void FlushDirCache( const RString &sPath ) { }
+	/* Mountpoints only change by mounting, which journals don't cover anyway. */
+	bool StartChangeJournal( const RString & /* sPath */, int /* iDepth */ ) { return true; }
+	bool ReadChangeJournal( const RString & /* sPath */, vector<RString> & /* asChangedDirs */ ) { return true; }
 
 	void LoadFromDrivers( const vector<LoadedDriver *> &apDrivers )
 	{
@@ -850,6 +853,79 @@ void RageFileManager::FlushDirCache( const RString &sPath_ )
 	}
 }
 
+/* A driver mounted below sPath, rather than at or above it, covers only part
+ * of it, and its own journal can't be asked about sPath. */
+static bool IsMountedBelow( const LoadedDriver &ld, const RString &sPath )
+{
+	return ld.m_sMountPoint.size() > sPath.size() &&
+		!ld.m_sMountPoint.Left( sPath.size() ).CompareNoCase( sPath );
+}
+
+bool RageFileManager::StartChangeJournal( const RString &sPath_, int iDepth )
+{
+	RString sPath = sPath_;
+	NormalizePath( sPath );
+	if( sPath.Right(1) != "/" )
+		sPath += "/";
+
+	vector<LoadedDriver *> apDriverList;
+	ReferenceAllDrivers( apDriverList );
+
+	bool bRet = true;
+	for( unsigned i = 0; i < apDriverList.size(); ++i )
+	{
+		const RString p = apDriverList[i]->GetPath( sPath );
+		if( p.size() == 0 )
+		{
+			if( IsMountedBelow(*apDriverList[i], sPath) )
+				bRet = false;
+			continue;
+		}
+		if( !apDriverList[i]->m_pDriver->StartChangeJournal(p, iDepth) )
+			bRet = false;
+	}
+
+	UnreferenceAllDrivers( apDriverList );
+	return bRet;
+}
+
+bool RageFileManager::ReadChangeJournal( const RString &sPath_, vector<RString> &asChangedDirs )
+{
+	RString sPath = sPath_;
+	NormalizePath( sPath );
+	if( sPath.Right(1) != "/" )
+		sPath += "/";
+
+	vector<LoadedDriver *> apDriverList;
+	ReferenceAllDrivers( apDriverList );
+
+	/* Read every journal even if one fails, so none of them are left holding
+	 * changes that were already dealt with by a full rescan. */
+	bool bRet = true;
+	for( unsigned i = 0; i < apDriverList.size(); ++i )
+	{
+		const LoadedDriver &ld = *apDriverList[i];
+		const RString p = ld.GetPath( sPath );
+		if( p.size() == 0 )
+		{
+			if( IsMountedBelow(ld, sPath) )
+				bRet = false;
+			continue;
+		}
+
+		vector<RString> asDirs;
+		if( !ld.m_pDriver->ReadChangeJournal(p, asDirs) )
+			bRet = false;
+
+		// The driver's paths start with a slash; the mountpoint ends with one.
+		for( unsigned j = 0; j < asDirs.size(); ++j )
+			asChangedDirs.push_back( ld.m_sMountPoint + asDirs[j].substr(1) );
+	}
+
+	UnreferenceAllDrivers( apDriverList );
+	return bRet;
+}
+
 RageFileManager::FileType RageFileManager::GetFileType( const RString &sPath_ )
 {
 	RString sPath = sPath_;
@@ -67,6 +67,14 @@ public:
 
 	void FlushDirCache( const RString &sPath = RString() );
 
+	/* Start recording which directories under sPath change, down to iDepth
+	 * levels below it.  Return false if some filesystem mounted there can't. */
+	bool StartChangeJournal( const RString &sPath, int iDepth );
+	/* Add the directories under sPath that changed since the last call, and
+	 * return true, or return false if that isn't known and everything under
+	 * sPath has to be rescanned. */
+	bool ReadChangeJournal( const RString &sPath, vector<RString> &asChangedDirs );
+
 	/* Used only by RageFile: */
 	RageFileBasic *Open( const RString &sPath, int iMode, int &iError );
 	void CacheFile( const RageFileBasic *fb, const RString &sPath );
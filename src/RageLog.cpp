@@ -3,11 +3,20 @@
 #include "RageUtil.h"
 #include "RageTimer.h"
 #include "RageFile.h"
+#include "RageFileManager.h"
 #include "RageThreads.h"
 
+#include <atomic>
 #include <ctime>
+#include <fcntl.h>
 #if defined(_WINDOWS)
 #include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#if !defined(O_BINARY)
+#define O_BINARY 0
 #endif
 #include <map>
 
@@ -64,6 +73,76 @@ static RageFile *g_fileLog, *g_fileInfo, *g_fileUserLog, *g_fileTimeLog;
  * only place we write to the same file from multiple threads. */
 static RageMutex *g_Mutex;
 
+/* In async mode, traces are put in this ring instead, without locking, and a
+ * writer thread takes them out and writes them every few milliseconds.  Any
+ * thread may add records; only the holder of g_Mutex removes them.
+ *
+ * Each slot has a sequence number: a slot at position i is free when its
+ * sequence is i, and holds a finished record when it's i+1.  Lines too long for
+ * a slot are written synchronously.  If the ring is full, the line is dropped
+ * and counted, so logging never blocks. */
+static const unsigned ASYNC_LOG_SLOTS = 1024;
+static const unsigned ASYNC_LOG_MAX_TEXT = 480;
+struct AsyncLogRecord
+{
+	std::atomic<unsigned> iSeq;
+	int iWhere;
+	float fTime;	// taken by the thread that logged it
+	char szText[ASYNC_LOG_MAX_TEXT];
+};
+static AsyncLogRecord g_AsyncLog[ASYNC_LOG_SLOTS];
+static std::atomic<unsigned> g_iAsyncLogHead( 0 );
+static unsigned g_iAsyncLogTail = 0;
+static std::atomic<unsigned> g_iAsyncLogDropped( 0 );
+
+static RageThread *g_pAsyncWriter = nullptr;
+static std::atomic<bool> g_bStopAsyncWriter( false );
+/* Threads between checking m_bAsync and finishing their push.  SetAsync waits
+ * for this to drop to 0 after turning async off, so nothing is pushed after
+ * its last drain. */
+static std::atomic<int> g_iAsyncPushers( 0 );
+/* Broadcast by the last of those threads once async is off. */
+static RageEvent *g_AsyncPushersDone;
+/* Where log.txt really is, so a crash handler can add the lines still in the
+ * ring without going through RageFile.  Empty when not logging to disk. */
+static char g_sLogOSPath[1024] = "";
+/* How often the writer thread writes. */
+static const int ASYNC_LOG_WRITE_USECS = 10000;
+
+static bool PushAsyncRecord( int where, const RString &sLine )
+{
+	if( sLine.size() >= ASYNC_LOG_MAX_TEXT )
+		return false;
+
+	unsigned iPos = g_iAsyncLogHead.load( std::memory_order_relaxed );
+	AsyncLogRecord *pRecord;
+	for(;;)
+	{
+		pRecord = &g_AsyncLog[iPos % ASYNC_LOG_SLOTS];
+		const int iDiff = int( pRecord->iSeq.load(std::memory_order_acquire) - iPos );
+		if( iDiff == 0 )
+		{
+			if( g_iAsyncLogHead.compare_exchange_weak(iPos, iPos+1, std::memory_order_relaxed) )
+				break;
+		}
+		else if( iDiff < 0 )
+		{
+			++g_iAsyncLogDropped;
+			return true;
+		}
+		else
+		{
+			iPos = g_iAsyncLogHead.load( std::memory_order_relaxed );
+		}
+	}
+
+	pRecord->iWhere = where;
+	pRecord->fTime = RageTimer::GetTimeSinceStart();
+	memcpy( pRecord->szText, sLine.c_str(), sLine.size()+1 );
+	pRecord->iSeq.store( iPos+1, std::memory_order_release );
+	return true;
+}
+
 /* staticlog gets info.txt
  * crashlog gets log.txt */
 enum
@@ -80,7 +159,8 @@ enum
 };
 
 RageLog::RageLog(): m_bLogToDisk(false), m_bInfoToDisk(false),
-m_bUserLogToDisk(false), m_bFlush(false), m_bShowLogOutput(false)
+m_bUserLogToDisk(false), m_bFlush(false), m_bShowLogOutput(false),
+m_bAsync(false)
 {
 	g_fileLog = new RageFile;
 	g_fileInfo = new RageFile;
@@ -91,10 +171,13 @@ m_bUserLogToDisk(false), m_bFlush(false), m_bShowLogOutput(false)
 	{ fprintf(stderr, "Couldn't open %s: %s\n", TIME_PATH, g_fileTimeLog->GetError().c_str()); }
 	
 	g_Mutex = new RageMutex( "Log" );
+	g_AsyncPushersDone = new RageEvent( "Log pushers" );
 }
 
 RageLog::~RageLog()
 {
+	SetAsync( false );
+
 	/* Add the mapped log data to info.txt. */
 	const RString AdditionalLog = GetAdditionalLog();
 	vector<RString> AdditionalLogLines;
@@ -113,6 +196,7 @@ RageLog::~RageLog()
 	g_fileTimeLog->Close();
 
 	SAFE_DELETE( g_Mutex );
+	SAFE_DELETE( g_AsyncPushersDone );
 	SAFE_DELETE( g_fileLog );
 	SAFE_DELETE( g_fileInfo );
 	SAFE_DELETE( g_fileUserLog );
@@ -127,13 +211,18 @@ void RageLog::SetLogToDisk( bool b )
 
 	if( !m_bLogToDisk )
 	{
+		g_sLogOSPath[0] = 0;
 		if( g_fileLog->IsOpen() )
 			g_fileLog->Close();
 		return;
 	}
 
 	if( !g_fileLog->Open( LOG_PATH, RageFile::WRITE|RageFile::STREAMED ) )
+	{
 		fprintf( stderr, "Couldn't open %s: %s\n", LOG_PATH, g_fileLog->GetError().c_str() );
+		return;
+	}
+	strncpy( g_sLogOSPath, FILEMAN->ResolvePath(LOG_PATH).c_str(), sizeof(g_sLogOSPath)-1 );
 }
 
 void RageLog::SetInfoToDisk( bool b )
@@ -176,6 +265,75 @@ void RageLog::SetFlushing( bool b )
 	m_bFlush = b;
 }
 
+void RageLog::SetAsync( bool b )
+{
+	if( m_bAsync == b )
+		return;
+
+	if( b )
+	{
+		/* Position p lives in slot p % ASYNC_LOG_SLOTS. */
+		for( unsigned i = 0; i < ASYNC_LOG_SLOTS; ++i )
+			g_AsyncLog[(g_iAsyncLogTail + i) % ASYNC_LOG_SLOTS].iSeq.store( g_iAsyncLogTail + i );
+		g_iAsyncLogHead = g_iAsyncLogTail;
+
+		g_bStopAsyncWriter = false;
+		g_pAsyncWriter = new RageThread;
+		g_pAsyncWriter->SetName( "Log writer" );
+		g_pAsyncWriter->Create( AsyncWriter_Start, this );
+		m_bAsync = true;
+		return;
+	}
+
+	m_bAsync = false;
+	g_bStopAsyncWriter = true;
+	g_pAsyncWriter->Wait();
+	SAFE_DELETE( g_pAsyncWriter );
+
+	/* Write anything that was logged while stopping, once the threads that
+	 * still saw m_bAsync set have finished pushing. */
+	g_AsyncPushersDone->Lock();
+	while( g_iAsyncPushers != 0 )
+		g_AsyncPushersDone->Wait();
+	g_AsyncPushersDone->Unlock();
+
+	LockMut( *g_Mutex );
+	DrainAsync();
+	Flush();
+}
+
+void RageLog::AsyncWriter()
+{
+	while( !g_bStopAsyncWriter )
+	{
+		usleep( ASYNC_LOG_WRITE_USECS );
+
+		LockMut( *g_Mutex );
+		DrainAsync();
+		if( m_bFlush )
+			Flush();
+	}
+}
+
+/* Write the records in the async ring.  g_Mutex must be locked. */
+void RageLog::DrainAsync()
+{
+	for(;;)
+	{
+		AsyncLogRecord &r = g_AsyncLog[g_iAsyncLogTail % ASYNC_LOG_SLOTS];
+		if( r.iSeq.load(std::memory_order_acquire) != g_iAsyncLogTail+1 )
+			break;
+
+		WriteLine( r.iWhere, r.szText, r.fTime );
+		r.iSeq.store( g_iAsyncLogTail + ASYNC_LOG_SLOTS, std::memory_order_release );
+		++g_iAsyncLogTail;
+	}
+
+	const unsigned iDropped = g_iAsyncLogDropped.exchange( 0 );
+	if( iDropped != 0 )
+		WriteLine( WRITE_LOUD, ssprintf("%u log lines were dropped; the log writer couldn't keep up", iDropped), RageTimer::GetTimeSinceStart() );
+}
+
 /* Enable or disable display of output to stdout, or a console window in Windows. */
 void RageLog::SetShowLogOutput( bool show )
 {
@@ -253,8 +411,36 @@ void RageLog::UserLog( const RString &sType, const RString &sElement, const char
 
 void RageLog::Write( int where, const RString &sLine )
 {
+	/* Info, warnings and user logs are written right away, so they're on
+	 * disk if we crash. */
+	if( !(where & (WRITE_TO_INFO|WRITE_TO_USER_LOG)) )
+	{
+		++g_iAsyncPushers;
+		const bool bPushed = m_bAsync && PushAsyncRecord( where, sLine );
+		if( --g_iAsyncPushers == 0 && !m_bAsync )
+		{
+			/* SetAsync(false) may be waiting for us. */
+			g_AsyncPushersDone->Lock();
+			g_AsyncPushersDone->Broadcast();
+			g_AsyncPushersDone->Unlock();
+		}
+		if( bPushed )
+			return;
+	}
+
 	LockMut( *g_Mutex );
 
+	/* Write anything queued before this first, to keep the log in order. */
+	DrainAsync();
+	WriteLine( where, sLine, RageTimer::GetTimeSinceStart() );
+
+	if( m_bFlush || (where & WRITE_TO_INFO) )
+		Flush();
+}
+
+/* g_Mutex must be locked. */
+void RageLog::WriteLine( int where, const RString &sLine, float fTime )
+{
 	const char *const sWarningSeparator = "/////////////////////////////////////////";
 	vector<RString> asLines;
 	split( sLine, "\n", asLines, false );
@@ -265,7 +451,7 @@ void RageLog::Write( int where, const RString &sLine )
 		puts( sWarningSeparator );
 	}
 
-	RString sTimestamp = SecondsToMMSSMsMsMs( RageTimer::GetTimeSinceStart() ) + ": ";
+	RString sTimestamp = SecondsToMMSSMsMsMs( fTime ) + ": ";
 	RString sWarning;
 	if( where & WRITE_LOUD )
 		sWarning = "WARNING: ";
@@ -305,8 +491,6 @@ void RageLog::Write( int where, const RString &sLine )
 			g_fileLog->PutLine( sWarningSeparator );
 		puts( sWarningSeparator );
 	}
-	if( m_bFlush || (where & WRITE_TO_INFO) )
-		Flush();
 }
 
 
@@ -355,9 +539,8 @@ const char *RageLog::GetInfo()
 static const int BACKLOG_LINES = 10;
 static char backlog[BACKLOG_LINES][1024];
 static int backlog_start=0, backlog_cnt=0;
-void RageLog::AddToRecentLogs( const RString &str )
+static void AddToBacklog( const char *str, unsigned len )
 {
-	unsigned len = str.size();
 	if( len > sizeof(backlog[backlog_start])-1 )
 		len = sizeof(backlog[backlog_start])-1;
 
@@ -370,6 +553,39 @@ void RageLog::AddToRecentLogs( const RString &str )
 	backlog_start %= BACKLOG_LINES;
 }
 
+void RageLog::AddToRecentLogs( const RString &str )
+{
+	AddToBacklog( str.c_str(), str.size() );
+}
+
+void RageLog::DrainAsyncForCrash()
+{
+	/* Don't allocate or lock; we may be in a signal handler.  Lines buffered
+	 * in g_fileLog are lost with the process anyway, so appending to the file
+	 * directly keeps what survives in order. */
+	int iFD = -1;
+	if( g_sLogOSPath[0] != 0 && g_AsyncLog[g_iAsyncLogTail % ASYNC_LOG_SLOTS].iSeq.load() == g_iAsyncLogTail+1 )
+		iFD = open( g_sLogOSPath, O_BINARY|O_WRONLY|O_APPEND );
+
+	for( unsigned iPos = g_iAsyncLogTail; ; ++iPos )
+	{
+		AsyncLogRecord &r = g_AsyncLog[iPos % ASYNC_LOG_SLOTS];
+		if( r.iSeq.load(std::memory_order_acquire) != iPos+1 )
+			break;
+
+		char buf[sizeof(backlog[0])];
+		const int iMS = int( r.fTime * 1000 );
+		int len = snprintf( buf, sizeof(buf), "%02d:%02d.%03d: %s", iMS / 60000, (iMS / 1000) % 60, iMS % 1000, r.szText );
+		len = min( len, (int) sizeof(buf)-1 );
+		AddToBacklog( buf, len );
+		if( iFD != -1 && write(iFD, buf, len) == len )
+			write( iFD, NEWLINE, strlen(NEWLINE) );
+	}
+
+	if( iFD != -1 )
+		close( iFD );
+}
+
 const char *RageLog::GetRecentLog( int n )
 {
 	if( n >= BACKLOG_LINES || n >= backlog_cnt )
@@ -3,6 +3,8 @@
 #ifndef RAGE_LOG_H
 #define RAGE_LOG_H
 
+#include <atomic>
+
 class RageLog
 {
 public:
@@ -24,12 +26,16 @@ public:
 	static const char *GetInfo();
 	/* Returns nullptr if past the last recent log. */
 	static const char *GetRecentLog( int n );
+	/* For crash handlers: add lines still waiting for the async writer to
+	 * the recent logs and to log.txt.  This only touches static data. */
+	static void DrainAsyncForCrash();
 
 	void SetShowLogOutput( bool show ); // enable or disable logging to stdout
 	void SetLogToDisk( bool b );	// enable or disable logging to file
 	void SetInfoToDisk( bool b );	// enable or disable logging info.txt to file
 	void SetUserLogToDisk( bool b);	// enable or disable logging user.txt to file
 	void SetFlushing( bool b );	// enable or disable flushing
+	void SetAsync( bool b );	// enable or disable writing traces on a thread
 
 private:
 	bool m_bLogToDisk;
@@ -37,7 +43,12 @@ private:
 	bool m_bUserLogToDisk;
 	bool m_bFlush;
 	bool m_bShowLogOutput;
+	std::atomic<bool> m_bAsync;
 	void Write( int, const RString &str );
+	void WriteLine( int where, const RString &sLine, float fTime );
+	void DrainAsync();
+	static int AsyncWriter_Start( void *p ) { ((RageLog *) p)->AsyncWriter(); return 0; }
+	void AsyncWriter();
 	void UpdateMappedLog();
 	void AddToInfo( const RString &buf );
 	void AddToRecentLogs( const RString &buf );
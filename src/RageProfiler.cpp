@@ -0,0 +1,315 @@
+#include "global.h"
+#include "RageProfiler.h"
+#include "RageTimer.h"
+#include "RageFile.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "EnumHelper.h"
+
+#include <map>
+#include <thread>
+#include <typeindex>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
+static const char *ProfileZoneNames[] = {
+	"SoundManager",
+	"GameSound",
+	"Textures",
+	"GameState",
+	"Screens",
+	"MemoryCards",
+	"Songs",
+	"Input",
+	"Lights",
+	"Draw",
+	"Present",
+	"ActorUpdate",
+	"ActorDraw",
+	"Lua",
+};
+XToString( ProfileZone );
+
+bool RageProfiler::g_bEnabled = false;
+bool RageProfiler::g_bTimeActorTypes = false;
+
+/* Everything here is only touched by the profiled thread, so there's no
+ * locking. */
+namespace
+{
+	/** @brief Ten seconds at 60Hz. */
+	const int NUM_FRAMES = 600;
+	/** @brief Keep a busy frame from making the trace huge. */
+	const unsigned MAX_EVENTS_PER_FRAME = 1024;
+
+	struct ZoneEvent
+	{
+		ProfileZone zone;
+		uint64_t iStartUsecs;
+		uint64_t iLengthUsecs;
+	};
+
+	struct Frame
+	{
+		RageProfiler::FrameSample sample;
+		/** @brief Every zone entered in the frame, for the trace, except
+		 * zones inside another zone of the same kind, like an actor
+		 * updating its children. */
+		vector<ZoneEvent> aEvents;
+	};
+
+	struct OpenZone
+	{
+		ProfileZone zone;
+		uint64_t iStartUsecs;
+		uint64_t iChildUsecs;
+		bool bRecordEvent;
+		const std::type_info *pType;
+	};
+
+	struct ActorTypeTotals
+	{
+		uint64_t iUpdateUsecs;
+		uint64_t iDrawUsecs;
+		uint64_t iUpdates;
+		uint64_t iDraws;
+	};
+
+	Frame g_Frames[NUM_FRAMES];
+	/** @brief The frame being recorded, or -1 if none is. */
+	int g_iCurrentFrame = -1;
+	/** @brief The number of finished frames before g_iCurrentFrame. */
+	int g_iNumFrames = 0;
+	vector<OpenZone> g_OpenZones;
+	int g_iOpenZonesOfType[NUM_ProfileZone];
+	std::thread::id g_ProfiledThread;
+	std::map<std::type_index, ActorTypeTotals> g_ActorTypes;
+}
+
+void RageProfiler::SetEnabled( bool b )
+{
+	if( b == g_bEnabled )
+		return;
+
+	// Start from scratch; keep the old frames around when stopping, so they
+	// can still be looked at and written.
+	if( b )
+	{
+		g_iCurrentFrame = -1;
+		g_iNumFrames = 0;
+	}
+	g_bEnabled = b;
+}
+
+void RageProfiler::BeginFrame()
+{
+	if( !g_bEnabled )
+		return;
+
+	const uint64_t iNow = RageTimer::GetUsecsSinceStart();
+	g_ProfiledThread = std::this_thread::get_id();
+
+	if( g_iCurrentFrame != -1 )
+	{
+		FrameSample &last = g_Frames[g_iCurrentFrame].sample;
+		last.iLengthUsecs = iNow - last.iStartUsecs;
+		// The new frame takes the oldest one's slot.
+		g_iNumFrames = min( g_iNumFrames + 1, NUM_FRAMES - 1 );
+	}
+	else
+	{
+		g_OpenZones.clear();
+		ZERO( g_iOpenZonesOfType );
+	}
+
+	g_iCurrentFrame = (g_iCurrentFrame + 1) % NUM_FRAMES;
+	Frame &f = g_Frames[g_iCurrentFrame];
+	f.sample.iStartUsecs = iNow;
+	f.sample.iLengthUsecs = 0;
+	ZERO( f.sample.iZoneUsecs );
+	f.aEvents.clear();
+}
+
+bool RageProfiler::EnterZone( ProfileZone z, const std::type_info *pType )
+{
+	if( g_iCurrentFrame == -1 || std::this_thread::get_id() != g_ProfiledThread )
+		return false;
+
+	OpenZone oz;
+	oz.zone = z;
+	oz.iStartUsecs = RageTimer::GetUsecsSinceStart();
+	oz.iChildUsecs = 0;
+	oz.bRecordEvent = g_iOpenZonesOfType[z]++ == 0;
+	oz.pType = g_bTimeActorTypes? pType:nullptr;
+	g_OpenZones.push_back( oz );
+	return true;
+}
+
+void RageProfiler::LeaveZone()
+{
+	ASSERT( !g_OpenZones.empty() );
+	const OpenZone oz = g_OpenZones.back();
+	g_OpenZones.pop_back();
+	--g_iOpenZonesOfType[oz.zone];
+
+	// Profiling was restarted while this zone was open.
+	if( g_iCurrentFrame == -1 )
+		return;
+
+	const uint64_t iLength = RageTimer::GetUsecsSinceStart() - oz.iStartUsecs;
+	if( !g_OpenZones.empty() )
+		g_OpenZones.back().iChildUsecs += iLength;
+
+	Frame &f = g_Frames[g_iCurrentFrame];
+	f.sample.iZoneUsecs[oz.zone] += iLength - oz.iChildUsecs;
+	if( oz.pType != nullptr )
+	{
+		ActorTypeTotals &t = g_ActorTypes[std::type_index(*oz.pType)];
+		if( oz.zone == ProfileZone_ActorDraw )
+		{
+			t.iDrawUsecs += iLength - oz.iChildUsecs;
+			++t.iDraws;
+		}
+		else
+		{
+			t.iUpdateUsecs += iLength - oz.iChildUsecs;
+			++t.iUpdates;
+		}
+	}
+	if( oz.bRecordEvent && f.aEvents.size() < MAX_EVENTS_PER_FRAME )
+	{
+		ZoneEvent ev = { oz.zone, oz.iStartUsecs, iLength };
+		f.aEvents.push_back( ev );
+	}
+}
+
+static int GetFrameIndex( int iFrame )
+{
+	return (g_iCurrentFrame - g_iNumFrames + iFrame + NUM_FRAMES) % NUM_FRAMES;
+}
+
+void RageProfiler::GetFrames( vector<FrameSample> &aOut )
+{
+	aOut.clear();
+	if( g_iCurrentFrame == -1 )
+		return;
+	for( int i = 0; i < g_iNumFrames; ++i )
+		aOut.push_back( g_Frames[GetFrameIndex(i)].sample );
+}
+
+bool RageProfiler::GetLastFrame( FrameSample &out )
+{
+	if( g_iCurrentFrame == -1 || g_iNumFrames == 0 )
+		return false;
+	out = g_Frames[GetFrameIndex(g_iNumFrames-1)].sample;
+	return true;
+}
+
+void RageProfiler::SetTimeActorTypes( bool b )
+{
+	if( b && !g_bTimeActorTypes )
+		g_ActorTypes.clear();
+	g_bTimeActorTypes = b;
+}
+
+static RString GetTypeName( const std::type_index &type )
+{
+#if defined(__GNUC__)
+	int iStatus;
+	char *szName = abi::__cxa_demangle( type.name(), nullptr, nullptr, &iStatus );
+	if( iStatus == 0 )
+	{
+		RString sName = szName;
+		free( szName );
+		return sName;
+	}
+#endif
+	// MSVC gives "class Sprite".
+	RString sName = type.name();
+	if( BeginsWith(sName, "class ") )
+		sName.erase( 0, 6 );
+	return sName;
+}
+
+static bool CompareActorTypesByTime( const RageProfiler::ActorTypeSample &a, const RageProfiler::ActorTypeSample &b )
+{
+	return a.iUpdateUsecs + a.iDrawUsecs > b.iUpdateUsecs + b.iDrawUsecs;
+}
+
+void RageProfiler::GetActorTypeTimes( vector<ActorTypeSample> &aOut )
+{
+	aOut.clear();
+	for (std::pair<const std::type_index, ActorTypeTotals> const &it : g_ActorTypes)
+	{
+		ActorTypeSample s;
+		s.sType = GetTypeName( it.first );
+		s.iUpdateUsecs = it.second.iUpdateUsecs;
+		s.iDrawUsecs = it.second.iDrawUsecs;
+		s.iUpdates = it.second.iUpdates;
+		s.iDraws = it.second.iDraws;
+		aOut.push_back( s );
+	}
+	sort( aOut.begin(), aOut.end(), CompareActorTypesByTime );
+}
+
+static RString TraceEvent( const char *szName, uint64_t iStartUsecs, uint64_t iLengthUsecs )
+{
+	return ssprintf( "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%llu,\"dur\":%llu}",
+		szName, (unsigned long long) iStartUsecs, (unsigned long long) iLengthUsecs );
+}
+
+bool RageProfiler::WriteChromeTrace( const RString &sPath )
+{
+	RageFile f;
+	if( !f.Open(sPath, RageFile::WRITE) )
+	{
+		LOG->Warn( "Couldn't write frame trace \"%s\": %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+
+	f.PutLine( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+	bool bFirst = true;
+	for( int i = 0; g_iCurrentFrame != -1 && i < g_iNumFrames; ++i )
+	{
+		const Frame &fr = g_Frames[GetFrameIndex(i)];
+		f.PutLine( (bFirst? "":",") + TraceEvent("Frame", fr.sample.iStartUsecs, fr.sample.iLengthUsecs) );
+		bFirst = false;
+		for (ZoneEvent const &ev : fr.aEvents)
+			f.PutLine( "," + TraceEvent(ProfileZoneToString(ev.zone), ev.iStartUsecs, ev.iLengthUsecs) );
+	}
+	f.PutLine( "]}" );
+
+	if( f.Flush() == -1 )
+	{
+		LOG->Warn( "Couldn't write frame trace \"%s\": %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+	return true;
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
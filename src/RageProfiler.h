@@ -0,0 +1,147 @@
+/* RageProfiler - Find out where the time in each frame goes. */
+
+#ifndef RAGE_PROFILER_H
+#define RAGE_PROFILER_H
+
+#include <typeinfo>
+#include <vector>
+
+/** @brief The parts of a frame that are timed separately. */
+enum ProfileZone
+{
+	ProfileZone_SoundManager,	/**< SOUNDMAN->Update */
+	ProfileZone_GameSound,		/**< SOUND->Update */
+	ProfileZone_Textures,		/**< TEXTUREMAN->Update */
+	ProfileZone_GameState,		/**< GAMESTATE->Update */
+	ProfileZone_Screens,		/**< SCREENMAN->Update, apart from actors */
+	ProfileZone_MemoryCards,	/**< MEMCARDMAN->Update and PROFILEMAN->Update */
+	ProfileZone_Songs,		/**< SONGMAN->Update */
+	ProfileZone_Input,		/**< Handling input events */
+	ProfileZone_Lights,		/**< LIGHTSMAN->Update */
+	ProfileZone_Draw,		/**< SCREENMAN->Draw, apart from actors */
+	ProfileZone_Present,		/**< Finishing the frame and waiting for vsync */
+	ProfileZone_ActorUpdate,	/**< Actor::Update */
+	ProfileZone_ActorDraw,		/**< Actor::Draw */
+	ProfileZone_Lua,		/**< Actor commands and update functions */
+	NUM_ProfileZone,
+	ProfileZone_Invalid
+};
+const RString& ProfileZoneToString( ProfileZone z );
+
+/**
+ * @brief Records the time spent in each ProfileZone, frame by frame.
+ *
+ * Zones nest; each zone is only charged for the time not spent in zones
+ * inside it, so a frame's zone times add up to no more than the frame.  The
+ * last few hundred frames are kept.  Only the thread running the game loop
+ * is timed.  While profiling is off, a zone costs one test of a bool. */
+namespace RageProfiler
+{
+	struct FrameSample
+	{
+		uint64_t iStartUsecs;
+		uint64_t iLengthUsecs;
+		/** @brief Time spent in each zone, not counting zones inside it. */
+		uint64_t iZoneUsecs[NUM_ProfileZone];
+	};
+
+	/** @brief The time spent in one type of actor, not counting the
+	 * actors inside it. */
+	struct ActorTypeSample
+	{
+		RString sType;
+		uint64_t iUpdateUsecs;
+		uint64_t iDrawUsecs;
+		uint64_t iUpdates;
+		uint64_t iDraws;
+	};
+
+	extern bool g_bEnabled;
+	inline bool IsEnabled() { return g_bEnabled; }
+	void SetEnabled( bool b );
+
+	/** @brief Finish the current frame and start a new one.  Call this
+	 * from the game loop, once per frame. */
+	void BeginFrame();
+
+	/** @brief Start timing zone z.  Return false if nothing is being
+	 * recorded on this thread, in which case don't call LeaveZone.  If
+	 * pType is given and actor types are being timed, the zone is also
+	 * charged to that type. */
+	bool EnterZone( ProfileZone z, const std::type_info *pType = nullptr );
+	void LeaveZone();
+
+	/** @brief Get the recorded frames, oldest first. */
+	void GetFrames( std::vector<FrameSample> &aOut );
+	/** @brief Get the last finished frame.  Return false if there isn't one. */
+	bool GetLastFrame( FrameSample &out );
+
+	/** @brief Total up ActorUpdate and ActorDraw by the type of actor,
+	 * from now on.  This looks up the type of every actor as it's
+	 * updated and drawn, so it's meant for benchmarks. */
+	extern bool g_bTimeActorTypes;
+	inline bool IsTimingActorTypes() { return g_bEnabled && g_bTimeActorTypes; }
+	void SetTimeActorTypes( bool b );
+	/** @brief Get the totals since SetTimeActorTypes(true), most time first. */
+	void GetActorTypeTimes( std::vector<ActorTypeSample> &aOut );
+
+	/** @brief Write the recorded frames and zones as JSON for
+	 * chrome://tracing or Perfetto. */
+	bool WriteChromeTrace( const RString &sPath );
+}
+
+/** @brief Time the rest of the enclosing block as zone z. */
+class ProfileScope
+{
+public:
+	ProfileScope( ProfileZone z ):
+		m_bActive( RageProfiler::IsEnabled() && RageProfiler::EnterZone(z) ) { }
+	ProfileScope( ProfileZone z, const std::type_info *pType ):
+		m_bActive( RageProfiler::IsEnabled() && RageProfiler::EnterZone(z, pType) ) { }
+	~ProfileScope()
+	{
+		if( m_bActive )
+			RageProfiler::LeaveZone();
+	}
+
+private:
+	bool m_bActive;
+
+	ProfileScope( const ProfileScope &rhs );
+	ProfileScope &operator=( const ProfileScope &rhs );
+};
+
+#define PROFILE_SCOPE_NAME2( line ) ProfileScope_##line
+#define PROFILE_SCOPE_NAME( line ) PROFILE_SCOPE_NAME2( line )
+#define PROFILE_SCOPE( zone ) ProfileScope PROFILE_SCOPE_NAME(__LINE__)( zone )
+/** @brief Time the rest of the block as zone z, and charge it to the type of
+ * obj too when actor types are being timed. */
+#define PROFILE_SCOPE_TYPE( zone, obj ) ProfileScope PROFILE_SCOPE_NAME(__LINE__)( zone, \
+	RageProfiler::IsTimingActorTypes()? &typeid(obj):nullptr )
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -200,6 +200,26 @@ bool RageSound::Load( RString sSoundFilePath, bool bPrecache, const RageSoundLoa
 		bNeedBuffer = false;
 	}
 
+	LoadFileReader( pSound, sSoundFilePath, bPrecache, bNeedBuffer, pParams );
+	return true;
+}
+
+bool RageSound::Load( RageSoundReader *pSound, RString sSoundFilePath, const RageSoundLoadParams *pParams )
+{
+	LOG->Trace( "RageSound: Load \"%s\" (opened)", sSoundFilePath.c_str() );
+
+	if( pParams == nullptr )
+	{
+		static const RageSoundLoadParams Defaults;
+		pParams = &Defaults;
+	}
+
+	LoadFileReader( pSound, sSoundFilePath, false, true, pParams );
+	return true;
+}
+
+void RageSound::LoadFileReader( RageSoundReader *pSound, const RString &sSoundFilePath, bool bPrecache, bool bNeedBuffer, const RageSoundLoadParams *pParams )
+{
 	LoadSoundReader( pSound );
 
 	/* Try to precache.  Do this after calling LoadSoundReader() to put the
@@ -231,8 +251,6 @@ bool RageSound::Load( RString sSoundFilePath, bool bPrecache, const RageSoundLoa
 	m_sFilePath = sSoundFilePath;
 
 	m_Mutex.SetName( ssprintf("RageSound (%s)", Basename(sSoundFilePath).c_str() ) );
-
-	return true;
 }
 
 void RageSound::LoadSoundReader( RageSoundReader *pSound )
@@ -104,6 +104,10 @@ public:
 	 * this always will not cache the sound; this may become a preference. */
 	bool Load( RString sFile );
 
+	/* Load a file that's already been opened, eg. by RageSoundReader_Prefetched
+	 * on another thread, with the same buffering as above.  Doesn't fail. */
+	bool Load( RageSoundReader *pSound, RString sFile, const RageSoundLoadParams *pParams = nullptr );
+
 	/* Load a RageSoundReader that you've set up yourself. Sample rate conversion
 	 * will be set up only if needed. Doesn't fail. */
 	void LoadSoundReader( RageSoundReader *pSound );
@@ -154,6 +158,7 @@ private:
 
 	RString m_sFilePath;
 
+	void LoadFileReader( RageSoundReader *pSound, const RString &sFile, bool bPrecache, bool bNeedBuffer, const RageSoundLoadParams *pParams );
 	void ApplyParams();
 	RageSoundParams m_Param;
 
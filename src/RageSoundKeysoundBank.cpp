@@ -0,0 +1,496 @@
+#include "global.h"
+#include "RageSoundKeysoundBank.h"
+#include "RageLog.h"
+#include "RageSoundManager.h"
+#include "RageSoundReader_FileReader.h"
+#include "RageSoundReader_PostBuffering.h"
+#include "RageSoundReader_Resample_Good.h"
+#include "RageSoundUtil.h"
+#include "RageThreads.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "Preference.h"
+
+#include <atomic>
+#include <thread>
+
+/* The same limit as RageSoundReader_Preload. */
+extern Preference<int> g_iSoundPreloadMaxSamples;
+
+/* Voices per RageSoundKeysounds.  The driver mixes at most 32 sounds at once,
+ * and the music and the other player need some of them. */
+static const int NUM_VOICES = 12;
+
+static RageMutex g_BanksLock( "KeysoundBanks" ); /* protects g_mapBanks and reference counts */
+static map<RString, RageSoundKeysoundBank *> g_mapBanks;
+
+namespace
+{
+	struct DecodeQueue
+	{
+		DecodeQueue( const vector<RString> &asPaths, int iSampleRate ):
+			m_asPaths(asPaths), m_iSampleRate(iSampleRate),
+			m_aDecoded(asPaths.size()), m_aiChannels(asPaths.size(), 0), m_iNextJob(0) { }
+		const vector<RString> &m_asPaths;
+		int m_iSampleRate;
+		vector< vector<int16_t> > m_aDecoded;
+		/* 0 if the file wasn't loaded. */
+		vector<int> m_aiChannels;
+		std::atomic<size_t> m_iNextJob;
+	};
+
+	/* Decode a whole file at iSampleRate.  Return the number of channels, or 0
+	 * if it can't be loaded or is too long. */
+	int DecodeSample( const RString &sPath, int iSampleRate, vector<int16_t> &aOut )
+	{
+		RString sError;
+		RageSoundReader *pReader = RageSoundReader_FileReader::OpenFile( sPath, sError );
+		if( pReader == nullptr )
+		{
+			LOG->Warn( "Couldn't load keysound \"%s\": %s", sPath.c_str(), sError.c_str() );
+			return 0;
+		}
+
+		const int iChannels = pReader->GetNumChannels();
+		if( iChannels > 2 )
+		{
+			LOG->Warn( "Keysound \"%s\" has %i channels", sPath.c_str(), iChannels );
+			delete pReader;
+			return 0;
+		}
+
+		if( pReader->GetSampleRate() != iSampleRate )
+			pReader = new RageSoundReader_Resample_Good( pReader, iSampleRate );
+
+		const size_t iMaxSamples = g_iSoundPreloadMaxSamples.Get();
+		float buffer[1024];
+		for(;;)
+		{
+			int iGot = pReader->Read( buffer, ARRAYLEN(buffer) / iChannels );
+			if( iGot == RageSoundReader::END_OF_FILE )
+				break;
+			if( iGot < 0 || aOut.size() + iGot*iChannels > iMaxSamples )
+			{
+				/* Errors are reported again when it's streamed. */
+				aOut.clear();
+				delete pReader;
+				return 0;
+			}
+
+			const size_t iOldSize = aOut.size();
+			aOut.resize( iOldSize + iGot*iChannels );
+			RageSoundUtil::ConvertFloatToNativeInt16( buffer, &aOut[iOldSize], iGot*iChannels );
+		}
+
+		delete pReader;
+		return iChannels;
+	}
+
+	int DecodeThread( void *p )
+	{
+		DecodeQueue &queue = *static_cast<DecodeQueue *>( p );
+		for(;;)
+		{
+			const size_t iJob = queue.m_iNextJob++;
+			if( iJob >= queue.m_asPaths.size() )
+				return 0;
+			queue.m_aiChannels[iJob] = DecodeSample( queue.m_asPaths[iJob], queue.m_iSampleRate, queue.m_aDecoded[iJob] );
+		}
+	}
+}
+
+RageSoundKeysoundBank::RageSoundKeysoundBank( const vector<RString> &asPaths, int iSampleRate ):
+	m_sKey( join("\n", asPaths) ), m_asPaths( asPaths ), m_aSamples( asPaths.size() ),
+	m_iSampleRate( iSampleRate ), m_iReferences( 1 )
+{
+	RageTimer timer;
+
+	DecodeQueue queue( asPaths, iSampleRate );
+	const int iThreads = min( max(1, (int) std::thread::hardware_concurrency()), (int) asPaths.size() );
+	vector<RageThread *> apThreads;
+	for( int i = 0; i < iThreads; ++i )
+	{
+		RageThread *pThread = new RageThread;
+		pThread->SetName( ssprintf("Keysound decoder %i", i) );
+		pThread->Create( DecodeThread, &queue );
+		apThreads.push_back( pThread );
+	}
+	for (RageThread *pThread : apThreads)
+	{
+		pThread->Wait();
+		delete pThread;
+	}
+
+	/* Lay out each distinct sound once.  Identical sounds hash the same;
+	 * compare them to be sure. */
+	map< unsigned, vector<int> > mapHashToSamples;
+	vector<bool> abStored( m_aSamples.size(), false );
+	size_t iArenaSize = 0;
+	int iDuplicates = 0;
+	for( unsigned i = 0; i < m_aSamples.size(); ++i )
+	{
+		Sample &s = m_aSamples[i];
+		const vector<int16_t> &aData = queue.m_aDecoded[i];
+		s.iChannels = queue.m_aiChannels[i];
+		s.iFrames = s.iChannels? aData.size() / s.iChannels: 0;
+		s.iOffset = 0;
+		if( s.iChannels == 0 )
+			continue;
+
+		unsigned iHash = 0;
+		CRC32( iHash, aData.data(), aData.size() * sizeof(int16_t) );
+		iHash ^= s.iChannels;
+
+		vector<int> &aiSame = mapHashToSamples[iHash];
+		bool bDuplicate = false;
+		for (int j : aiSame)
+		{
+			if( m_aSamples[j].iChannels == s.iChannels && queue.m_aDecoded[j] == aData )
+			{
+				s.iOffset = m_aSamples[j].iOffset;
+				bDuplicate = true;
+				++iDuplicates;
+				break;
+			}
+		}
+		if( bDuplicate )
+			continue;
+
+		aiSame.push_back( i );
+		abStored[i] = true;
+		s.iOffset = iArenaSize;
+		iArenaSize += aData.size();
+	}
+
+	m_Arena.resize( iArenaSize );
+	for( unsigned i = 0; i < m_aSamples.size(); ++i )
+	{
+		if( abStored[i] )
+			copy( queue.m_aDecoded[i].begin(), queue.m_aDecoded[i].end(), m_Arena.begin() + m_aSamples[i].iOffset );
+	}
+
+	LOG->Trace( "Loaded %i keysounds (%i duplicates) in %.2f seconds, %i KiB",
+		(int) asPaths.size(), iDuplicates, timer.GetDeltaTime(), int(GetMemoryUsage() / 1024) );
+}
+
+RageSoundKeysoundBank *RageSoundKeysoundBank::Get( const vector<RString> &asPaths )
+{
+	const RString sKey = join( "\n", asPaths );
+	{
+		LockMut( g_BanksLock );
+		map<RString, RageSoundKeysoundBank *>::iterator it = g_mapBanks.find( sKey );
+		if( it != g_mapBanks.end() )
+		{
+			++it->second->m_iReferences;
+			return it->second;
+		}
+	}
+
+	/* Don't hold the lock while decoding; that would block readers being
+	 * copied on the sound thread. */
+	RageSoundKeysoundBank *pBank = new RageSoundKeysoundBank( asPaths, SOUNDMAN->GetDriverSampleRate() );
+
+	LockMut( g_BanksLock );
+	map<RString, RageSoundKeysoundBank *>::iterator it = g_mapBanks.find( sKey );
+	if( it != g_mapBanks.end() )
+	{
+		/* Someone else loaded it while we were. */
+		delete pBank;
+		++it->second->m_iReferences;
+		return it->second;
+	}
+
+	g_mapBanks[sKey] = pBank;
+	return pBank;
+}
+
+void RageSoundKeysoundBank::AddReference()
+{
+	LockMut( g_BanksLock );
+	++m_iReferences;
+}
+
+void RageSoundKeysoundBank::Release( RageSoundKeysoundBank *pBank )
+{
+	if( pBank == nullptr )
+		return;
+
+	LockMut( g_BanksLock );
+	if( --pBank->m_iReferences > 0 )
+		return;
+
+	g_mapBanks.erase( pBank->m_sKey );
+	delete pBank;
+}
+
+int RageSoundKeysoundBank::Read( int iSample, int iFrame, float *pBuf, int iFrames ) const
+{
+	const Sample &s = m_aSamples[iSample];
+	iFrames = clamp( s.iFrames - iFrame, 0, iFrames );
+	if( iFrames == 0 )
+		return 0;
+
+	RageSoundUtil::ConvertNativeInt16ToFloat( &m_Arena[s.iOffset + iFrame*s.iChannels], pBuf, iFrames * s.iChannels );
+	if( s.iChannels == 1 )
+		RageSoundUtil::ConvertMonoToStereoInPlace( pBuf, iFrames );
+	return iFrames;
+}
+
+RageSoundReader *RageSoundKeysoundBank::MakeReader( int iSample )
+{
+	ASSERT( IsLoaded(iSample) );
+	return new RageSoundReader_KeysoundBank( this, iSample );
+}
+
+RageSoundReader_KeysoundBank::RageSoundReader_KeysoundBank( RageSoundKeysoundBank *pBank, int iSample ):
+	m_pBank(pBank), m_iSample(iSample), m_iPosition(0)
+{
+	m_pBank->AddReference();
+}
+
+RageSoundReader_KeysoundBank::RageSoundReader_KeysoundBank( const RageSoundReader_KeysoundBank &cpy ):
+	RageSoundReader(cpy), m_pBank(cpy.m_pBank), m_iSample(cpy.m_iSample), m_iPosition(cpy.m_iPosition)
+{
+	m_pBank->AddReference();
+}
+
+RageSoundReader_KeysoundBank::~RageSoundReader_KeysoundBank()
+{
+	RageSoundKeysoundBank::Release( m_pBank );
+}
+
+int RageSoundReader_KeysoundBank::GetLength() const
+{
+	return int( int64_t(m_pBank->GetLengthFrames(m_iSample)) * 1000 / m_pBank->GetSampleRate() );
+}
+
+int RageSoundReader_KeysoundBank::SetPosition( int iFrame )
+{
+	const int iFrames = m_pBank->GetLengthFrames( m_iSample );
+	m_iPosition = min( iFrame, iFrames );
+	return m_iPosition < iFrames? 1:0;
+}
+
+int RageSoundReader_KeysoundBank::Read( float *pBuf, int iFrames )
+{
+	iFrames = m_pBank->Read( m_iSample, m_iPosition, pBuf, iFrames );
+	if( iFrames == 0 )
+		return END_OF_FILE;
+	m_iPosition += iFrames;
+	return iFrames;
+}
+
+/* One playing copy of a sample.  It's started and stopped on the main
+ * thread; GetDataToPlay is called by the driver's decoding thread. */
+class RageSoundKeysounds::Voice: public RageSoundBase
+{
+public:
+	Voice(): m_pBank(nullptr), m_iSample(0), m_iFrame(0), m_fVolume(1.0f),
+		m_fPan(0), m_bPlaying(false), m_iStartedNumber(0) { }
+
+	void SoundIsFinishedPlaying() { m_bPlaying = false; }
+	int GetDataToPlay( float *pBuffer, int iFrames, int64_t &iStreamFrame, int &iFramesStored )
+	{
+		iStreamFrame = m_iFrame;
+		iFramesStored = m_pBank->Read( m_iSample, m_iFrame, pBuffer, iFrames );
+		if( iFramesStored == 0 )
+			return RageSoundReader::END_OF_FILE;
+		m_iFrame += iFramesStored;
+
+		/* Like RageSoundReader_PostBuffering. */
+		const float fMaster = RageSoundReader_PostBuffering::GetMasterVolume();
+		const float fVolume = clamp( m_fVolume * fMaster * fMaster, 0.0f, 1.0f );
+		if( fVolume != 1.0f )
+			RageSoundUtil::Attenuate( pBuffer, iFramesStored * 2, fVolume );
+		RageSoundUtil::Pan( pBuffer, iFramesStored, m_fPan );
+		return iFramesStored;
+	}
+	void CommitPlayingPosition( int64_t iFrameno, int64_t iPosition, int iBytesRead ) { }
+	RString GetLoadedFilePath() const { return m_pBank->GetPath( m_iSample ); }
+
+	RageSoundKeysoundBank *m_pBank;
+	int m_iSample;
+	int m_iFrame;
+	std::atomic<float> m_fVolume;
+	float m_fPan;
+	bool m_bPlaying;
+	int m_iStartedNumber;
+};
+
+RageSoundKeysounds::RageSoundKeysounds()
+{
+	m_fPan = 0;
+	m_pBank = nullptr;
+	m_iVoicesStarted = 0;
+	for( int i = 0; i < NUM_VOICES; ++i )
+		m_apVoices.push_back( new Voice );
+}
+
+RageSoundKeysounds::~RageSoundKeysounds()
+{
+	Unload();
+	for (Voice *pVoice : m_apVoices)
+		delete pVoice;
+}
+
+void RageSoundKeysounds::Load( const vector<RString> &asPaths, float fPan )
+{
+	m_fPan = fPan;
+	for (RageSound &sound : m_StreamedSounds)
+		sound.SetProperty( "Pan", m_fPan );
+	if( asPaths == m_asPaths )
+		return;
+
+	Unload();
+	m_asPaths = asPaths;
+	if( m_asPaths.empty() )
+		return;
+
+	m_pBank = RageSoundKeysoundBank::Get( m_asPaths );
+
+	RageSoundLoadParams SoundParams;
+	SoundParams.m_bSupportPan = true;
+	m_StreamedSounds.resize( m_asPaths.size() );
+	for( unsigned i = 0; i < m_asPaths.size(); ++i )
+	{
+		if( m_pBank->IsLoaded(i) )
+			continue;
+		RageSound &sound = m_StreamedSounds[i];
+		sound.Load( m_asPaths[i], true, &SoundParams );
+		sound.SetProperty( "Pan", m_fPan );
+		sound.SetStopModeFromString( "stop" );
+	}
+}
+
+void RageSoundKeysounds::Unload()
+{
+	for (Voice *pVoice : m_apVoices)
+	{
+		if( pVoice->m_bPlaying )
+			SOUNDMAN->StopMixing( pVoice );
+		pVoice->m_bPlaying = false;
+		pVoice->m_pBank = nullptr;
+	}
+
+	m_StreamedSounds.clear();
+	RageSoundKeysoundBank::Release( m_pBank );
+	m_pBank = nullptr;
+	m_asPaths.clear();
+}
+
+void RageSoundKeysounds::Play( int iSound, float fVolume )
+{
+	if( iSound < 0 || iSound >= GetNumSounds() )
+		return;
+
+	if( !m_pBank->IsLoaded(iSound) )
+	{
+		RageSound &sound = m_StreamedSounds[iSound];
+		sound.Play( false );
+		sound.SetProperty( "Volume", fVolume );
+		return;
+	}
+
+	/* Use a free voice, or cut off the one that started first. */
+	Voice *pVoice = m_apVoices[0];
+	for (Voice *v : m_apVoices)
+	{
+		if( !v->m_bPlaying )
+		{
+			pVoice = v;
+			break;
+		}
+		if( v->m_iStartedNumber < pVoice->m_iStartedNumber )
+			pVoice = v;
+	}
+	if( pVoice->m_bPlaying )
+	{
+		SOUNDMAN->StopMixing( pVoice );
+		pVoice->m_bPlaying = false;
+	}
+
+	pVoice->m_pBank = m_pBank;
+	pVoice->m_iSample = iSound;
+	pVoice->m_iFrame = 0;
+	pVoice->m_fVolume = fVolume;
+	pVoice->m_fPan = m_fPan;
+	pVoice->m_iStartedNumber = ++m_iVoicesStarted;
+	pVoice->m_bPlaying = true;
+	SOUNDMAN->StartMixing( pVoice );
+}
+
+bool RageSoundKeysounds::IsPlaying( int iSound ) const
+{
+	if( iSound < 0 || iSound >= GetNumSounds() )
+		return false;
+	if( !m_pBank->IsLoaded(iSound) )
+		return m_StreamedSounds[iSound].IsPlaying();
+
+	for (Voice const *pVoice : m_apVoices)
+		if( pVoice->m_bPlaying && pVoice->m_iSample == iSound )
+			return true;
+	return false;
+}
+
+void RageSoundKeysounds::Stop( int iSound )
+{
+	if( iSound < 0 || iSound >= GetNumSounds() )
+		return;
+	if( !m_pBank->IsLoaded(iSound) )
+	{
+		m_StreamedSounds[iSound].Stop();
+		return;
+	}
+
+	for (Voice *pVoice : m_apVoices)
+	{
+		if( pVoice->m_bPlaying && pVoice->m_iSample == iSound )
+		{
+			SOUNDMAN->StopMixing( pVoice );
+			pVoice->m_bPlaying = false;
+		}
+	}
+}
+
+void RageSoundKeysounds::SetVolume( int iSound, float fVolume )
+{
+	if( iSound < 0 || iSound >= GetNumSounds() )
+		return;
+	if( !m_pBank->IsLoaded(iSound) )
+	{
+		m_StreamedSounds[iSound].SetProperty( "Volume", fVolume );
+		return;
+	}
+
+	Voice *pLatest = nullptr;
+	for (Voice *pVoice : m_apVoices)
+		if( pVoice->m_bPlaying && pVoice->m_iSample == iSound && (pLatest == nullptr || pVoice->m_iStartedNumber > pLatest->m_iStartedNumber) )
+			pLatest = pVoice;
+	if( pLatest != nullptr )
+		pLatest->m_fVolume = fVolume;
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -0,0 +1,155 @@
+/* RageSoundKeysoundBank - A song's keysounds, decoded once and shared by everything that plays them. */
+
+#ifndef RAGE_SOUND_KEYSOUND_BANK_H
+#define RAGE_SOUND_KEYSOUND_BANK_H
+
+#include "RageSound.h"
+#include "RageSoundReader.h"
+
+/**
+ * @brief Every keysound of a song, in one block of memory.
+ *
+ * All of the files are decoded at once, on as many threads as there are
+ * CPUs, and resampled to the sound driver's rate, so nothing has to be
+ * resampled while playing.  Files that decode to the same sound, which is
+ * common in BMS, are only stored once.  Files that are too long to preload
+ * (see SoundPreloadMaxSamples) or that fail to load are left out; IsLoaded
+ * returns false for them.
+ *
+ * Banks are shared: Get returns the loaded bank for the same files, if there
+ * is one.  The bank is freed when the last reference is released. */
+class RageSoundKeysoundBank
+{
+public:
+	static RageSoundKeysoundBank *Get( const vector<RString> &asPaths );
+	static void Release( RageSoundKeysoundBank *pBank );
+	void AddReference();
+
+	int GetNumSamples() const { return m_aSamples.size(); }
+	bool IsLoaded( int iSample ) const { return m_aSamples[iSample].iChannels != 0; }
+	int GetSampleRate() const { return m_iSampleRate; }
+	const RString &GetPath( int iSample ) const { return m_asPaths[iSample]; }
+	int GetLengthFrames( int iSample ) const { return m_aSamples[iSample].iFrames; }
+
+	/** @brief Read up to iFrames stereo frames of the sample, starting at
+	 * iFrame.  Returns the number of frames read, which is 0 at the end. */
+	int Read( int iSample, int iFrame, float *pBuf, int iFrames ) const;
+
+	/** @brief A reader for one loaded sample.  It holds a reference to
+	 * the bank. */
+	RageSoundReader *MakeReader( int iSample );
+
+	/** @brief The decoded sound data, in bytes. */
+	size_t GetMemoryUsage() const { return m_Arena.size() * sizeof(int16_t); }
+
+private:
+	RageSoundKeysoundBank( const vector<RString> &asPaths, int iSampleRate );
+
+	struct Sample
+	{
+		/* In samples, into m_Arena. */
+		size_t iOffset;
+		int iFrames;
+		/* 1 or 2; 0 if the sample isn't loaded. */
+		int iChannels;
+	};
+
+	RString m_sKey;
+	vector<RString> m_asPaths;
+	vector<Sample> m_aSamples;
+	vector<int16_t> m_Arena;
+	int m_iSampleRate;
+	int m_iReferences;
+};
+
+class RageSoundReader_KeysoundBank: public RageSoundReader
+{
+public:
+	RageSoundReader_KeysoundBank( RageSoundKeysoundBank *pBank, int iSample );
+	RageSoundReader_KeysoundBank( const RageSoundReader_KeysoundBank &cpy );
+	~RageSoundReader_KeysoundBank();
+	RageSoundReader_KeysoundBank *Copy() const { return new RageSoundReader_KeysoundBank(*this); }
+
+	int GetLength() const;
+	int GetLength_Fast() const { return GetLength(); }
+	int SetPosition( int iFrame );
+	int Read( float *pBuf, int iFrames );
+	int GetSampleRate() const { return m_pBank->GetSampleRate(); }
+	unsigned GetNumChannels() const { return 2; }
+	int GetNextSourceFrame() const { return m_iPosition; }
+	float GetStreamToSourceRatio() const { return 1.0f; }
+	RString GetError() const { return ""; }
+
+private:
+	RageSoundKeysoundBank *m_pBank;
+	int m_iSample;
+	int m_iPosition;
+};
+
+/**
+ * @brief Play one song's keysounds for a player.
+ *
+ * Loaded samples are played from the bank on a few lightweight voices that
+ * go straight to the sound driver, instead of through a RageSound each;
+ * when every voice is busy, the oldest is cut off.  Samples that aren't in
+ * the bank are streamed with a RageSound, as before. */
+class RageSoundKeysounds
+{
+public:
+	RageSoundKeysounds();
+	~RageSoundKeysounds();
+
+	/** @brief Load the given files.  If they're already loaded, as in the
+	 * editor, this does nothing. */
+	void Load( const vector<RString> &asPaths, float fPan );
+	void Unload();
+
+	int GetNumSounds() const { return m_asPaths.size(); }
+	void Play( int iSound, float fVolume );
+	bool IsPlaying( int iSound ) const;
+	/** @brief Stop every playing copy of a sound. */
+	void Stop( int iSound );
+	/** @brief Change the volume of the last started copy of a sound. */
+	void SetVolume( int iSound, float fVolume );
+
+private:
+	class Voice;
+
+	vector<RString> m_asPaths;
+	float m_fPan;
+	RageSoundKeysoundBank *m_pBank;
+	vector<Voice *> m_apVoices;
+	vector<RageSound> m_StreamedSounds;
+	int m_iVoicesStarted;
+
+	// Swallow up warnings. If they must be used, define them.
+	RageSoundKeysounds& operator=(const RageSoundKeysounds& rhs);
+	RageSoundKeysounds(const RageSoundKeysounds& rhs);
+};
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -18,6 +18,7 @@
 #include "LocalizedString.h"
 #include "Preference.h"
 #include "RageSoundReader_PostBuffering.h"
+#include "RageSoundMixKernels.h"
 
 #include "arch/Sound/RageSoundDriver.h"
 
@@ -44,6 +45,7 @@ void RageSoundManager::Init()
 	m_pDriver = RageSoundDriver::Create( g_sSoundDrivers );
 	if( m_pDriver == nullptr )
 		RageException::Throw( "%s", COULDNT_FIND_SOUND_DRIVER.GetValue().c_str() );
+	LOG->Info( "Sound mixing kernels: %s", MixKernelSetToString(RageSoundMixKernels::GetSelected()).c_str() );
 }
 
 RageSoundManager::~RageSoundManager()
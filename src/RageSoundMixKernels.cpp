@@ -0,0 +1,443 @@
+#include "global.h"
+#include "RageSoundMixKernels.h"
+#include "RageUtil.h"
+#include "EnumHelper.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MIX_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+/* Build the SSE2 and AVX2 kernels whatever the compiler flags say; only the
+ * ones the CPU has are ever called. */
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+#elif defined(__aarch64__)
+#define MIX_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+static const char *MixKernelSetNames[] = {
+	"Scalar",
+	"SSE2",
+	"AVX2",
+	"NEON",
+};
+XToString( MixKernelSet );
+
+namespace
+{
+	/* Stereo is the only layout mixed often enough to be worth vectorizing
+	 * the (de)interleaving; other channel counts use the scalar loops. */
+	struct Kernels
+	{
+		void (*MixAdd)( float *pDest, const float *pSrc, unsigned iSamples );
+		void (*Scale)( float *pBuf, unsigned iSamples, float fVolume );
+		void (*FloatToInt16)( const float *pFrom, int16_t *pTo, unsigned iSamples, float fScale );
+		float (*DotProduct)( const float *pA, const float *pB, unsigned iSamples );
+		void (*InterleaveStereo)( const float *pLeft, const float *pRight, float *pTo, unsigned iFrames );
+		void (*DeinterleaveStereo)( const float *pFrom, float *pLeft, float *pRight, unsigned iFrames );
+	};
+
+	// Scalar.  The vector kernels use these for the samples left over at the end.
+	void MixAdd_Scalar( float *pDest, const float *pSrc, unsigned iSamples )
+	{
+		for( unsigned i = 0; i < iSamples; ++i )
+			pDest[i] += pSrc[i];
+	}
+
+	void Scale_Scalar( float *pBuf, unsigned iSamples, float fVolume )
+	{
+		for( unsigned i = 0; i < iSamples; ++i )
+			pBuf[i] *= fVolume;
+	}
+
+	void FloatToInt16_Scalar( const float *pFrom, int16_t *pTo, unsigned iSamples, float fScale )
+	{
+		for( unsigned i = 0; i < iSamples; ++i )
+		{
+			int iOut = lrintf( clamp(pFrom[i], -1.0f, +1.0f) * fScale );
+			pTo[i] = (int16_t) clamp( iOut, -32768, 32767 );
+		}
+	}
+
+	float DotProduct_Scalar( const float *pA, const float *pB, unsigned iSamples )
+	{
+		float fTot = 0;
+		for( unsigned i = 0; i < iSamples; ++i )
+			fTot += pA[i]*pB[i];
+		return fTot;
+	}
+
+	void InterleaveStereo_Scalar( const float *pLeft, const float *pRight, float *pTo, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			pTo[i*2+0] = pLeft[i];
+			pTo[i*2+1] = pRight[i];
+		}
+	}
+
+	void DeinterleaveStereo_Scalar( const float *pFrom, float *pLeft, float *pRight, unsigned iFrames )
+	{
+		for( unsigned i = 0; i < iFrames; ++i )
+		{
+			pLeft[i] = pFrom[i*2+0];
+			pRight[i] = pFrom[i*2+1];
+		}
+	}
+
+	const Kernels g_Scalar = { MixAdd_Scalar, Scale_Scalar, FloatToInt16_Scalar,
+		DotProduct_Scalar, InterleaveStereo_Scalar, DeinterleaveStereo_Scalar };
+
+#if defined(MIX_KERNELS_X86)
+	/* cvtps2dq rounds like lrintf, in the current rounding mode, and
+	 * packssdw saturates, so these match the scalar kernels exactly. */
+	TARGET_SSE2 void MixAdd_SSE2( float *pDest, const float *pSrc, unsigned iSamples )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iSamples; i += 4 )
+			_mm_storeu_ps( pDest+i, _mm_add_ps(_mm_loadu_ps(pDest+i), _mm_loadu_ps(pSrc+i)) );
+		MixAdd_Scalar( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	TARGET_SSE2 void Scale_SSE2( float *pBuf, unsigned iSamples, float fVolume )
+	{
+		const __m128 vol = _mm_set1_ps( fVolume );
+		unsigned i = 0;
+		for( ; i + 4 <= iSamples; i += 4 )
+			_mm_storeu_ps( pBuf+i, _mm_mul_ps(_mm_loadu_ps(pBuf+i), vol) );
+		Scale_Scalar( pBuf+i, iSamples-i, fVolume );
+	}
+
+	TARGET_SSE2 void FloatToInt16_SSE2( const float *pFrom, int16_t *pTo, unsigned iSamples, float fScale )
+	{
+		const __m128 lo = _mm_set1_ps( -1.0f ), hi = _mm_set1_ps( +1.0f );
+		const __m128 scale = _mm_set1_ps( fScale );
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+		{
+			__m128 a = _mm_mul_ps( _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pFrom+i), lo), hi), scale );
+			__m128 b = _mm_mul_ps( _mm_min_ps(_mm_max_ps(_mm_loadu_ps(pFrom+i+4), lo), hi), scale );
+			__m128i packed = _mm_packs_epi32( _mm_cvtps_epi32(a), _mm_cvtps_epi32(b) );
+			_mm_storeu_si128( (__m128i *) (pTo+i), packed );
+		}
+		FloatToInt16_Scalar( pFrom+i, pTo+i, iSamples-i, fScale );
+	}
+
+	TARGET_SSE2 float HorizontalSum_SSE2( __m128 v )
+	{
+		v = _mm_add_ps( v, _mm_movehl_ps(v, v) );
+		v = _mm_add_ss( v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,1,1,1)) );
+		return _mm_cvtss_f32( v );
+	}
+
+	TARGET_SSE2 float DotProduct_SSE2( const float *pA, const float *pB, unsigned iSamples )
+	{
+		__m128 tot = _mm_setzero_ps();
+		unsigned i = 0;
+		for( ; i + 4 <= iSamples; i += 4 )
+			tot = _mm_add_ps( tot, _mm_mul_ps(_mm_loadu_ps(pA+i), _mm_loadu_ps(pB+i)) );
+		return HorizontalSum_SSE2( tot ) + DotProduct_Scalar( pA+i, pB+i, iSamples-i );
+	}
+
+	TARGET_SSE2 void InterleaveStereo_SSE2( const float *pLeft, const float *pRight, float *pTo, unsigned iFrames )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iFrames; i += 4 )
+		{
+			__m128 l = _mm_loadu_ps( pLeft+i ), r = _mm_loadu_ps( pRight+i );
+			_mm_storeu_ps( pTo+i*2, _mm_unpacklo_ps(l, r) );
+			_mm_storeu_ps( pTo+i*2+4, _mm_unpackhi_ps(l, r) );
+		}
+		InterleaveStereo_Scalar( pLeft+i, pRight+i, pTo+i*2, iFrames-i );
+	}
+
+	TARGET_SSE2 void DeinterleaveStereo_SSE2( const float *pFrom, float *pLeft, float *pRight, unsigned iFrames )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iFrames; i += 4 )
+		{
+			__m128 a = _mm_loadu_ps( pFrom+i*2 ), b = _mm_loadu_ps( pFrom+i*2+4 );
+			_mm_storeu_ps( pLeft+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)) );
+			_mm_storeu_ps( pRight+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)) );
+		}
+		DeinterleaveStereo_Scalar( pFrom+i*2, pLeft+i, pRight+i, iFrames-i );
+	}
+
+	const Kernels g_SSE2 = { MixAdd_SSE2, Scale_SSE2, FloatToInt16_SSE2,
+		DotProduct_SSE2, InterleaveStereo_SSE2, DeinterleaveStereo_SSE2 };
+
+	TARGET_AVX2 void MixAdd_AVX2( float *pDest, const float *pSrc, unsigned iSamples )
+	{
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+			_mm256_storeu_ps( pDest+i, _mm256_add_ps(_mm256_loadu_ps(pDest+i), _mm256_loadu_ps(pSrc+i)) );
+		MixAdd_Scalar( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	TARGET_AVX2 void Scale_AVX2( float *pBuf, unsigned iSamples, float fVolume )
+	{
+		const __m256 vol = _mm256_set1_ps( fVolume );
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+			_mm256_storeu_ps( pBuf+i, _mm256_mul_ps(_mm256_loadu_ps(pBuf+i), vol) );
+		Scale_Scalar( pBuf+i, iSamples-i, fVolume );
+	}
+
+	TARGET_AVX2 void FloatToInt16_AVX2( const float *pFrom, int16_t *pTo, unsigned iSamples, float fScale )
+	{
+		const __m256 lo = _mm256_set1_ps( -1.0f ), hi = _mm256_set1_ps( +1.0f );
+		const __m256 scale = _mm256_set1_ps( fScale );
+		unsigned i = 0;
+		for( ; i + 16 <= iSamples; i += 16 )
+		{
+			__m256 a = _mm256_mul_ps( _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(pFrom+i), lo), hi), scale );
+			__m256 b = _mm256_mul_ps( _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(pFrom+i+8), lo), hi), scale );
+			// vpackssdw packs within each 128-bit lane; put the quarters back in order.
+			__m256i packed = _mm256_packs_epi32( _mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b) );
+			packed = _mm256_permute4x64_epi64( packed, _MM_SHUFFLE(3,1,2,0) );
+			_mm256_storeu_si256( (__m256i *) (pTo+i), packed );
+		}
+		FloatToInt16_Scalar( pFrom+i, pTo+i, iSamples-i, fScale );
+	}
+
+	/* No FMA: that's a separate CPU feature, and AVX2 without it is common
+	 * enough in virtual machines. */
+	TARGET_AVX2 float DotProduct_AVX2( const float *pA, const float *pB, unsigned iSamples )
+	{
+		__m256 tot = _mm256_setzero_ps();
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+			tot = _mm256_add_ps( tot, _mm256_mul_ps(_mm256_loadu_ps(pA+i), _mm256_loadu_ps(pB+i)) );
+		__m128 tot4 = _mm_add_ps( _mm256_castps256_ps128(tot), _mm256_extractf128_ps(tot, 1) );
+		for( ; i + 4 <= iSamples; i += 4 )
+			tot4 = _mm_add_ps( tot4, _mm_mul_ps(_mm_loadu_ps(pA+i), _mm_loadu_ps(pB+i)) );
+		return HorizontalSum_SSE2( tot4 ) + DotProduct_Scalar( pA+i, pB+i, iSamples-i );
+	}
+
+	/* Shuffles across 128-bit lanes cost as much as the loads they'd save,
+	 * so (de)interleaving stays on SSE2. */
+	const Kernels g_AVX2 = { MixAdd_AVX2, Scale_AVX2, FloatToInt16_AVX2,
+		DotProduct_AVX2, InterleaveStereo_SSE2, DeinterleaveStereo_SSE2 };
+
+	bool CPUHas( MixKernelSet s )
+	{
+#if defined(__GNUC__)
+		__builtin_cpu_init();
+		switch( s )
+		{
+		case MixKernelSet_SSE2: return __builtin_cpu_supports( "sse2" );
+		case MixKernelSet_AVX2: return __builtin_cpu_supports( "avx2" );
+		default: return false;
+		}
+#elif defined(_MSC_VER)
+		int regs[4];
+		__cpuid( regs, 1 );
+		const bool bSSE2 = (regs[3] & (1 << 26)) != 0;
+		// AVX2 also needs the OS to save the YMM registers.
+		const bool bAVX = (regs[2] & (1 << 28)) != 0 && (regs[2] & (1 << 27)) != 0 &&
+			(_xgetbv(0) & 6) == 6;
+		__cpuidex( regs, 7, 0 );
+		const bool bAVX2 = bAVX && (regs[1] & (1 << 5)) != 0;
+		switch( s )
+		{
+		case MixKernelSet_SSE2: return bSSE2;
+		case MixKernelSet_AVX2: return bAVX2;
+		default: return false;
+		}
+#else
+		return false;
+#endif
+	}
+#endif
+
+#if defined(MIX_KERNELS_NEON)
+	/* vcvtnq rounds to nearest even, like lrintf in the default rounding
+	 * mode, and vqmovn saturates. */
+	void MixAdd_NEON( float *pDest, const float *pSrc, unsigned iSamples )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iSamples; i += 4 )
+			vst1q_f32( pDest+i, vaddq_f32(vld1q_f32(pDest+i), vld1q_f32(pSrc+i)) );
+		MixAdd_Scalar( pDest+i, pSrc+i, iSamples-i );
+	}
+
+	void Scale_NEON( float *pBuf, unsigned iSamples, float fVolume )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iSamples; i += 4 )
+			vst1q_f32( pBuf+i, vmulq_n_f32(vld1q_f32(pBuf+i), fVolume) );
+		Scale_Scalar( pBuf+i, iSamples-i, fVolume );
+	}
+
+	void FloatToInt16_NEON( const float *pFrom, int16_t *pTo, unsigned iSamples, float fScale )
+	{
+		const float32x4_t lo = vdupq_n_f32( -1.0f ), hi = vdupq_n_f32( +1.0f );
+		unsigned i = 0;
+		for( ; i + 8 <= iSamples; i += 8 )
+		{
+			float32x4_t a = vmulq_n_f32( vminq_f32(vmaxq_f32(vld1q_f32(pFrom+i), lo), hi), fScale );
+			float32x4_t b = vmulq_n_f32( vminq_f32(vmaxq_f32(vld1q_f32(pFrom+i+4), lo), hi), fScale );
+			vst1q_s16( pTo+i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))) );
+		}
+		FloatToInt16_Scalar( pFrom+i, pTo+i, iSamples-i, fScale );
+	}
+
+	float DotProduct_NEON( const float *pA, const float *pB, unsigned iSamples )
+	{
+		float32x4_t tot = vdupq_n_f32( 0 );
+		unsigned i = 0;
+		for( ; i + 4 <= iSamples; i += 4 )
+			tot = vmlaq_f32( tot, vld1q_f32(pA+i), vld1q_f32(pB+i) );
+		return vaddvq_f32( tot ) + DotProduct_Scalar( pA+i, pB+i, iSamples-i );
+	}
+
+	void InterleaveStereo_NEON( const float *pLeft, const float *pRight, float *pTo, unsigned iFrames )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iFrames; i += 4 )
+		{
+			float32x4x2_t lr = { { vld1q_f32(pLeft+i), vld1q_f32(pRight+i) } };
+			vst2q_f32( pTo+i*2, lr );
+		}
+		InterleaveStereo_Scalar( pLeft+i, pRight+i, pTo+i*2, iFrames-i );
+	}
+
+	void DeinterleaveStereo_NEON( const float *pFrom, float *pLeft, float *pRight, unsigned iFrames )
+	{
+		unsigned i = 0;
+		for( ; i + 4 <= iFrames; i += 4 )
+		{
+			float32x4x2_t lr = vld2q_f32( pFrom+i*2 );
+			vst1q_f32( pLeft+i, lr.val[0] );
+			vst1q_f32( pRight+i, lr.val[1] );
+		}
+		DeinterleaveStereo_Scalar( pFrom+i*2, pLeft+i, pRight+i, iFrames-i );
+	}
+
+	const Kernels g_NEON = { MixAdd_NEON, Scale_NEON, FloatToInt16_NEON,
+		DotProduct_NEON, InterleaveStereo_NEON, DeinterleaveStereo_NEON };
+#endif
+
+	const Kernels *GetKernels( MixKernelSet s )
+	{
+		switch( s )
+		{
+		case MixKernelSet_Scalar: return &g_Scalar;
+#if defined(MIX_KERNELS_X86)
+		case MixKernelSet_SSE2: return CPUHas(s)? &g_SSE2:nullptr;
+		case MixKernelSet_AVX2: return CPUHas(s)? &g_AVX2:nullptr;
+#endif
+#if defined(MIX_KERNELS_NEON)
+		case MixKernelSet_NEON: return &g_NEON;
+#endif
+		default: return nullptr;
+		}
+	}
+
+	MixKernelSet ChooseBest()
+	{
+		for( int s = NUM_MixKernelSet-1; s > MixKernelSet_Scalar; --s )
+			if( GetKernels((MixKernelSet) s) != nullptr )
+				return (MixKernelSet) s;
+		return MixKernelSet_Scalar;
+	}
+
+	MixKernelSet g_Selected = ChooseBest();
+	const Kernels *g_pKernels = GetKernels( g_Selected );
+}
+
+bool RageSoundMixKernels::IsSupported( MixKernelSet s )
+{
+	return GetKernels( s ) != nullptr;
+}
+
+void RageSoundMixKernels::Select( MixKernelSet s )
+{
+	ASSERT_M( IsSupported(s), MixKernelSetToString(s) );
+	g_Selected = s;
+	g_pKernels = GetKernels( s );
+}
+
+MixKernelSet RageSoundMixKernels::GetSelected()
+{
+	return g_Selected;
+}
+
+void RageSoundMixKernels::MixAdd( float *pDest, const float *pSrc, unsigned iSamples )
+{
+	g_pKernels->MixAdd( pDest, pSrc, iSamples );
+}
+
+void RageSoundMixKernels::Scale( float *pBuf, unsigned iSamples, float fVolume )
+{
+	g_pKernels->Scale( pBuf, iSamples, fVolume );
+}
+
+void RageSoundMixKernels::FloatToInt16( const float *pFrom, int16_t *pTo, unsigned iSamples, float fScale )
+{
+	g_pKernels->FloatToInt16( pFrom, pTo, iSamples, fScale );
+}
+
+float RageSoundMixKernels::DotProduct( const float *pA, const float *pB, unsigned iSamples )
+{
+	return g_pKernels->DotProduct( pA, pB, iSamples );
+}
+
+void RageSoundMixKernels::Interleave( const float *const *pFrom, float *pTo, int iChannels, unsigned iFrames )
+{
+	if( iChannels == 2 )
+	{
+		g_pKernels->InterleaveStereo( pFrom[0], pFrom[1], pTo, iFrames );
+		return;
+	}
+
+	for( int ch = 0; ch < iChannels; ++ch )
+		for( unsigned i = 0; i < iFrames; ++i )
+			pTo[i*iChannels + ch] = pFrom[ch][i];
+}
+
+void RageSoundMixKernels::Deinterleave( const float *pFrom, float *const *pTo, int iChannels, unsigned iFrames )
+{
+	if( iChannels == 2 )
+	{
+		g_pKernels->DeinterleaveStereo( pFrom, pTo[0], pTo[1], iFrames );
+		return;
+	}
+
+	for( unsigned i = 0; i < iFrames; ++i )
+		for( int ch = 0; ch < iChannels; ++ch )
+			pTo[ch][i] = pFrom[i*iChannels + ch];
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
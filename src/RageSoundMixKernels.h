@@ -0,0 +1,73 @@
+/* RageSoundMixKernels - Vectorized inner loops for mixing and converting sound buffers. */
+
+#ifndef RAGE_SOUND_MIX_KERNELS_H
+#define RAGE_SOUND_MIX_KERNELS_H
+
+/** @brief The instruction sets the kernels are written for. */
+enum MixKernelSet
+{
+	MixKernelSet_Scalar,	/**< Plain C++; always available. */
+	MixKernelSet_SSE2,	/**< x86 and x86-64. */
+	MixKernelSet_AVX2,	/**< x86-64 CPUs from about 2013 on. */
+	MixKernelSet_NEON,	/**< 64-bit ARM. */
+	NUM_MixKernelSet,
+	MixKernelSet_Invalid
+};
+const RString& MixKernelSetToString( MixKernelSet s );
+
+/**
+ * @brief The loops that every mixed sample goes through.
+ *
+ * The best set the CPU supports is picked at startup.  Every set gives the
+ * same results as the scalar one, sample for sample, so which one runs is
+ * never audible; the one exception is DotProduct, which adds in a different
+ * order on each set.  Buffers don't need any particular alignment. */
+namespace RageSoundMixKernels
+{
+	bool IsSupported( MixKernelSet s );
+	/** @brief Switch to another set, for comparing them.  It must be supported. */
+	void Select( MixKernelSet s );
+	MixKernelSet GetSelected();
+
+	/** @brief pDest[i] += pSrc[i] */
+	void MixAdd( float *pDest, const float *pSrc, unsigned iSamples );
+	/** @brief pBuf[i] *= fVolume */
+	void Scale( float *pBuf, unsigned iSamples, float fVolume );
+	/** @brief Clamp each sample to -1..+1, multiply by fScale and round to
+	 * the nearest int16_t, saturating. */
+	void FloatToInt16( const float *pFrom, int16_t *pTo, unsigned iSamples, float fScale );
+	/** @brief The sum of pA[i] * pB[i], for FIR filters.  It may differ
+	 * from the scalar result in the last few bits. */
+	float DotProduct( const float *pA, const float *pB, unsigned iSamples );
+	/** @brief Merge one buffer per channel into one buffer of frames. */
+	void Interleave( const float *const *pFrom, float *pTo, int iChannels, unsigned iFrames );
+	/** @brief Split a buffer of frames into one buffer per channel. */
+	void Deinterleave( const float *pFrom, float *const *pTo, int iChannels, unsigned iFrames );
+}
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
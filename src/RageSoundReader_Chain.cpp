@@ -3,6 +3,7 @@
 #include "RageSoundReader_FileReader.h"
 #include "RageSoundReader_Resample_Good.h"
 #include "RageSoundReader_Preload.h"
+#include "RageSoundKeysoundBank.h"
 #include "RageSoundReader_Pan.h"
 #include "RageLog.h"
 #include "RageUtil.h"
@@ -105,6 +106,8 @@ int RageSoundReader_Chain::GetSampleRateInternal() const
 	int iRate = -1;
 	for (RageSoundReader const *it : m_apLoadedSounds)
 	{
+		if( it == nullptr )
+			continue;
 		if( iRate == -1 )
 			iRate = it->GetSampleRate();
 		else if( iRate != it->GetSampleRate() )
@@ -123,7 +126,7 @@ void RageSoundReader_Chain::Finish()
 
 	if( m_iChannels > 2 )
 	{
-		for (RageSoundReader *it : m_apLoadedSounds)
+		for (RageSoundReader *&it : m_apLoadedSounds)
 		{
 			if( it->GetNumChannels() != m_iChannels )
 			{
@@ -158,8 +161,10 @@ void RageSoundReader_Chain::Finish()
 	m_iActualSampleRate = GetSampleRateInternal();
 	if( m_iActualSampleRate == -1 )
 	{
-		for (RageSoundReader *it : m_apLoadedSounds)
+		for (RageSoundReader *&it : m_apLoadedSounds)
 		{
+			if( it == nullptr || it->GetSampleRate() == m_iPreferredSampleRate )
+				continue;
 			RageSoundReader_Resample_Good *pResample = new RageSoundReader_Resample_Good( it, m_iPreferredSampleRate );
 			it = pResample;
 		}
@@ -167,10 +172,11 @@ void RageSoundReader_Chain::Finish()
 		m_iActualSampleRate = m_iPreferredSampleRate;
 	}
 
-	/* Attempt to preload all sounds. */
-	for (RageSoundReader *it : m_apLoadedSounds)
+	/* Attempt to preload all sounds that aren't in memory already. */
+	for (RageSoundReader *&it : m_apLoadedSounds)
 	{
-		RageSoundReader_Preload::PreloadSound( it );
+		if( it != nullptr && dynamic_cast<RageSoundReader_KeysoundBank *>(it) == nullptr )
+			RageSoundReader_Preload::PreloadSound( it );
 	}
 
 	/* Sort the sounds by start time. */
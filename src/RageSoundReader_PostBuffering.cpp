@@ -23,6 +23,12 @@ void RageSoundReader_PostBuffering::SetMasterVolume(float fVolume) {
 	g_fMasterVolume = fVolume;
 }
 
+float RageSoundReader_PostBuffering::GetMasterVolume()
+{
+	LockMut(g_Mutex);
+	return g_fMasterVolume;
+}
+
 int RageSoundReader_PostBuffering::Read( float *pBuf, int iFrames )
 {
 	iFrames = m_pSource->Read( pBuf, iFrames );
@@ -11,6 +11,7 @@ public:
 	RageSoundReader_PostBuffering( RageSoundReader *pSource );
 	RageSoundReader_PostBuffering *Copy() const { return new RageSoundReader_PostBuffering(*this); }
 	static void SetMasterVolume( float fVolume );
+	static float GetMasterVolume();
 	virtual int Read( float *pBuf, int iFrames );
 	virtual bool SetProperty( const RString &sProperty, float fValue );
 
@@ -0,0 +1,141 @@
+#include "global.h"
+#include "RageSoundReader_Prefetched.h"
+#include "RageSoundReader_FileReader.h"
+#include "RageUtil.h"
+
+RageSoundReader_Prefetched::RageSoundReader_Prefetched( RageSoundReader *pSource, int iStartFrame ):
+	RageSoundReader_Filter( pSource )
+{
+	m_iStartFrame = iStartFrame;
+	m_iPrefetchedFrames = 0;
+	m_iPosition = -1;
+	m_bSourceAtEnd = true;
+}
+
+RageSoundReader_Prefetched *RageSoundReader_Prefetched::Open( const RString &sPath, float fStartSecond, float fSeconds, RString &sError )
+{
+	bool bPrebuffer;
+	RageSoundReader *pSource = RageSoundReader_FileReader::OpenFile( sPath, sError, &bPrebuffer );
+	if( pSource == nullptr )
+		return nullptr;
+
+	const int iStartFrame = max( (int) lrintf(fStartSecond * pSource->GetSampleRate()), 0 );
+	RageSoundReader_Prefetched *pRet = new RageSoundReader_Prefetched( pSource, iStartFrame );
+	int iRet = pSource->SetPosition( iStartFrame );
+	if( iRet == -1 )
+	{
+		sError = pSource->GetError();
+		delete pRet;
+		return nullptr;
+	}
+
+	/* If the start is past the end of the file, there's nothing to prefetch. */
+	if( iRet == 0 )
+		return pRet;
+
+	const int iChannels = pSource->GetNumChannels();
+	const int iWantFrames = lrintf( fSeconds * pSource->GetSampleRate() );
+	pRet->m_Prefetched.resize( iWantFrames * iChannels );
+	while( pRet->m_iPrefetchedFrames < iWantFrames )
+	{
+		int iGot = pSource->Read( &pRet->m_Prefetched[pRet->m_iPrefetchedFrames * iChannels], iWantFrames - pRet->m_iPrefetchedFrames );
+		if( iGot == RageSoundReader::ERROR )
+		{
+			sError = pSource->GetError();
+			delete pRet;
+			return nullptr;
+		}
+		if( iGot <= 0 )
+			break;
+		pRet->m_iPrefetchedFrames += iGot;
+	}
+	pRet->m_Prefetched.resize( pRet->m_iPrefetchedFrames * iChannels );
+
+	if( pRet->m_iPrefetchedFrames > 0 )
+		pRet->m_iPosition = iStartFrame;
+	return pRet;
+}
+
+int RageSoundReader_Prefetched::SetPosition( int iFrame )
+{
+	if( iFrame >= m_iStartFrame && iFrame < m_iStartFrame + m_iPrefetchedFrames )
+	{
+		m_iPosition = iFrame;
+		return 1;
+	}
+
+	m_iPosition = -1;
+	m_bSourceAtEnd = false;
+	return RageSoundReader_Filter::SetPosition( iFrame );
+}
+
+int RageSoundReader_Prefetched::Read( float *pBuf, int iFrames )
+{
+	if( InPrefetch() )
+	{
+		const int iOffset = m_iPosition - m_iStartFrame;
+		const int iFramesLeft = m_iPrefetchedFrames - iOffset;
+		if( iFramesLeft > 0 )
+		{
+			const int iChannels = GetNumChannels();
+			iFrames = min( iFrames, iFramesLeft );
+			memcpy( pBuf, &m_Prefetched[iOffset * iChannels], iFrames * iChannels * sizeof(float) );
+			m_iPosition += iFrames;
+			return iFrames;
+		}
+
+		/* That's everything we prefetched.  Carry on from the file; if it's
+		 * been read or seeked since, put it back at the end of the block. */
+		m_iPosition = -1;
+		if( !m_bSourceAtEnd )
+		{
+			int iRet = RageSoundReader_Filter::SetPosition( m_iStartFrame + m_iPrefetchedFrames );
+			if( iRet == -1 )
+				return RageSoundReader::ERROR;
+			if( iRet == 0 )
+				return RageSoundReader::END_OF_FILE;
+		}
+	}
+
+	m_bSourceAtEnd = false;
+	return m_pSource->Read( pBuf, iFrames );
+}
+
+int RageSoundReader_Prefetched::GetNextSourceFrame() const
+{
+	if( InPrefetch() )
+		return m_iPosition;
+	return m_pSource->GetNextSourceFrame();
+}
+
+float RageSoundReader_Prefetched::GetStreamToSourceRatio() const
+{
+	if( InPrefetch() )
+		return 1.0f;
+	return m_pSource->GetStreamToSourceRatio();
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -0,0 +1,71 @@
+/* RageSoundReader_Prefetched - A file reader with the start of playback already decoded. */
+
+#ifndef RAGE_SOUND_READER_PREFETCHED_H
+#define RAGE_SOUND_READER_PREFETCHED_H
+
+#include "RageSoundReader_Filter.h"
+
+/**
+ * @brief Open a sound file and decode a few seconds from a given point ahead
+ * of time, so it can start playing there without touching the disk.
+ *
+ * Reads inside the decoded block come from memory; when they run past it,
+ * they continue from the file, which is already positioned there.  Seeking
+ * anywhere else seeks the file as usual. */
+class RageSoundReader_Prefetched: public RageSoundReader_Filter
+{
+public:
+	/** @brief Open sPath and decode fSeconds of it from fStartSecond.  This
+	 * takes a while; call it from a thread.  Returns nullptr on error. */
+	static RageSoundReader_Prefetched *Open( const RString &sPath, float fStartSecond, float fSeconds, RString &sError );
+
+	RageSoundReader_Prefetched *Copy() const { return new RageSoundReader_Prefetched(*this); }
+
+	int SetPosition( int iFrame );
+	int Read( float *pBuf, int iFrames );
+	int GetNextSourceFrame() const;
+	float GetStreamToSourceRatio() const;
+
+	int GetPrefetchedFrames() const { return m_iPrefetchedFrames; }
+
+private:
+	RageSoundReader_Prefetched( RageSoundReader *pSource, int iStartFrame );
+	bool InPrefetch() const { return m_iPosition != -1; }
+
+	/* Interleaved, from m_iStartFrame. */
+	vector<float> m_Prefetched;
+	int m_iStartFrame;
+	int m_iPrefetchedFrames;
+
+	/* The next frame to read from m_Prefetched, or -1 if reading from the file. */
+	int m_iPosition;
+	/* True if the file is positioned at the end of m_Prefetched. */
+	bool m_bSourceAtEnd;
+};
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -11,11 +11,13 @@
 #include "RageUtil.h"
 #include "RageMath.h"
 #include "RageThreads.h"
+#include "RageSoundMixKernels.h"
+#include "PrefsManager.h"
 
 #include <numeric>
 
-/* Filter length.  This must be a power of 2. */
-#define L 8
+/* Filter length for each ResampleQuality.  These must be powers of 2. */
+static const int g_iFilterTaps[RageSoundReader_Resample_Good::NUM_RESAMP] = { 4, 8, 16 };
 
 namespace
 {
@@ -144,32 +146,43 @@ void RunFIRFilter( float *pIn, float *pOut, int iInputValues, float *pFIR, int i
 }
 #endif
 
+/* A buffer whose start is aligned to 32 bytes.  Rows of a filter L taps wide
+ * only start on a vector boundary when L is a multiple of 8, so the mixing
+ * kernels use unaligned loads.  T must be a plain type like float;
+ * constructors aren't run. */
 template<typename T>
 class AlignedBuffer
 {
 public:
 	AlignedBuffer( int iSize )
 	{
-		m_iSize = iSize;
-		m_pBuf = new T[m_iSize];
+		Allocate( iSize );
 	}
 
 	AlignedBuffer( const AlignedBuffer &cpy )
 	{
-		m_iSize = cpy.m_iSize;
-		m_pBuf = new T[m_iSize];
+		Allocate( cpy.m_iSize );
 		memcpy( m_pBuf, cpy.m_pBuf, sizeof(T)*m_iSize );
 	}
 	~AlignedBuffer()
 	{
-		delete [] m_pBuf;
+		delete [] m_pAllocation;
 	}
 	operator T*() { return m_pBuf; }
 	operator const T*() const { return m_pBuf; }
 
 private:
+	enum { ALIGNMENT = 32 };
+	void Allocate( int iSize )
+	{
+		m_iSize = iSize;
+		m_pAllocation = new char[sizeof(T)*m_iSize + ALIGNMENT-1];
+		m_pBuf = (T *) (((uintptr_t) m_pAllocation + ALIGNMENT-1) & ~(uintptr_t) (ALIGNMENT-1));
+	}
+
 	T& operator=( T &rhs );
 	int m_iSize;
+	char *m_pAllocation;
 	T *m_pBuf;
 };
 
@@ -177,8 +190,8 @@ struct PolyphaseFilter
 {
 	struct State
 	{
-		State( int iUpFactor ):
-			m_fBuf( L * 2 )
+		State( int iUpFactor, int iTaps ):
+			m_fBuf( iTaps * 2 )
 		{
 			m_iPolyIndex = iUpFactor-1;
 			m_iFilled = 0;
@@ -188,30 +201,32 @@ struct PolyphaseFilter
 		int m_iPolyIndex;
 		int m_iFilled;
 
-		/* This buffer is duplicated.  If the circular buffer is size L, the actual buffer
-		 * is size L*2, and data at buf[N] is also at buf[N+L].  That way, we can access
-		 * up to buf[N*2-1] without having to wrap. */
+		/* This buffer is duplicated.  If the circular buffer is size L (the number of taps),
+		 * the actual buffer is size L*2, and data at buf[N] is also at buf[N+L].  That way,
+		 * we can access up to buf[N*2-1] without having to wrap. */
 		AlignedBuffer<float> m_fBuf;
 		int m_iBufNext;
 	};
 	friend struct State;
 
-	PolyphaseFilter( int iUpFactor ):
-		m_pPolyphase( L*iUpFactor )
+	PolyphaseFilter( int iUpFactor, int iTaps ):
+		m_pPolyphase( iTaps*iUpFactor )
 	{
 		m_iUpFactor = iUpFactor;
+		m_iTaps = iTaps;
 	}
 
 	void Generate( const float *pFIR );
 	int RunPolyphaseFilter( State &State, const float *pIn, int iSamplesIn, int iDownFactor,
 			float *pOut, int iSamplesOut, int iSampleStride ) const;
-	int GetLatency() const { return L/2; }
+	int GetLatency() const { return m_iTaps/2; }
 
 	int NumInputsForOutputSamples( const State &State, int iOut, int iDownFactor ) const;
 
 private:
 	AlignedBuffer<float> m_pPolyphase;
 	int m_iUpFactor;
+	int m_iTaps;
 };
 
 /*
@@ -250,6 +265,7 @@ private:
  */
 void PolyphaseFilter::Generate( const float *pFIR )
 {
+	const int L = m_iTaps;
 	float *pOutput=m_pPolyphase;
 	int iInputSize = L*m_iUpFactor;
 
@@ -298,6 +314,7 @@ int PolyphaseFilter::RunPolyphaseFilter(
 {
 	ASSERT( iSamplesIn >= 0 );
 
+	const int L = m_iTaps;
 	float *pOutOrig = pOut;
 	const float *pInEnd = pIn + iSamplesIn*iSampleStride;
 	const float *pOutEnd = pOut + iSamplesOut*iSampleStride;
@@ -326,10 +343,7 @@ int PolyphaseFilter::RunPolyphaseFilter(
 			const float *pCurPoly = &m_pPolyphase[iPolyIndex*L];
 			const float *pInData = &State.m_fBuf[State.m_iBufNext];
 
-			float fTot = 0;
-			for( int j = 0; j < L; ++j )
-				fTot += pInData[j]*pCurPoly[j];
-			*pOut = fTot;
+			*pOut = RageSoundMixKernels::DotProduct( pInData, pCurPoly, L );
 			pOut += iSampleStride;
 
 			iPolyIndex += iDownFactor;
@@ -355,6 +369,7 @@ int PolyphaseFilter::RunPolyphaseFilter(
  */
 int PolyphaseFilter::NumInputsForOutputSamples( const State &State, int iOut, int iDownFactor ) const
 {
+	const int L = m_iTaps;
 	int iIn = 0;
 	int iFilled = State.m_iFilled;
 	int iPolyIndex = State.m_iPolyIndex;
@@ -401,15 +416,18 @@ int PolyphaseFilter::NumInputsForOutputSamples( const State &State, int iOut, in
 namespace PolyphaseFilterCache
 {
 	/* Cache filter data, and reuse it without copying.  All operations after creation
-	 * are const, so this doesn't cause thread-safety problems. */
-	typedef map<pair<int,float>, PolyphaseFilter *> FilterMap;
+	 * are const, so this doesn't cause thread-safety problems.  Filters are keyed by
+	 * (taps, upsampling factor), then cutoff frequency, which is set by the downsampling
+	 * factor. */
+	typedef pair<pair<int,int>,float> FilterParams;
+	typedef map<FilterParams, PolyphaseFilter *> FilterMap;
 	static RageMutex PolyphaseFiltersLock("PolyphaseFiltersLock");
 	static FilterMap g_mapPolyphaseFilters;
 		
-	const PolyphaseFilter *MakePolyphaseFilter( int iUpFactor, float fCutoffFrequency )
+	const PolyphaseFilter *MakePolyphaseFilter( int iTaps, int iUpFactor, float fCutoffFrequency )
 	{
 		PolyphaseFiltersLock.Lock();
-		pair<int,float> params( make_pair(iUpFactor, fCutoffFrequency) );
+		FilterParams params( make_pair(iTaps, iUpFactor), fCutoffFrequency );
 		FilterMap::const_iterator it = g_mapPolyphaseFilters.find(params);
 		if( it != g_mapPolyphaseFilters.end() )
 		{
@@ -418,14 +436,14 @@ namespace PolyphaseFilterCache
 			PolyphaseFiltersLock.Unlock();
 			return pPolyphase;
 		}
-		int iWinSize = L*iUpFactor;
+		int iWinSize = iTaps*iUpFactor;
 		float *pFIR = new float[iWinSize];
 		GenerateSincLowPassFilter( pFIR, iWinSize, fCutoffFrequency );
 		ApplyKaiserWindow( pFIR, iWinSize, 8 );
 		NormalizeVector( pFIR, iWinSize );
 		MultiplyVector( &pFIR[0], &pFIR[iWinSize], (float) iUpFactor );
 
-		PolyphaseFilter *pPolyphase = new PolyphaseFilter( iUpFactor );
+		PolyphaseFilter *pPolyphase = new PolyphaseFilter( iUpFactor, iTaps );
 		pPolyphase->Generate( pFIR );
 		delete [] pFIR;
 
@@ -434,17 +452,17 @@ namespace PolyphaseFilterCache
 		return pPolyphase;
 	}
 
-	const PolyphaseFilter *FindNearestPolyphaseFilter( int iUpFactor, float fCutoffFrequency )
+	const PolyphaseFilter *FindNearestPolyphaseFilter( int iTaps, int iUpFactor, float fCutoffFrequency )
 	{
-		/* Find a cached filter with the same iUpFactor and a nearby cutoff frequency.
-		 * Round the cutoff down, if possible; it's better to filter out too much than
-		 * too little. */
+		/* Find a cached filter with the same iTaps and iUpFactor and a nearby cutoff
+		 * frequency.  Round the cutoff down, if possible; it's better to filter out too
+		 * much than too little. */
 		PolyphaseFiltersLock.Lock();
-		pair<int,float> params( make_pair(iUpFactor, fCutoffFrequency + 0.0001f) );
+		FilterParams params( make_pair(iTaps, iUpFactor), fCutoffFrequency + 0.0001f );
 		FilterMap::const_iterator it = g_mapPolyphaseFilters.upper_bound( params );
 		if( it != g_mapPolyphaseFilters.begin() )
 			--it;
-		ASSERT( it->first.first == iUpFactor );
+		ASSERT( it->first.first == params.first );
 		PolyphaseFilter *pPolyphase = it->second;
 		PolyphaseFiltersLock.Unlock();
 		return pPolyphase;
@@ -461,12 +479,13 @@ public:
 	/* Note that going outside of [iMinDownFactor,iMaxDownFactor] while resampling isn't
 	 * fatal.  It'll only cause aliasing, by not having a LPF that's low enough, or cause
 	 * too much filtering, by not having a LPF that's high enough. */
-	RageSoundResampler_Polyphase( int iUpFactor, int iMinDownFactor, int iMaxDownFactor )
+	RageSoundResampler_Polyphase( int iTaps, int iUpFactor, int iMinDownFactor, int iMaxDownFactor )
 	{
 		/* Cache filters between iMinDownFactor and iMaxDownFactor.  Do them in 
 		 * iFilterIncrement increments; we'll round down to the closest match
 		 * when filtering.  This will only cause the low-pass filter to be rounded;
 		 * the conversion ratio will always be exact. */
+		m_iTaps = iTaps;
 		m_iUpFactor = iUpFactor;
 		m_pPolyphase = nullptr;
 
@@ -474,12 +493,12 @@ public:
 		for( int iDownFactor = iMinDownFactor; iDownFactor <= iMaxDownFactor; iDownFactor += iFilterIncrement )
 		{
 			float fCutoffFrequency = GetCutoffFrequency( iDownFactor );
-			PolyphaseFilterCache::MakePolyphaseFilter( m_iUpFactor, fCutoffFrequency );
+			PolyphaseFilterCache::MakePolyphaseFilter( m_iTaps, m_iUpFactor, fCutoffFrequency );
 		}
 
 		SetDownFactor( iUpFactor );
 
-		m_pState = new PolyphaseFilter::State( iUpFactor );
+		m_pState = new PolyphaseFilter::State( iUpFactor, m_iTaps );
 	}
 
 	~RageSoundResampler_Polyphase()
@@ -501,7 +520,7 @@ public:
 	void Reset()
 	{
 		delete m_pState;
-		m_pState = new PolyphaseFilter::State( m_iUpFactor );
+		m_pState = new PolyphaseFilter::State( m_iUpFactor, m_iTaps );
 	}
 
 	int NumInputsForOutputSamples( int iOut ) const { return m_pPolyphase->NumInputsForOutputSamples(*m_pState, iOut, m_iDownFactor); }
@@ -512,6 +531,7 @@ public:
 	{
 		m_pPolyphase = cpy.m_pPolyphase; // don't copy
 		m_pState = new PolyphaseFilter::State(*cpy.m_pState);
+		m_iTaps = cpy.m_iTaps;
 		m_iUpFactor = cpy.m_iUpFactor;
 		m_iDownFactor = cpy.m_iDownFactor;
 	}
@@ -536,11 +556,12 @@ private:
 	const PolyphaseFilter *GetFilter( int iDownFactor ) const
 	{
 		float fCutoffFrequency = GetCutoffFrequency( iDownFactor );
-		return PolyphaseFilterCache::FindNearestPolyphaseFilter( m_iUpFactor, fCutoffFrequency );
+		return PolyphaseFilterCache::FindNearestPolyphaseFilter( m_iTaps, m_iUpFactor, fCutoffFrequency );
 	}
 	
 	const PolyphaseFilter *m_pPolyphase;
 	PolyphaseFilter::State *m_pState;
+	int m_iTaps;
 	int m_iUpFactor;
 	int m_iDownFactor;
 };
@@ -579,6 +600,19 @@ RageSoundReader_Resample_Good::RageSoundReader_Resample_Good( RageSoundReader *p
 {
 	m_iSampleRate = iSampleRate;
 	m_fRate = -1;
+	m_Quality = RESAMP_NORMAL;
+	if( PREFSMAN != nullptr )
+		m_Quality = (ResampleQuality) clamp( PREFSMAN->m_iSoundResampleQuality.Get(), 0, NUM_RESAMP-1 );
+	ReopenResampler();
+}
+
+/* Changing the filter length starts the filter over, like a seek. */
+void RageSoundReader_Resample_Good::SetQuality( ResampleQuality q )
+{
+	ASSERT( q >= 0 && q < NUM_RESAMP );
+	if( q == m_Quality )
+		return;
+	m_Quality = q;
 	ReopenResampler();
 }
 
@@ -626,7 +660,7 @@ void RageSoundReader_Resample_Good::ReopenResampler()
 		if( m_fRate != -1 )
 			iMaxDownFactor *= 5;
 
-		RageSoundResampler_Polyphase *p = new RageSoundResampler_Polyphase( iUpFactor, iMinDownFactor, iMaxDownFactor );
+		RageSoundResampler_Polyphase *p = new RageSoundResampler_Polyphase( g_iFilterTaps[m_Quality], iUpFactor, iMinDownFactor, iMaxDownFactor );
 		m_apResamplers.push_back( p );
 	}
 
@@ -731,6 +765,7 @@ RageSoundReader_Resample_Good::RageSoundReader_Resample_Good( const RageSoundRea
 		this->m_apResamplers.push_back( new RageSoundResampler_Polyphase(*cpy.m_apResamplers[i]) );
 	this->m_iSampleRate = cpy.m_iSampleRate;
 	this->m_fRate = cpy.m_fRate;
+	this->m_Quality = cpy.m_Quality;
 }
 
 RageSoundReader_Resample_Good *RageSoundReader_Resample_Good::Copy() const
@@ -11,7 +11,17 @@ class RageSoundResampler_Polyphase;
 class RageSoundReader_Resample_Good: public RageSoundReader_Filter
 {
 public:
-	/* We own source. */
+	/** @brief How long a filter to use.  Longer filters let less aliasing
+	 * through, but take longer to run. */
+	enum ResampleQuality
+	{
+		RESAMP_FAST,		/**< 4 taps. */
+		RESAMP_NORMAL,		/**< 8 taps. */
+		RESAMP_HIGHQUALITY,	/**< 16 taps. */
+		NUM_RESAMP
+	};
+
+	/* We own source.  The quality defaults to the SoundResampleQuality preference. */
 	RageSoundReader_Resample_Good( RageSoundReader *pSource, int iSampleRate );
 	RageSoundReader_Resample_Good( const RageSoundReader_Resample_Good &cpy );
 	int SetPosition( int iFrame );
@@ -34,6 +44,9 @@ public:
 
 	int GetSampleRate() const { return m_iSampleRate; }
 
+	void SetQuality( ResampleQuality q );
+	ResampleQuality GetQuality() const { return m_Quality; }
+
 private:
 	void Reset();
 	void ReopenResampler();
@@ -43,6 +56,7 @@ private:
 
 	int m_iSampleRate;
 	float m_fRate;
+	ResampleQuality m_Quality;
 };
 
 #endif
@@ -3,6 +3,7 @@
 #include "RageUtil.h"
 #include "RageSoundReader_Vorbisfile.h"
 #include "RageLog.h"
+#include "RageSoundMixKernels.h"
 
 #if defined(INTEGER_VORBIS)
 #include <tremor/ivorbisfile.h>
@@ -228,19 +229,7 @@ int RageSoundReader_Vorbisfile::Read( float *buf, int iFrames )
 			if( ret > 0 )
 			{
 				iFramesRead = ret;
-
-				int iNumChannels = channels;
-				for( int iChannel = 0; iChannel < iNumChannels; ++iChannel )
-				{
-					const float *pChannelIn = pcm[iChannel];
-					float *pChannelOut = &buf[iChannel];
-					for( int i = 0; i < iFramesRead; ++i )
-					{
-						*pChannelOut = *pChannelIn;
-						++pChannelIn;
-						pChannelOut += iNumChannels;
-					}
-				}
+				RageSoundMixKernels::Interleave( pcm, buf, channels, iFramesRead );
 			}
 #endif
 		}
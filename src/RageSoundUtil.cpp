@@ -1,14 +1,11 @@
 #include "global.h"
 #include "RageSoundUtil.h"
 #include "RageUtil.h"
+#include "RageSoundMixKernels.h"
 
 void RageSoundUtil::Attenuate( float *pBuf, int iSamples, float fVolume )
 {
-	while( iSamples-- )
-	{
-		*pBuf *= fVolume;
-		++pBuf;
-	}
+	RageSoundMixKernels::Scale( pBuf, iSamples, fVolume );
 }
 
 /* Pan buffer left or right; fPos is -1...+1.  Buffer is assumed to be stereo. */
@@ -89,11 +86,7 @@ void RageSoundUtil::ConvertNativeInt16ToFloat( const int16_t *pFrom, float *pTo,
 
 void RageSoundUtil::ConvertFloatToNativeInt16( const float *pFrom, int16_t *pTo, int iSamples )
 {
-	for( int i = 0; i < iSamples; ++i )
-	{
-		int iOut = lrintf( pFrom[i] * 32768.0f );
-		pTo[i] = clamp( iOut, -32768, 32767 );
-	}
+	RageSoundMixKernels::FloatToInt16( pFrom, pTo, iSamples, 32768.0f );
 }
 
 /*
@@ -16,6 +16,10 @@ public:
 	virtual void Reload() {}
 	virtual void Invalidate() { }	/* only called by RageTextureManager::InvalidateTextures */
 	virtual uintptr_t GetTexHandle() const = 0;	// accessed by RageDisplay
+	/* True while an async texture is waiting to be decoded and uploaded.
+	 * A pending texture is an empty 1x1 texture. */
+	virtual bool IsPending() const { return false; }
+	virtual void FinishLoading() { }	// stop being pending now
 
 	// movie texture/animated texture stuff
 	virtual void SetPosition( float /* fSeconds */ ) {} // seek
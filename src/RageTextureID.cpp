@@ -15,6 +15,7 @@ void RageTextureID::Init()
 	bHotPinkColorKey = false;
 	AdditionalTextureHints = "";
 	Policy = TEXTUREMAN->GetDefaultTexturePolicy();
+	bAsync = false;
 }
 
 void RageTextureID::SetFilename( const RString &fn )
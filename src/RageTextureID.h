@@ -54,17 +54,25 @@ struct RageTextureID
 	 * a different policy. */
 	enum TexPolicy { TEX_VOLATILE, TEX_DEFAULT } Policy;
 
+	/* If true, decode the image on a background thread and upload it a few
+	 * frames later; until then, the texture is pending (see
+	 * RageTexture::IsPending).  Loading an already pending texture without this
+	 * set finishes it immediately.  Like Policy, this is not considered for
+	 * ordering/equality. */
+	bool bAsync;
+
 	void Init();
 
 	RageTextureID(): filename(RString()), iMaxSize(0), bMipMaps(false),
 		iAlphaBits(0), iGrayscaleBits(0), iColorDepth(0),
 		bDither(false), bStretch(false), bHotPinkColorKey(false),
-		AdditionalTextureHints(RString()), Policy(TEX_DEFAULT)  { Init(); }
+		AdditionalTextureHints(RString()), Policy(TEX_DEFAULT),
+		bAsync(false) { Init(); }
 	RageTextureID( const RString &fn ): filename(RString()), iMaxSize(0),
 		bMipMaps(false), iAlphaBits(0), iGrayscaleBits(0),
 		iColorDepth(0), bDither(false), bStretch(false),
 		bHotPinkColorKey(false), AdditionalTextureHints(RString()),
-		Policy(TEX_DEFAULT) { Init(); SetFilename(fn); }
+		Policy(TEX_DEFAULT), bAsync(false) { Init(); SetFilename(fn); }
 	void SetFilename( const RString &fn );
 };
 
@@ -25,9 +25,11 @@
 #include "RageUtil.h"
 #include "RageLog.h"
 #include "RageDisplay.h"
+#include "RageTimer.h"
 #include "ActorUtil.h"
 
 #include <map>
+#include <thread>
 
 RageTextureManager*		TEXTUREMAN		= nullptr; // global and accessible from anywhere in our program
 
@@ -38,9 +40,23 @@ namespace
 	map<RageTexture*, RageTextureID> m_texture_ids_by_pointer;
 };
 
+/* Uploading a decoded texture can still take a while for big images, so
+ * only spend this long on it each frame. */
+static const float UPLOAD_SECONDS_PER_FRAME = 0.002f;
+
+/* Leave a CPU for the main thread.  More than a few threads won't help, since
+ * only a few textures are uploaded each frame anyway. */
+static int GetNumDecodeThreads()
+{
+	return clamp( (int) std::thread::hardware_concurrency() - 1, 1, 4 );
+}
+
 RageTextureManager::RageTextureManager():
+	m_Decoder("Texture decode", GetNumDecodeThreads()),
 	m_iNoWarnAboutOddDimensions(0),
-	m_TexturePolicy(RageTextureID::TEX_DEFAULT) {}
+	m_TexturePolicy(RageTextureID::TEX_DEFAULT)
+{
+}
 
 RageTextureManager::~RageTextureManager()
 {
@@ -53,6 +69,9 @@ RageTextureManager::~RageTextureManager()
 	}
 	m_textures_to_update.clear();
 	m_texture_ids_by_pointer.clear();
+
+	// Deleting the textures cancelled their jobs; anything left would leak.
+	m_Decoder.Abort();
 }
 
 void RageTextureManager::Update( float fDeltaTime )
@@ -62,6 +81,41 @@ void RageTextureManager::Update( float fDeltaTime )
 		RageTexture* pTexture = i.second;
 		pTexture->Update( fDeltaTime );
 	}
+
+	/* Upload decoded textures.  Always do at least one, so a big texture
+	 * can't hold up the ones behind it forever. */
+	RageTimer tm;
+	for(;;)
+	{
+		RageTextureDecodeJob *pJob = static_cast<RageTextureDecodeJob *>( m_Decoder.TakeFinished() );
+		if( pJob == nullptr )
+			break;
+
+		pJob->Finish();
+		delete pJob;
+
+		if( tm.Ago() >= UPLOAD_SECONDS_PER_FRAME )
+			break;
+	}
+}
+
+void RageTextureManager::QueueDecode( RageTextureDecodeJob *pJob )
+{
+	m_Decoder.Queue( pJob );
+}
+
+void RageTextureManager::FinishDecode( RageTextureDecodeJob *pJob )
+{
+	if( !m_Decoder.Take(pJob) )
+		pJob->Decode();
+	pJob->Finish();
+	delete pJob;
+}
+
+void RageTextureManager::CancelDecode( RageTextureDecodeJob *pJob )
+{
+	m_Decoder.Take( pJob );
+	delete pJob;
 }
 
 void RageTextureManager::AdjustTextureID( RageTextureID &ID ) const
@@ -153,6 +207,11 @@ RageTexture* RageTextureManager::LoadTextureInternal( RageTextureID ID )
 		/* Found the texture.  Just increase the refcount and return it. */
 		RageTexture* pTexture = p->second;
 		pTexture->m_iRefCount++;
+
+		/* If it's still being loaded in the background and this caller
+		 * can't wait for it, finish it now. */
+		if( !ID.bAsync && pTexture->IsPending() )
+			pTexture->FinishLoading();
 		return pTexture;
 	}
 
@@ -5,6 +5,7 @@
 
 #include "RageTexture.h"
 #include "RageSurface.h"
+#include "RageUtil_BackgroundLoader.h"
 
 struct RageTextureManagerPrefs
 {
@@ -45,6 +46,18 @@ struct RageTextureManagerPrefs
 	}
 };
 
+/* Work for loading a texture, split so the slow part can be done on
+ * RageTextureManager's decode threads. */
+class RageTextureDecodeJob: public BackgroundLoader::Job
+{
+public:
+	void Load() { Decode(); }
+	/* Read and convert the image; this must not touch the display. */
+	virtual void Decode() = 0;
+	/* Upload the decoded image.  Called from the main thread. */
+	virtual void Finish() = 0;
+};
+
 class RageTextureManager
 {
 public:
@@ -87,12 +100,22 @@ public:
 	RageTextureID GetScreenTextureID();
 	RageSurface* GetScreenSurface();
 
+	/* Async loading.  Queued jobs are started in order on the decode threads,
+	 * but may finish decoding in any order; Update uploads a few of the
+	 * decoded ones each frame, in the order they finished.  These take
+	 * ownership of the job. */
+	void QueueDecode( RageTextureDecodeJob *pJob );
+	void FinishDecode( RageTextureDecodeJob *pJob );	// finish it now
+	void CancelDecode( RageTextureDecodeJob *pJob );
+
 private:
 	void DeleteTexture( RageTexture *t );
 	enum GCType { screen_changed, delayed_delete };
 	void GarbageCollect( GCType type );
 	RageTexture* LoadTextureInternal( RageTextureID ID );
 
+	BackgroundLoader m_Decoder;
+
 	RageTextureManagerPrefs m_Prefs;
 	int m_iNoWarnAboutOddDimensions;
 	RageTextureID::TexPolicy m_TexturePolicy;
@@ -2420,6 +2420,21 @@ bool FileCopy( const RString &sSrcFile, const RString &sDstFile )
 	return true;
 }
 
+bool FileHasContents( const RString &sPath, int iSize, uint32_t iCRC )
+{
+	RageFile f;
+	if( !f.Open(sPath) || f.GetFileSize() != iSize )
+		return false;
+
+	f.EnableCRC32();
+	RString sData;
+	if( f.Read(sData, iSize) != iSize )
+		return false;
+
+	uint32_t iReadCRC;
+	return f.GetCRC32( &iReadCRC ) && iReadCRC == iCRC;
+}
+
 bool FileCopy( RageFileBasic &in, RageFileBasic &out, RString &sError, bool *bReadError )
 {
 	for(;;)
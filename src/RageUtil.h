@@ -647,6 +647,9 @@ namespace StringConversion
 class RageFileBasic;
 bool FileCopy( const RString &sSrcFile, const RString &sDstFile );
 bool FileCopy( RageFileBasic &in, RageFileBasic &out, RString &sError, bool *bReadError = nullptr );
+/* Whether the file at sPath is the iSize bytes with the given CRC.  Safe
+ * writes rename on Close, which can't fail, so this is how to find out. */
+bool FileHasContents( const RString &sPath, int iSize, uint32_t iCRC );
 
 template<class T>
 void GetAsNotInBs( const vector<T> &as, const vector<T> &bs, vector<T> &difference )
@@ -1,248 +1,294 @@
 #include "global.h"
 #include "RageUtil_BackgroundLoader.h"
 #include "RageFile.h"
-#include "RageFileManager.h"
 #include "RageUtil.h"
 #include "RageLog.h"
-#include "RageThreads.h"
 
-
-/* If we're on an OS with a good caching system, writing to our own cache will only
- * waste memory.  In that case, just read the file, to force it into system cache.
- * If we're on a system with an unreliable cache, read it into our own cache.  This
- * helps in Windows, where even reading directory entries off of a CD--even if they've
- * just been read--can cause long delays if the disk is in use. */
-static const bool g_bWriteToCache = true;
-
-static const bool g_bEnableBackgroundLoading = false;
-
-BackgroundLoader::BackgroundLoader():
-	m_StartSem( "BackgroundLoaderSem" ),
-	m_Mutex( "BackgroundLoaderMutex" )
+/* CacheFile used to copy files into a memory cache, for systems with an
+ * unreliable cache.  That changed the path the file was loaded from, which
+ * textures are keyed by, so now the file is only read, to force it into the
+ * system's cache.  This helps in Windows, where even reading directory entries
+ * off of a CD--even if they've just been read--can cause long delays if the
+ * disk is in use. */
+class BackgroundLoader::FileJob: public BackgroundLoader::Job
 {
-	if( !g_bEnableBackgroundLoading )
-		return;
+public:
+	FileJob( const RString &sFile ): m_sFile(sFile) { }
+	void Load()
+	{
+		RageFile f;
+		if( !f.Open(m_sFile) )
+			return;
 
-	m_sCachePathPrefix = ssprintf( "@mem/%p", this );
+		char buf[1024*32];
+		while( !IsCancelled() && !f.AtEOF() )
+		{
+			if( f.Read(buf, sizeof(buf)) <= 0 )
+				break;
+		}
+	}
 
-	m_bShutdownThread = false;
-	m_sThreadIsActive = m_sThreadShouldAbort = false;
-	m_LoadThread.SetName( "BackgroundLoader" );
-	m_LoadThread.Create( LoadThread_Start, this );
-}
+private:
+	RString m_sFile;
+};
 
-static void DeleteEmptyDirectories( RString sDir )
+BackgroundLoader::BackgroundLoader( const RString &sName, int iThreads ):
+	m_Event( sName ),
+	m_iNextSerial( 0 ),
+	m_bShutdown( false )
 {
-	vector<RString> asNewDirs;
-	GetDirListing( sDir + "/*", asNewDirs, false, true );
-	for( unsigned i = 0; i < asNewDirs.size(); ++i )
+	for( int i = 0; i < max(iThreads, 1); ++i )
 	{
-		ASSERT_M( IsADirectory(asNewDirs[i]), asNewDirs[i] );
-		DeleteEmptyDirectories( asNewDirs[i] );
+		RageThread *pThread = new RageThread;
+		pThread->SetName( ssprintf("%s %i", sName.c_str(), i) );
+		pThread->Create( LoadThread_Start, this );
+		m_apThreads.push_back( pThread );
 	}
-
-	FILEMAN->Remove( sDir );
 }
 
 BackgroundLoader::~BackgroundLoader()
 {
-	if( !g_bEnableBackgroundLoading )
-		return;
-
 	Abort();
 
-	m_bShutdownThread = true;
-	m_StartSem.Post();
-	m_LoadThread.Wait();
-
-	/* Delete all leftover cached files. */
-	map<RString,int>::iterator it;
-	for( it = m_FinishedRequests.begin(); it != m_FinishedRequests.end(); ++it )
-		FILEMAN->Remove( GetCachePath( it->first ) );
-
-	/* m_sCachePathPrefix should be filled with several empty directories.  Delete
-	 * them and m_sCachePathPrefix, so we don't leak them. */
-	DeleteEmptyDirectories( m_sCachePathPrefix );
-}
-
-/* Pull a request out of m_CacheRequests. */
-RString BackgroundLoader::GetRequest()
-{
-	if( !g_bEnableBackgroundLoading )
-		return RString();
-
-	LockMut( m_Mutex );
-	if( !m_CacheRequests.size() )
-		return RString();
-
-	RString ret;
-	ret = m_CacheRequests.front();
-	m_CacheRequests.erase( m_CacheRequests.begin(), m_CacheRequests.begin()+1 );
-	return ret;
-}
+	m_Event.Lock();
+	m_bShutdown = true;
+	m_Event.Broadcast();
+	m_Event.Unlock();
 
-RString BackgroundLoader::GetCachePath( RString sPath ) const
-{
-	return m_sCachePathPrefix + sPath;
+	for (RageThread *pThread : m_apThreads)
+	{
+		pThread->Wait();
+		delete pThread;
+	}
 }
 
 void BackgroundLoader::LoadThread()
 {
-	while( !m_bShutdownThread )
+	m_Event.Lock();
+	while( !m_bShutdown )
 	{
-		/* Wait for a request.  It's normal for this to wait for a long time; don't
-		 * fail on timeout. */
-		m_StartSem.Wait( false );
-
-		RString sFile = GetRequest();
-		if( sFile.empty() )
+		if( m_Queued.empty() )
+		{
+			/* It's normal for this to wait for a long time. */
+			m_Event.Wait();
 			continue;
+		}
 
+		/* Take the highest priority request, oldest first. */
+		size_t iBest = 0;
+		for( size_t i = 1; i < m_Queued.size(); ++i )
 		{
-			/* If the file already exists, short circuit. */
-			LockMut( m_Mutex );
-			map<RString,int>::iterator it;
-			it = m_FinishedRequests.find( sFile );
-			if( it != m_FinishedRequests.end() )
-			{
-				++it->second;
-				LOG->Trace("XXX: request %s done loading (already done), cnt now %i", sFile.c_str(), m_FinishedRequests[sFile] );
-				continue;
-			}
+			const Request &r = m_Queued[i], &best = m_Queued[iBest];
+			if( r.iPriority > best.iPriority || (r.iPriority == best.iPriority && r.iSerial < best.iSerial) )
+				iBest = i;
 		}
+		Request r = m_Queued[iBest];
+		m_Queued.erase( m_Queued.begin() + iBest );
+		m_Loading.push_back( r.pJob );
+		m_Event.Unlock();
 
-		m_sThreadIsActive = true;
-
-		LOG->Trace("XXX: reading %s", sFile.c_str());
-
-		RString sCachePath = GetCachePath( sFile );
+		r.pJob->Load();
 
-		/* Open the file and read it. */
-		RageFile src;
-		if( src.Open(sFile) )
+		m_Event.Lock();
+		m_Loading.erase( find(m_Loading.begin(), m_Loading.end(), r.pJob) );
+		if( r.pJob->m_bCancelled )
 		{
-			/* If we're writing to a file cache ... */
-			RageFile dst;
-
-			bool bWriteToCache = g_bWriteToCache;
-			if( bWriteToCache )
-				bWriteToCache = dst.Open( sCachePath, RageFile::WRITE );
-			LOG->Trace("XXX: go on '%s' to '%s'", sFile.c_str(), sCachePath.c_str());
-			
-			char buf[1024*4];
-			while( !m_sThreadShouldAbort && !src.AtEOF() )
-			{
-				int got = src.Read( buf, sizeof(buf) );
-				if( got > 0 && bWriteToCache )
-					dst.Write( buf, got );
-			}
-			if( bWriteToCache )
-				dst.Close();
-
-			LOG->Trace("XXX: done");
+			delete r.pJob;
 		}
-		src.Close();
-
-		LockMut( m_Mutex );
-		if( !m_sThreadShouldAbort )
+		else if( !r.sFile.empty() )
 		{
-			++m_FinishedRequests[sFile];
-		LOG->Trace("XXX: request %s done loading, cnt now %i", sFile.c_str(), m_FinishedRequests[sFile] );
+			CachedFile &file = m_CachedFiles[r.sFile];
+			ASSERT( file.pJob == r.pJob );
+			file.pJob = nullptr;
+			file.bFinished = true;
+			delete r.pJob;
 		}
 		else
 		{
-			FILEMAN->Remove( sCachePath );
-
-			LOG->Trace("XXX: request %s aborted", sFile.c_str() );
+			m_Finished.push_back( r.pJob );
 		}
+		m_Event.Broadcast();
+	}
+	m_Event.Unlock();
+}
+
+void BackgroundLoader::Queue( Job *pJob, int iPriority )
+{
+	LockMut( m_Event );
+	Request r;
+	r.pJob = pJob;
+	r.iPriority = iPriority;
+	r.iSerial = m_iNextSerial++;
+	m_Queued.push_back( r );
+	m_Event.Broadcast();
+}
 
-		m_sThreadShouldAbort = false;
-		m_sThreadIsActive = false;
+void BackgroundLoader::SetPriority( Job *pJob, int iPriority )
+{
+	LockMut( m_Event );
+	for (Request &r : m_Queued)
+	{
+		if( r.pJob == pJob )
+			r.iPriority = iPriority;
 	}
 }
 
-void BackgroundLoader::CacheFile( const RString &sFile )
+bool BackgroundLoader::Take( Job *pJob )
 {
-	if( !g_bEnableBackgroundLoading )
-		return;
+	m_Event.Lock();
+	while( find(m_Loading.begin(), m_Loading.end(), pJob) != m_Loading.end() )
+		m_Event.Wait();
+
+	bool bLoaded = false;
+	vector<Request>::iterator it = m_Queued.begin();
+	while( it != m_Queued.end() && it->pJob != pJob )
+		++it;
+	if( it != m_Queued.end() )
+	{
+		m_Queued.erase( it );
+	}
+	else
+	{
+		std::deque<Job *>::iterator fin = find( m_Finished.begin(), m_Finished.end(), pJob );
+		ASSERT( fin != m_Finished.end() );
+		m_Finished.erase( fin );
+		bLoaded = true;
+	}
+	m_Event.Unlock();
+	return bLoaded;
+}
 
-	if( sFile == "" )
+BackgroundLoader::Job *BackgroundLoader::TakeFinished()
+{
+	LockMut( m_Event );
+	if( m_Finished.empty() )
+		return nullptr;
+	Job *pJob = m_Finished.front();
+	m_Finished.pop_front();
+	return pJob;
+}
+
+BackgroundLoader::Job *BackgroundLoader::WaitForFinished()
+{
+	LockMut( m_Event );
+	while( m_Finished.empty() )
+	{
+		if( m_Queued.empty() && m_Loading.empty() )
+			return nullptr;
+		m_Event.Wait();
+	}
+	Job *pJob = m_Finished.front();
+	m_Finished.pop_front();
+	return pJob;
+}
+
+/* Delete a job if it's queued, or have it deleted when it finishes loading. */
+void BackgroundLoader::CancelRequest( Job *pJob )
+{
+	if( find(m_Loading.begin(), m_Loading.end(), pJob) != m_Loading.end() )
+	{
+		pJob->m_bCancelled = true;
 		return;
+	}
 
-	LockMut( m_Mutex );
-	m_CacheRequests.push_back( sFile );
-	m_StartSem.Post();
+	for( size_t i = 0; i < m_Queued.size(); ++i )
+	{
+		if( m_Queued[i].pJob == pJob )
+		{
+			m_Queued.erase( m_Queued.begin() + i );
+			break;
+		}
+	}
+	delete pJob;
 }
 
-bool BackgroundLoader::IsCacheFileFinished( const RString &sFile, RString &sActualPath )
+void BackgroundLoader::CacheFile( const RString &sFile, int iPriority )
 {
-	if( !g_bEnableBackgroundLoading )
+	if( sFile == "" )
+		return;
+
+	LockMut( m_Event );
+	map<RString,CachedFile>::iterator it = m_CachedFiles.find( sFile );
+	if( it != m_CachedFiles.end() )
 	{
-		sActualPath = sFile;
-		return true;
+		++it->second.iRequests;
+		for (Request &r : m_Queued)
+		{
+			if( r.pJob == it->second.pJob )
+				r.iPriority = max( r.iPriority, iPriority );
+		}
+		return;
 	}
 
-	LockMut( m_Mutex );
+	CachedFile file;
+	file.pJob = new FileJob( sFile );
+	file.iRequests = 1;
+	file.bFinished = false;
+	m_CachedFiles[sFile] = file;
+
+	Request r;
+	r.pJob = file.pJob;
+	r.iPriority = iPriority;
+	r.iSerial = m_iNextSerial++;
+	r.sFile = sFile;
+	m_Queued.push_back( r );
+	m_Event.Broadcast();
+}
 
+bool BackgroundLoader::IsCacheFileFinished( const RString &sFile, RString &sActualPath )
+{
 	if( sFile == "" )
 	{
 		sActualPath = "";
 		return true;
 	}
 
-	map<RString,int>::iterator it;
-	it = m_FinishedRequests.find( sFile );
-	if( it == m_FinishedRequests.end() )
+	LockMut( m_Event );
+	map<RString,CachedFile>::const_iterator it = m_CachedFiles.find( sFile );
+	if( it == m_CachedFiles.end() || !it->second.bFinished )
 		return false;
 
-	LOG->Trace("XXX: %s finished (%i)", sFile.c_str(), it->second);
-	if( g_bWriteToCache )
-		sActualPath = GetCachePath( sFile );
-	else
-		sActualPath = sFile;
-
+	sActualPath = sFile;
 	return true;
 }
 
 void BackgroundLoader::FinishedWithCachedFile( RString sFile )
 {
-	if( !g_bEnableBackgroundLoading )
-		return;
-
 	if( sFile == "" )
 		return;
 
-	map<RString,int>::iterator it;
-	it = m_FinishedRequests.find( sFile );
-	ASSERT_M( it != m_FinishedRequests.end(), sFile );
+	LockMut( m_Event );
+	map<RString,CachedFile>::iterator it = m_CachedFiles.find( sFile );
+	if( it == m_CachedFiles.end() )
+		return; // aborted
 
-	--it->second;
-	ASSERT_M( it->second >= 0, ssprintf("%i", it->second) );
-	if( !it->second )
+	--it->second.iRequests;
+	ASSERT_M( it->second.iRequests >= 0, ssprintf("%i", it->second.iRequests) );
+	if( it->second.iRequests == 0 )
 	{
-		m_FinishedRequests.erase( it );
-		FILEMAN->Remove( GetCachePath( sFile ) );
+		if( it->second.pJob != nullptr )
+			CancelRequest( it->second.pJob );
+		m_CachedFiles.erase( it );
 	}
 }
 
 void BackgroundLoader::Abort()
 {
-	if( !g_bEnableBackgroundLoading )
-		return;
+	LockMut( m_Event );
 
-	LockMut( m_Mutex );
-
-	/* Clear any pending requests. */
-	while( !GetRequest().empty() )
-		;
+	/* Clear any pending requests, and tell the threads to abort any requests
+	 * they're handling now. */
+	for (Request const &r : m_Queued)
+		delete r.pJob;
+	m_Queued.clear();
+	for (Job *pJob : m_Loading)
+		pJob->m_bCancelled = true;
 
 	/* Clear any previously finished requests. */
-	while( m_FinishedRequests.size() )
-		FinishedWithCachedFile( m_FinishedRequests.begin()->first );
-
-	/* Tell the thread to abort any request it's handling now. */
-	if( m_sThreadIsActive )
-		m_sThreadShouldAbort = true;
+	for (Job *pJob : m_Finished)
+		delete pJob;
+	m_Finished.clear();
+	m_CachedFiles.clear();
 }
 
 /*
@@ -1,61 +1,108 @@
-/* BackgroundLoader - Loads files in a thread. */
+/* BackgroundLoader - Loads files and other things on worker threads. */
 
 #ifndef RAGE_UTIL_BACKGROUND_LOADER_H
 #define RAGE_UTIL_BACKGROUND_LOADER_H
 
 #include "RageThreads.h"
-#include <map>
 
-class RageFileDriverCached;
+#include <atomic>
+#include <deque>
+#include <map>
 
 class BackgroundLoader
 {
 public:
-	BackgroundLoader();
-
-	/* Note that destruction of this object will wait for any existing requests
-	 * to finish aborting before returning. */
+	/* Something to load.  Load is called on a worker thread, so it mustn't
+	 * touch the display or anything else that isn't thread safe. */
+	class Job
+	{
+	public:
+		Job(): m_bCancelled(false) { }
+		virtual ~Job() { }
+		virtual void Load() = 0;
+
+	protected:
+		/* Long loads can check this, and stop early if it's set.  The
+		 * job will be deleted when Load returns. */
+		bool IsCancelled() const { return m_bCancelled; }
+
+	private:
+		friend class BackgroundLoader;
+		std::atomic<bool> m_bCancelled;
+	};
+
+	BackgroundLoader( const RString &sName = "BackgroundLoader", int iThreads = 2 );
+
+	/* Note that destruction of this object will wait for any loads in
+	 * progress to finish aborting before returning. */
 	~BackgroundLoader();
 
-	/* Read the file in a background thread.  Files will be read in the order requested. */
-	void CacheFile( const RString &file );
+	/* Load a job.  Jobs with a higher priority are loaded first, and jobs with
+	 * the same priority in the order queued.  This takes ownership of the job
+	 * until it's taken back. */
+	void Queue( Job *pJob, int iPriority = 0 );
+	/* Change the priority of a job that hasn't been started yet. */
+	void SetPriority( Job *pJob, int iPriority );
+
+	/* Take a job back, waiting for it if it's being loaded right now.  Return
+	 * true if it has been loaded. */
+	bool Take( Job *pJob );
+	/* Take back a loaded job, in the order they finished, or return null
+	 * if none have finished. */
+	Job *TakeFinished();
+	/* Take back the next loaded job, waiting for one if needed.  Return null
+	 * if nothing is queued or loading. */
+	Job *WaitForFinished();
+
+	/* Read the file on a worker thread, so it's in the system's cache when
+	 * it's loaded for real.  Requesting a file that's already requested
+	 * doesn't read it again, but raises its priority. */
+	void CacheFile( const RString &sFile, int iPriority = 0 );
 
 	/* Return true if the requested CacheFile request has finished.  If true is returned,
 	 * the cached file can be read using the path returned in sActualPath. */
 	bool IsCacheFileFinished( const RString &sFile, RString &sActualPath );
 
-	/* Call this when finished with a cached file, to release any resources. */
+	/* Call this when finished with a cached file, to release any resources.  If
+	 * it hasn't been read yet, and nobody else requested it, it won't be. */
 	void FinishedWithCachedFile( RString sFile );
 
-	/* Abort all loads. */
+	/* Abort all loads, and delete all jobs that haven't been taken back. */
 	void Abort();
 
 private:
-	RageThread m_LoadThread;
-	bool m_bShutdownThread;
 	void LoadThread();
 	static int LoadThread_Start( void *p ) { ((BackgroundLoader *) p)->LoadThread(); return 0; }
 
-	RString GetRequest();
-
-	RString GetCachePath( RString sPath ) const;
-	RString m_sCachePathPrefix;
-
-	RageSemaphore m_StartSem;
+	class FileJob;
+	struct Request
+	{
+		Job *pJob;
+		int iPriority;
+		int iSerial;
+		RString sFile;	// for CacheFile requests
+	};
+	struct CachedFile
+	{
+		Job *pJob;
+		int iRequests;
+		bool bFinished;
+	};
+
+	/* m_Event must be locked. */
+	void CancelRequest( Job *pJob );
+
+	vector<RageThread *> m_apThreads;
 
 	/* Lock before accessing any of the rest of the object.  Don't keep this locked
 	 * while doing expensive operations, like reading files. */
-	RageMutex m_Mutex;
-
-	vector<RString> m_CacheRequests;
-
-	/* Filename to number of completed requests */
-	map<RString,int> m_FinishedRequests;
-
-	bool m_sThreadIsActive;
-	bool m_sThreadShouldAbort;
-
-	RageFileDriverCached *m_pDriver;
+	RageEvent m_Event;
+	vector<Request> m_Queued;
+	vector<Job *> m_Loading;
+	std::deque<Job *> m_Finished;
+	map<RString,CachedFile> m_CachedFiles;
+	int m_iNextSerial;
+	bool m_bShutdown;
 };
 
 #endif
@@ -3,6 +3,8 @@
 #ifndef RAGE_UTIL_CIRCULAR_BUFFER
 #define RAGE_UTIL_CIRCULAR_BUFFER
 
+#include <atomic>
+
 /* Lock-free circular buffer.  This should be threadsafe if one thread is reading
  * and another is writing. */
 template<class T>
@@ -19,8 +21,10 @@ class CircBuf
 	unsigned size;
 	unsigned m_iBlockSize;
 
-	/* These are volatile to prevent reads and writes to them from being optimized. */
-	volatile unsigned read_pos, write_pos;
+	/* Each side publishes its position with a release store and reads the other
+	 * side's with an acquire load, so the elements it hands over are visible
+	 * before the position that says they're there. */
+	std::atomic<unsigned> read_pos, write_pos;
 
 public:
 	CircBuf()
@@ -38,8 +42,8 @@ public:
 	{
 		std::swap( size, rhs.size );
 		std::swap( m_iBlockSize, rhs.m_iBlockSize );
-		std::swap( read_pos, rhs.read_pos );
-		std::swap( write_pos, rhs.write_pos );
+		read_pos = rhs.read_pos.exchange( read_pos );
+		write_pos = rhs.write_pos.exchange( write_pos );
 		std::swap( buf, rhs.buf );
 	}
 
@@ -53,8 +57,8 @@ public:
 	CircBuf( const CircBuf &cpy )
 	{
 		size = cpy.size;
-		read_pos = cpy.read_pos;
-		write_pos = cpy.write_pos;
+		read_pos = cpy.read_pos.load();
+		write_pos = cpy.write_pos.load();
 		m_iBlockSize = cpy.m_iBlockSize;
 		if( size )
 		{
@@ -70,8 +74,8 @@ public:
 	/* Return the number of elements available to read. */
 	unsigned num_readable() const
 	{
-		const int rpos = read_pos;
-		const int wpos = write_pos;
+		const int rpos = read_pos.load( std::memory_order_acquire );
+		const int wpos = write_pos.load( std::memory_order_acquire );
 		if( rpos < wpos )
 			/* The buffer looks like "eeeeDDDDeeee" (e = empty, D = data). */
 			return wpos - rpos;
@@ -86,8 +90,8 @@ public:
 	/* Return the number of writable elements. */
 	unsigned num_writable() const
 	{
-		const int rpos = read_pos;
-		const int wpos = write_pos;
+		const int rpos = read_pos.load( std::memory_order_acquire );
+		const int wpos = write_pos.load( std::memory_order_acquire );
 
 		int ret;
 		if( rpos < wpos )
@@ -137,19 +141,19 @@ public:
 	/* Indicate that n elements have been written. */
 	void advance_write_pointer( int n )
 	{
-		write_pos = (write_pos + n) % size;
+		write_pos.store( (write_pos.load(std::memory_order_relaxed) + n) % size, std::memory_order_release );
 	}
 	
 	/* Indicate that n elements have been read. */
 	void advance_read_pointer( int n )
 	{
-		read_pos = (read_pos + n) % size;
+		read_pos.store( (read_pos.load(std::memory_order_relaxed) + n) % size, std::memory_order_release );
 	}
 	
 	void get_write_pointers( T *pPointers[2], unsigned pSizes[2] )
 	{
-		const int rpos = read_pos;
-		const int wpos = write_pos;
+		const int rpos = read_pos.load( std::memory_order_acquire );
+		const int wpos = write_pos.load( std::memory_order_acquire );
 
 		if( rpos <= wpos )
 		{
@@ -190,8 +194,8 @@ public:
 
 	void get_read_pointers( T *pPointers[2], unsigned pSizes[2] )
 	{
-		const int rpos = read_pos;
-		const int wpos = write_pos;
+		const int rpos = read_pos.load( std::memory_order_acquire );
+		const int wpos = write_pos.load( std::memory_order_acquire );
 
 		if( rpos < wpos )
 		{
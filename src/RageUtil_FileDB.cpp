@@ -536,6 +536,26 @@ void FilenameDB::FlushDirCache( const RString & /* sDir */ )
 		m_Mutex.Unlock();
 }
 
+void FilenameDB::FlushDir( const RString &sDir )
+{
+	FileSet *pFileSet = GetFileSet( sDir, false );
+	if( pFileSet != nullptr )
+	{
+		while( !pFileSet->m_bFilled )
+			m_Mutex.Wait();
+
+		for( map<RString, FileSet *>::iterator it = dirs.begin(); it != dirs.end(); ++it )
+		{
+			if( it->second == pFileSet )
+			{
+				DelFileSet( it );
+				break;
+			}
+		}
+	}
+	m_Mutex.Unlock(); // Locked by GetFileSet()
+}
+
 const File *FilenameDB::GetFile( const RString &sPath )
 {
 	if( m_Mutex.IsLockedByThisThread() && LOG )
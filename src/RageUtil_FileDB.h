@@ -111,6 +111,9 @@ public:
 	void GetDirListing( const RString &sPath, vector<RString> &asAddTo, bool bOnlyDirs, bool bReturnPathToo );
 
 	void FlushDirCache( const RString &sDir = RString() );
+	/* Forget the listing of one directory (not its subdirectories), so it's
+	 * read again the next time it's needed. */
+	void FlushDir( const RString &sDir );
 
 	void GetFileSetCopy( const RString &dir, FileSet &out );
 	/* Probably slow, so override it. */
@@ -30,6 +30,7 @@
 #include "ScreenSyncOverlay.h"
 #include "ThemeMetric.h"
 #include "XmlToLua.h"
+#include "RageProfiler.h"
 
 static bool g_bIsDisplayed = false;
 static bool g_bIsSlow = false;
@@ -92,6 +93,102 @@ static bool IsGameplay()
 	return SCREENMAN && SCREENMAN->GetTopScreen() && SCREENMAN->GetTopScreen()->GetScreenType() == gameplay;
 }
 
+static const RString PROFILER_PAGE = "Profiler";
+#define FRAME_TRACE_PATH "/Logs/frametrace.json"
+
+static const RageColor g_ZoneColors[NUM_ProfileZone] =
+{
+	RageColor( 0.2f, 0.6f, 1.0f, 1 ),	// SoundManager
+	RageColor( 0.4f, 0.8f, 1.0f, 1 ),	// GameSound
+	RageColor( 1.0f, 0.6f, 0.2f, 1 ),	// Textures
+	RageColor( 0.6f, 0.4f, 1.0f, 1 ),	// GameState
+	RageColor( 0.2f, 0.8f, 0.4f, 1 ),	// Screens
+	RageColor( 0.6f, 0.6f, 0.2f, 1 ),	// MemoryCards
+	RageColor( 1.0f, 1.0f, 0.3f, 1 ),	// Input
+	RageColor( 0.8f, 0.5f, 0.8f, 1 ),	// Lights
+	RageColor( 1.0f, 0.3f, 0.3f, 1 ),	// Draw
+	RageColor( 0.4f, 0.4f, 0.6f, 1 ),	// Present
+	RageColor( 0.3f, 1.0f, 0.6f, 1 ),	// ActorUpdate
+	RageColor( 1.0f, 0.6f, 0.6f, 1 ),	// ActorDraw
+	RageColor( 0.9f, 0.9f, 0.9f, 1 ),	// Lua
+};
+// Time in a frame that isn't in any zone.
+static const RageColor OTHER_ZONE_COLOR( 0.5f, 0.5f, 0.5f, 1 );
+// The graph's height is two frames at 60Hz.
+static const float GRAPH_MAX_USECS = 2 * 1000000 / 60.0f;
+static const int GRAPH_FRAMES = 300;
+
+/** @brief One stacked bar per frame, split into the time spent in each zone. */
+class FrameTimeGraph: public Actor
+{
+public:
+	void DrawPrimitives()
+	{
+		RageProfiler::GetFrames( m_Frames );
+		m_Quads.clear();
+
+		const float fLeft = SCREEN_LEFT + 20;
+		const float fRight = SCREEN_RIGHT - 20;
+		m_fBottom = SCREEN_BOTTOM - 20;
+		m_fTop = m_fBottom - SCREEN_HEIGHT/4;
+		const float fPixelsPerUsec = (m_fBottom - m_fTop) / GRAPH_MAX_USECS;
+
+		// A line at one 60Hz frame.
+		const float fLineY = (m_fTop + m_fBottom) / 2;
+		AddQuad( fLeft, fRight, fLineY - 1, fLineY, RageColor(1,1,1,0.5f) );
+
+		const int iFirst = max( 0, (int) m_Frames.size() - GRAPH_FRAMES );
+		const float fBarWidth = (fRight - fLeft) / GRAPH_FRAMES;
+		for( int i = iFirst; i < (int) m_Frames.size(); ++i )
+		{
+			const RageProfiler::FrameSample &s = m_Frames[i];
+			const float fX = fLeft + (i - iFirst) * fBarWidth;
+			float fY = m_fBottom;
+			uint64_t iInZones = 0;
+			FOREACH_ENUM( ProfileZone, z )
+			{
+				iInZones += s.iZoneUsecs[z];
+				const float fTop = fY - s.iZoneUsecs[z] * fPixelsPerUsec;
+				AddQuad( fX, fX + fBarWidth, fTop, fY, g_ZoneColors[z] );
+				fY = fTop;
+			}
+			if( s.iLengthUsecs > iInZones )
+				AddQuad( fX, fX + fBarWidth, fY - (s.iLengthUsecs - iInZones) * fPixelsPerUsec, fY, OTHER_ZONE_COLOR );
+		}
+
+		Actor::SetGlobalRenderStates();
+		DISPLAY->ClearAllTextures();
+		Actor::SetTextureRenderStates();
+		if( !m_Quads.empty() )
+			DISPLAY->DrawQuads( &m_Quads[0], m_Quads.size() );
+	}
+
+private:
+	void AddQuad( float fLeft, float fRight, float fTop, float fBottom, const RageColor &c )
+	{
+		// Long frames are cut off at the top of the graph.
+		fTop = max( fTop, m_fTop );
+		fBottom = min( fBottom, m_fBottom );
+		if( fTop >= fBottom )
+			return;
+
+		RageSpriteVertex v[4];
+		v[0].p = RageVector3( fLeft, fTop, 0 );
+		v[1].p = RageVector3( fLeft, fBottom, 0 );
+		v[2].p = RageVector3( fRight, fBottom, 0 );
+		v[3].p = RageVector3( fRight, fTop, 0 );
+		for( int i = 0; i < 4; ++i )
+		{
+			v[i].c = c;
+			m_Quads.push_back( v[i] );
+		}
+	}
+
+	float m_fTop, m_fBottom;
+	vector<RageProfiler::FrameSample> m_Frames;
+	vector<RageSpriteVertex> m_Quads;
+};
+
 
 REGISTER_SCREEN_CLASS( ScreenDebugOverlay );
 
@@ -99,6 +196,13 @@ ScreenDebugOverlay::~ScreenDebugOverlay()
 {
 	this->RemoveAllChildren();
 
+	SAFE_DELETE( m_pFrameGraph );
+	for (BitmapText *p : m_vptextProfiler)
+	{
+		SAFE_DELETE(p);
+	}
+	m_vptextProfiler.clear();
+
 	for (BitmapText *p : m_vptextPages)
 	{
 		SAFE_DELETE(p);
@@ -310,6 +414,25 @@ void ScreenDebugOverlay::Init()
 		}
 	}
 
+	m_pFrameGraph = new FrameTimeGraph;
+	this->AddChild( m_pFrameGraph );
+
+	// One line per zone, one for time outside of zones, and one for the whole frame.
+	for( int i = 0; i < NUM_ProfileZone + 2; ++i )
+	{
+		BitmapText *bt = new BitmapText;
+		bt->SetName( "FunctionText" );
+		bt->LoadFromFont( THEME->GetPathF("ScreenDebugOverlay", "line") );
+		bt->SetHorizAlign( align_left );
+		LOAD_ALL_COMMANDS_AND_ON_COMMAND( *bt );
+		if( i < NUM_ProfileZone )
+			bt->SetDiffuse( g_ZoneColors[i] );
+		else if( i == NUM_ProfileZone )
+			bt->SetDiffuse( OTHER_ZONE_COLOR );
+		m_vptextProfiler.push_back( bt );
+		this->AddChild( bt );
+	}
+
 	this->SetVisible( false );
 }
 
@@ -412,6 +535,8 @@ void ScreenDebugOverlay::UpdateText()
 		txt2.SetText( s1 + s2 );
 	}
 
+	UpdateProfilerText();
+
 	if( g_bIsHalt )
 	{
 		/* More than once I've paused the game accidentally and wasted time
@@ -424,6 +549,61 @@ void ScreenDebugOverlay::UpdateText()
 	}
 }
 
+void ScreenDebugOverlay::UpdateProfilerText()
+{
+	const bool bShow = GetCurrentPageName() == PROFILER_PAGE && RageProfiler::IsEnabled();
+	m_pFrameGraph->SetVisible( bShow );
+	for (BitmapText *p : m_vptextProfiler)
+		p->SetVisible( bShow );
+	if( !bShow )
+		return;
+
+	vector<RageProfiler::FrameSample> frames;
+	RageProfiler::GetFrames( frames );
+
+	// The average and worst time of each zone, then other time, then frames.
+	vector<uint64_t> iTotal( NUM_ProfileZone + 2 ), iMax( NUM_ProfileZone + 2 );
+	for (RageProfiler::FrameSample const &s : frames)
+	{
+		uint64_t iInZones = 0;
+		for( int z = 0; z < NUM_ProfileZone + 2; ++z )
+		{
+			uint64_t iUsecs;
+			if( z < NUM_ProfileZone )
+				iUsecs = s.iZoneUsecs[z];
+			else if( z == NUM_ProfileZone )
+				iUsecs = s.iLengthUsecs > iInZones? s.iLengthUsecs - iInZones:0;
+			else
+				iUsecs = s.iLengthUsecs;
+			iInZones += iUsecs;
+			iTotal[z] += iUsecs;
+			iMax[z] = max( iMax[z], iUsecs );
+		}
+	}
+
+	// Below this page's lines.
+	int iOffset = 0;
+	for (IDebugLine *p : *g_pvpSubscribers)
+		if( p->GetPageName() == PROFILER_PAGE )
+			++iOffset;
+	++iOffset;
+
+	for( int z = 0; z < NUM_ProfileZone + 2; ++z )
+	{
+		RString sName;
+		if( z < NUM_ProfileZone )
+			sName = ProfileZoneToString( (ProfileZone) z );
+		else
+			sName = z == NUM_ProfileZone? "Other":"Frame";
+		const float fAverageMs = frames.empty()? 0:iTotal[z] / 1000.0f / frames.size();
+
+		BitmapText &txt = *m_vptextProfiler[z];
+		txt.SetX( LINE_FUNCTION_X );
+		txt.SetY( LINE_START_Y + (iOffset + z) * LINE_SPACING );
+		txt.SetText( ssprintf("%s: %.2fms, worst %.2fms", sName.c_str(), fAverageMs, iMax[z] / 1000.0f) );
+	}
+}
+
 template<typename U, typename V>
 static bool GetValueFromMap( const map<U, V> &m, const U &key, V &val )
 {
@@ -589,6 +769,9 @@ static LocalizedString VISUAL_DELAY_DOWN	( "ScreenDebugOverlay", "Visual Delay D
 static LocalizedString VOLUME_UP		( "ScreenDebugOverlay", "Volume Up" );
 static LocalizedString VOLUME_DOWN		( "ScreenDebugOverlay", "Volume Down" );
 static LocalizedString UPTIME			( "ScreenDebugOverlay", "Uptime" );
+static LocalizedString FRAME_PROFILER		( "ScreenDebugOverlay", "Frame Profiler" );
+static LocalizedString WRITE_FRAME_TRACE	( "ScreenDebugOverlay", "Write Frame Trace" );
+static LocalizedString LOG_NOTE_DATA_MEMORY	( "ScreenDebugOverlay", "Log Note Data Memory" );
 static LocalizedString FORCE_CRASH		( "ScreenDebugOverlay", "Force Crash" );
 static LocalizedString SLOW			( "ScreenDebugOverlay", "Slow" );
 static LocalizedString CPU				( "ScreenDebugOverlay", "CPU" );
@@ -1321,6 +1504,46 @@ class DebugLineUptime : public IDebugLine
 	virtual void DoAndLog( RString &sMessageOut ) {}
 };
 
+class DebugLineFrameProfiler : public IDebugLine
+{
+	virtual RString GetDisplayTitle() { return FRAME_PROFILER.GetValue(); }
+	virtual RString GetPageName() const { return PROFILER_PAGE; }
+	virtual bool IsEnabled() { return RageProfiler::IsEnabled(); }
+	virtual void DoAndLog( RString &sMessageOut )
+	{
+		RageProfiler::SetEnabled( !RageProfiler::IsEnabled() );
+		IDebugLine::DoAndLog( sMessageOut );
+	}
+};
+
+class DebugLineWriteFrameTrace : public IDebugLine
+{
+	virtual RString GetDisplayTitle() { return WRITE_FRAME_TRACE.GetValue(); }
+	virtual RString GetDisplayValue() { return RString(); }
+	virtual RString GetPageName() const { return PROFILER_PAGE; }
+	virtual bool IsEnabled() { return true; }
+	virtual void DoAndLog( RString &sMessageOut )
+	{
+		RageProfiler::WriteChromeTrace( FRAME_TRACE_PATH );
+		IDebugLine::DoAndLog( sMessageOut );
+		sMessageOut += " - " FRAME_TRACE_PATH;
+	}
+};
+
+class DebugLineLogNoteDataMemory : public IDebugLine
+{
+	virtual RString GetDisplayTitle() { return LOG_NOTE_DATA_MEMORY.GetValue(); }
+	virtual RString GetDisplayValue() { return RString(); }
+	virtual RString GetPageName() const { return PROFILER_PAGE; }
+	virtual bool IsEnabled() { return true; }
+	virtual void DoAndLog( RString &sMessageOut )
+	{
+		SONGMAN->LogNoteDataMemoryUsage();
+		IDebugLine::DoAndLog( sMessageOut );
+		sMessageOut += ssprintf( " - %.1fMB", SONGMAN->GetNoteDataMemoryUsage(RString()) / (1024.0f*1024.0f) );
+	}
+};
+
 /* #ifdef out the lines below if you don't want them to appear on certain
  * platforms.  This is easier than #ifdefing the whole DebugLine definitions
  * that can span pages.
@@ -1367,6 +1590,9 @@ DECLARE_ONE( DebugLineForceCrash );
 DECLARE_ONE( DebugLineUptime );
 DECLARE_ONE( DebugLineResetKeyMapping );
 DECLARE_ONE( DebugLineMuteActions );
+DECLARE_ONE( DebugLineFrameProfiler );
+DECLARE_ONE( DebugLineWriteFrameTrace );
+DECLARE_ONE( DebugLineLogNoteDataMemory );
 
 
 /*
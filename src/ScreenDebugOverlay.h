@@ -22,6 +22,7 @@ public:
 
 private:
 	void UpdateText();
+	void UpdateProfilerText();
 
 	RString GetCurrentPageName() const { return m_asPages[m_iCurrentPage]; }
 	vector<RString> m_asPages;
@@ -33,6 +34,10 @@ private:
 	vector<BitmapText*> m_vptextPages;
 	vector<BitmapText*> m_vptextButton;
 	vector<BitmapText*> m_vptextFunction;
+
+	// The "Profiler" page shows the frame time graph and a line per zone.
+	Actor *m_pFrameGraph;
+	vector<BitmapText*> m_vptextProfiler;
 };
 
 
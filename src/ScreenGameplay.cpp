@@ -1,5 +1,6 @@
 #include "global.h"
 #include "ScreenGameplay.h"
+#include "AudioAnalysisCache.h"
 #include "SongManager.h"
 #include "ScreenManager.h"
 #include "GameConstantsAndTypes.h"
@@ -324,6 +325,12 @@ ScreenGameplay::ScreenGameplay()
 	m_pSongForeground = nullptr;
 	m_delaying_ready_announce= false;
 	GAMESTATE->m_AdjustTokensBySongCostForFinalStageCheck= false;
+
+	// Don't decode music for analysis while playing.  This is paired with
+	// the destructor, since a restart makes the next screen before deleting
+	// this one.
+	if( AUDIOANALYSIS )
+		AUDIOANALYSIS->Pause();
 }
 
 void ScreenGameplay::Init()
@@ -988,6 +995,8 @@ void ScreenGameplay::InitSongQueues()
 ScreenGameplay::~ScreenGameplay()
 {
 	GAMESTATE->m_AdjustTokensBySongCostForFinalStageCheck= true;
+	if( AUDIOANALYSIS )
+		AUDIOANALYSIS->Unpause();
 	if( this->IsFirstUpdate() )
 	{
 		/* We never received any updates. That means we were deleted without being
@@ -72,6 +72,7 @@
 #include "ScreenDimensions.h"
 #include "ActorUtil.h"
 #include "InputEventPlus.h"
+#include "RageProfiler.h"
 
 ScreenManager*	SCREENMAN = nullptr;	// global and accessible from anywhere in our program
 
@@ -494,6 +495,7 @@ void ScreenManager::Draw()
 	if( g_ScreenStack.size() && g_ScreenStack.back().m_pScreen->IsFirstUpdate() )
 		return;
 
+	PROFILE_SCOPE( ProfileZone_Draw );
 	if( !DISPLAY->BeginFrame() )
 		return;
 
@@ -509,6 +511,7 @@ void ScreenManager::Draw()
 		g_OverlayScreens[i]->Draw();
 
 
+	PROFILE_SCOPE( ProfileZone_Present );
 	DISPLAY->EndFrame();
 }
 
@@ -84,6 +84,7 @@ void ScreenSelectMusic::Init()
 	SAMPLE_MUSIC_PREVIEW_MODE.Load( m_sName, "SampleMusicPreviewMode" );
 	SAMPLE_MUSIC_FALLBACK_FADE_IN_SECONDS.Load( m_sName, "SampleMusicFallbackFadeInSeconds" );
 	SAMPLE_MUSIC_FADE_OUT_SECONDS.Load( m_sName, "SampleMusicFadeOutSeconds" );
+	SAMPLE_MUSIC_CROSS_FADE_SECONDS.Load( m_sName, "SampleMusicCrossFadeSeconds" );
 	DO_ROULETTE_ON_MENU_TIMER.Load( m_sName, "DoRouletteOnMenuTimer" );
 	ROULETTE_TIMER_SECONDS.Load( m_sName, "RouletteTimerSeconds" );
 	ALIGN_MUSIC_BEATS.Load( m_sName, "AlignMusicBeat" );
@@ -291,6 +292,7 @@ ScreenSelectMusic::~ScreenSelectMusic()
 {
 	LOG->Trace( "ScreenSelectMusic::~ScreenSelectMusic()" );
 	IMAGECACHE->Undemand("Banner");
+	SOUND->PrefetchMusic( vector<GameSoundManager::PlayMusicParams>() );
 }
 
 // If bForce is true, the next request will be started even if it might cause a skip.
@@ -377,6 +379,7 @@ void ScreenSelectMusic::CheckBackgroundRequests( bool bForce )
 		PlayParams.fFadeOutLengthSeconds = SAMPLE_MUSIC_FADE_OUT_SECONDS;
 		PlayParams.bAlignBeat = ALIGN_MUSIC_BEATS;
 		PlayParams.bApplyMusicRate = true;
+		PlayParams.fCrossFadeSeconds = SAMPLE_MUSIC_CROSS_FADE_SECONDS;
 
 		GameSoundManager::PlayMusicParams FallbackMusic;
 		FallbackMusic.sFile = m_sLoopMusicPath;
@@ -1705,6 +1708,36 @@ void ScreenSelectMusic::SwitchToPreferredDifficulty()
 	}
 }
 
+/* Open the sample music of the songs around the cursor ahead of time, so it
+ * can start as soon as the wheel settles on one of them. */
+void ScreenSelectMusic::PrefetchSampleMusic()
+{
+	static const int PREFETCH_DISTANCE = 3;
+
+	vector<GameSoundManager::PlayMusicParams> aParams;
+	const int iNumItems = m_MusicWheel.GetNumItems();
+	const int iCurrent = m_MusicWheel.GetCurrentIndex();
+	for( int iDist = 0; iDist <= PREFETCH_DISTANCE && iDist*2 < iNumItems; ++iDist )
+	{
+		for( int iDir = (iDist == 0? 1:-1); iDir <= 1; iDir += 2 )
+		{
+			const int iIndex = (iCurrent + iDist*iDir + iNumItems) % iNumItems;
+			const Song *pSong = m_MusicWheel.GetCurWheelItemData( iIndex )->m_pSong;
+			if( pSong == nullptr )
+				continue;
+
+			GameSoundManager::PlayMusicParams params;
+			params.sFile = pSong->GetPreviewMusicPath();
+			params.fStartSecond = pSong->GetPreviewStartSeconds();
+			if( params.sFile.empty() || ActorUtil::GetFileType(params.sFile) != FT_Sound )
+				continue;
+			aParams.push_back( params );
+		}
+	}
+
+	SOUND->PrefetchMusic( aParams );
+}
+
 void ScreenSelectMusic::AfterMusicChange()
 {
 	if( !m_MusicWheel.IsRouletting() )
@@ -1861,6 +1894,7 @@ void ScreenSelectMusic::AfterMusicChange()
 				m_pSampleMusicTimingData = &pSong->m_SongTiming;
 				m_fSampleStartSeconds = pSong->GetPreviewStartSeconds();
 				m_fSampleLengthSeconds = pSong->m_fMusicSampleLengthSeconds;
+				PrefetchSampleMusic();
 				break;
 			default:
 				FAIL_M(ssprintf("Invalid preview mode: %i", pmode));
@@ -1944,7 +1978,8 @@ void ScreenSelectMusic::AfterMusicChange()
 	if( !g_sCDTitlePath.empty() || g_bWantFallbackCdTitle )
 	{
 		LOG->Trace( "cache \"%s\"", g_sCDTitlePath.c_str());
-		m_BackgroundLoader.CacheFile( g_sCDTitlePath ); // empty OK
+		// The CDTitle is small; read it ahead of the banner.
+		m_BackgroundLoader.CacheFile( g_sCDTitlePath, 1 ); // empty OK
 		g_bCDTitleWaiting = true;
 	}
 
@@ -64,6 +64,7 @@ protected:
 	void AfterStepsOrTrailChange( const vector<PlayerNumber> &vpns );
 	void SwitchToPreferredDifficulty();
 	void AfterMusicChange();
+	void PrefetchSampleMusic();
 
 	void CheckBackgroundRequests( bool bForce );	
 	bool DetectCodes( const InputEventPlus &input );
@@ -81,6 +82,7 @@ protected:
 	ThemeMetric<SampleMusicPreviewMode> SAMPLE_MUSIC_PREVIEW_MODE;
 	ThemeMetric<float>		SAMPLE_MUSIC_FALLBACK_FADE_IN_SECONDS;
 	ThemeMetric<float>		SAMPLE_MUSIC_FADE_OUT_SECONDS;
+	ThemeMetric<float>		SAMPLE_MUSIC_CROSS_FADE_SECONDS;
 	ThemeMetric<bool>		DO_ROULETTE_ON_MENU_TIMER;
 	ThemeMetric<float>		ROULETTE_TIMER_SECONDS;
 	ThemeMetric<bool>		ALIGN_MUSIC_BEATS;
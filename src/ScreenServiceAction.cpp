@@ -4,6 +4,7 @@
 #include "Bookkeeper.h"
 #include "Profile.h"
 #include "ProfileManager.h"
+#include "ProfileSaveQueue.h"
 #include "ScreenManager.h"
 #include "RageFileManager.h"
 #include "RageLog.h"
@@ -108,7 +109,10 @@ static RString TransferStatsMachineToMemoryCard()
 
 	bool bSaved = PROFILEMAN->GetMachineProfile()->SaveAllToDir( sDir, PREFSMAN->m_bSignProfileData );
 
+	// This waits for the save to be written.
 	MEMCARDMAN->UnmountCard(pn);
+	if( PROFILEMAN->GetSaveQueue()->TakeFailure(sDir) )
+		bSaved = false;
 
 	if( bSaved )
 		return ssprintf(MACHINE_STATS_SAVED.GetValue(),pn+1);
@@ -88,8 +88,52 @@ class InputList: public BitmapText
 
 REGISTER_ACTOR_CLASS( InputList );
 
+static LocalizedString INPUT_LATENCY	( "ScreenTestInput", "Input latency" );
+static LocalizedString SLOWER		( "ScreenTestInput", "slower" );
+class InputLatencyList: public BitmapText
+{
+public:
+	void Update( float fDeltaTime )
+	{
+		vector<InputLatencyBucket> aBuckets;
+		INPUTFILTER->GetLatencyHistogram( aBuckets );
+
+		int iMaxCount = 1;
+		for (InputLatencyBucket const &b : aBuckets)
+			iMaxCount = max( iMaxCount, b.iCount );
+
+		// One line per bucket, with a bar scaled to the fullest one.
+		static const int BAR_WIDTH = 30;
+		vector<RString> asLines;
+		asLines.push_back( INPUT_LATENCY.GetValue() );
+		for (InputLatencyBucket const &b : aBuckets)
+		{
+			RString sBucket;
+			if( b.fMaxSeconds < 0 )
+				sBucket = SLOWER.GetValue();
+			else
+				sBucket = ssprintf( "<= %.1fms", b.fMaxSeconds * 1000 );
+			asLines.push_back( ssprintf("%-10s %6i %s", sBucket.c_str(), b.iCount,
+				RString(b.iCount * BAR_WIDTH / iMaxCount, '|').c_str()) );
+		}
+		this->SetText( join("\n", asLines) );
+
+		BitmapText::Update( fDeltaTime );
+	}
+
+	virtual InputLatencyList *Copy() const;
+};
+
+REGISTER_ACTOR_CLASS( InputLatencyList );
+
 REGISTER_SCREEN_CLASS( ScreenTestInput );
 
+void ScreenTestInput::BeginScreen()
+{
+	INPUTFILTER->ResetLatencyHistogram();
+	ScreenWithMenuElements::BeginScreen();
+}
+
 bool ScreenTestInput::Input( const InputEventPlus &input )
 {
 	RString sMessage = input.DeviceI.ToString();
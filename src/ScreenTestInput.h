@@ -10,6 +10,7 @@
 class ScreenTestInput : public ScreenWithMenuElements
 {
 public:
+	virtual void BeginScreen();
 	virtual bool Input( const InputEventPlus &input );
 
 	virtual bool MenuStart( const InputEventPlus &input );
@@ -36,6 +36,7 @@
 #include "LyricsLoader.h"
 #include "ActorUtil.h"
 #include "CommonMetrics.h"
+#include "AudioAnalysisCache.h"
 
 #include <time.h>
 #include <set>
@@ -48,7 +49,7 @@
  * @brief The internal version of the cache for StepMania.
  *
  * Increment this value to invalidate the current cache. */
-const int FILE_CACHE_VERSION = 227;
+const int FILE_CACHE_VERSION = 228;
 
 /** @brief How long does a song sample last by default? */
 const float DEFAULT_MUSIC_SAMPLE_LENGTH = 12.f;
@@ -255,11 +256,6 @@ const BackgroundChange &Song::GetBackgroundAtBeat( BackgroundLayer iLayer, float
 }
 
 
-RString Song::GetCacheFilePath() const
-{
-	return SongCacheIndex::GetCacheFilePath( "Songs", m_sSongDir );
-}
-
 // Get a path to the SM containing data for this song. It might be a cache file.
 const RString &Song::GetSongFilePath() const
 {
@@ -269,10 +265,6 @@ const RString &Song::GetSongFilePath() const
 	return m_sSongFileName;
 }
 
-/* Hack: This should be a parameter to TidyUpData, but I don't want to pull in
- * <set> into Song.h, which is heavily used. */
-static set<RString> BlacklistedImages;
-
 /* If PREFSMAN->m_bFastLoad is true, always load from cache if possible.
  * Don't read the contents of sDir if we can avoid it. That means we can't call
  * HasMusic(), HasBanner() or GetHashForDirectory().
@@ -308,14 +300,12 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
 		use_cache= false;
 	}
 
-	RString cache_file_path;
 	if(m_LoadedFromProfile == ProfileSlot_Invalid)
 	{
 		// First, look in the cache for this song (without loading NoteData)
 		unsigned uCacheHash = SONGINDEX->GetCacheHash(m_sSongDir);
-		cache_file_path = GetCacheFilePath();
 
-		if( !DoesFileExist(cache_file_path) )
+		if( !SONGINDEX->HasCachedSong(m_sSongDir) )
 		{ use_cache = false; }
 		else if(!PREFSMAN->m_bFastLoad && GetHashForDirectory(m_sSongDir) != uCacheHash)
 		{ use_cache = false; } // this cache is out of date
@@ -323,22 +313,14 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
 		{ use_cache= false; }
 	}
 
+	if(use_cache && !SONGINDEX->LoadSongFromCache(*this))
+	{ use_cache = false; }
+
 	if(use_cache)
 	{
-		/*
-		LOG->Trace("Loading '%s' from cache file '%s'.",
-				   m_sSongDir.c_str(),
-				   GetCacheFilePath().c_str());
-		*/
-		SSCLoader loaderSSC;
-		bool bLoadedFromSSC = loaderSSC.LoadFromSimfile( cache_file_path, *this, true );
-		if( !bLoadedFromSSC )
-		{
-			// load from .sm
-			SMLoader loaderSM;
-			loaderSM.LoadFromSimfile( cache_file_path, *this, true );
-			loaderSM.TidyUpData( *this, true );
-		}
+		// Fix up paths and timing the same way a cache load through the
+		// SSC loader did.
+		TidyUpData(true, true);
 		if(m_sMainTitle == "" || (m_sMusicFile == "" && m_vsKeysoundFile.empty()))
 		{
 			LOG->Warn("Main title or music file for '%s' came up blank, forced to fall back on TidyUpData to fix title and paths.  Do not use # or ; in a song title.", m_sSongDir.c_str());
@@ -352,6 +334,9 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
 		// There was no entry in the cache for this song, or it was out of date.
 		// Let's load it from a file, then write a cache entry.
 
+		// Songs are loaded on several threads at once, so this belongs to
+		// this load only.
+		set<RString> BlacklistedImages;
 		if(!NotesLoader::LoadFromDir(sDir, *this, BlacklistedImages, load_autosave))
 		{
 			LOG->UserLog( "Song", sDir, "has no SSC, SM, SMA, DWI, BMS, or KSF files." );
@@ -377,7 +362,7 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
 		// loading time. -Kyz
 		LoadEditsFromSongDir(sDir);
 
-		TidyUpData(false, true);
+		TidyUpData(false, true, &BlacklistedImages);
 
 		// Don't save a cache file if the autosave is being loaded, because the
 		// cache file would contain the autosave filename. -Kyz
@@ -386,9 +371,8 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
 		// entries. -Kyz
 		if(!load_autosave && m_LoadedFromProfile == ProfileSlot_Invalid)
 		{
-			// save a cache file so we don't have to parse it all over again next time
-			if(!SaveToCacheFile())
-			{ cache_file_path = RString(); }
+			// save a cache entry so we don't have to parse it all over again next time
+			SaveToCacheFile();
 		}
 	}
 
@@ -457,9 +441,9 @@ bool Song::LoadFromSongDir(RString sDir, bool load_autosave, ProfileSlot from_pr
  * Song/Steps objects to reload themselves. -- djpohly */
 bool Song::ReloadFromSongDir( RString sDir )
 {
-	// Remove the cache file to force the song to reload from its dir instead
+	// Remove the cache entry to force the song to reload from its dir instead
 	// of loading from the cache. -Kyz
-	FILEMAN->Remove(GetCacheFilePath());
+	SONGINDEX->RemoveSongFromCache(m_sSongDir);
 
 	RemoveAutoGenNotes();
 	vector<Steps*> vOldSteps = m_vpSteps;
@@ -621,7 +605,7 @@ void FixupPath( RString &path, const RString &sSongPath )
 }
 
 // Songs in BlacklistImages will never be autodetected as song images.
-void Song::TidyUpData( bool from_cache, bool /* duringCache */ )
+void Song::TidyUpData( bool from_cache, bool /* duringCache */, const set<RString> *pBlacklistedImages )
 {
 	// We need to do this before calling any of HasMusic, HasHasCDTitle, etc.
 	ASSERT_M(m_sSongDir.Left(3) != "../", m_sSongDir); // meaningless
@@ -962,7 +946,7 @@ void Song::TidyUpData( bool from_cache, bool /* duringCache */ )
 				// ignore DWI "-char" graphics
 				RString lower = image_list[i];
 				lower.MakeLower();
-				if(BlacklistedImages.find(lower) != BlacklistedImages.end())
+				if(pBlacklistedImages != nullptr && pBlacklistedImages->find(lower) != pBlacklistedImages->end())
 				continue;	// skip
 
 				// Skip any image that we've already classified
@@ -1367,9 +1351,11 @@ bool Song::SaveToCacheFile()
 	{
 		return true;
 	}
+	// Store the song before its hash, so the index never vouches for a
+	// cache entry that doesn't exist.
+	SONGINDEX->SaveSongToCache(*this);
 	SONGINDEX->AddCacheIndex(m_sSongDir, GetHashForDirectory(m_sSongDir));
-	const RString sPath = GetCacheFilePath();
-	return SaveToSSCFile(sPath, true);
+	return true;
 }
 
 bool Song::SaveToDWIFile()
@@ -2279,6 +2265,40 @@ public:
 		lua_pushnumber(L, p->GetPreviewStartSeconds());
 		return 1;
 	}
+	/* These return nil until the music has been analyzed in the background;
+	 * asking for it moves the song to the front of the queue. */
+	static int GetMusicLoudness( T* p, lua_State *L )
+	{
+		AudioAnalysis analysis;
+		if( p->HasMusic() && AUDIOANALYSIS->Get(p->GetMusicPath(), analysis) )
+			lua_pushnumber(L, analysis.GetLoudness());
+		else
+			lua_pushnil(L);
+		return 1;
+	}
+	static int GetMusicEnvelope( T* p, lua_State *L )
+	{
+		AudioAnalysis analysis;
+		if( !p->HasMusic() || !AUDIOANALYSIS->Get(p->GetMusicPath(), analysis) )
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		const int iPoints = IArg(3);
+		if( iPoints < 1 )
+			luaL_error( L, "GetMusicEnvelope: %i points requested", iPoints );
+		vector<float> aPeak, aRMS, aOnset;
+		analysis.GetEnvelope( FArg(1), FArg(2), iPoints, &aPeak, &aRMS, &aOnset );
+		lua_createtable( L, 0, 3 );
+		LuaHelpers::CreateTableFromArray( aPeak, L );
+		lua_setfield( L, -2, "Peak" );
+		LuaHelpers::CreateTableFromArray( aRMS, L );
+		lua_setfield( L, -2, "RMS" );
+		LuaHelpers::CreateTableFromArray( aOnset, L );
+		lua_setfield( L, -2, "Onset" );
+		return 1;
+	}
 	static int GetSampleLength( T* p, lua_State *L )
 	{
 		lua_pushnumber(L, p->m_fMusicSampleLengthSeconds);
@@ -2490,6 +2510,8 @@ public:
 		ADD_METHOD( GetGroupName );
 		ADD_METHOD( MusicLengthSeconds );
 		ADD_METHOD( GetSampleStart );
+		ADD_METHOD( GetMusicLoudness );
+		ADD_METHOD( GetMusicEnvelope );
 		ADD_METHOD( GetSampleLength );
 		ADD_METHOD( IsLong );
 		ADD_METHOD( IsMarathon );
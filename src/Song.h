@@ -101,8 +101,10 @@ public:
 	/**
 	 * @brief Call this after loading a song to clean up invalid data.
 	 * @param fromCache was this data loaded from the cache file?
-	 * @param duringCache was this data loaded during the cache process? */
-	void TidyUpData( bool fromCache = false, bool duringCache = false );
+	 * @param duringCache was this data loaded during the cache process?
+	 * @param pBlacklistedImages images the loader found aren't song graphics,
+	 * which aren't considered for the banner, background or CD title. */
+	void TidyUpData( bool fromCache = false, bool duringCache = false, const set<RString> *pBlacklistedImages = nullptr );
 
 	/**
 	 * @brief Get the new radar values, and determine the last second at the same time.
@@ -145,7 +147,6 @@ public:
 	{ return m_loaded_from_autosave; }
 
 	const RString &GetSongFilePath() const;
-	RString GetCacheFilePath() const;
 
 	void AddAutoGenNotes();
 	/**
@@ -417,6 +418,8 @@ public:
 	bool HasStepsTypeAndDifficulty( StepsType st, Difficulty dc ) const;
 	// TODO: Allow for a non const version.
 	const vector<Steps*>& GetAllSteps() const { return m_vpSteps; }
+	/** @brief Steps of StepsTypes this version doesn't know, kept so saving doesn't lose them. */
+	const vector<Steps*>& GetUnknownStyleSteps() const { return m_UnknownStyleSteps; }
 	const vector<Steps*>& GetStepsByStepsType( StepsType st ) const { return m_vpStepsByType[st]; }
 	bool IsEasy( StepsType st ) const;
 	bool IsTutorial() const;
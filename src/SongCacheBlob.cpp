@@ -0,0 +1,775 @@
+#include "global.h"
+
+#include "SongCacheBlob.h"
+#include "BackgroundUtil.h"
+#include "GameManager.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageThreads.h"
+#include "RageUtil.h"
+#include "Song.h"
+#include "SongUtil.h"
+#include "SpecialFiles.h"
+#include "Steps.h"
+
+#include <cstring>
+
+/* Layout of the file:
+ *
+ *   "SMSB" <uint32 BLOB_VERSION> <uint32 FILE_CACHE_VERSION>
+ *   any number of entries: <string song dir> <string record> <uint32 CRC>
+ *
+ * Like the cache index, this is a log: saving a song appends an entry, and a
+ * later entry for the same song dir replaces an earlier one.  An empty record
+ * removes the song.  The entry CRC covers the rest of the entry, so an entry
+ * cut short by a crash while appending is noticed and dropped, along with
+ * anything after it.
+ *
+ * Each record also starts with a CRC of the rest of the record, so a damaged
+ * record is noticed before anything is read into the song.
+ *
+ * Strings are a uint32 length followed by the bytes.  Numbers are written in
+ * native byte order; the cache is never shared between machines, and a blob
+ * written with the other byte order fails the version check and is rebuilt. */
+#define SONG_CACHE_BLOB SpecialFiles::CACHE_DIR + "songs.cache"
+
+static const char BLOB_MAGIC[4] = { 'S', 'M', 'S', 'B' };
+/** @brief Bump this when the record layout changes. */
+static const uint32_t BLOB_VERSION = 3;
+
+/* Song loader threads read and add records concurrently. */
+static RageMutex g_BlobMutex( "SongCacheBlob" );
+
+namespace
+{
+	class BlobWriter
+	{
+	public:
+		BlobWriter( RString &sOut ): m_sOut(sOut) { }
+
+		void Bytes( const void *p, size_t iSize ) { m_sOut.append( static_cast<const char *>(p), iSize ); }
+		void U32( uint32_t i ) { Bytes( &i, sizeof(i) ); }
+		void Int( int i ) { U32( static_cast<uint32_t>(i) ); }
+		void Float( float f ) { Bytes( &f, sizeof(f) ); }
+		void Bool( bool b ) { char c = b; Bytes( &c, 1 ); }
+		void Str( const RString &s ) { U32( s.size() ); Bytes( s.data(), s.size() ); }
+		void Strings( const vector<RString> &v )
+		{
+			U32( v.size() );
+			for (RString const &s : v)
+				Str( s );
+		}
+
+	private:
+		RString &m_sOut;
+	};
+
+	/* Reading past the end sets the error flag and returns zeroes, so callers
+	 * only need to check Failed() once at the end. */
+	class BlobReader
+	{
+	public:
+		BlobReader( const char *p, size_t iSize ): m_p(p), m_pEnd(p + iSize), m_bFailed(false) { }
+
+		bool Bytes( void *p, size_t iSize )
+		{
+			if( m_bFailed || size_t(m_pEnd - m_p) < iSize )
+			{
+				m_bFailed = true;
+				memset( p, 0, iSize );
+				return false;
+			}
+			memcpy( p, m_p, iSize );
+			m_p += iSize;
+			return true;
+		}
+		uint32_t U32() { uint32_t i; Bytes( &i, sizeof(i) ); return i; }
+		int Int() { return static_cast<int>( U32() ); }
+		float Float() { float f; Bytes( &f, sizeof(f) ); return f; }
+		bool Bool() { char c; Bytes( &c, 1 ); return c != 0; }
+		RString Str()
+		{
+			uint32_t iSize = U32();
+			if( m_bFailed || size_t(m_pEnd - m_p) < iSize )
+			{
+				m_bFailed = true;
+				return RString();
+			}
+			RString s( m_p, iSize );
+			m_p += iSize;
+			return s;
+		}
+		void Strings( vector<RString> &v )
+		{
+			uint32_t iCount = U32();
+			v.clear();
+			for( uint32_t i = 0; i < iCount && !m_bFailed; ++i )
+				v.push_back( Str() );
+		}
+
+		bool Failed() const { return m_bFailed; }
+		bool AtEnd() const { return m_p == m_pEnd; }
+		const char *GetPos() const { return m_p; }
+
+	private:
+		const char *m_p, *m_pEnd;
+		bool m_bFailed;
+	};
+}
+
+static void WriteTimingData( BlobWriter &w, const TimingData &timing )
+{
+	w.Float( timing.m_fBeat0OffsetInSeconds );
+	w.Str( timing.m_sFile );
+
+	FOREACH_TimingSegmentType( tst )
+	{
+		const vector<TimingSegment *> &segs = timing.GetTimingSegments( tst );
+		w.U32( segs.size() );
+		for (TimingSegment const *seg : segs)
+		{
+			w.Int( seg->GetRow() );
+			switch( tst )
+			{
+			case SEGMENT_BPM:	w.Float( ToBPM(seg)->GetBPM() ); break;
+			case SEGMENT_STOP:	w.Float( ToStop(seg)->GetPause() ); break;
+			case SEGMENT_DELAY:	w.Float( ToDelay(seg)->GetPause() ); break;
+			case SEGMENT_TIME_SIG:
+				w.Int( ToTimeSignature(seg)->GetNum() );
+				w.Int( ToTimeSignature(seg)->GetDen() );
+				break;
+			case SEGMENT_WARP:	w.Int( ToWarp(seg)->GetLengthRows() ); break;
+			case SEGMENT_LABEL:	w.Str( ToLabel(seg)->GetLabel() ); break;
+			case SEGMENT_TICKCOUNT:	w.Int( ToTickcount(seg)->GetTicks() ); break;
+			case SEGMENT_COMBO:
+				w.Int( ToCombo(seg)->GetCombo() );
+				w.Int( ToCombo(seg)->GetMissCombo() );
+				break;
+			case SEGMENT_SPEED:
+				w.Float( ToSpeed(seg)->GetRatio() );
+				w.Float( ToSpeed(seg)->GetDelay() );
+				w.Int( ToSpeed(seg)->GetUnit() );
+				break;
+			case SEGMENT_SCROLL:	w.Float( ToScroll(seg)->GetRatio() ); break;
+			case SEGMENT_FAKE:	w.Int( ToFake(seg)->GetLengthRows() ); break;
+			default: FAIL_M( ssprintf("Invalid timing segment type: %i", tst) );
+			}
+		}
+	}
+}
+
+static void ReadTimingData( BlobReader &r, TimingData &timing )
+{
+	timing.Clear();
+	timing.m_fBeat0OffsetInSeconds = r.Float();
+	timing.m_sFile = r.Str();
+
+	FOREACH_TimingSegmentType( tst )
+	{
+		uint32_t iCount = r.U32();
+		for( uint32_t i = 0; i < iCount && !r.Failed(); ++i )
+		{
+			int iRow = r.Int();
+			switch( tst )
+			{
+			case SEGMENT_BPM:	timing.AddSegment( BPMSegment(iRow, r.Float()) ); break;
+			case SEGMENT_STOP:	timing.AddSegment( StopSegment(iRow, r.Float()) ); break;
+			case SEGMENT_DELAY:	timing.AddSegment( DelaySegment(iRow, r.Float()) ); break;
+			case SEGMENT_TIME_SIG:
+			{
+				int iNum = r.Int();
+				int iDen = r.Int();
+				timing.AddSegment( TimeSignatureSegment(iRow, iNum, iDen) );
+				break;
+			}
+			case SEGMENT_WARP:	timing.AddSegment( WarpSegment(iRow, r.Int()) ); break;
+			case SEGMENT_LABEL:	timing.AddSegment( LabelSegment(iRow, r.Str()) ); break;
+			case SEGMENT_TICKCOUNT:	timing.AddSegment( TickcountSegment(iRow, r.Int()) ); break;
+			case SEGMENT_COMBO:
+			{
+				int iCombo = r.Int();
+				int iMissCombo = r.Int();
+				timing.AddSegment( ComboSegment(iRow, iCombo, iMissCombo) );
+				break;
+			}
+			case SEGMENT_SPEED:
+			{
+				float fRatio = r.Float();
+				float fDelay = r.Float();
+				SpeedSegment::BaseUnit unit = static_cast<SpeedSegment::BaseUnit>( r.Int() );
+				timing.AddSegment( SpeedSegment(iRow, fRatio, fDelay, unit) );
+				break;
+			}
+			case SEGMENT_SCROLL:	timing.AddSegment( ScrollSegment(iRow, r.Float()) ); break;
+			case SEGMENT_FAKE:	timing.AddSegment( FakeSegment(iRow, r.Int()) ); break;
+			default: FAIL_M( ssprintf("Invalid timing segment type: %i", tst) );
+			}
+		}
+	}
+}
+
+static void WriteAttacks( BlobWriter &w, const AttackArray &attacks, const vector<RString> &vsAttackString )
+{
+	w.U32( attacks.size() );
+	for (Attack const &a : attacks)
+	{
+		w.Int( a.level );
+		w.Float( a.fStartSecond );
+		w.Float( a.fSecsRemaining );
+		w.Str( a.sModifiers );
+		w.Bool( a.bGlobal );
+		w.Bool( a.bShowInAttackList );
+	}
+	w.Strings( vsAttackString );
+}
+
+static void ReadAttacks( BlobReader &r, AttackArray &attacks, vector<RString> &vsAttackString )
+{
+	uint32_t iCount = r.U32();
+	attacks.clear();
+	for( uint32_t i = 0; i < iCount && !r.Failed(); ++i )
+	{
+		Attack a;
+		a.level = static_cast<AttackLevel>( r.Int() );
+		a.fStartSecond = r.Float();
+		a.fSecsRemaining = r.Float();
+		a.sModifiers = r.Str();
+		a.bGlobal = r.Bool();
+		a.bShowInAttackList = r.Bool();
+		attacks.push_back( a );
+	}
+	r.Strings( vsAttackString );
+}
+
+static void WriteBackgroundChanges( BlobWriter &w, const vector<BackgroundChange> &changes )
+{
+	w.U32( changes.size() );
+	for (BackgroundChange const &bgc : changes)
+	{
+		w.Str( bgc.m_def.m_sEffect );
+		w.Str( bgc.m_def.m_sFile1 );
+		w.Str( bgc.m_def.m_sFile2 );
+		w.Str( bgc.m_def.m_sColor1 );
+		w.Str( bgc.m_def.m_sColor2 );
+		w.Float( bgc.m_fStartBeat );
+		w.Float( bgc.m_fRate );
+		w.Str( bgc.m_sTransition );
+	}
+}
+
+static void ReadBackgroundChanges( BlobReader &r, vector<BackgroundChange> &changes )
+{
+	uint32_t iCount = r.U32();
+	changes.clear();
+	for( uint32_t i = 0; i < iCount && !r.Failed(); ++i )
+	{
+		BackgroundChange bgc;
+		bgc.m_def.m_sEffect = r.Str();
+		bgc.m_def.m_sFile1 = r.Str();
+		bgc.m_def.m_sFile2 = r.Str();
+		bgc.m_def.m_sColor1 = r.Str();
+		bgc.m_def.m_sColor2 = r.Str();
+		bgc.m_fStartBeat = r.Float();
+		bgc.m_fRate = r.Float();
+		bgc.m_sTransition = r.Str();
+		changes.push_back( bgc );
+	}
+}
+
+static void WriteSteps( BlobWriter &w, const Steps &steps )
+{
+	w.Str( steps.m_StepsTypeStr );
+	w.Str( steps.GetChartName() );
+	w.Str( steps.GetDescription() );
+	w.Str( steps.GetChartStyle() );
+	w.Int( steps.GetDifficulty() );
+	w.Int( steps.GetMeter() );
+	w.Str( steps.GetCredit() );
+	w.Str( steps.GetMusicFile() );
+	w.Str( steps.GetFilename() );
+	FOREACH_PlayerNumber( pn )
+	{
+		const RadarValues &rv = steps.GetRadarValues( pn );
+		FOREACH_ENUM( RadarCategory, rc )
+			w.Float( rv[rc] );
+	}
+	w.Int( steps.GetDisplayBPM() );
+	w.Float( steps.GetMinBPM() );
+	w.Float( steps.GetMaxBPM() );
+	WriteAttacks( w, steps.m_Attacks, steps.m_sAttackString );
+	// Empty until something asks for it.
+	w.Str( steps.ChartKey );
+
+	// Steps without their own timing use the song's.
+	w.Bool( !steps.m_Timing.empty() );
+	if( !steps.m_Timing.empty() )
+		WriteTimingData( w, steps.m_Timing );
+}
+
+static void ReadSteps( BlobReader &r, Steps &steps )
+{
+	steps.m_StepsTypeStr = r.Str();
+	steps.m_StepsType = GAMEMAN->StringToStepsType( steps.m_StepsTypeStr );
+	steps.SetChartName( r.Str() );
+	RString sDescription = r.Str();
+	steps.SetChartStyle( r.Str() );
+	Difficulty dc = static_cast<Difficulty>( r.Int() );
+	steps.SetDifficultyAndDescription( dc, sDescription );
+	steps.SetMeter( r.Int() );
+	steps.SetCredit( r.Str() );
+	steps.SetMusicFile( r.Str() );
+	steps.SetFilename( r.Str() );
+	RadarValues rv[NUM_PLAYERS];
+	FOREACH_PlayerNumber( pn )
+	{
+		FOREACH_ENUM( RadarCategory, rc )
+			rv[pn][rc] = r.Float();
+	}
+	steps.SetCachedRadarValues( rv );
+	steps.SetDisplayBPM( static_cast<DisplayBPM>(r.Int()) );
+	steps.SetMinBPM( r.Float() );
+	steps.SetMaxBPM( r.Float() );
+	ReadAttacks( r, steps.m_Attacks, steps.m_sAttackString );
+	steps.SetChartKey( r.Str() );
+
+	if( r.Bool() )
+		ReadTimingData( r, steps.m_Timing );
+}
+
+static void WriteSong( BlobWriter &w, const Song &song )
+{
+	w.Str( song.m_sSongFileName );
+	w.Str( song.m_sMainTitle );
+	w.Str( song.m_sSubTitle );
+	w.Str( song.m_sArtist );
+	w.Str( song.m_sMainTitleTranslit );
+	w.Str( song.m_sSubTitleTranslit );
+	w.Str( song.m_sArtistTranslit );
+	w.Str( song.m_sGenre );
+	w.Str( song.m_sOrigin );
+	w.Str( song.m_sCredit );
+	w.Str( song.m_sBannerFile );
+	w.Str( song.m_sBackgroundFile );
+	w.Str( song.m_sPreviewVidFile );
+	w.Str( song.m_sJacketFile );
+	w.Str( song.m_sCDFile );
+	w.Str( song.m_sDiscFile );
+	w.Str( song.m_sLyricsFile );
+	w.Str( song.m_sCDTitleFile );
+	w.Str( song.m_sMusicFile );
+	w.Str( song.m_PreviewFile );
+	FOREACH_ENUM( InstrumentTrack, it )
+		w.Str( song.m_sInstrumentTrackFile[it] );
+	w.Strings( song.m_vsKeysoundFile );
+
+	w.Float( song.m_fMusicLengthSeconds );
+	w.Float( song.m_fMusicSampleStartSeconds );
+	w.Float( song.m_fMusicSampleLengthSeconds );
+	w.Int( song.m_SelectionDisplay );
+	w.Int( song.m_DisplayBPMType );
+	w.Float( song.m_fSpecifiedBPMMin );
+	w.Float( song.m_fSpecifiedBPMMax );
+	w.Float( song.GetFirstSecond() );
+	w.Float( song.GetLastSecond() );
+	w.Float( song.GetSpecifiedLastSecond() );
+	w.Bool( song.m_bHasMusic );
+	w.Bool( song.m_bHasBanner );
+	w.Bool( song.m_bHasBackground );
+
+	WriteTimingData( w, song.m_SongTiming );
+	FOREACH_BackgroundLayer( bl )
+		WriteBackgroundChanges( w, song.GetBackgroundChanges(bl) );
+	WriteBackgroundChanges( w, song.GetForegroundChanges() );
+	WriteAttacks( w, song.m_Attacks, song.m_sAttackString );
+
+	// Save the same Steps as Song::SaveToSSCFile does.
+	vector<const Steps *> vpSteps;
+	for (Steps const *pSteps : song.GetAllSteps())
+	{
+		if( pSteps->IsAutogen() || pSteps->WasLoadedFromProfile() )
+			continue;
+		vpSteps.push_back( pSteps );
+	}
+	for (Steps const *pSteps : song.GetUnknownStyleSteps())
+		vpSteps.push_back( pSteps );
+
+	w.U32( vpSteps.size() );
+	for (Steps const *pSteps : vpSteps)
+		WriteSteps( w, *pSteps );
+}
+
+static void ReadSong( BlobReader &r, Song &song )
+{
+	song.m_sSongFileName = r.Str();
+	song.m_sMainTitle = r.Str();
+	song.m_sSubTitle = r.Str();
+	song.m_sArtist = r.Str();
+	song.m_sMainTitleTranslit = r.Str();
+	song.m_sSubTitleTranslit = r.Str();
+	song.m_sArtistTranslit = r.Str();
+	song.m_sGenre = r.Str();
+	song.m_sOrigin = r.Str();
+	song.m_sCredit = r.Str();
+	song.m_sBannerFile = r.Str();
+	song.m_sBackgroundFile = r.Str();
+	song.m_sPreviewVidFile = r.Str();
+	song.m_sJacketFile = r.Str();
+	song.m_sCDFile = r.Str();
+	song.m_sDiscFile = r.Str();
+	song.m_sLyricsFile = r.Str();
+	song.m_sCDTitleFile = r.Str();
+	song.m_sMusicFile = r.Str();
+	song.m_PreviewFile = r.Str();
+	FOREACH_ENUM( InstrumentTrack, it )
+		song.m_sInstrumentTrackFile[it] = r.Str();
+	r.Strings( song.m_vsKeysoundFile );
+
+	song.m_fMusicLengthSeconds = r.Float();
+	song.m_fMusicSampleStartSeconds = r.Float();
+	song.m_fMusicSampleLengthSeconds = r.Float();
+	song.m_SelectionDisplay = static_cast<Song::SelectionDisplay>( r.Int() );
+	song.m_DisplayBPMType = static_cast<DisplayBPM>( r.Int() );
+	song.m_fSpecifiedBPMMin = r.Float();
+	song.m_fSpecifiedBPMMax = r.Float();
+	song.SetFirstSecond( r.Float() );
+	song.SetLastSecond( r.Float() );
+	song.SetSpecifiedLastSecond( r.Float() );
+	song.m_bHasMusic = r.Bool();
+	song.m_bHasBanner = r.Bool();
+	song.m_bHasBackground = r.Bool();
+
+	ReadTimingData( r, song.m_SongTiming );
+	FOREACH_BackgroundLayer( bl )
+		ReadBackgroundChanges( r, song.GetBackgroundChanges(bl) );
+	ReadBackgroundChanges( r, song.GetForegroundChanges() );
+	ReadAttacks( r, song.m_Attacks, song.m_sAttackString );
+
+	uint32_t iSteps = r.U32();
+	for( uint32_t i = 0; i < iSteps && !r.Failed(); ++i )
+	{
+		Steps *pSteps = song.CreateSteps();
+		ReadSteps( r, *pSteps );
+		song.AddSteps( pSteps );
+	}
+	song.m_fVersion = STEPFILE_VERSION_NUMBER;
+}
+
+/** @brief Fill in a song from a record, checking its CRC first.
+ * @return false if the record is damaged or from another version. */
+static bool ReadRecord( const RString &sRecord, Song &song )
+{
+	BlobReader r( sRecord.data(), sRecord.size() );
+	const uint32_t iCRC = r.U32();
+	if( r.Failed() || iCRC != GetHashForString(sRecord.substr(sizeof(iCRC))) )
+		return false;
+	ReadSong( r, song );
+	return !r.Failed() && r.AtEnd();
+}
+
+static RString MakeRecord( const Song &song )
+{
+	RString sBody;
+	BlobWriter body( sBody );
+	WriteSong( body, song );
+
+	RString sRecord;
+	BlobWriter w( sRecord );
+	w.U32( GetHashForString(sBody) );
+	w.Bytes( sBody.data(), sBody.size() );
+	return sRecord;
+}
+
+static void AppendEntry( RString &sOut, const RString &sSongDir, const RString &sRecord )
+{
+	RString sEntry;
+	BlobWriter w( sEntry );
+	w.Str( sSongDir );
+	w.Str( sRecord );
+	w.U32( GetHashForString(sEntry) );
+	sOut += sEntry;
+}
+
+SongCacheBlob::SongCacheBlob():
+	m_iEntriesOnDisk(0), m_bRewrite(true), m_bDirty(false)
+{
+}
+
+void SongCacheBlob::ReadFromDisk()
+{
+	LockMut( g_BlobMutex );
+	m_mapRecords.clear();
+	m_sPendingEntries = RString();
+	m_iEntriesOnDisk = 0;
+	m_bRewrite = true;
+	m_bDirty = false;
+
+	RageFile f;
+	if( !f.Open(SONG_CACHE_BLOB) )
+		return;
+
+	RString sData;
+	if( f.Read(sData, f.GetFileSize()) != f.GetFileSize() )
+	{
+		LOG->Warn( "Error reading %s: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		return;
+	}
+	f.Close();
+
+	BlobReader r( sData.data(), sData.size() );
+	char magic[sizeof(BLOB_MAGIC)];
+	r.Bytes( magic, sizeof(magic) );
+	const uint32_t iBlobVersion = r.U32();
+	const uint32_t iCacheVersion = r.U32();
+	if( r.Failed() || memcmp(magic, BLOB_MAGIC, sizeof(magic)) ||
+		iBlobVersion != BLOB_VERSION || iCacheVersion != uint32_t(FILE_CACHE_VERSION) )
+	{
+		LOG->Trace( "Song cache blob is out of date.  Discarding it." );
+		return;
+	}
+
+	bool bDamaged = false;
+	while( !r.AtEnd() )
+	{
+		const char *pEntry = r.GetPos();
+		RString sSongDir = r.Str();
+		RString sRecord = r.Str();
+		const RString sEntry( pEntry, r.GetPos() - pEntry );
+		if( r.U32() != GetHashForString(sEntry) || r.Failed() )
+		{
+			bDamaged = true;
+			break;
+		}
+
+		if( sRecord.empty() )
+			m_mapRecords.erase( sSongDir );
+		else
+			m_mapRecords[sSongDir] = sRecord;
+		++m_iEntriesOnDisk;
+	}
+
+	if( !bDamaged )
+	{
+		m_bRewrite = false;
+	}
+	else
+	{
+		// Most likely a crash while appending.  Whatever came before the
+		// bad entry is fine, but nothing can be appended after it.
+		LOG->Warn( "Song cache blob is damaged after %u entries; the rest will be rebuilt.", m_iEntriesOnDisk );
+		m_bDirty = true;
+	}
+}
+
+void SongCacheBlob::WriteToDisk()
+{
+	LockMut( g_BlobMutex );
+
+	// Once most of the log is replaced entries, compact it.
+	if( m_iEntriesOnDisk > 2 * m_mapRecords.size() + 64 )
+		m_bRewrite = true;
+
+	if( m_bRewrite )
+		Rewrite();
+	else
+		AppendPendingEntries();
+}
+
+void SongCacheBlob::AppendPendingEntries()
+{
+	if( m_sPendingEntries.empty() )
+	{
+		m_bDirty = false;
+		return;
+	}
+
+	// A crash part way through only damages the last entry, which is
+	// dropped when the blob is next read.
+	RageFile f;
+	if( !f.Open(SONG_CACHE_BLOB, RageFile::WRITE|RageFile::STREAMED|RageFile::APPEND) )
+	{
+		LOG->Warn( "Couldn't open %s for writing: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		return;
+	}
+	if( f.Write(m_sPendingEntries) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Error writing %s: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		// We don't know how much made it, so start over next time.
+		m_bRewrite = true;
+		return;
+	}
+	m_sPendingEntries = RString();
+	m_bDirty = false;
+}
+
+void SongCacheBlob::Rewrite()
+{
+	RString sData;
+	BlobWriter w( sData );
+	w.Bytes( BLOB_MAGIC, sizeof(BLOB_MAGIC) );
+	w.U32( BLOB_VERSION );
+	w.U32( FILE_CACHE_VERSION );
+	for (std::pair<RString const, RString> const &rec : m_mapRecords)
+		AppendEntry( sData, rec.first, rec.second );
+
+	// RageFileDriverDirect writes to a temporary file and renames it on
+	// close, so a crash never leaves a half written blob behind.
+	RageFile f;
+	if( !f.Open(SONG_CACHE_BLOB, RageFile::WRITE) )
+	{
+		LOG->Warn( "Couldn't open %s for writing: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		return;
+	}
+	f.EnableCRC32();
+	if( f.Write(sData) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Error writing %s: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		return;
+	}
+
+	uint32_t iCRC;
+	f.GetCRC32( &iCRC );
+	const int iSize = f.Tell();
+	f.Close();
+
+	// If the rename on close failed, the old blob is still there.
+	if( !FileHasContents(SONG_CACHE_BLOB, iSize, iCRC) )
+	{
+		LOG->Warn( "Couldn't replace %s", f.GetRealPath().c_str() );
+		return;
+	}
+	m_sPendingEntries = RString();
+	m_iEntriesOnDisk = m_mapRecords.size();
+	m_bRewrite = false;
+	m_bDirty = false;
+}
+
+void SongCacheBlob::Clear()
+{
+	LockMut( g_BlobMutex );
+	m_mapRecords.clear();
+	m_sPendingEntries = RString();
+	m_iEntriesOnDisk = 0;
+	m_bRewrite = true;
+	m_bDirty = false;
+	FILEMAN->Remove( SONG_CACHE_BLOB );
+}
+
+bool SongCacheBlob::HasSong( const RString &sSongDir ) const
+{
+	LockMut( g_BlobMutex );
+	return m_mapRecords.find( sSongDir ) != m_mapRecords.end();
+}
+
+bool SongCacheBlob::LoadSong( Song &out )
+{
+	RString sRecord;
+	{
+		LockMut( g_BlobMutex );
+		std::map<RString, RString>::const_iterator it = m_mapRecords.find( out.GetSongDir() );
+		if( it == m_mapRecords.end() )
+			return false;
+		sRecord = it->second;
+	}
+
+	// Read into a copy, so a bad record leaves the song as it was.  The
+	// record doesn't hold what Song::LoadFromSongDir set before looking in
+	// the cache, so carry that over.
+	Song song;
+	song.SetSongDir( out.GetSongDir() );
+	song.m_sGroupName = out.m_sGroupName;
+	song.m_LoadedFromProfile = out.m_LoadedFromProfile;
+	if( !ReadRecord(sRecord, song) )
+	{
+		LOG->Warn( "Cache record for \"%s\" is damaged or out of date; reloading the song.", out.GetSongDir().c_str() );
+		RemoveSong( out.GetSongDir() );
+		return false;
+	}
+
+	// Hand the Steps over to out, as Song::ReloadFromSongDir does.
+	out = song;
+	for (Steps *pSteps : out.GetAllSteps())
+		pSteps->m_pSong = &out;
+	for (Steps *pSteps : out.GetUnknownStyleSteps())
+		pSteps->m_pSong = &out;
+	song.DetachSteps();
+	return true;
+}
+
+void SongCacheBlob::SaveSong( const Song &song )
+{
+	const RString sRecord = MakeRecord( song );
+
+	LockMut( g_BlobMutex );
+	m_mapRecords[song.GetSongDir()] = sRecord;
+	AppendEntry( m_sPendingEntries, song.GetSongDir(), sRecord );
+	++m_iEntriesOnDisk;
+	m_bDirty = true;
+}
+
+void SongCacheBlob::SaveChartKeys( const Song &song )
+{
+	LockMut( g_BlobMutex );
+	std::map<RString, RString>::iterator it = m_mapRecords.find( song.GetSongDir() );
+	if( it == m_mapRecords.end() )
+		return;
+
+	Song cached;
+	cached.SetSongDir( song.GetSongDir() );
+	if( !ReadRecord(it->second, cached) )
+		return;
+
+	bool bChanged = false;
+	for (Steps *pCached : cached.GetAllSteps())
+	{
+		if( pCached->HasChartKey() )
+			continue;
+		const Steps *pSteps = SongUtil::GetSameSteps( &song, pCached );
+		if( pSteps == nullptr || !pSteps->HasChartKey() )
+			continue;
+		pCached->SetChartKey( pSteps->ChartKey );
+		bChanged = true;
+	}
+	if( !bChanged )
+		return;
+
+	it->second = MakeRecord( cached );
+	AppendEntry( m_sPendingEntries, it->first, it->second );
+	++m_iEntriesOnDisk;
+	m_bDirty = true;
+}
+
+void SongCacheBlob::RemoveSong( const RString &sSongDir )
+{
+	LockMut( g_BlobMutex );
+	if( !m_mapRecords.erase(sSongDir) )
+		return;
+	AppendEntry( m_sPendingEntries, sSongDir, RString() );
+	++m_iEntriesOnDisk;
+	m_bDirty = true;
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
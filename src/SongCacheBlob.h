@@ -0,0 +1,92 @@
+#ifndef SONG_CACHE_BLOB_H
+#define SONG_CACHE_BLOB_H
+
+#include <map>
+
+class Song;
+
+/**
+ * @brief A single binary file holding the cached data of every song.
+ *
+ * This replaces the per-song .ssc files that used to live in Cache/Songs.
+ * The whole file is read into memory with one read at startup, and songs
+ * are rebuilt from their record directly, without going through MsdFile and
+ * the SSC loader.  On disk it's a log, like the cache index: saved records
+ * are appended, and the whole file is only rewritten when most of it is out
+ * of date.  Like the old cache files, only the data needed to show the
+ * song is stored; note data is still read from the simfile on demand.
+ *
+ * Whether a record is up to date is decided by SongCacheIndex, which keeps
+ * the directory hashes. */
+class SongCacheBlob
+{
+public:
+	SongCacheBlob();
+
+	/** @brief Read the blob from disk, discarding it if it's from another version. */
+	void ReadFromDisk();
+	/** @brief Write the records saved since the last write to disk. */
+	void WriteToDisk();
+	/** @brief Forget every record and delete the file. */
+	void Clear();
+
+	bool HasSong( const RString &sSongDir ) const;
+	/**
+	 * @brief Fill in a song from its cached record.
+	 * @param out the Song, which must be empty apart from its song dir and
+	 * group; those are kept.
+	 * @return false if there was no usable record, in which case the song
+	 * wasn't touched and must be loaded from its simfile. */
+	bool LoadSong( Song &out );
+	void SaveSong( const Song &song );
+	/**
+	 * @brief Copy the chart keys of a song into its record, if it has one.
+	 *
+	 * Nothing else in the record changes, so keys made from a song that's
+	 * being edited don't bring the unsaved edits into the cache. */
+	void SaveChartKeys( const Song &song );
+	void RemoveSong( const RString &sSongDir );
+
+	bool IsDirty() const { return m_bDirty; }
+
+private:
+	void AppendPendingEntries();
+	void Rewrite();
+
+	/** @brief Song dir -> serialized song. */
+	std::map<RString, RString> m_mapRecords;
+	/** @brief Entries saved since the blob was last written, ready to append. */
+	RString m_sPendingEntries;
+	/** @brief How many entries the log holds, counting replaced ones and pending ones. */
+	unsigned m_iEntriesOnDisk;
+	/** @brief The file on disk can't be appended to, and must be rewritten. */
+	bool m_bRewrite;
+	bool m_bDirty;
+};
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
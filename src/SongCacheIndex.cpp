@@ -7,29 +7,44 @@
 #include "Song.h"
 #include "SpecialFiles.h"
 #include "CommonMetrics.h"
+#include "RageThreads.h"
+#include "RageFile.h"
+
+#include <cstring>
 
 /*
- * A quick explanation of song cache hashes: Each song has two hashes; a hash of the
- * song path, and a hash of the song directory.  The former is Song::GetCacheFilePath;
- * it stays the same if the contents of the directory change.  The latter is 
- * GetHashForDirectory(m_sSongDir), and changes on each modification.
- *
- * The file hash is used as the cache filename.  We don't want to use the directory
- * hash: if we do that, then we'll write a new cache file every time the song changes,
- * and they'll accumulate or we'll have to be careful to delete them.
+ * A quick explanation of song cache hashes: Each song is cached under its song
+ * path, which stays the same if the contents of the directory change, and has a
+ * hash of the song directory, GetHashForDirectory(m_sSongDir), which changes on
+ * each modification.  (Courses and images still use GetCacheFilePath, a hash of
+ * the path, as their cache filename.)
  *
- * The directory hash is stored in here, indexed by the song path, and used to determine
- * if a song has changed.
+ * The songs themselves live in SongBlob.  The directory hash is stored in here,
+ * indexed by the song path, and used to determine if a song has changed.
  *
  * Another advantage of this system is that we can load songs from cache given only their
  * path; we don't have to actually look in the directory (to find out the directory hash)
- * in order to find the cache file.
+ * in order to find the cache entry.
  */
 #define CACHE_INDEX SpecialFiles::CACHE_DIR + "index.cache"
 
+/* Layout of the index file:
+ *
+ *   "SMCI" <uint32 INDEX_VERSION> <uint32 FILE_CACHE_VERSION>
+ *   any number of entries: <uint32 dir hash> <uint32 length> <song dir> <uint32 CRC>
+ *
+ * A later entry for the same song dir replaces an earlier one.  The CRC covers
+ * the rest of the entry, so an entry cut short by a crash while appending is
+ * noticed and dropped, along with anything after it. */
+static const char INDEX_MAGIC[4] = { 'S', 'M', 'C', 'I' };
+/** @brief Bump this when the layout of the index file changes. */
+static const uint32_t INDEX_VERSION = 1;
 
 SongCacheIndex *SONGINDEX; // global and accessible from anywhere in our program
 
+/* Song loader threads look up and add entries concurrently. */
+static RageMutex g_CacheIndexMutex( "SongCacheIndex" );
+
 RString SongCacheIndex::GetCacheFilePath( const RString &sGroup, const RString &sPath )
 {
 	/* Don't use GetHashForFile, since we don't want to spend time
@@ -54,14 +69,17 @@ RString SongCacheIndex::GetCacheFilePath( const RString &sGroup, const RString &
 	return ssprintf( "%s%s/%s", SpecialFiles::CACHE_DIR.c_str(), sGroup.c_str(), s.c_str() );
 }
 
-SongCacheIndex::SongCacheIndex()
+SongCacheIndex::SongCacheIndex():
+	m_iEntriesOnDisk(0), m_bRewriteIndex(false), delay_save_cache(false)
 {
 	ReadCacheIndex();
 }
 
 SongCacheIndex::~SongCacheIndex()
 {
-
+	// Records updated after loading, like new chart keys, are only written here.
+	if( SongBlob.IsDirty() )
+		SongBlob.WriteToDisk();
 }
 
 void SongCacheIndex::ReadFromDisk()
@@ -82,26 +100,99 @@ static void EmptyDir( RString dir )
 	}
 }
 
+static void AppendU32( RString &sOut, uint32_t i )
+{
+	sOut.append( reinterpret_cast<const char *>(&i), sizeof(i) );
+}
+
+static bool ReadU32( const RString &sData, size_t &iPos, uint32_t &iOut )
+{
+	if( sData.size() - iPos < sizeof(iOut) )
+		return false;
+	memcpy( &iOut, sData.data() + iPos, sizeof(iOut) );
+	iPos += sizeof(iOut);
+	return true;
+}
+
+static void AppendEntry( RString &sOut, const RString &sPath, unsigned iHash )
+{
+	RString sEntry;
+	AppendU32( sEntry, iHash );
+	AppendU32( sEntry, sPath.size() );
+	sEntry += sPath;
+	AppendU32( sEntry, GetHashForString(sEntry) );
+	sOut += sEntry;
+}
+
 void SongCacheIndex::ReadCacheIndex()
 {
-	CacheIndex.ReadFile( CACHE_INDEX );	// don't care if this fails
+	LockMut( g_CacheIndexMutex );
+	m_mapDirHashes.clear();
+	m_sPendingEntries = RString();
+	m_iEntriesOnDisk = 0;
+	m_bRewriteIndex = false;
 
-	int iCacheVersion = -1;
-	CacheIndex.GetValue( "Cache", "CacheVersion", iCacheVersion );
-	if( iCacheVersion == FILE_CACHE_VERSION )
+	RString sData;
+	RageFile f;
+	if( f.Open(CACHE_INDEX) )	// don't care if this fails
+	{
+		if( f.Read(sData, f.GetFileSize()) != f.GetFileSize() )
+			sData = RString();
+		f.Close();
+	}
+
+	size_t iPos = 0;
+	uint32_t iIndexVersion = 0, iCacheVersion = 0;
+	if( sData.size() >= sizeof(INDEX_MAGIC) && !memcmp(sData.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) )
+	{
+		iPos = sizeof(INDEX_MAGIC);
+		ReadU32( sData, iPos, iIndexVersion );
+		ReadU32( sData, iPos, iCacheVersion );
+	}
+
+	if( iIndexVersion == INDEX_VERSION && iCacheVersion == uint32_t(FILE_CACHE_VERSION) )
+	{
+		while( iPos < sData.size() )
+		{
+			const size_t iStart = iPos;
+			uint32_t iHash, iSize, iCRC;
+			if( !ReadU32(sData, iPos, iHash) || !ReadU32(sData, iPos, iSize) ||
+				sData.size() - iPos < iSize )
+				break;
+			iPos += iSize;
+			if( !ReadU32(sData, iPos, iCRC) ||
+				iCRC != GetHashForString(sData.substr(iStart, iPos - sizeof(iCRC) - iStart)) )
+				break;
+
+			m_mapDirHashes[sData.substr(iStart + 2*sizeof(uint32_t), iSize)] = iHash;
+			++m_iEntriesOnDisk;
+		}
+
+		if( iPos < sData.size() )
+		{
+			// Most likely a crash while appending.  Whatever came before the
+			// bad entry is fine, but nothing can be appended after it.
+			LOG->Warn( "Song cache index is damaged after %u entries; the rest will be rebuilt.", m_iEntriesOnDisk );
+			m_bRewriteIndex = true;
+		}
+
+		SongBlob.ReadFromDisk();
 		return; // OK
+	}
 
 	LOG->Trace( "Cache format is out of date.  Deleting all cache files." );
 	EmptyDir( SpecialFiles::CACHE_DIR );
 	EmptyDir( SpecialFiles::CACHE_DIR+"Songs/" );
 	EmptyDir( SpecialFiles::CACHE_DIR+"Courses/" );
+	EmptyDir( SpecialFiles::CACHE_DIR+"Analysis/" );
 	
 	vector<RString> ImageDir;
 	split( CommonMetrics::IMAGES_TO_CACHE, ",", ImageDir );
 	for( unsigned c=0; c<ImageDir.size(); c++ )
 		EmptyDir( SpecialFiles::CACHE_DIR+ImageDir[c]+"/" );
 
-	CacheIndex.Clear();
+	m_bRewriteIndex = true;
+	SongBlob.Clear();
 	/* This is right now in place because our song file paths are apparently being
 	 * cached in two distinct areas, and songs were loading from paths in FILEMAN.
 	 * This is admittedly a hack for now, but this does bring up a good question on
@@ -110,39 +201,132 @@ void SongCacheIndex::ReadCacheIndex()
 	FILEMAN->FlushDirCache();
 }
 
+void SongCacheIndex::AppendPendingEntries()
+{
+	if( m_bRewriteIndex )
+	{
+		RewriteIndex();
+		return;
+	}
+	if( m_sPendingEntries.empty() )
+		return;
+
+	// A crash part way through only damages the last entry, which is
+	// dropped when the index is next read.
+	RageFile f;
+	if( !f.Open(CACHE_INDEX, RageFile::WRITE|RageFile::STREAMED|RageFile::APPEND) )
+	{
+		LOG->Warn( "Couldn't open %s for writing: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		return;
+	}
+	if( f.Write(m_sPendingEntries) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Error writing %s: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		// We don't know how much made it, so start over next time.
+		m_bRewriteIndex = true;
+		return;
+	}
+	m_sPendingEntries = RString();
+}
+
+void SongCacheIndex::RewriteIndex()
+{
+	RString sData;
+	sData.append( INDEX_MAGIC, sizeof(INDEX_MAGIC) );
+	AppendU32( sData, INDEX_VERSION );
+	AppendU32( sData, FILE_CACHE_VERSION );
+	for (std::pair<std::string const, unsigned> const &entry : m_mapDirHashes)
+		AppendEntry( sData, entry.first, entry.second );
+
+	// A safe write goes to a temporary file that's renamed over the index on
+	// close, so a crash leaves either the old index or the new one.
+	RageFile f;
+	if( !f.Open(CACHE_INDEX, RageFile::WRITE) )
+	{
+		LOG->Warn( "Couldn't open %s for writing: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		return;
+	}
+	f.EnableCRC32();
+	if( f.Write(sData) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Error writing %s: %s", f.GetPath().c_str(), f.GetError().c_str() );
+		return;
+	}
+
+	uint32_t iCRC;
+	f.GetCRC32( &iCRC );
+	const int iSize = f.Tell();
+	f.Close();
+
+	// The rename happens in Close, which can't fail, so check that it did.
+	// If not, the old index is still there; try again on the next save.
+	if( !FileHasContents(CACHE_INDEX, iSize, iCRC) )
+	{
+		LOG->Warn( "Couldn't replace %s", f.GetRealPath().c_str() );
+		return;
+	}
+	m_sPendingEntries = RString();
+	m_iEntriesOnDisk = m_mapDirHashes.size();
+	m_bRewriteIndex = false;
+}
+
 void SongCacheIndex::SaveCacheIndex()
 {
-	CacheIndex.WriteFile(CACHE_INDEX);
+	LockMut( g_CacheIndexMutex );
+	// Write the songs first, so the index never vouches for a record that
+	// didn't make it to disk.
+	if( SongBlob.IsDirty() )
+		SongBlob.WriteToDisk();
+
+	// Once most of the log is replaced entries, compact it.
+	if( m_iEntriesOnDisk > 2 * m_mapDirHashes.size() + 64 )
+		m_bRewriteIndex = true;
+	AppendPendingEntries();
 }
 
 void SongCacheIndex::AddCacheIndex(const RString &path, unsigned hash)
 {
 	if( hash == 0 )
 		++hash; /* no 0 hash values */
-	CacheIndex.SetValue( "Cache", "CacheVersion", FILE_CACHE_VERSION );
-	CacheIndex.SetValue( "Cache", MangleName(path), hash );
+	LockMut( g_CacheIndexMutex );
+	std::unordered_map<std::string, unsigned>::iterator it = m_mapDirHashes.find( path );
+	if( it != m_mapDirHashes.end() && it->second == hash )
+		return;
+	m_mapDirHashes[path] = hash;
+	AppendEntry( m_sPendingEntries, path, hash );
+	++m_iEntriesOnDisk;
 	if(!delay_save_cache)
 	{
-		CacheIndex.WriteFile(CACHE_INDEX);
+		AppendPendingEntries();
 	}
 }
 
-unsigned SongCacheIndex::GetCacheHash( const RString &path ) const
+void SongCacheIndex::SaveSongToCache( const Song &song )
 {
-	unsigned iDirHash = 0;
-	if( !CacheIndex.GetValue( "Cache", MangleName(path), iDirHash ) )
-		return 0;
-	if( iDirHash == 0 )
-		++iDirHash; /* no 0 hash values */
-	return iDirHash;
+	SongBlob.SaveSong( song );
+	if( !delay_save_cache )
+		SongBlob.WriteToDisk();
+}
+
+void SongCacheIndex::SaveChartKeysToCache( const Song &song )
+{
+	SongBlob.SaveChartKeys( song );
 }
 
-RString SongCacheIndex::MangleName( const RString &Name )
+void SongCacheIndex::RemoveSongFromCache( const RString &sSongDir )
 {
-	/* We store paths in an INI.  We can't store '='. */
-	RString ret = Name;
-	ret.Replace( "=", "");
-	return ret;
+	SongBlob.RemoveSong( sSongDir );
+	if( !delay_save_cache && SongBlob.IsDirty() )
+		SongBlob.WriteToDisk();
+}
+
+unsigned SongCacheIndex::GetCacheHash( const RString &path ) const
+{
+	LockMut( g_CacheIndexMutex );
+	std::unordered_map<std::string, unsigned>::const_iterator it = m_mapDirHashes.find( path );
+	if( it == m_mapDirHashes.end() )
+		return 0;
+	return it->second;
 }
 
 /*
@@ -1,12 +1,31 @@
 #ifndef SONG_CACHE_INDEX_H
 #define SONG_CACHE_INDEX_H
 
-#include "IniFile.h"
+#include "SongCacheBlob.h"
 
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Maps each cached song directory to the hash of its contents.
+ *
+ * The index is kept in memory as a hash table.  On disk it's a log of
+ * entries: new and changed entries are appended to the end of the file, and
+ * the whole file is only rewritten when most of it is out of date. */
 class SongCacheIndex
 {
-	IniFile CacheIndex;
-	static RString MangleName( const RString &Name );
+	/** @brief Song dir -> directory hash. */
+	std::unordered_map<std::string, unsigned> m_mapDirHashes;
+	/** @brief Entries added since the index was last written, ready to append. */
+	RString m_sPendingEntries;
+	/** @brief How many entries the log holds, counting replaced ones and pending ones. */
+	unsigned m_iEntriesOnDisk;
+	/** @brief The file on disk can't be appended to, and must be rewritten. */
+	bool m_bRewriteIndex;
+	SongCacheBlob SongBlob;
+
+	void AppendPendingEntries();
+	void RewriteIndex();
 
 public:
 	SongCacheIndex();
@@ -18,6 +37,15 @@ public:
 	void SaveCacheIndex();
 	void AddCacheIndex( const RString &path, unsigned hash );
 	unsigned GetCacheHash( const RString &path ) const;
+
+	/** @brief Does the cache hold a record for the song in this directory? */
+	bool HasCachedSong( const RString &sSongDir ) const { return SongBlob.HasSong( sSongDir ); }
+	bool LoadSongFromCache( Song &out ) { return SongBlob.LoadSong( out ); }
+	void SaveSongToCache( const Song &song );
+	/** @brief Keep newly made chart keys in the record of a song that's
+	 * already cached.  It's written with the rest of the cache. */
+	void SaveChartKeysToCache( const Song &song );
+	void RemoveSongFromCache( const RString &sSongDir );
 	bool delay_save_cache;
 };
 
@@ -37,7 +37,10 @@
 #include "TrailUtil.h"
 #include "UnlockManager.h"
 #include "SpecialFiles.h"
+#include "RageThreads.h"
 
+#include <atomic>
+#include <thread>
 #include <tuple>
 
 SongManager*	SONGMAN = nullptr;	// global and accessible from anywhere in our program
@@ -56,6 +59,9 @@ static const ThemeMetric<int>		EXTRA_STAGE2_DIFFICULTY_MAX	( "SongManager", "Ext
 
 static Preference<RString> g_sDisabledSongs( "DisabledSongs", "" );
 static Preference<bool> g_bHideIncompleteCourses( "HideIncompleteCourses", false );
+/* Number of threads used to load songs at startup.  1 loads songs on the
+ * main thread, as before; 0 uses one thread per CPU. */
+static Preference<int> g_iSongLoadThreads( "SongLoadThreads", 1 );
 
 RString SONG_GROUP_COLOR_NAME( size_t i )   { return ssprintf( "SongGroupColor%i", (int) i+1 ); }
 RString COURSE_GROUP_COLOR_NAME( size_t i ) { return ssprintf( "CourseGroupColor%i", (int) i+1 ); }
@@ -63,7 +69,7 @@ RString profile_song_group_color_name(size_t i) { return ssprintf("ProfileSongGr
 
 static const float next_loading_window_update= 0.02f;
 
-SongManager::SongManager()
+SongManager::SongManager(): m_pChartKeyJob(nullptr)
 {
 	// Register with Lua.
 	{
@@ -93,7 +99,7 @@ SongManager::~SongManager()
 	FreeSongs();
 }
 
-void SongManager::InitAll( LoadingWindow *ld, bool onlyAdditions )
+void SongManager::InitAll( LoadingWindow *ld, bool onlyAdditions, const set<RString> *pOnlyGroups )
 {
 	vector<RString> never_cache;
 	split(PREFSMAN->m_NeverCacheList, ",", never_cache);
@@ -102,7 +108,7 @@ void SongManager::InitAll( LoadingWindow *ld, bool onlyAdditions )
 	{
 		m_GroupsToNeverCache.insert(*group);
 	}
-	InitSongsFromDisk( ld, onlyAdditions );
+	InitSongsFromDisk( ld, onlyAdditions, pOnlyGroups );
 	InitCoursesFromDisk( ld, onlyAdditions );
 	if (onlyAdditions)
 	{
@@ -208,25 +214,61 @@ void SongManager::Reload( LoadingWindow *ld )
 
 void SongManager::LoadAdditions( LoadingWindow *ld )
 {
-	FILEMAN->FlushDirCache( SpecialFiles::SONGS_DIR );
+	/* If the change journal knows what changed under Songs since the last
+	 * load, only the groups that changed need to be looked at, and the journal
+	 * has already flushed their listings.  Otherwise, rescan everything. */
+	vector<RString> asChangedDirs;
+	const bool bKnowChanges = FILEMAN->ReadChangeJournal( SpecialFiles::SONGS_DIR, asChangedDirs );
+	set<RString> changedGroups;
+	if( bKnowChanges )
+	{
+		for( RString const &sChangedDir : asChangedDirs )
+		{
+			// "/Songs/Group/Song/" -> "Group", "Song"
+			vector<RString> asParts;
+			split( sChangedDir, "/", asParts );
+			if( asParts.size() < 2 )
+				continue;
+			RString sGroup = asParts[1];
+			sGroup.MakeLower();
+			changedGroups.insert( sGroup );
+
+			/* Songs that are already loaded aren't reloaded here, but their
+			 * cache entries are stale. */
+			if( asParts.size() < 3 )
+				continue;
+			Song *pSong = GetSongFromDir( "/" + asParts[0] + "/" + asParts[1] + "/" + asParts[2] + "/" );
+			if( pSong != nullptr )
+				SONGINDEX->RemoveSongFromCache( pSong->GetSongDir() );
+		}
+		LOG->Trace( "LoadAdditions: %i changed directories in %i groups.",
+			(int) asChangedDirs.size(), (int) changedGroups.size() );
+	}
+	else
+	{
+		FILEMAN->FlushDirCache( SpecialFiles::SONGS_DIR );
+	}
 	FILEMAN->FlushDirCache( SpecialFiles::COURSES_DIR );
 	FILEMAN->FlushDirCache( EDIT_SUBDIR );
 
-	InitAll( ld, /*onlyAdditions=*/true );
+	InitAll( ld, /*onlyAdditions=*/true, bKnowChanges? &changedGroups:nullptr );
 
 	UNLOCKMAN->Reload();
 
 	UpdatePreferredSort();
 }
 
-void SongManager::InitSongsFromDisk( LoadingWindow *ld, bool onlyAdditions )
+void SongManager::InitSongsFromDisk( LoadingWindow *ld, bool onlyAdditions, const set<RString> *pOnlyGroups )
 {
 	RageTimer tm;
+	// Record changes from here on, so LoadAdditions can look at only those.
+	if( !onlyAdditions )
+		FILEMAN->StartChangeJournal( SpecialFiles::SONGS_DIR, 2 );
 	// Tell SONGINDEX to not write the cache index file every time a song adds
 	// an entry. -Kyz
 	SONGINDEX->delay_save_cache = true;
 	IMAGECACHE->delay_save_cache = true;
-	LoadSongDir( SpecialFiles::SONGS_DIR, ld, onlyAdditions );
+	LoadSongDir( SpecialFiles::SONGS_DIR, ld, onlyAdditions, pOnlyGroups );
 	LoadEnabledSongsFromPref();
 	SONGINDEX->SaveCacheIndex();
 	SONGINDEX->delay_save_cache = false;
@@ -329,7 +371,129 @@ void SongManager::AddGroup( RString sDir, RString sGroupDirName )
 }
 
 static LocalizedString LOADING_SONGS ( "SongManager", "Loading songs..." );
-void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditions )
+namespace
+{
+	/** @brief A song directory waiting to be loaded, and the result. */
+	struct SongLoadJob
+	{
+		SongLoadJob( const RString &sDir ): m_sSongDir(sDir), m_pSong(nullptr) { }
+		RString m_sSongDir;
+		/** @brief The loaded song, or nullptr if it failed to load. */
+		Song *m_pSong;
+	};
+
+	/** @brief Work shared between the song loader threads. */
+	struct SongLoadQueue
+	{
+		SongLoadQueue( vector<SongLoadJob> &jobs ): m_Jobs(jobs), m_iNextJob(0), m_iFinished(0) { }
+		vector<SongLoadJob> &m_Jobs;
+		std::atomic<size_t> m_iNextJob;
+		std::atomic<int> m_iFinished;
+	};
+
+	void LoadSongJob( SongLoadJob &job )
+	{
+		Song* pNewSong = new Song;
+		if( !pNewSong->LoadFromSongDir( job.m_sSongDir ) )
+		{
+			// The song failed to load.
+			delete pNewSong;
+			return;
+		}
+		job.m_pSong = pNewSong;
+	}
+
+	int SongLoadThread( void *p )
+	{
+		SongLoadQueue &queue = *static_cast<SongLoadQueue *>( p );
+		for(;;)
+		{
+			const size_t iJob = queue.m_iNextJob++;
+			if( iJob >= queue.m_Jobs.size() )
+				return 0;
+			LoadSongJob( queue.m_Jobs[iJob] );
+			++queue.m_iFinished;
+		}
+	}
+
+	int GetNumSongLoadThreads( size_t iJobs )
+	{
+		int iThreads = g_iSongLoadThreads;
+		if( iThreads <= 0 )
+			iThreads = max( 1, (int) std::thread::hardware_concurrency() );
+		return min( iThreads, (int) iJobs );
+	}
+}
+
+/** @brief Songs whose chart keys are being made in the background.
+ *
+ * The songs keep being used while the workers run, so the workers never touch
+ * them.  Each song is read back from the cache into a copy, and the keys are
+ * made from that; Update gives the keys to the songs on the main thread.
+ * Songs that aren't cached are skipped.  A song's Steps share notes with each
+ * other (autogen), so each song is one job. */
+struct ChartKeyJob
+{
+	ChartKeyJob( const vector<Song*> &songs ): m_Songs(songs), m_Copies(songs.size()),
+		m_iNextSong(0), m_iThreadsRunning(0)
+	{
+		for (Song const *pSong : songs)
+			m_SongDirs.push_back( pSong->GetSongDir() );
+	}
+	~ChartKeyJob()
+	{
+		for (Song *pCopy : m_Copies)
+			delete pCopy;
+	}
+
+	/** @brief Only used on the main thread. */
+	vector<Song*> m_Songs;
+	vector<RString> m_SongDirs;
+	/** @brief m_Copies[i] is the cached copy of m_Songs[i] with its new keys,
+	 * or nullptr if no keys were made for it. */
+	vector<Song*> m_Copies;
+	std::atomic<size_t> m_iNextSong;
+	std::atomic<int> m_iThreadsRunning;
+	vector<RageThread *> m_apThreads;
+	RageTimer m_Timer;
+};
+
+static int ChartKeyThread( void *p )
+{
+	ChartKeyJob &job = *static_cast<ChartKeyJob *>( p );
+	for(;;)
+	{
+		const size_t iSong = job.m_iNextSong++;
+		if( iSong >= job.m_SongDirs.size() )
+			break;
+
+		Song *pCopy = new Song;
+		pCopy->SetSongDir( job.m_SongDirs[iSong] );
+		bool bMadeKeys = false;
+		if( SONGINDEX->LoadSongFromCache(*pCopy) )
+		{
+			// The copy has no autogen Steps, which aren't cached anyway.
+			for (Steps *pSteps : pCopy->GetAllSteps())
+			{
+				if( pSteps->HasChartKey() )
+					continue;
+				pSteps->GenerateChartKey();
+				bMadeKeys = true;
+			}
+		}
+		if( !bMadeKeys )
+		{
+			delete pCopy;
+			continue;
+		}
+		SONGINDEX->SaveChartKeysToCache( *pCopy );
+		job.m_Copies[iSong] = pCopy;
+	}
+	--job.m_iThreadsRunning;
+	return 0;
+}
+
+void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditions, const set<RString> *pOnlyGroups )
 {
 	if( ld )
 		ld->SetText( LOADING_SONGS );
@@ -350,12 +514,24 @@ void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditio
 	SortRStringArray( arrayGroupDirs );
 	StripCvsAndSvn( arrayGroupDirs );
 	StripMacResourceForks( arrayGroupDirs );
+	if( pOnlyGroups != nullptr )
+	{
+		vector<RString> arrayWanted;
+		for( RString const &sGroupDirName : arrayGroupDirs )
+		{
+			RString sLower = sGroupDirName;
+			sLower.MakeLower();
+			if( pOnlyGroups->find(sLower) != pOnlyGroups->end() )
+				arrayWanted.push_back( sGroupDirName );
+		}
+		arrayGroupDirs.swap( arrayWanted );
+	}
 
-	vector< vector<RString> > arrayGroupSongDirs;
-	int groupIndex, songCount, songIndex;
+	/* Every song to load, in group/song order.  arrayGroupFirstJob[i] is the
+	 * index of the first job belonging to arrayGroupDirs[i]. */
+	vector<SongLoadJob> jobs;
+	vector<size_t> arrayGroupFirstJob;
 
-	groupIndex = 0;
-	songCount = 0;
 	if(ld)
 	{
 		ld->SetIndeterminate(false);
@@ -381,34 +557,9 @@ void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditio
 		StripMacResourceForks( arraySongDirs );
 		SortRStringArray( arraySongDirs );
 
-		arrayGroupSongDirs.push_back(arraySongDirs);
-		songCount += arraySongDirs.size();
-
-	}
-
-	if( songCount==0 ) return;
-
-	if( ld ) {
-		ld->SetIndeterminate( false );
-		ld->SetTotalWork( songCount );
-	}
-
-	groupIndex = 0;
-	songIndex = 0;
-	for (RString const &sGroupDirName : arrayGroupDirs)	// foreach dir in /Songs/
-	{
-		vector<RString> &arraySongDirs = arrayGroupSongDirs[groupIndex++];
-
-		LOG->Trace("Attempting to load %i songs from \"%s\"", int(arraySongDirs.size()),
-				   (sDir+sGroupDirName).c_str() );
-		int loaded = 0;
-
-		SongPointerVector& index_entry = m_mapSongGroupIndex[sGroupDirName];
-		RString group_base_name= Basename(sGroupDirName);
-		for( unsigned j=0; j< arraySongDirs.size(); ++j )	// for each song dir
+		arrayGroupFirstJob.push_back( jobs.size() );
+		for (RString const &sSongDirName : arraySongDirs)
 		{
-			RString sSongDirName = arraySongDirs[j];
-
 			// Skip already loaded songs if onlyAdditions is set.
 			if (onlyAdditions)
 			{
@@ -417,32 +568,99 @@ void SongManager::LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditio
 				if (songID.ToSong() != nullptr)
 					continue;
 			}
+			jobs.push_back( SongLoadJob(sSongDirName) );
+		}
+	}
+	arrayGroupFirstJob.push_back( jobs.size() );
+
+	if( jobs.empty() ) return;
+
+	if( ld ) {
+		ld->SetIndeterminate( false );
+		ld->SetTotalWork( jobs.size() );
+	}
+
+	const int iThreads = GetNumSongLoadThreads( jobs.size() );
+	if( iThreads == 1 )
+	{
+		int groupIndex = 0;
+		for( size_t j=0; j<jobs.size(); ++j )	// for each song dir
+		{
+			while( arrayGroupFirstJob[groupIndex+1] <= j )
+				++groupIndex;
 
 			// this is a song directory. Load a new song.
 			if(ld && loading_window_last_update_time.Ago() > next_loading_window_update)
 			{
 				loading_window_last_update_time.Touch();
-				ld->SetProgress(songIndex);
+				ld->SetProgress(j);
 				ld->SetText( LOADING_SONGS.GetValue() +
 					ssprintf("\n%s\n%s",
-						group_base_name.c_str(),
-						Basename(sSongDirName).c_str()
+						Basename(arrayGroupDirs[groupIndex]).c_str(),
+						Basename(jobs[j].m_sSongDir).c_str()
 					)
 				);
 			}
 
-			Song* pNewSong = new Song;
-			if( !pNewSong->LoadFromSongDir( sSongDirName ) )
+			LoadSongJob( jobs[j] );
+		}
+	}
+	else
+	{
+		LOG->Trace( "Loading %i songs with %i threads", int(jobs.size()), iThreads );
+
+		SongLoadQueue queue( jobs );
+		vector<RageThread *> apThreads;
+		for( int i = 0; i < iThreads; ++i )
+		{
+			RageThread *pThread = new RageThread;
+			pThread->SetName( ssprintf("Song loader %i", i) );
+			pThread->Create( SongLoadThread, &queue );
+			apThreads.push_back( pThread );
+		}
+
+		// Workers only report a count, so aggregate their progress here.
+		while( queue.m_iFinished < (int) jobs.size() )
+		{
+			if(ld && loading_window_last_update_time.Ago() > next_loading_window_update)
 			{
-				// The song failed to load.
-				delete pNewSong;
-				continue;
+				loading_window_last_update_time.Touch();
+				ld->SetProgress(queue.m_iFinished);
+				ld->SetText( LOADING_SONGS.GetValue() +
+					ssprintf("\n%i/%i", int(queue.m_iFinished), int(jobs.size())) );
 			}
+			usleep( 10000 );
+		}
+
+		for (RageThread *pThread : apThreads)
+		{
+			pThread->Wait();
+			delete pThread;
+		}
+	}
+
+	// Add the results in group/song order, so the result doesn't depend on
+	// which thread finished first.
+	for( size_t groupIndex = 0; groupIndex < arrayGroupDirs.size(); ++groupIndex )	// foreach dir in /Songs/
+	{
+		RString const &sGroupDirName = arrayGroupDirs[groupIndex];
+		const size_t iFirstJob = arrayGroupFirstJob[groupIndex];
+		const size_t iLastJob = arrayGroupFirstJob[groupIndex+1];
+
+		LOG->Trace("Attempting to load %i songs from \"%s\"", int(iLastJob - iFirstJob),
+				   (sDir+sGroupDirName).c_str() );
+		int loaded = 0;
+
+		SongPointerVector& index_entry = m_mapSongGroupIndex[sGroupDirName];
+		for( size_t j = iFirstJob; j < iLastJob; ++j )
+		{
+			Song* pNewSong = jobs[j].m_pSong;
+			if( pNewSong == nullptr )
+				continue;
 			AddSongToList(pNewSong);
 
 			index_entry.push_back( pNewSong );
 			loaded++;
-			songIndex++;
 		}
 
 		LOG->Trace("Loaded %i songs from \"%s\"", loaded, (sDir+sGroupDirName).c_str() );
@@ -534,8 +752,71 @@ void SongManager::PreloadSongImages()
 	preload.Swap( m_TexturePreload );
 }
 
+void SongManager::GenerateChartKeys( const vector<Song*> &vpSongs )
+{
+	if( vpSongs.empty() )
+		return;
+
+	// Only one job runs at a time.
+	FinishChartKeys();
+
+	m_pChartKeyJob = new ChartKeyJob( vpSongs );
+	const int iThreads = GetNumSongLoadThreads( vpSongs.size() );
+	m_pChartKeyJob->m_iThreadsRunning = iThreads;
+	for( int i = 0; i < iThreads; ++i )
+	{
+		RageThread *pThread = new RageThread;
+		pThread->SetName( ssprintf("Chart key worker %i", i) );
+		pThread->Create( ChartKeyThread, m_pChartKeyJob );
+		m_pChartKeyJob->m_apThreads.push_back( pThread );
+	}
+}
+
+void SongManager::FinishChartKeys()
+{
+	if( m_pChartKeyJob == nullptr )
+		return;
+
+	ChartKeyJob &job = *m_pChartKeyJob;
+	for (RageThread *pThread : job.m_apThreads)
+	{
+		pThread->Wait();
+		delete pThread;
+	}
+
+	int iUpdated = 0;
+	for( size_t i = 0; i < job.m_Songs.size(); ++i )
+	{
+		const Song *pCopy = job.m_Copies[i];
+		if( pCopy == nullptr )
+			continue;
+		for (Steps const *pKeyed : pCopy->GetAllSteps())
+		{
+			Steps *pSteps = SongUtil::GetSameSteps( job.m_Songs[i], pKeyed );
+			if( pSteps != nullptr && !pSteps->HasChartKey() )
+				pSteps->SetChartKey( pKeyed->ChartKey );
+		}
+		++iUpdated;
+	}
+	if( iUpdated != 0 )
+		SONGINDEX->SaveCacheIndex();
+
+	LOG->Trace( "Made chart keys for %i of %i songs in %f seconds.",
+		iUpdated, (int) job.m_Songs.size(), job.m_Timer.GetDeltaTime() );
+	SAFE_DELETE( m_pChartKeyJob );
+}
+
+void SongManager::Update()
+{
+	if( m_pChartKeyJob != nullptr && m_pChartKeyJob->m_iThreadsRunning == 0 )
+		FinishChartKeys();
+}
+
 void SongManager::FreeSongs()
 {
+	// Give the songs their keys while they're still here.
+	FinishChartKeys();
+
 	m_sSongGroupNames.clear();
 	m_sSongGroupBannerPaths.clear();
 	//m_sSongGroupBackgroundPaths.clear();
@@ -1170,6 +1451,46 @@ void SongManager::Cleanup()
 	}
 }
 
+size_t SongManager::GetNoteDataMemoryUsage( const RString &sGroupName ) const
+{
+	size_t iBytes = 0;
+	const vector<Song*> &apSongs = sGroupName.empty()? m_pSongs:GetSongs( sGroupName );
+	for (Song const *pSong : apSongs)
+	{
+		for (Steps const *pSteps : pSong->GetAllSteps())
+			iBytes += pSteps->GetNoteDataMemoryUsage();
+	}
+	return iBytes;
+}
+
+void SongManager::LogNoteDataMemoryUsage() const
+{
+	LOG->Trace( "Note data memory by group:" );
+	size_t iTotalBytes = 0;
+	int iTotalCharts = 0, iTotalInMemory = 0;
+	for (RString const &sGroupName : m_sSongGroupNames)
+	{
+		size_t iBytes = 0;
+		int iCharts = 0, iInMemory = 0;
+		for (Song const *pSong : GetSongs(sGroupName))
+		{
+			for (Steps const *pSteps : pSong->GetAllSteps())
+			{
+				const size_t iChartBytes = pSteps->GetNoteDataMemoryUsage();
+				iBytes += iChartBytes;
+				++iCharts;
+				if( iChartBytes != 0 )
+					++iInMemory;
+			}
+		}
+		LOG->Trace( "  %s: %i charts, %i in memory, %.1fKB", sGroupName.c_str(), iCharts, iInMemory, iBytes / 1024.0f );
+		iTotalBytes += iBytes;
+		iTotalCharts += iCharts;
+		iTotalInMemory += iInMemory;
+	}
+	LOG->Trace( "Total: %i charts, %i in memory, %.1fKB", iTotalCharts, iTotalInMemory, iTotalBytes / 1024.0f );
+}
+
 /* Flush all Song*, Steps* and Course* caches. This is when a Song or its Steps
  * are removed or changed. This doesn't touch GAMESTATE and StageStats
  * pointers. Currently, the only time Steps are altered independently of the
@@ -2076,6 +2397,12 @@ public:
 	static int GetNumCourses( T* p, lua_State *L )		{ lua_pushnumber( L, p->GetNumCourses() ); return 1; }
 	static int GetNumAdditionalCourses( T* p, lua_State *L ){ lua_pushnumber( L, 0 ); return 1; }	// deprecated
 	static int GetNumCourseGroups( T* p, lua_State *L )	{ lua_pushnumber( L, p->GetNumCourseGroups() ); return 1; }
+	static int GetNoteDataMemoryUsage( T* p, lua_State *L )
+	{
+		RString sGroup = lua_isnoneornil(L, 1)? RString():RString(SArg(1));
+		lua_pushnumber( L, (double) p->GetNoteDataMemoryUsage(sGroup) );
+		return 1;
+	}
 
 	/* Note: this could now be implemented as Luna<Steps>::GetSong */
 	static int GetSongFromSteps( T* p, lua_State *L )
@@ -2136,6 +2463,11 @@ public:
 		LuaHelpers::CreateTableFromArray<Song*>( v, L );
 		return 1;
 	}
+	static int GenerateChartKeys( T* p, lua_State *L )
+	{
+		p->GenerateChartKeys( p->GetSongs(lua_isnoneornil(L, 1)? GROUP_ALL:RString(SArg(1))) );
+		COMMON_RETURN_SELF;
+	}
 
 	static int GetCoursesInGroup( T* p, lua_State *L )
 	{
@@ -2200,6 +2532,7 @@ public:
 		ADD_METHOD( GetNumCourses );
 		ADD_METHOD( GetNumAdditionalCourses );	// deprecated
 		ADD_METHOD( GetNumCourseGroups );
+		ADD_METHOD( GetNoteDataMemoryUsage );
 		ADD_METHOD( GetSongFromSteps );
 		ADD_METHOD( GetExtraStageInfo );
 		ADD_METHOD( GetSongColor );
@@ -2208,6 +2541,7 @@ public:
 		ADD_METHOD( GetSongRank );
 		ADD_METHOD( GetSongGroupNames );
 		ADD_METHOD( GetSongsInGroup );
+		ADD_METHOD( GenerateChartKeys );
 		ADD_METHOD( GetCoursesInGroup );
 		ADD_METHOD( ShortenGroupName );
 		ADD_METHOD( SetPreferredSongs );
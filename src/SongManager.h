@@ -7,6 +7,7 @@ class Style;
 class Steps;
 class PlayerOptions;
 struct lua_State;
+struct ChartKeyJob;
 
 #include "RageTypes.h"
 #include "GameConstantsAndTypes.h"
@@ -40,8 +41,9 @@ public:
 	 * @param ld the loading window to be updated, or nullptr
 	 * @param onlyAdditions only load songs added after the last
 	 *        invocation of this function
+	 * @param pOnlyGroups if not nullptr, only look in these group folders
 	 */
-	void InitSongsFromDisk( LoadingWindow *ld, bool onlyAdditions );
+	void InitSongsFromDisk( LoadingWindow *ld, bool onlyAdditions, const set<RString> *pOnlyGroups = nullptr );
 	void FreeSongs();
 	void UnlistSong(Song *song);
 	void Cleanup();
@@ -82,11 +84,26 @@ public:
 	 * @param ld the loading window to be updated, or nullptr
 	 * @param onlyAdditions only load songs and courses added after the
 	 *        last invocation of this function
+	 * @param pOnlyGroups if not nullptr, only look for songs in these
+	 *        group folders
 	 */
-	void InitAll( LoadingWindow *ld, bool onlyAdditions );
+	void InitAll( LoadingWindow *ld, bool onlyAdditions, const set<RString> *pOnlyGroups = nullptr );
 	void Reload( LoadingWindow *ld=nullptr );
 	void LoadAdditions( LoadingWindow *ld=nullptr );
 	void PreloadSongImages();
+	/**
+	 * @brief Start making the chart keys that the songs' Steps don't have yet,
+	 *        on as many threads as songs are loaded with, and keep them in the
+	 *        song cache.
+	 *
+	 * This returns right away.  The keys are given to the songs by Update once
+	 * they're all made; until then, they're made one at a time when they're
+	 * asked for, as usual. */
+	void GenerateChartKeys( const vector<Song*> &vpSongs );
+	/** @brief Wait for the keys started by GenerateChartKeys, and give them
+	 * to the songs. */
+	void FinishChartKeys();
+	void Update();
 
 	bool IsGroupNeverCached(const RString& group) const;
 
@@ -153,6 +170,11 @@ public:
 	int GetNumUnlockedSongs() const;
 	int GetNumSelectableAndUnlockedSongs() const;
 	int GetNumSongGroups() const;
+	/** @brief The memory used by the notes of a group's charts, or of every
+	 * chart if sGroupName is empty.  See Steps::GetNoteDataMemoryUsage. */
+	size_t GetNoteDataMemoryUsage( const RString &sGroupName ) const;
+	/** @brief Log the note data memory of each group. */
+	void LogNoteDataMemoryUsage() const;
 	/**
 	 * @brief Retrieve the number of courses in the game.
 	 * @return the number of courses. */
@@ -195,8 +217,9 @@ protected:
 	 * @param ld the loading window to be updated, or nullptr
 	 * @param onlyAdditions only load songs added after the last
 	 *        invocation of this function
+	 * @param pOnlyGroups if not nullptr, only look in these group folders
 	 */
-	void LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditions );
+	void LoadSongDir( RString sDir, LoadingWindow *ld, bool onlyAdditions, const set<RString> *pOnlyGroups = nullptr );
 	bool GetExtraStageInfoFromCourse( bool bExtra2, RString sPreferredGroup, Song*& pSongOut, Steps*& pStepsOut, StepsType stype );
 	void SanityCheckGroupDir( RString sDir ) const;
 	void AddGroup( RString sDir, RString sGroupDirName );
@@ -241,6 +264,8 @@ protected:
 	vector<CoursePointerVector> m_vPreferredCourseSort;
 
 	RageTexturePreloader m_TexturePreload;
+	/** @brief The keys being made by GenerateChartKeys, or nullptr. */
+	ChartKeyJob *m_pChartKeyJob;
 
 	ThemeMetric<int>		NUM_SONG_GROUP_COLORS;
 	ThemeMetric1D<RageColor>	SONG_GROUP_COLOR;
@@ -218,6 +218,21 @@ Steps* SongUtil::GetStepsByCredit( const Song *pSong, StepsType st, RString sCre
 		return vNotes[0];
 }
 
+Steps* SongUtil::GetSameSteps( const Song *pSong, const Steps *pSteps )
+{
+	for (Steps *p : pSong->GetAllSteps())
+	{
+		if( p->IsAutogen() )
+			continue;
+		if( p->m_StepsType == pSteps->m_StepsType &&
+			p->GetDifficulty() == pSteps->GetDifficulty() &&
+			p->GetDescription() == pSteps->GetDescription() &&
+			p->GetChartName() == pSteps->GetChartName() )
+			return p;
+	}
+	return nullptr;
+}
+
 
 Steps* SongUtil::GetClosestNotes( const Song *pSong, StepsType st, Difficulty dc, bool bIgnoreLocked )
 {
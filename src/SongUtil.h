@@ -126,6 +126,9 @@ namespace SongUtil
 	Steps* GetStepsByMeter(		const Song *pSong, StepsType st, int iMeterLow, int iMeterHigh );
 	Steps* GetStepsByDescription(	const Song *pSong, StepsType st, RString sDescription );
 	Steps* GetStepsByCredit(	const Song *pSong, StepsType st, RString sCredit );
+	/** @brief Find the Steps in pSong that are the same chart as pSteps, which
+	 * belongs to another copy of the song, such as one read from the cache. */
+	Steps* GetSameSteps(		const Song *pSong, const Steps *pSteps );
 	Steps* GetClosestNotes(		const Song *pSong, StepsType st, Difficulty dc, bool bIgnoreLocked=false );
 	
 	void AdjustDuplicateSteps( Song *pSong ); // part of TidyUpData
@@ -30,6 +30,7 @@ Sprite::Sprite()
 	m_bUsingCustomTexCoords = false;
 	m_bUsingCustomPosCoords = false;
 	m_bSkipNextUpdate = true;
+	m_bTexturePending = false;
 	m_DecodeMovie= true;
 	m_EffectMode = EffectMode_Normal;
 	
@@ -69,6 +70,7 @@ Sprite::Sprite( const Sprite &cpy ):
 	CPY( m_bUsingCustomTexCoords );
 	CPY( m_bUsingCustomPosCoords );
 	CPY( m_bSkipNextUpdate );
+	CPY( m_bTexturePending );
 	CPY( m_DecodeMovie );
 	CPY( m_EffectMode );
 	memcpy( m_CustomTexCoords, cpy.m_CustomTexCoords, sizeof(m_CustomTexCoords) );
@@ -97,6 +99,7 @@ Sprite &Sprite::operator=( Sprite other )
 	SWAP( m_bUsingCustomTexCoords );
 	SWAP( m_bUsingCustomPosCoords );
 	SWAP( m_bSkipNextUpdate );
+	SWAP( m_bTexturePending );
 	SWAP( m_DecodeMovie );
 	SWAP( m_EffectMode );
 	memcpy( m_CustomTexCoords, other.m_CustomTexCoords, sizeof(m_CustomTexCoords) );
@@ -338,6 +341,8 @@ void Sprite::SetTexture( RageTexture *pTexture )
 	ASSERT( m_pTexture->GetTextureWidth() >= 0 );
 	ASSERT( m_pTexture->GetTextureHeight() >= 0 );
 
+	m_bTexturePending = m_pTexture->IsPending();
+
 	// the size of the sprite is the size of the image before it was scaled
 	Sprite::m_size.x = (float)m_pTexture->GetSourceFrameWidth();
 	Sprite::m_size.y = (float)m_pTexture->GetSourceFrameHeight();
@@ -455,6 +460,15 @@ void Sprite::Update( float fDelta )
 	const bool bSkipThisMovieUpdate = m_bSkipNextUpdate;
 	m_bSkipNextUpdate = false;
 
+	/* The texture was loaded in the background and has just been uploaded;
+	 * size ourself to it and take its frames.  SetTexture re-applies a clip
+	 * from ScaleToClipped; other sizing done while pending is lost. */
+	if( m_bTexturePending && m_pTexture != nullptr && !m_pTexture->IsPending() )
+	{
+		m_States.clear();
+		SetTexture( m_pTexture );
+	}
+
 	if( !m_bIsAnimating )
 		return;
 
@@ -664,7 +678,8 @@ void Sprite::DrawTexture( const TweenState *state )
 
 bool Sprite::EarlyAbortDraw() const
 {
-	return m_pTexture == nullptr;
+	// Draw nothing until the texture's been uploaded.
+	return m_pTexture == nullptr || m_bTexturePending;
 }
 
 void Sprite::DrawPrimitives()
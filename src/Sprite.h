@@ -119,6 +119,8 @@ private:
 	bool m_bUsingCustomTexCoords;
 	bool m_bUsingCustomPosCoords;
 	bool m_bSkipNextUpdate;
+	// m_pTexture is being loaded asynchronously; see RageTextureID::bAsync.
+	bool m_bTexturePending;
 	/**
 	 * @brief Set up the coordinates for the texture.
 	 *
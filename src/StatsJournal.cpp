@@ -0,0 +1,323 @@
+#include "global.h"
+#include "StatsJournal.h"
+#include "Profile.h"
+#include "HighScore.h"
+#include "GameManager.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "XmlFile.h"
+#include "XmlFileUtil.h"
+
+static const char JOURNAL_MAGIC[4] = { 'S', 'M', 'S', 'J' };
+static const uint32_t JOURNAL_VERSION = 2;
+
+void StatsJournal::AppendRecord( RString &sOut, RecordType type, const XNode *pNode )
+{
+	RString sRecord;
+	XmlFileUtil::GetBinary( pNode, sRecord );
+
+	const uint8_t iType = type;
+	const uint32_t iSize = sRecord.size();
+	sOut.append( (const char *) &iType, sizeof(iType) );
+	sOut.append( (const char *) &iSize, sizeof(iSize) );
+	sOut.append( sRecord );
+}
+
+static XNode *CreateCategoryNode( StepsType st, RankingCategory rc )
+{
+	XNode *pNode = new XNode( "Category" );
+	pNode->AppendAttr( "StepsType", GAMEMAN->GetStepsTypeInfo(st).szName );
+	pNode->AppendAttr( "RankingCategory", RankingCategoryToString(rc) );
+	return pNode;
+}
+
+void StatsJournal::AddStepsScore( const SongID &songID, const StepsID &stepsID, const HighScore &hs )
+{
+	XNode node( "Score" );
+	node.AppendChild( songID.CreateNode() );
+	node.AppendChild( stepsID.CreateNode() );
+	node.AppendChild( hs.CreateNode() );
+	AppendRecord( m_sPending, RECORD_STEPS_SCORE, &node );
+}
+
+void StatsJournal::AddCourseScore( const CourseID &courseID, const TrailID &trailID, const HighScore &hs )
+{
+	XNode node( "Score" );
+	node.AppendChild( courseID.CreateNode() );
+	node.AppendChild( trailID.CreateNode() );
+	node.AppendChild( hs.CreateNode() );
+	AppendRecord( m_sPending, RECORD_COURSE_SCORE, &node );
+}
+
+void StatsJournal::AddCategoryScore( StepsType st, RankingCategory rc, const HighScore &hs )
+{
+	XNode node( "Score" );
+	node.AppendChild( CreateCategoryNode(st, rc) );
+	node.AppendChild( hs.CreateNode() );
+	AppendRecord( m_sPending, RECORD_CATEGORY_SCORE, &node );
+}
+
+void StatsJournal::IncrementStepsPlayCount( const SongID &songID, const StepsID &stepsID, const DateTime &when )
+{
+	XNode node( "Played" );
+	node.AppendAttr( "When", when.GetString() );
+	node.AppendChild( songID.CreateNode() );
+	node.AppendChild( stepsID.CreateNode() );
+	AppendRecord( m_sPending, RECORD_STEPS_PLAYED, &node );
+}
+
+void StatsJournal::IncrementCoursePlayCount( const CourseID &courseID, const TrailID &trailID, const DateTime &when )
+{
+	XNode node( "Played" );
+	node.AppendAttr( "When", when.GetString() );
+	node.AppendChild( courseID.CreateNode() );
+	node.AppendChild( trailID.CreateNode() );
+	AppendRecord( m_sPending, RECORD_COURSE_PLAYED, &node );
+}
+
+void StatsJournal::IncrementCategoryPlayCount( StepsType st, RankingCategory rc, const DateTime &when )
+{
+	XNode node( "Played" );
+	node.AppendAttr( "When", when.GetString() );
+	node.AppendChild( CreateCategoryNode(st, rc) );
+	AppendRecord( m_sPending, RECORD_CATEGORY_PLAYED, &node );
+}
+
+bool StatsJournal::AppendToFile( const RString &sPath, const RString &sStatsID, const RString &sRecords, const XNode *pStats )
+{
+	RString sData;
+	if( !FILEMAN->IsAFile(sPath) || FILEMAN->GetFileSizeInBytes(sPath) == 0 )
+	{
+		const uint32_t iIDSize = sStatsID.size();
+		sData.append( JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC) );
+		sData.append( (const char *) &JOURNAL_VERSION, sizeof(JOURNAL_VERSION) );
+		sData.append( (const char *) &iIDSize, sizeof(iIDSize) );
+		sData.append( sStatsID );
+	}
+	sData.append( sRecords );
+	AppendRecord( sData, RECORD_STATS, pStats );
+
+	/* APPEND is only honoured for STREAMED files; otherwise the data goes
+	 * to a temporary file that replaces the journal. */
+	RageFile f;
+	if( !f.Open(sPath, RageFile::WRITE|RageFile::STREAMED|RageFile::APPEND|RageFile::SLOW_FLUSH) )
+	{
+		LOG->Warn( "Couldn't open %s for writing: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+	if( f.Write(sData) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Error writing %s: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+
+	return true;
+}
+
+static bool LoadCategory( const XNode *pNode, StepsType &st, RankingCategory &rc )
+{
+	const XNode *pCategory = pNode->GetChild( "Category" );
+	RString sStepsType, sCategory;
+	if( pCategory == nullptr || !pCategory->GetAttrValue("StepsType", sStepsType) || !pCategory->GetAttrValue("RankingCategory", sCategory) )
+		return false;
+	st = GAMEMAN->StringToStepsType( sStepsType );
+	rc = StringToRankingCategory( sCategory );
+	return st != StepsType_Invalid && rc != RankingCategory_Invalid;
+}
+
+/* Find the list a record is for.  Returns nullptr if the record is bad, or is for a
+ * steps type this build doesn't know. */
+HighScoreList *StatsJournal::GetHighScoreList( Profile &profile, RecordType type, const XNode *pNode )
+{
+	if( type == RECORD_STEPS_SCORE || type == RECORD_STEPS_PLAYED )
+	{
+		const XNode *pSong = pNode->GetChild( "Song" ), *pSteps = pNode->GetChild( "Steps" );
+		if( pSong == nullptr || pSteps == nullptr )
+			return nullptr;
+		SongID songID;
+		songID.LoadFromNode( pSong );
+		StepsID stepsID;
+		stepsID.LoadFromNode( pSteps );
+		return &profile.m_SongHighScores[songID].m_StepsHighScores[stepsID].hsl;
+	}
+
+	if( type == RECORD_COURSE_SCORE || type == RECORD_COURSE_PLAYED )
+	{
+		const XNode *pCourse = pNode->GetChild( "Course" ), *pTrail = pNode->GetChild( "Trail" );
+		if( pCourse == nullptr || pTrail == nullptr )
+			return nullptr;
+		CourseID courseID;
+		courseID.LoadFromNode( pCourse );
+		TrailID trailID;
+		trailID.LoadFromNode( pTrail );
+		return &profile.m_CourseHighScores[courseID].m_TrailHighScores[trailID].hsl;
+	}
+
+	StepsType st;
+	RankingCategory rc;
+	if( !LoadCategory(pNode, st, rc) )
+		return nullptr;
+	return &profile.GetCategoryHighScoreList( st, rc );
+}
+
+bool StatsJournal::Replay( const RString &sPath, const RString &sStatsID, Profile &profile )
+{
+	RageFile f;
+	if( !f.Open(sPath) )
+	{
+		LOG->Warn( "Couldn't open %s: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+
+	RString sData;
+	if( f.Read(sData, f.GetFileSize()) != f.GetFileSize() )
+	{
+		LOG->Warn( "Error reading %s: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+
+	const char *p = sData.data();
+	const char *pEnd = p + sData.size();
+	uint32_t iVersion;
+	if( sData.size() < sizeof(JOURNAL_MAGIC) + sizeof(iVersion) || memcmp(p, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) )
+	{
+		LOG->Warn( "%s isn't a stats journal", sPath.c_str() );
+		return false;
+	}
+	p += sizeof(JOURNAL_MAGIC);
+	memcpy( &iVersion, p, sizeof(iVersion) );
+	p += sizeof(iVersion);
+	if( iVersion != JOURNAL_VERSION )
+	{
+		LOG->Warn( "%s is version %u; expected %u", sPath.c_str(), iVersion, JOURNAL_VERSION );
+		return false;
+	}
+
+	/* A crash after Stats.xml was replaced, but before the journal was
+	 * removed, leaves a journal whose scores are already in Stats.xml. */
+	uint32_t iIDSize;
+	if( pEnd - p < int(sizeof(iIDSize)) )
+	{
+		LOG->Warn( "%s is truncated", sPath.c_str() );
+		return false;
+	}
+	memcpy( &iIDSize, p, sizeof(iIDSize) );
+	p += sizeof(iIDSize);
+	if( uint32_t(pEnd - p) < iIDSize || RString(p, iIDSize) != sStatsID )
+	{
+		LOG->Warn( "%s wasn't started from this Stats.xml; ignoring it", sPath.c_str() );
+		return false;
+	}
+	p += iIDSize;
+
+	unique_ptr<XNode> pStats;
+	int iRecords = 0;
+	while( p != pEnd )
+	{
+		uint8_t iType;
+		uint32_t iSize;
+		if( pEnd - p < int(sizeof(iType) + sizeof(iSize)) )
+			break;
+		memcpy( &iType, p, sizeof(iType) );
+		p += sizeof(iType);
+		memcpy( &iSize, p, sizeof(iSize) );
+		p += sizeof(iSize);
+		if( uint32_t(pEnd - p) < iSize )
+			break;
+
+		const char *pRecordEnd = p + iSize;
+		XNode node;
+		const bool bLoaded = XmlFileUtil::LoadFromBinary( &node, p, pRecordEnd );
+		p = pRecordEnd;
+		++iRecords;
+		if( !bLoaded || iType >= NUM_RECORD_TYPES )
+		{
+			LOG->Warn( "%s: record %i is bad", sPath.c_str(), iRecords );
+			continue;
+		}
+
+		if( iType == RECORD_STATS )
+		{
+			pStats.reset( new XNode(node) );
+			continue;
+		}
+
+		HighScoreList *pList = GetHighScoreList( profile, (RecordType) iType, &node );
+		if( pList == nullptr )
+		{
+			LOG->Warn( "%s: record %i is for unknown steps", sPath.c_str(), iRecords );
+			continue;
+		}
+
+		switch( iType )
+		{
+		case RECORD_STEPS_SCORE:
+		case RECORD_COURSE_SCORE:
+		case RECORD_CATEGORY_SCORE:
+		{
+			const XNode *pHighScore = node.GetChild( "HighScore" );
+			if( pHighScore == nullptr )
+				break;
+			HighScore hs;
+			hs.LoadFromNode( pHighScore );
+			int iIndex;
+			pList->AddHighScore( hs, iIndex, profile.IsMachine() );
+			break;
+		}
+		default:
+		{
+			RString sWhen;
+			DateTime when;
+			if( node.GetAttrValue("When", sWhen) && when.FromString(sWhen) )
+				pList->IncrementPlayCount( when );
+			break;
+		}
+		}
+	}
+
+	/* A record cut off by a crash while saving.  Anything appended after it
+	 * would be read as part of it, so the caller must write Stats.xml in full
+	 * rather than append to this journal. */
+	const bool bComplete = p == pEnd;
+	if( !bComplete )
+		LOG->Warn( "%s ends with a partial record, which was ignored", sPath.c_str() );
+
+	/* The stats are written in full each time, so only the last ones matter.
+	 * Screenshots and calories are added to what's there when loaded. */
+	if( pStats.get() != nullptr )
+	{
+		profile.InitScreenshotData();
+		profile.InitCalorieData();
+		profile.LoadStatsXmlFromNode( pStats.get() );
+	}
+
+	LOG->Trace( "Replayed %i records from %s", iRecords, sPath.c_str() );
+	return bComplete;
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -0,0 +1,107 @@
+/* StatsJournal - Scores added to a profile since its Stats.xml was written. */
+
+#ifndef STATS_JOURNAL_H
+#define STATS_JOURNAL_H
+
+#include "GameConstantsAndTypes.h"
+
+class XNode;
+class Profile;
+class SongID;
+class StepsID;
+class CourseID;
+class TrailID;
+struct HighScore;
+struct HighScoreList;
+struct DateTime;
+
+/**
+ * @brief An append-only record of the scores and plays added to a profile.
+ *
+ * Writing Stats.xml means building and writing every score the profile has,
+ * which takes a while for big profiles.  Instead, Profile saves the scores
+ * added since the last save to a journal beside it.  The rest of the stats,
+ * which are small, are written with them.  Loading replays the journal over
+ * Stats.xml.  Once the journal grows large, Stats.xml is written in full and
+ * the journal is removed.
+ *
+ * Each Stats.xml gets a new random ID when it's written in full, and the
+ * journal's header holds the ID of the Stats.xml it was started from, so a
+ * journal that outlived its Stats.xml is never replayed over the new one.
+ *
+ * Each record is a type, a length and a tree in XmlFileUtil's binary form. */
+class StatsJournal
+{
+public:
+	void AddStepsScore( const SongID &songID, const StepsID &stepsID, const HighScore &hs );
+	void AddCourseScore( const CourseID &courseID, const TrailID &trailID, const HighScore &hs );
+	void AddCategoryScore( StepsType st, RankingCategory rc, const HighScore &hs );
+	void IncrementStepsPlayCount( const SongID &songID, const StepsID &stepsID, const DateTime &when );
+	void IncrementCoursePlayCount( const CourseID &courseID, const TrailID &trailID, const DateTime &when );
+	void IncrementCategoryPlayCount( StepsType st, RankingCategory rc, const DateTime &when );
+
+	/** @brief Forget what's been recorded, eg. after writing Stats.xml. */
+	void Clear() { m_sPending.clear(); }
+
+	/** @brief Return what's been recorded since the last call, for AppendToFile. */
+	RString TakePending() { RString s; s.swap( m_sPending ); return s; }
+
+	/**
+	 * @brief Append records from TakePending to sPath, followed by pStats,
+	 * which holds the rest of the profile's stats.  If sPath is started
+	 * here, it's marked as belonging to the Stats.xml with ID sStatsID.
+	 * This is safe to call from any thread. */
+	static bool AppendToFile( const RString &sPath, const RString &sStatsID, const RString &sRecords, const XNode *pStats );
+
+	/**
+	 * @brief Add the scores and plays in sPath to profile, and load the
+	 * stats written last.  A record cut off at the end, from a crash while
+	 * saving, is ignored, but false is returned so the journal isn't
+	 * appended to again.  A journal that wasn't started from the Stats.xml
+	 * with ID sStatsID isn't replayed at all, and false is returned. */
+	static bool Replay( const RString &sPath, const RString &sStatsID, Profile &profile );
+
+private:
+	enum RecordType
+	{
+		RECORD_STEPS_SCORE,
+		RECORD_COURSE_SCORE,
+		RECORD_CATEGORY_SCORE,
+		RECORD_STEPS_PLAYED,
+		RECORD_COURSE_PLAYED,
+		RECORD_CATEGORY_PLAYED,
+		RECORD_STATS,
+		NUM_RECORD_TYPES
+	};
+	static void AppendRecord( RString &sOut, RecordType type, const XNode *pNode );
+	static HighScoreList *GetHighScoreList( Profile &profile, RecordType type, const XNode *pNode );
+
+	RString m_sPending;
+};
+
+#endif
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
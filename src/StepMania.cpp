@@ -30,6 +30,7 @@
 #include "RageSurface.h"
 #include "RageSurface_Load.h"
 #include "CommandLineActions.h"
+#include "Benchmark.h"
 
 #if !defined(SUPPORT_OPENGL) && !defined(SUPPORT_D3D)
 #define SUPPORT_OPENGL
@@ -55,6 +56,7 @@
 #include "InputQueue.h"
 #include "SongCacheIndex.h"
 #include "ImageCache.h"
+#include "AudioAnalysisCache.h"
 #include "UnlockManager.h"
 #include "RageFileManager.h"
 #include "Bookkeeper.h"
@@ -311,6 +313,7 @@ void ShutdownGame()
 	SAFE_DELETE( CRYPTMAN );
 	SAFE_DELETE( MEMCARDMAN );
 	SAFE_DELETE( SONGMAN );
+	SAFE_DELETE( AUDIOANALYSIS );
 	SAFE_DELETE( IMAGECACHE );
 	SAFE_DELETE( SONGINDEX );
 	SAFE_DELETE( SOUND ); // uses GAMESTATE, PREFSMAN
@@ -365,6 +368,8 @@ void StepMania::ResetGame()
 ThemeMetric<RString>	INITIAL_SCREEN	("Common","InitialScreen");
 RString StepMania::GetInitialScreen()
 {
+	if( Benchmark::IsRunning() )
+		return Benchmark::GetScreen();
 	if(PREFSMAN->m_sTestInitialScreen.Get() != "" &&
 		SCREENMAN->IsScreenNameValid(PREFSMAN->m_sTestInitialScreen))
 	{
@@ -440,6 +445,7 @@ static void AdjustForChangedSystemCapabilities()
 #endif
 
 #include "RageDisplay_Null.h"
+#include "RageDisplay_Recording.h"
 
 
 struct VideoCardDefaults
@@ -755,6 +761,9 @@ RageDisplay *CreateDisplay()
 
 	vector<RString> asRenderers;
 	split( PREFSMAN->m_sVideoRenderers, ",", asRenderers, true );
+	// Benchmarks measure the CPU, with or without a GPU.
+	if( Benchmark::IsRunning() )
+		asRenderers.assign( 1, "recording" );
 
 	if( asRenderers.empty() )
 		RageException::Throw( "%s", ERROR_NO_VIDEO_RENDERERS.GetValue().c_str() );
@@ -787,6 +796,10 @@ RageDisplay *CreateDisplay()
 		{
 			return new RageDisplay_Null;
 		}
+		else if( sRenderer.CompareNoCase("recording")==0 )
+		{
+			return new RageDisplay_Recording;
+		}
 		else
 		{
 			RageException::Throw( ERROR_UNKNOWN_VIDEO_RENDERER.GetValue(), sRenderer.c_str() );
@@ -977,6 +990,7 @@ static void ApplyLogPreferences()
 	LOG->SetInfoToDisk( true );
 	LOG->SetUserLogToDisk( true );
 	LOG->SetFlushing( PREFSMAN->m_bForceLogFlush );
+	LOG->SetAsync( PREFSMAN->m_bAsyncLog );
 	Checkpoints::LogCheckpoints( PREFSMAN->m_bLogCheckpoints );
 }
 
@@ -1089,6 +1103,8 @@ int sm_main(int argc, char* argv[])
 	if( GetCommandlineArgument("dopefish") )
 		GAMESTATE->m_bDopefish = true;
 
+	Benchmark::Init();
+
 	{
 		/* Now that THEME is loaded, load the icon and splash for the current
 		 * theme into the loading window. */
@@ -1124,6 +1140,8 @@ int sm_main(int argc, char* argv[])
 	// depends on SONGINDEX:
 	SONGMAN		= new SongManager;
 	SONGMAN->InitAll( pLoadingWindow, /*onlyAdditions=*/false );	// this takes a long time
+	AUDIOANALYSIS	= new AudioAnalysisCache;
+	AUDIOANALYSIS->QueueSongs( SONGMAN->GetAllSongs() );
 	CRYPTMAN	= new CryptManager;		// need to do this before ProfileMan
 	if( PREFSMAN->m_bSignProfileData )
 		CRYPTMAN->GenerateGlobalKeys();
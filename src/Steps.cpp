@@ -21,6 +21,7 @@
 #include "NoteData.h"
 #include "GameManager.h"
 #include "SongManager.h"
+#include "SongCacheIndex.h"
 #include "NoteDataUtil.h"
 #include "NotesLoaderSSC.h"
 #include "NotesLoaderSM.h"
@@ -35,6 +36,7 @@
 
 // For hashing hart keys - Mina
 #include "CryptManager.h"
+#include "RageThreads.h"
 
 static const char *DisplayBPMNames[] =
 {
@@ -45,6 +47,14 @@ static const char *DisplayBPMNames[] =
 XToString( DisplayBPM );
 LuaXType( DisplayBPM );
 
+/* GAMESTATE's processed timing data is global, but radar values are
+ * calculated by every song loader thread. */
+static RageMutex g_RadarValuesMutex( "RadarValues" );
+
+/* Keep the notes of charts that have been looked at packed in memory, instead
+ * of reading them from the simfile again the next time. */
+static Preference<bool> g_bKeepPackedNoteData( "KeepPackedNoteData", true );
+
 Steps::Steps(Song *song): m_StepsType(StepsType_Invalid), m_pSong(song),
 	parent(nullptr), m_pNoteData(new NoteData), m_bNoteDataIsFilled(false), 
 	m_sNoteDataCompressed(""), m_sFilename(""), m_bSavedToDisk(false), 
@@ -86,19 +96,31 @@ unsigned Steps::GetHash() const
 		return parent->GetHash();
 	if( m_iHash )
 		return m_iHash;
-	if( m_sNoteDataCompressed.empty() )
-	{
-		if( !m_bNoteDataIsFilled )
-			return 0; // No data, no hash.
-		NoteDataUtil::GetSMNoteDataString( *m_pNoteData, m_sNoteDataCompressed );
-	}
-	m_iHash = GetHashForString( m_sNoteDataCompressed );
+
+	/* The hash is of the SM text, whatever the notes are kept as. */
+	RString sSMNoteData;
+	GetSMNoteData( sSMNoteData );
+	if( sSMNoteData.empty() )
+		return 0; // No data, no hash.
+	m_iHash = GetHashForString( sSMNoteData );
 	return m_iHash;
 }
 
 bool Steps::IsNoteDataEmpty() const
 {
-	return this->m_sNoteDataCompressed.empty();
+	return this->m_sNoteDataCompressed.empty() && this->m_sNoteDataPacked.empty();
+}
+
+size_t Steps::GetNoteDataMemoryUsage() const
+{
+	size_t iBytes = m_sNoteDataCompressed.capacity() + m_sNoteDataPacked.capacity();
+	if( m_bNoteDataIsFilled )
+	{
+		/* Roughly; each note is a node in a map, or an entry in a vector. */
+		for( int t = 0; t < m_pNoteData->GetNumTracks(); ++t )
+			iBytes += distance( m_pNoteData->begin(t), m_pNoteData->end(t) ) * (sizeof(int) + sizeof(TapNote) + 32);
+	}
+	return iBytes;
 }
 
 bool Steps::GetNoteDataFromSimfile()
@@ -180,7 +202,9 @@ void Steps::SetNoteData( const NoteData& noteDataNew )
 	m_bNoteDataIsFilled = true;
 	
 	m_sNoteDataCompressed = RString();
+	m_sNoteDataPacked = RString();
 	m_iHash = 0;
+	ChartKey = RString();
 }
 
 void Steps::GetNoteData( NoteData& noteDataOut ) const
@@ -211,6 +235,7 @@ void Steps::SetSMNoteData( const RString &notes_comp_ )
 	m_bNoteDataIsFilled = false;
 
 	m_sNoteDataCompressed = notes_comp_;
+	m_sNoteDataPacked = RString();
 	m_iHash = 0;
 }
 
@@ -221,6 +246,16 @@ void Steps::GetSMNoteData( RString &notes_comp_out ) const
 	{
 		if( !m_bNoteDataIsFilled ) 
 		{
+			if( !m_sNoteDataPacked.empty() )
+			{
+				/* Don't keep the text; it's several times the size. */
+				NoteData nd;
+				nd.SetNumTracks( GAMEMAN->GetStepsTypeInfo(m_StepsType).iNumTracks );
+				NoteDataUtil::LoadFromPackedNoteData( nd, m_sNoteDataPacked );
+				NoteDataUtil::GetSMNoteDataString( nd, notes_comp_out );
+				return;
+			}
+
 			/* no data is no data */
 			notes_comp_out = "";
 			return;
@@ -318,6 +353,7 @@ void Steps::CalculateRadarValues( float fMusicLengthSeconds )
 	FOREACH_PlayerNumber( pn )
 		m_CachedRadarValues[pn].Zero();
 
+	LockMut( g_RadarValuesMutex );
 	GAMESTATE->SetProcessedTimingData(this->GetTimingData());
 	if( tempNoteData.IsComposite() )
 	{
@@ -414,15 +450,31 @@ void Steps::Decompress()
 		return;
 	}
 
+	if( !m_sNoteDataPacked.empty() )
+	{
+		m_pNoteData->SetNumTracks( GAMEMAN->GetStepsTypeInfo(m_StepsType).iNumTracks );
+		if( NoteDataUtil::LoadFromPackedNoteData(*m_pNoteData, m_sNoteDataPacked) )
+		{
+			m_bNoteDataIsFilled = true;
+			return;
+		}
+
+		LOG->Warn( "Couldn't unpack the %s chart's NoteData", DifficultyToString(m_Difficulty).c_str() );
+		m_sNoteDataPacked = RString();
+	}
+
 	if( !m_sFilename.empty() && m_sNoteDataCompressed.empty() )
 	{
 		// We have NoteData on disk and not in memory. Load it.
+		// Some loaders go through SetNoteData; the notes haven't really changed.
+		const RString sChartKey = ChartKey;
 		if (!this->GetNoteDataFromSimfile())
 		{
 			LOG->Warn("Couldn't load the %s chart's NoteData from \"%s\"",
 					  DifficultyToString(m_Difficulty).c_str(), m_sFilename.c_str());
 			return;
 		}
+		ChartKey = sChartKey;
 
 		this->GetSMNoteData( m_sNoteDataCompressed );
 	}
@@ -448,22 +500,38 @@ void Steps::Compress() const
 	if( this->m_StepsType == StepsType_lights_cabinet && m_bNoteDataIsFilled )
 	{
 		m_sNoteDataCompressed = RString();
+		m_sNoteDataPacked = RString();
 		return;
 	}
-	
+
 	// Don't compress data in the editor: it's still in use.
 	if (GAMESTATE->m_bInStepEditor)
 	{
 		return;
 	}
 
+	// Autogen notes are made from the parent's again; don't keep them.
+	if( parent )
+	{
+		m_pNoteData->Init();
+		m_bNoteDataIsFilled = false;
+		return;
+	}
+
 	if( !m_sFilename.empty() && m_LoadedFromProfile == ProfileSlot_Invalid )
 	{
 		/* We have a file on disk; clear all data in memory.
 		 * Data on profiles can't be accessed normally (need to mount and time-out
 		 * the device), and when we start a game and load edits, we want to be
 		 * sure that it'll be available if the user picks it and pulls the device.
-		 * Also, Decompress() doesn't know how to load .edits. */
+		 * Also, Decompress() doesn't know how to load .edits.
+		 *
+		 * If it's been loaded, keep it packed, so it's not read again.  Don't
+		 * pack charts that were only just loaded; that'd parse every chart. */
+		if( m_bNoteDataIsFilled && g_bKeepPackedNoteData )
+			NoteDataUtil::GetPackedNoteData( *m_pNoteData, m_sNoteDataPacked );
+		else if( !g_bKeepPackedNoteData )
+			m_sNoteDataPacked = RString();
 		m_pNoteData->Init();
 		m_bNoteDataIsFilled = false;
 
@@ -474,11 +542,14 @@ void Steps::Compress() const
 	}
 
 	// We have no file on disk. Compress the data, if necessary.
-	if( m_sNoteDataCompressed.empty() )
+	if( m_bNoteDataIsFilled )
 	{
-		if( !m_bNoteDataIsFilled )
-			return; /* no data is no data */
-		NoteDataUtil::GetSMNoteDataString( *m_pNoteData, m_sNoteDataCompressed );
+		NoteDataUtil::GetPackedNoteData( *m_pNoteData, m_sNoteDataPacked );
+		m_sNoteDataCompressed = RString();
+	}
+	else if( m_sNoteDataCompressed.empty() && m_sNoteDataPacked.empty() )
+	{
+		return; /* no data is no data */
 	}
 
 	m_pNoteData->Init();
@@ -630,70 +701,55 @@ void Steps::SetCachedRadarValues( const RadarValues v[NUM_PLAYERS] )
 
 RString Steps::GenerateChartKey()
 {
+	// Leave the notes as they were; they may be in use.  Keys are made for
+	// every chart, so don't keep them all packed either.
+	const bool bWasFilled = m_bNoteDataIsFilled;
+	const bool bWasPacked = !m_sNoteDataPacked.empty();
+	this->Decompress();
 	ChartKey = this->GenerateChartKey(*m_pNoteData, this->GetTimingData());
+	if (!bWasFilled)
+	{
+		this->Compress();
+		if (!bWasPacked && !m_sFilename.empty() && m_LoadedFromProfile == ProfileSlot_Invalid)
+			m_sNoteDataPacked = RString();
+	}
 	return ChartKey;
 }
 RString Steps::GetChartKey()
 {
 	if (ChartKey.empty()) {
-		this->Decompress();
-		ChartKey = this->GenerateChartKey(*m_pNoteData, this->GetTimingData());
-		this->Compress();
+		this->GenerateChartKey();
+		// Keep it, so it isn't made again next time the game starts.  Not
+		// while editing, since the notes may not match the simfile.
+		if (m_pSong != nullptr && !IsAutogen() && !WasLoadedFromProfile() &&
+			!GAMESTATE->m_bInStepEditor)
+			SONGINDEX->SaveChartKeysToCache(*m_pSong);
 	}
 	return ChartKey;
 }
 RString Steps::GenerateChartKey(NoteData &nd, TimingData *td)
 {
-	RString k = "";
-	RString o = "";
-	float bpm;
 	nd.LogNonEmptyRows();
-	std::vector<int>& nerv = nd.GetNonEmptyRowVector();
-
-
-	RString firstHalf = "";
-	RString secondHalf = "";
-
-#pragma omp parallel sections
-	{
-#pragma omp section
-		{
-			for (size_t r = 0; r < nerv.size() / 2; r++) {
-				int row = nerv[r];
-				for (int t = 0; t < nd.GetNumTracks(); ++t) {
-					const TapNote &tn = nd.GetTapNote(t, row);
-					std::ostringstream os;
-					os << tn.type;
-					firstHalf.append(os.str());
-				}
-				bpm = td->GetBPMAtRow(row);
-				std::ostringstream os;
-				os << static_cast<int>(bpm + 0.374643f);
-				firstHalf.append(os.str());
-			}
-		}
-
-#pragma omp section
-		{
-			for (size_t r = nerv.size() / 2; r < nerv.size(); r++) {
-				int row = nerv[r];
-				for (int t = 0; t < nd.GetNumTracks(); ++t) {
-					const TapNote &tn = nd.GetTapNote(t, row);
-					std::ostringstream os;
-					os << tn.type;
-					secondHalf.append(os.str());
-				}
-				bpm = td->GetBPMAtRow(row);
-				std::ostringstream os;
-				os << static_cast<int>(bpm + 0.374643f);
-				firstHalf.append(os.str());
-			}
-		}
-	}
-	k = firstHalf + secondHalf;
-
-	//ChartKeyRecord = k;
-	o.append("X");	// I was thinking of using "C" to indicate chart.. however.. X is cooler... - Mina
+	const std::vector<int>& nerv = nd.GetNonEmptyRowVector();
+
+	/* Each row in the first half adds a digit for each track's TapNoteType,
+	 * then the BPM at the row.  For the second half, all of the BPMs come
+	 * first and then all of the digits.  Scores are stored by chart key, so
+	 * this must never change, odd as it is. */
+	const size_t iHalf = nerv.size() / 2;
+	RString k, sSecondHalfTaps;
+	k.reserve(nerv.size() * (nd.GetNumTracks() + 3));
+	sSecondHalfTaps.reserve((nerv.size() - iHalf) * nd.GetNumTracks());
+	for (size_t r = 0; r < nerv.size(); ++r) {
+		const int row = nerv[r];
+		RString &sTaps = r < iHalf? k:sSecondHalfTaps;
+		for (int t = 0; t < nd.GetNumTracks(); ++t)
+			sTaps += static_cast<char>('0' + nd.GetTapNote(t, row).type);
+		k += std::to_string(static_cast<int>(td->GetBPMAtRow(row) + 0.374643f));
+	}
+	k += sSecondHalfTaps;
+
+	RString o = "X";	// I was thinking of using "C" to indicate chart.. however.. X is cooler... - Mina
 	o.append(BinaryToHex(CryptManager::GetSHA1ForString(k)));
 	return o;
 }
@@ -743,6 +799,7 @@ public:
 		return 1;
 	}
 	static int GetHash( T* p, lua_State *L ) { lua_pushnumber( L, p->GetHash() ); return 1; }
+	static int GetChartKey( T* p, lua_State *L ) { lua_pushstring( L, p->GetChartKey() ); return 1; }
 	// untested
 	/*
 	static int GetSMNoteData( T* p, lua_State *L )
@@ -804,6 +861,7 @@ public:
 		ADD_METHOD( GetDifficulty );
 		ADD_METHOD( GetFilename );
 		ADD_METHOD( GetHash );
+		ADD_METHOD( GetChartKey );
 		ADD_METHOD( GetMeter );
 		ADD_METHOD( HasSignificantTimingChanges );
 		ADD_METHOD( HasAttacks );
@@ -126,9 +126,13 @@ public:
 	/* This is a reimplementation of the lua version of the script to generate chart keys, except this time
 	using the notedata stored in game memory immediately after reading it than parsing it using lua. - Mina */
 	RString GenerateChartKey(NoteData &nd, TimingData *td);
+	/* Make the chart key from this chart's notes, loading them if needed. */
 	RString GenerateChartKey();
 	RString ChartKey;
+	/* Chart keys are only made the first time they're asked for, and are then
+	 * kept in the song cache. */
 	RString GetChartKey();
+	bool HasChartKey() const { return !ChartKey.empty(); }
 	void SetChartKey(const RString &k) { ChartKey = k; }
 
 	void ChangeFilenamesForCustomSong();
@@ -157,6 +161,10 @@ public:
 	 * @return true if our notedata is empty, false otherwise. */
 	bool IsNoteDataEmpty() const;
 
+	/** @brief How much memory the notes take while they're kept in memory:
+	 * decompressed, packed or as SM text. */
+	size_t GetNoteDataMemoryUsage() const;
+
 	void TidyUpData();
 	void CalculateRadarValues( float fMusicLengthSeconds );
 
@@ -225,6 +233,10 @@ private:
 	mutable HiddenPtr<NoteData>	m_pNoteData;
 	mutable bool			m_bNoteDataIsFilled;
 	mutable RString			m_sNoteDataCompressed;
+	/* Compress() keeps the notes packed (see NoteDataUtil::GetPackedNoteData)
+	 * instead of as SM text, once they've been decompressed.  This is never
+	 * set along with m_sNoteDataCompressed. */
+	mutable RString			m_sNoteDataPacked;
 
 	/** @brief The name of the file where these steps are stored. */
 	RString				m_sFilename;
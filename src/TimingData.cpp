@@ -6,6 +6,7 @@
 #include "RageLog.h"
 #include "ThemeManager.h"
 #include "NoteTypes.h"
+#include "RageThreads.h"
 #include <float.h>
 
 static void EraseSegment(vector<TimingSegment*> &vSegs, int index, TimingSegment *cur);
@@ -13,7 +14,7 @@ static const int INVALID_INDEX = -1;
 
 TimingSegment* GetSegmentAtRow( int iNoteRow, TimingSegmentType tst );
 
-TimingData::TimingData(float fOffset) : m_fBeat0OffsetInSeconds(fOffset)
+TimingData::TimingData(float fOffset) : m_bLookupBuilt(false), m_fBeat0OffsetInSeconds(fOffset)
 {
 }
 
@@ -36,6 +37,8 @@ void TimingData::Copy( const TimingData& cpy )
 
 void TimingData::Clear()
 {
+	InvalidateLookup( TimingSegmentType_Invalid );
+
 	/* Delete all pointers owned by this TimingData. */
 	FOREACH_TimingSegmentType( tst )
 	{
@@ -51,20 +54,19 @@ void TimingData::Clear()
 
 bool TimingData::IsSafeFullTiming()
 {
-	static vector<TimingSegmentType> needed_segments;
-	if(needed_segments.empty())
-	{
-		needed_segments.push_back(SEGMENT_BPM);
-		needed_segments.push_back(SEGMENT_TIME_SIG);
-		needed_segments.push_back(SEGMENT_TICKCOUNT);
-		needed_segments.push_back(SEGMENT_COMBO);
-		needed_segments.push_back(SEGMENT_LABEL);
-		needed_segments.push_back(SEGMENT_SPEED);
-		needed_segments.push_back(SEGMENT_SCROLL);
-	}
-	for(size_t s= 0; s < needed_segments.size(); ++s)
-	{
-		if(m_avpTimingSegments[needed_segments[s]].empty())
+	static const TimingSegmentType needed_segments[] =
+	{
+		SEGMENT_BPM,
+		SEGMENT_TIME_SIG,
+		SEGMENT_TICKCOUNT,
+		SEGMENT_COMBO,
+		SEGMENT_LABEL,
+		SEGMENT_SPEED,
+		SEGMENT_SCROLL,
+	};
+	for (TimingSegmentType const &tst : needed_segments)
+	{
+		if(m_avpTimingSegments[tst].empty())
 		{
 			return false;
 		}
@@ -77,44 +79,45 @@ TimingData::~TimingData()
 	Clear();
 }
 
-void TimingData::PrepareLookup()
-{
-	// If multiple players have the same timing data, then adding to the
-	// lookups would probably cause FindEntryInLookup to return the wrong
-	// thing.  So release the lookups. -Kyz
-	ReleaseLookup();
-	const unsigned int segments_per_lookup= 16;
-	const vector<TimingSegment*>& bpms= m_avpTimingSegments[SEGMENT_BPM];
-	const vector<TimingSegment*>& warps= m_avpTimingSegments[SEGMENT_WARP];
-	const vector<TimingSegment*>& stops= m_avpTimingSegments[SEGMENT_STOP];
-	const vector<TimingSegment*>& delays= m_avpTimingSegments[SEGMENT_DELAY];
+/* Charts with fewer segments than this are quick enough to walk. */
+static const unsigned MIN_SEGMENTS_FOR_LOOKUP = 16;
 
-	unsigned int total_segments= bpms.size() + warps.size() + stops.size() + delays.size();
-	unsigned int lookup_entries= total_segments / segments_per_lookup;
-	m_beat_start_lookup.reserve(lookup_entries);
-	m_time_start_lookup.reserve(lookup_entries);
-	for(unsigned int curr_segment= segments_per_lookup;
-			curr_segment < total_segments; curr_segment+= segments_per_lookup)
-	{
-		GetBeatStarts beat_start;
-		beat_start.last_time= -m_fBeat0OffsetInSeconds;
-		GetBeatArgs args;
-		args.elapsed_time= FLT_MAX;
-		GetBeatInternal(beat_start, args, curr_segment);
-		m_beat_start_lookup.push_back(lookup_item_t(args.elapsed_time, beat_start));
+/* Building the lookup tables is rare, so one lock serves every TimingData. */
+static RageMutex g_LookupMutex( "TimingDataLookup" );
 
-		GetBeatStarts time_start;
-		time_start.last_time= -m_fBeat0OffsetInSeconds;
-		float time= GetElapsedTimeInternal(time_start, FLT_MAX, curr_segment);
-		m_time_start_lookup.push_back(lookup_item_t(NoteRowToBeat(time_start.last_row), time_start));
-	}
-	// If there are less than two entries, then FindEntryInLookup in lookup
-	// will always decide there's no appropriate entry.  So clear the table.
-	// -Kyz
-	if(m_beat_start_lookup.size() < 2)
+static bool AffectsLookup( TimingSegmentType tst )
+{
+	switch( tst )
 	{
-		ReleaseLookup();
+	case SEGMENT_BPM:
+	case SEGMENT_STOP:
+	case SEGMENT_DELAY:
+	case SEGMENT_WARP:
+	case TimingSegmentType_Invalid:
+		return true;
+	default:
+		return false;
 	}
+}
+
+static unsigned CountLookupSegments( const TimingData &timing )
+{
+	return timing.GetTimingSegments(SEGMENT_BPM).size() +
+		timing.GetTimingSegments(SEGMENT_WARP).size() +
+		timing.GetTimingSegments(SEGMENT_STOP).size() +
+		timing.GetTimingSegments(SEGMENT_DELAY).size();
+}
+
+static unsigned GetSegmentsPassed( const TimingData::GetBeatStarts &start )
+{
+	return start.bpm + start.warp + start.stop + start.delay;
+}
+
+void TimingData::PrepareLookup()
+{
+	// Build the tables now, rather than on the first lookup in gameplay.
+	if( CountLookupSegments(*this) >= MIN_SEGMENTS_FOR_LOOKUP )
+		BuildLookup();
 	// DumpLookupTables();
 }
 
@@ -129,11 +132,26 @@ void TimingData::ReleaseLookup()
 		beat_start_lookup_t tmp= lookup; \
 		lookup.swap(tmp); \
 	}
+	m_bLookupBuilt = false;
 	CLEAR_LOOKUP(m_beat_start_lookup);
 	CLEAR_LOOKUP(m_time_start_lookup);
 #undef CLEAR_LOOKUP
 }
 
+void TimingData::InvalidateLookup( TimingSegmentType tst, int row )
+{
+	if( !AffectsLookup(tst) )
+		return;
+	m_bLookupBuilt = false;
+
+	// An entry only depends on segments up to its row.  Rows only increase
+	// along the tables.
+	while( !m_beat_start_lookup.empty() && m_beat_start_lookup.back().second.last_row >= row )
+		m_beat_start_lookup.pop_back();
+	while( !m_time_start_lookup.empty() && m_time_start_lookup.back().second.last_row >= row )
+		m_time_start_lookup.pop_back();
+}
+
 RString SegInfoStr(const vector<TimingSegment*>& segs, unsigned int index, const RString& name)
 {
 	if(index < segs.size())
@@ -175,50 +193,99 @@ void TimingData::DumpLookupTables()
 	LOG->Trace("Finished dumping lookup tables for %s:", m_sFile.c_str());
 }
 
-TimingData::beat_start_lookup_t::const_iterator FindEntryInLookup(
+static bool LookupItemBefore( const TimingData::lookup_item_t &item, float entry )
+{
+	return item.first < entry;
+}
+
+static const TimingData::lookup_item_t *FindEntryInLookup(
 	const TimingData::beat_start_lookup_t& lookup, float entry)
 {
-	if(lookup.empty())
+	TimingData::beat_start_lookup_t::const_iterator it=
+		lower_bound(lookup.begin(), lookup.end(), entry, LookupItemBefore);
+	// If the time or beat being looked up is close enough to the starting
+	// point that is returned, such as putting the time inside a stop or delay,
+	// then it can make arrows unhittable.  So always return the entry before
+	// the closest one to prevent that. -Kyz
+	if(it - lookup.begin() < 2)
 	{
-		return lookup.end();
+		return nullptr;
 	}
-	size_t lower= 0;
-	size_t upper= lookup.size()-1;
-	if(lookup[lower].first > entry)
+	return &*(it - 2);
+}
+
+/* Add one entry per segment to each table, from where it was cut off by
+ * InvalidateLookup, until it reaches the last segment.  Other threads may be
+ * looking up times, so only one of them builds the tables, and the rest wait
+ * for it; once built, the tables are only read. */
+void TimingData::BuildLookup() const
+{
+	LockMut( g_LookupMutex );
+	if( m_bLookupBuilt )
+		return;
+
+	const unsigned total_segments= CountLookupSegments(*this);
+
+	GetBeatStarts start;
+	GetBeatArgs args;
+	if(!m_beat_start_lookup.empty())
 	{
-		return lookup.end();
+		const lookup_item_t& last= m_beat_start_lookup.back();
+		start= last.second;
+		args.warp_begin_out= last.warp_begin;
+		args.warp_dest_out= last.warp_dest;
 	}
-	if(lookup[upper].first < entry)
+	while(GetSegmentsPassed(start) < total_segments)
 	{
-		// See explanation at the end of this function. -Kyz
-		return lookup.begin() + upper - 1;
+		args.elapsed_time= FLT_MAX;
+		GetBeatInternal(start, args, GetSegmentsPassed(start) + 1);
+		lookup_item_t item(args.elapsed_time, start);
+		item.warp_begin= args.warp_begin_out;
+		item.warp_dest= args.warp_dest_out;
+		m_beat_start_lookup.push_back(item);
 	}
-	while(upper - lower > 1)
+
+	start= GetBeatStarts();
+	if(!m_time_start_lookup.empty())
 	{
-		size_t next= (upper + lower) / 2;
-		if(lookup[next].first > entry)
-		{
-			upper= next;
-		}
-		else if(lookup[next].first < entry)
-		{
-			lower= next;
-		}
-		else
-		{
-			lower= next;
-			break;
-		}
+		start= m_time_start_lookup.back().second;
 	}
-	// If the time or beat being looked up is close enough to the starting
-	// point that is returned, such as putting the time inside a stop or delay,
-	// then it can make arrows unhittable.  So always return the entry before
-	// the closest one to prevent that. -Kyz
-	if(lower == 0)
+	while(GetSegmentsPassed(start) < total_segments)
+	{
+		GetElapsedTimeInternal(start, FLT_MAX, GetSegmentsPassed(start) + 1);
+		m_time_start_lookup.push_back(lookup_item_t(NoteRowToBeat(start.last_row), start));
+	}
+
+	m_bLookupBuilt = true;
+}
+
+/* Find where to start walking to get the beat at elapsed_time, not counting
+ * the offset. */
+const TimingData::lookup_item_t *TimingData::FindBeatStart( float elapsed_time ) const
+{
+	if(CountLookupSegments(*this) < MIN_SEGMENTS_FOR_LOOKUP)
+	{
+		return nullptr;
+	}
+	if(!m_bLookupBuilt)
 	{
-		return lookup.end();
+		BuildLookup();
 	}
-	return lookup.begin() + lower - 1;
+	return FindEntryInLookup(m_beat_start_lookup, elapsed_time);
+}
+
+/* Find where to start walking to get the time of beat. */
+const TimingData::lookup_item_t *TimingData::FindTimeStart( float beat ) const
+{
+	if(CountLookupSegments(*this) < MIN_SEGMENTS_FOR_LOOKUP)
+	{
+		return nullptr;
+	}
+	if(!m_bLookupBuilt)
+	{
+		BuildLookup();
+	}
+	return FindEntryInLookup(m_time_start_lookup, beat);
 }
 
 bool TimingData::empty() const
@@ -262,9 +329,10 @@ void TimingData::ShiftRange(int start_row, int end_row,
 	{
 		if(seg_type == shift_type || shift_type == TimingSegmentType_Invalid)
 		{
-			vector<TimingSegment*>& segs= GetTimingSegments(seg_type);
+			vector<TimingSegment*>& segs= m_avpTimingSegments[seg_type];
 			int first_row= min(start_row, start_row + shift_amount);
 			int last_row= max(end_row, end_row + shift_amount);
+			InvalidateLookup(seg_type, first_row);
 			int first_affected= GetSegmentIndexAtRow(seg_type, first_row);
 			int last_affected= GetSegmentIndexAtRow(seg_type, last_row);
 			if(first_affected == INVALID_INDEX)
@@ -327,7 +395,8 @@ void TimingData::ClearRange(int start_row, int end_row, TimingSegmentType clear_
 	{
 		if(seg_type == clear_type || clear_type == TimingSegmentType_Invalid)
 		{
-			vector<TimingSegment*>& segs= GetTimingSegments(seg_type);
+			vector<TimingSegment*>& segs= m_avpTimingSegments[seg_type];
+			InvalidateLookup(seg_type, start_row);
 			int first_affected= GetSegmentIndexAtRow(seg_type, start_row);
 			int last_affected= GetSegmentIndexAtRow(seg_type, end_row);
 			if(first_affected == INVALID_INDEX)
@@ -431,6 +500,8 @@ struct ts_less
 // Multiply the BPM in the range [fStartBeat,fEndBeat) by fFactor.
 void TimingData::MultiplyBPMInBeatRange( int iStartIndex, int iEndIndex, float fFactor )
 {
+	InvalidateLookup( SEGMENT_BPM, iStartIndex );
+
 	// Change all other BPM segments in this range.
 	vector<TimingSegment *> &bpms = m_avpTimingSegments[SEGMENT_BPM];
 	for( unsigned i=0; i<bpms.size(); i++ )
@@ -576,7 +647,11 @@ const TimingSegment* TimingData::GetSegmentAtRow( int iNoteRow, TimingSegmentTyp
 
 TimingSegment* TimingData::GetSegmentAtRow( int iNoteRow, TimingSegmentType tst )
 {
-	return const_cast<TimingSegment*>( static_cast<const TimingData*>(this)->GetSegmentAtRow(iNoteRow, tst) );
+	TimingSegment *seg = const_cast<TimingSegment*>( static_cast<const TimingData*>(this)->GetSegmentAtRow(iNoteRow, tst) );
+	// The caller might change it.
+	if( seg != nullptr )
+		InvalidateLookup( tst, seg->GetRow() );
+	return seg;
 }
 
 static void EraseSegment( vector<TimingSegment*> &vSegs, int index, TimingSegment *cur )
@@ -601,6 +676,7 @@ void TimingData::AddSegment( const TimingSegment *seg )
 
 	TimingSegmentType tst = seg->GetType();
 	vector<TimingSegment*> &vSegs = m_avpTimingSegments[tst];
+	InvalidateLookup( tst, seg->GetRow() );
 
 	// OPTIMIZATION: if this is our first segment, push and return.
 	if( vSegs.empty() )
@@ -915,11 +991,14 @@ void TimingData::GetBeatAndBPSFromElapsedTimeNoOffset(GetBeatArgs& args) const
 {
 	GetBeatStarts start;
 	start.last_time= -m_fBeat0OffsetInSeconds;
-	beat_start_lookup_t::const_iterator looked_up_start=
-		FindEntryInLookup(m_beat_start_lookup, args.elapsed_time);
-	if(looked_up_start != m_beat_start_lookup.end())
+	const lookup_item_t *looked_up_start=
+		FindBeatStart(args.elapsed_time + m_fBeat0OffsetInSeconds);
+	if(looked_up_start != nullptr)
 	{
 		start= looked_up_start->second;
+		start.last_time-= m_fBeat0OffsetInSeconds;
+		args.warp_begin_out= looked_up_start->warp_begin;
+		args.warp_dest_out= looked_up_start->warp_dest;
 	}
 	GetBeatInternal(start, args, INT_MAX);
 }
@@ -1000,11 +1079,11 @@ float TimingData::GetElapsedTimeFromBeatNoOffset( float fBeat ) const
 {
 	GetBeatStarts start;
 	start.last_time= -m_fBeat0OffsetInSeconds;
-	beat_start_lookup_t::const_iterator looked_up_start=
-		FindEntryInLookup(m_time_start_lookup, fBeat);
-	if(looked_up_start != m_time_start_lookup.end())
+	const lookup_item_t *looked_up_start= FindTimeStart(fBeat);
+	if(looked_up_start != nullptr)
 	{
 		start= looked_up_start->second;
+		start.last_time-= m_fBeat0OffsetInSeconds;
 	}
 	GetElapsedTimeInternal(start, fBeat, INT_MAX);
 	return start.last_time;
@@ -1033,6 +1112,7 @@ void TimingData::ScaleRegion( float fScale, int iStartIndex, int iEndIndex, bool
 
 	int length = iEndIndex - iStartIndex;
 	int newLength = lrintf( fScale * length );
+	InvalidateLookup( TimingSegmentType_Invalid, iStartIndex );
 
 	FOREACH_TimingSegmentType( tst )
 		for (unsigned j = 0; j < m_avpTimingSegments[tst].size(); j++)
@@ -1067,6 +1147,7 @@ void TimingData::ScaleRegion( float fScale, int iStartIndex, int iEndIndex, bool
 
 void TimingData::InsertRows( int iStartRow, int iRowsToAdd )
 {
+	InvalidateLookup( TimingSegmentType_Invalid, iStartRow );
 	FOREACH_TimingSegmentType( tst )
 	{
 		vector<TimingSegment *> &segs = m_avpTimingSegments[tst];
@@ -1092,6 +1173,7 @@ void TimingData::InsertRows( int iStartRow, int iRowsToAdd )
 // Delete timing changes in [iStartRow, iStartRow + iRowsToDelete) and shift up.
 void TimingData::DeleteRows( int iStartRow, int iRowsToDelete )
 {
+	InvalidateLookup( TimingSegmentType_Invalid, iStartRow );
 	FOREACH_TimingSegmentType( tst )
 	{
 		// Don't delete the indefinite segments that are still in effect
@@ -1202,6 +1284,8 @@ void TimingData::TidyUpData(bool allowEmpty)
 	if( allowEmpty && empty() )
 		return;
 
+	InvalidateLookup( TimingSegmentType_Invalid );
+
 	// If there are no BPM segments, provide a default.
 	auto &segs = m_avpTimingSegments;
 	if( segs[SEGMENT_BPM].empty() )
@@ -1245,6 +1329,7 @@ void TimingData::TidyUpData(bool allowEmpty)
 void TimingData::SortSegments( TimingSegmentType tst )
 {
 	vector<TimingSegment*> &vSegments = m_avpTimingSegments[tst];
+	InvalidateLookup( tst );
 	sort( vSegments.begin(), vSegments.end() );
 }
 
@@ -6,6 +6,7 @@
 #include "PrefsManager.h"
 #include <float.h> // max float
 #include <array>
+#include <atomic>
 struct lua_State;
 
 /** @brief Compare a TimingData segment's properties with one another. */
@@ -70,7 +71,7 @@ public:
 	void Clear();
 	bool IsSafeFullTiming();
 
-	TimingData( const TimingData &cpy ) { Copy(cpy); }
+	TimingData( const TimingData &cpy ): m_bLookupBuilt(false) { Copy(cpy); }
 	TimingData& operator=( const TimingData &cpy ) { Copy(cpy); return *this; }
 
 	// GetBeatArgs, GetBeatStarts, m_beat_start_lookup, m_time_start_lookup,
@@ -84,6 +85,17 @@ public:
 	// tables are populated.  ReleaseLookup should be called after gameplay
 	// finishes so that memory isn't wasted.
 	// -Kyz
+	// The tables have an entry for every BPM change, stop, delay and warp, so
+	// a lookup is a binary search and a short walk.  They're built whole,
+	// under a lock, by the first lookup that needs them, so they work outside
+	// gameplay too, and loader, chart key and analysis threads can look up
+	// times in the same TimingData at once.  Editing a segment throws away the
+	// entries from its row on; the rest is built again by the next lookup.
+	// Times in the tables don't include the offset, so changing it doesn't
+	// affect them.  Charts with only a few segments don't use them.
+	// Changing the segments isn't thread safe, and anything that changes a
+	// segment through a pointer it got from a non-const accessor must not look
+	// up times in between getting the pointer and changing the segment.
 	struct GetBeatArgs
 	{
 		float elapsed_time;
@@ -120,14 +132,24 @@ public:
 	{
 		float first;
 		GetBeatStarts second;
-	lookup_item_t(float f, GetBeatStarts& s) :first(f), second(s) {}
+		// The warp outputs of GetBeatArgs after walking this far.
+		int warp_begin;
+		float warp_dest;
+	lookup_item_t(float f, GetBeatStarts& s) :first(f), second(s),
+			warp_begin(-1), warp_dest(0) {}
 	};
 	typedef vector<lookup_item_t> beat_start_lookup_t;
-	beat_start_lookup_t m_beat_start_lookup;
-	beat_start_lookup_t m_time_start_lookup;
+	mutable beat_start_lookup_t m_beat_start_lookup;
+	mutable beat_start_lookup_t m_time_start_lookup;
+	/** @brief Both tables reach the last segment, and won't change until a
+	 * segment does. */
+	mutable std::atomic<bool> m_bLookupBuilt;
 
 	void PrepareLookup();
 	void ReleaseLookup();
+	// Forget the lookup entries that depend on segments of type tst at or
+	// after row.  TimingSegmentType_Invalid means any type.
+	void InvalidateLookup( TimingSegmentType tst, int row = 0 );
 	void DumpOneTable(const beat_start_lookup_t& lookup, const RString& name);
 	void DumpLookupTables();
 
@@ -197,7 +219,8 @@ public:
 		} \
 		Seg* Get##Seg##AtRow( int iNoteRow ) \
 		{ \
-			return const_cast<Seg*> (((const TimingData*)this)->Get##Seg##AtRow(iNoteRow) ); \
+			TimingSegment *t = GetSegmentAtRow( iNoteRow, SegType ); \
+			return To##SegName( t ); \
 		} \
 		const Seg* Get##Seg##AtBeat( float fBeat ) const \
 		{ \
@@ -433,10 +456,12 @@ public:
 
 	const vector<TimingSegment*> &GetTimingSegments( TimingSegmentType tst ) const
 	{
-		return const_cast<TimingData *>(this)->GetTimingSegments(tst);
+		return m_avpTimingSegments[tst];
 	}
+	// The caller might change the segments, so this forgets the lookups.
 	vector<TimingSegment *> &GetTimingSegments( TimingSegmentType tst )
 	{
+		InvalidateLookup( tst );
 		return m_avpTimingSegments[tst];
 	}
 
@@ -466,6 +491,10 @@ protected:
 	// don't call this directly; use the derived-type overloads.
 	void AddSegment( const TimingSegment *seg );
 
+	void BuildLookup() const;
+	const lookup_item_t *FindBeatStart( float elapsed_time ) const;
+	const lookup_item_t *FindTimeStart( float beat ) const;
+
 	// All of the following vectors must be sorted before gameplay.
 	std::array<vector<TimingSegment *>, NUM_TimingSegmentType> m_avpTimingSegments;
 };
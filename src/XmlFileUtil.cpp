@@ -522,6 +522,103 @@ bool XmlFileUtil::SaveToFile( const XNode *pNode, const RString &sFile, const RS
 	return SaveToFile( pNode, f, sStylesheet, bWriteTabs );
 }
 
+/* Each node is its name, the number of attributes, the name and value of each,
+ * then the number of children and each child.  Strings are prefixed with their
+ * length.  Lengths and counts under 255 take one byte; larger ones are 255
+ * followed by 4 bytes. */
+static void AppendBinaryLength( RString &sOut, uint32_t iLength )
+{
+	if( iLength < 255 )
+	{
+		sOut.append( 1, (char) iLength );
+		return;
+	}
+	sOut.append( 1, (char) 255 );
+	sOut.append( (const char *) &iLength, sizeof(iLength) );
+}
+
+static void AppendBinaryString( RString &sOut, const RString &s )
+{
+	AppendBinaryLength( sOut, s.size() );
+	sOut.append( s );
+}
+
+static bool ReadBinaryLength( const char *&p, const char *pEnd, uint32_t &iOut )
+{
+	if( p == pEnd )
+		return false;
+	iOut = (unsigned char) *p++;
+	if( iOut < 255 )
+		return true;
+	if( pEnd - p < (int) sizeof(iOut) )
+		return false;
+	memcpy( &iOut, p, sizeof(iOut) );
+	p += sizeof(iOut);
+	return true;
+}
+
+static bool ReadBinaryString( const char *&p, const char *pEnd, RString &sOut )
+{
+	uint32_t iLength;
+	if( !ReadBinaryLength(p, pEnd, iLength) || uint32_t(pEnd - p) < iLength )
+		return false;
+	sOut.assign( p, iLength );
+	p += iLength;
+	return true;
+}
+
+void XmlFileUtil::GetBinary( const XNode *pNode, RString &sOut )
+{
+	AppendBinaryString( sOut, pNode->GetName() );
+
+	AppendBinaryLength( sOut, pNode->m_attrs.size() );
+	FOREACH_CONST_Attr( pNode, pAttr )
+	{
+		AppendBinaryString( sOut, pAttr->first );
+		AppendBinaryString( sOut, pAttr->second->GetValue<RString>() );
+	}
+
+	uint32_t iChildren = pNode->GetChildrenEnd() - pNode->GetChildrenBegin();
+	AppendBinaryLength( sOut, iChildren );
+	FOREACH_CONST_Child( pNode, pChild )
+		GetBinary( pChild, sOut );
+}
+
+bool XmlFileUtil::LoadFromBinary( XNode *pNode, const char *&p, const char *pEnd )
+{
+	RString sName, sValue;
+	if( !ReadBinaryString(p, pEnd, sName) )
+		return false;
+	pNode->SetName( sName );
+
+	/* Every attribute takes at least two bytes, and every child three, so
+	 * larger counts mean the data is bad. */
+	uint32_t iAttrs;
+	if( !ReadBinaryLength(p, pEnd, iAttrs) || iAttrs > uint32_t(pEnd - p) / 2 )
+		return false;
+	for( uint32_t i = 0; i < iAttrs; ++i )
+	{
+		if( !ReadBinaryString(p, pEnd, sName) || !ReadBinaryString(p, pEnd, sValue) )
+			return false;
+		pNode->AppendAttr( sName, sValue );
+	}
+
+	uint32_t iChildren;
+	if( !ReadBinaryLength(p, pEnd, iChildren) || iChildren > uint32_t(pEnd - p) / 3 )
+		return false;
+	for( uint32_t i = 0; i < iChildren; ++i )
+	{
+		XNode *pChild = new XNode;
+		if( !LoadFromBinary(pChild, p, pEnd) )
+		{
+			delete pChild;
+			return false;
+		}
+		pNode->AppendChild( pChild );
+	}
+	return true;
+}
+
 #include "LuaReference.h"
 class XNodeLuaValue: public XNodeValue
 {
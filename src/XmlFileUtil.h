@@ -21,6 +21,11 @@ namespace XmlFileUtil
 	bool SaveToFile( const XNode *pNode, const RString &sFile, const RString &sStylesheet = "", bool bWriteTabs = true );
 	bool SaveToFile( const XNode *pNode, RageFileBasic &f, const RString &sStylesheet = "", bool bWriteTabs = true );
 
+	/* A compact binary form of a tree, for files that are never edited by hand.
+	 * LoadFromBinary reads one tree from p, and advances p past it. */
+	void GetBinary( const XNode *pNode, RString &sOut );
+	bool LoadFromBinary( XNode *pNode, const char *&p, const char *pEnd );
+
 	void AnnotateXNodeTree( XNode *pNode, const RString &sFile );
 	void CompileXNodeTree( XNode *pNode, const RString &sFile );
 	XNode *XNodeFromTable( lua_State *L );
@@ -4,6 +4,7 @@
 #include "RageUtil.h"
 #include "LinuxInputManager.h"
 #include "GamePreferences.h" //needed for Axis Fix
+#include "arch/ArchHooks/ArchHooks_Unix.h"
 
 #if defined(HAVE_UNISTD_H)
 #include <unistd.h>
@@ -16,7 +17,15 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
 #include <linux/input.h>
+#include <time.h>
+
+// Newer headers hide the timeval in input_event behind these.
+#if !defined(input_event_sec)
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
 
 REGISTER_INPUT_HANDLER_CLASS2( LinuxEvent, Linux_Event );
 
@@ -57,6 +66,8 @@ struct EventDevice
 	}
 
 	int m_iFD;
+	/* The clock the kernel stamps this device's events with. */
+	clockid_t m_iClock;
 	RString m_sPath;
 	RString m_sName;
 	InputDevice m_Dev;
@@ -77,13 +88,14 @@ static bool BitIsSet( const uint8_t *pArray, uint32_t iBit )
 EventDevice::EventDevice()
 {
 	m_iFD = -1;
+	m_iClock = CLOCK_REALTIME;
 }
 
 bool EventDevice::Open( RString sFile, InputDevice dev )
 {
 	m_sPath = sFile;
 	m_Dev = dev;
-	m_iFD = open( sFile, O_RDWR );
+	m_iFD = open( sFile, O_RDWR | O_NONBLOCK );
 	if( m_iFD == -1 )
 	{
 		// HACK: Let the caller handle errno.
@@ -101,6 +113,18 @@ bool EventDevice::Open( RString sFile, InputDevice dev )
 			LOG->Info( "Event driver: v%i.%i.%i", (iVersion >> 16) & 0xFF, (iVersion >> 8) & 0xFF, iVersion & 0xFF ); 
 	}
 
+	/* Have the kernel stamp events with the clock RageTimer uses, so the
+	 * timestamps survive changes to the system clock.  Older kernels only
+	 * have the realtime clock. */
+	m_iClock = CLOCK_REALTIME;
+#if defined(EVIOCSCLOCKID)
+	int iClock = CLOCK_MONOTONIC;
+	if( ioctl(m_iFD, EVIOCSCLOCKID, &iClock) == -1 )
+		LOG->Warn( "ioctl(EVIOCSCLOCKID): %s", strerror(errno) );
+	else
+		m_iClock = CLOCK_MONOTONIC;
+#endif
+
 	char szName[1024];
 	if( ioctl(m_iFD, EVIOCGNAME(sizeof(szName)), szName) == -1 )
 	{
@@ -332,102 +356,148 @@ int InputHandler_Linux_Event::InputThread_Start( void *p )
 	return 0;
 }
 
+/* Convert an event's kernel timestamp to a RageTimer.  iClockOffset is the
+ * difference between the RageTimer clock and the device's clock. */
+static RageTimer EventTimeToRageTimer( const input_event &event, int64_t iClockOffset, const RageTimer &now )
+{
+	const int64_t iUsecs = int64_t(event.input_event_sec) * 1000000 + event.input_event_usec + iClockOffset;
+	RageTimer ts( unsigned(iUsecs / 1000000), unsigned(iUsecs % 1000000) );
+
+	// Never stamp an event later than it was read.
+	if( iUsecs <= 0 || now < ts )
+		return now;
+	return ts;
+}
+
+static int64_t GetClockOffset( clockid_t iClock )
+{
+	// RageTimer normally runs on CLOCK_MONOTONIC, so there's nothing to convert.
+	if( iClock == CLOCK_MONOTONIC && ArchHooks_Unix::GetClock() == CLOCK_MONOTONIC )
+		return 0;
+
+	timespec ts;
+	clock_gettime( iClock, &ts );
+	const int64_t iDeviceUsecs = int64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+	return ArchHooks::GetMicrosecondsSinceStart( true ) - iDeviceUsecs;
+}
+
 void InputHandler_Linux_Event::InputThread()
 {
-	while( !m_bShutdown )
+	int iEpollFD = epoll_create1( EPOLL_CLOEXEC );
+	if( iEpollFD == -1 )
 	{
-		fd_set fdset;
-		FD_ZERO( &fdset );
-		int iMaxFD = -1;
-		
-		for( int i = 0; i < (int) g_apEventDevices.size(); ++i )
-		{
-			int iFD = g_apEventDevices[i]->m_iFD;
-			if( !g_apEventDevices[i]->IsOpen() )
-				continue;
+		LOG->Warn( "epoll_create1: %s", strerror(errno) );
+		return;
+	}
 
-			FD_SET( iFD, &fdset );
-			iMaxFD = max( iMaxFD, iFD );
-		}
+	// Devices are only added while this thread is stopped.
+	int iOpenDevices = 0;
+	for( int i = 0; i < (int) g_apEventDevices.size(); ++i )
+	{
+		if( !g_apEventDevices[i]->IsOpen() )
+			continue;
 
-		if( iMaxFD == -1 )
-			break;
+		epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.ptr = g_apEventDevices[i];
+		if( epoll_ctl(iEpollFD, EPOLL_CTL_ADD, g_apEventDevices[i]->m_iFD, &ev) == -1 )
+		{
+			LOG->Warn( "epoll_ctl(%s): %s", g_apEventDevices[i]->m_sPath.c_str(), strerror(errno) );
+			continue;
+		}
+		++iOpenDevices;
+	}
 
-		struct timeval zero = {0,100000};
-		if( select(iMaxFD+1, &fdset, nullptr, nullptr, &zero) <= 0 )
+	while( !m_bShutdown && iOpenDevices > 0 )
+	{
+		epoll_event aReady[16];
+		int iReady = epoll_wait( iEpollFD, aReady, ARRAYLEN(aReady), 100 );
+		if( iReady <= 0 )
 			continue;
 		RageTimer now;
 
-		for( int i = 0; i < (int) g_apEventDevices.size(); ++i )
+		for( int i = 0; i < iReady; ++i )
 		{
-			if( !g_apEventDevices[i]->IsOpen() )
-				continue;
-
-			if( !FD_ISSET(g_apEventDevices[i]->m_iFD, &fdset) )
+			EventDevice *pDev = (EventDevice *) aReady[i].data.ptr;
+			if( !pDev->IsOpen() )
 				continue;
 
-			input_event event;
-			int ret = read( g_apEventDevices[i]->m_iFD, &event, sizeof(event) );
+			/* Read everything that's waiting at once; a chord on a pad arrives
+			 * as several events.  If there's more than fits, epoll will wake
+			 * us again right away for the rest. */
+			input_event aEvents[64];
+			int ret = read( pDev->m_iFD, aEvents, sizeof(aEvents) );
 			if( ret == -1 )
 			{
-				LOG->Warn( "Error reading from %s: %s; disabled", g_apEventDevices[i]->m_sPath.c_str(), strerror(errno) );
-				g_apEventDevices[i]->Close();
+				if( errno == EAGAIN || errno == EINTR )
+					continue;
+				LOG->Warn( "Error reading from %s: %s; disabled", pDev->m_sPath.c_str(), strerror(errno) );
+				pDev->Close();
+				--iOpenDevices;
 				continue;
 			}
 
-			if( ret != sizeof(event) )
+			if( ret % sizeof(input_event) != 0 )
 			{
-				LOG->Warn("Unexpected packet (size %i != %i) from joystick %i; disabled", ret, (int)sizeof(event), i);
-				g_apEventDevices[i]->Close();
+				LOG->Warn( "Unexpected packet (size %i, not a multiple of %i) from %s; disabled",
+					ret, (int) sizeof(input_event), pDev->m_sPath.c_str() );
+				pDev->Close();
+				--iOpenDevices;
 				continue;
 			}
 
-			switch (event.type) {
-			case EV_KEY: {
-				int iNum;
-				if (event.code >= BTN_JOYSTICK && event.code <= BTN_JOYSTICK + 0xf) {
-					// These guys have arbitrary names, but the kernel code in hid-input.c maps exactly 0xf of them.
-					iNum = event.code - BTN_JOYSTICK;
-				} else if (event.code >= BTN_TRIGGER_HAPPY1 && event.code <= BTN_TRIGGER_HAPPY40) {
-					// Actually, we only have 32 buttons defined.
-					iNum = event.code - BTN_TRIGGER_HAPPY1 + 0x10;
-				} else {
-					// If the button number is >40+0xf, it gets mapped to a code with no #define.
-					// I don't know if this is appropriate at all, but what else to do?
-					iNum = event.code;
-				}
-				wrap( iNum, 32 );	// max number of joystick buttons.  Make this a constant?
-				ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, enum_add2(JOY_BUTTON_1, iNum), event.value != 0, now) );
-				break;
-			}
-				
-			case EV_ABS: {
-				ASSERT_M( event.code < ABS_MAX, ssprintf("%i", event.code) );
-				DeviceButton neg = g_apEventDevices[i]->aiAbsMappingLow[event.code];
-				DeviceButton pos = g_apEventDevices[i]->aiAbsMappingHigh[event.code];
-
-				float l = SCALE( int(event.value), (float) g_apEventDevices[i]->aiAbsMin[event.code], (float) g_apEventDevices[i]->aiAbsMax[event.code], -1.0f, 1.0f );
-				if (GamePreferences::m_AxisFix)
-				{
-				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, neg, (l < -0.5)||((l > 0.0001)&&(l < 0.5)), now) ); //Up if between 0.0001 and 0.5 or if less than -0.5
-				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, pos, (l > 0.5)||((l > 0.0001)&&(l < 0.5)) , now) ); //Down if between 0.0001 and 0.5 or if more than 0.5
-				}
-				else
-				{
-				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, neg, max(-l,0), now) );
-				  ButtonPressed( DeviceInput(g_apEventDevices[i]->m_Dev, pos, max(+l,0), now) );
-				}
-				break;
-			}
-			}
-
+			const int64_t iClockOffset = GetClockOffset( pDev->m_iClock );
+			for( int e = 0; e < ret / (int) sizeof(input_event); ++e )
+				ProcessEvent( pDev, aEvents[e], EventTimeToRageTimer(aEvents[e], iClockOffset, now) );
 		}
-
 	}
 
+	close( iEpollFD );
 	InputHandler::UpdateTimer();
 }
 
+void InputHandler_Linux_Event::ProcessEvent( EventDevice *pDev, const input_event &event, const RageTimer &ts )
+{
+	switch (event.type) {
+	case EV_KEY: {
+		int iNum;
+		if (event.code >= BTN_JOYSTICK && event.code <= BTN_JOYSTICK + 0xf) {
+			// These guys have arbitrary names, but the kernel code in hid-input.c maps exactly 0xf of them.
+			iNum = event.code - BTN_JOYSTICK;
+		} else if (event.code >= BTN_TRIGGER_HAPPY1 && event.code <= BTN_TRIGGER_HAPPY40) {
+			// Actually, we only have 32 buttons defined.
+			iNum = event.code - BTN_TRIGGER_HAPPY1 + 0x10;
+		} else {
+			// If the button number is >40+0xf, it gets mapped to a code with no #define.
+			// I don't know if this is appropriate at all, but what else to do?
+			iNum = event.code;
+		}
+		wrap( iNum, 32 );	// max number of joystick buttons.  Make this a constant?
+		ButtonPressed( DeviceInput(pDev->m_Dev, enum_add2(JOY_BUTTON_1, iNum), event.value != 0, ts) );
+		break;
+	}
+
+	case EV_ABS: {
+		ASSERT_M( event.code < ABS_MAX, ssprintf("%i", event.code) );
+		DeviceButton neg = pDev->aiAbsMappingLow[event.code];
+		DeviceButton pos = pDev->aiAbsMappingHigh[event.code];
+
+		float l = SCALE( int(event.value), (float) pDev->aiAbsMin[event.code], (float) pDev->aiAbsMax[event.code], -1.0f, 1.0f );
+		if (GamePreferences::m_AxisFix)
+		{
+		  ButtonPressed( DeviceInput(pDev->m_Dev, neg, (l < -0.5)||((l > 0.0001)&&(l < 0.5)), ts) ); //Up if between 0.0001 and 0.5 or if less than -0.5
+		  ButtonPressed( DeviceInput(pDev->m_Dev, pos, (l > 0.5)||((l > 0.0001)&&(l < 0.5)) , ts) ); //Down if between 0.0001 and 0.5 or if more than 0.5
+		}
+		else
+		{
+		  ButtonPressed( DeviceInput(pDev->m_Dev, neg, max(-l,0), ts) );
+		  ButtonPressed( DeviceInput(pDev->m_Dev, pos, max(+l,0), ts) );
+		}
+		break;
+	}
+	}
+}
+
 void InputHandler_Linux_Event::GetDevicesAndDescriptions( vector<InputDeviceInfo>& vDevicesOut )
 {
 	for( unsigned i = 0; i < g_apEventDevices.size(); ++i )
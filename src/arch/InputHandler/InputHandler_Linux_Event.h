@@ -6,6 +6,8 @@
 #include "InputHandler.h"
 #include "RageThreads.h"
 
+struct EventDevice;
+struct input_event;
 
 class InputHandler_Linux_Event: public InputHandler
 {
@@ -21,6 +23,7 @@ private:
 	void StopThread();
 	static int InputThread_Start( void *p );
 	void InputThread();
+	void ProcessEvent( EventDevice *pDev, const input_event &event, const RageTimer &ts );
 
 	RageThread m_InputThread;
 	InputDevice m_NextDevice;
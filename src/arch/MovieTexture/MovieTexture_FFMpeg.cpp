@@ -277,7 +277,11 @@ int MovieDecoder_FFMpeg::DecodePacket( float fTargetTime )
 		 * to give it a buffer to read from since it tries to read anyway. */
 		m_Packet.data = m_Packet.size ? m_Packet.data : nullptr;
 		len = m_Packet.size;
-		avcodec::avcodec_send_packet(m_pStreamCodec, &m_Packet);
+		/* With frame threading, the decoder may be holding as many frames as
+		 * it has threads.  If it won't take the packet until one is taken out,
+		 * send the packet again next time. */
+		if( avcodec::avcodec_send_packet(m_pStreamCodec, &m_Packet) == AVERROR(EAGAIN) )
+			len = 0;
 		iGotFrame = !avcodec::avcodec_receive_frame(m_pStreamCodec, m_Frame);
 
 		if( len < 0 )
@@ -471,6 +475,11 @@ RString MovieDecoder_FFMpeg::OpenCodec()
 	m_pStreamCodec->idct_algo         = FF_IDCT_AUTO;
 	m_pStreamCodec->error_concealment = 3;
 
+	/* Decode on as many threads as there are CPUs.  Frame threading holds
+	 * frames back a frame per thread; the decoder thread's queue hides that. */
+	m_pStreamCodec->thread_count = 0;
+	m_pStreamCodec->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
 	LOG->Trace("Opening codec %s", pCodec->name );
 
 	int ret = avcodec::avcodec_open2( m_pStreamCodec, pCodec, nullptr );
@@ -4,6 +4,7 @@
 #include "RageDisplay.h"
 #include "RageLog.h"
 #include "RageSurface.h"
+#include "RageSurfaceUtils.h"
 #include "RageTextureManager.h"
 #include "RageTextureRenderTarget.h"
 #include "RageUtil.h"
@@ -17,8 +18,12 @@
 
 static Preference<bool> g_bMovieTextureDirectUpdates( "MovieTextureDirectUpdates", true );
 
+/* How many frames to decode ahead of the one being shown. */
+static const int MAX_QUEUED_FRAMES = 4;
+
 MovieTexture_Generic::MovieTexture_Generic( RageTextureID ID, MovieDecoder *pDecoder ):
-	RageMovieTexture( ID )
+	RageMovieTexture( ID ),
+	m_Event( "MovieTexture" )
 {
 	LOG->Trace( "MovieTexture_Generic::MovieTexture_Generic(%s)", ID.filename.c_str() );
 
@@ -30,10 +35,13 @@ MovieTexture_Generic::MovieTexture_Generic( RageTextureID ID, MovieDecoder *pDec
 	m_bLoop = true;
 	m_pSurface = nullptr;
 	m_pTextureLock = nullptr;
-	m_ImageWaiting = FRAME_NONE;
 	m_fRate = 1;
 	m_bWantRewind = false;
+	m_bDecoderDone = false;
+	m_iGeneration = 0;
+	m_State = DECODER_QUIT;
 	m_fClock = 0;
+	m_fLoopStart = 0;
 	m_bFrameSkipMode = false;
 	m_pSprite = new Sprite;
 }
@@ -57,13 +65,21 @@ RString MovieTexture_Generic::Init()
 		return ssprintf( "%s: EOF getting first frame", GetID().filename.c_str() );
 	}
 
-	m_ImageWaiting = FRAME_DECODED;
-
 	LOG->Trace( "Resolution: %ix%i (%ix%i, %ix%i)",
 			m_iSourceWidth, m_iSourceHeight,
 			m_iImageWidth, m_iImageHeight, m_iTextureWidth, m_iTextureHeight );
 
-	UpdateFrame();
+	/* Enough surfaces for a full queue, the frame being decoded and the one
+	 * being uploaded. */
+	for( int i = 0; i < MAX_QUEUED_FRAMES + 2; ++i )
+		m_apFreeSurfaces.push_back( CreateFrameSurface() );
+
+	m_pDecoder->GetFrame( m_apFreeSurfaces.back() );
+	UpdateFrame( m_apFreeSurfaces.back() );
+
+	m_State = DECODER_RUNNING;
+	m_DecoderThread.SetName( ssprintf("Movie decoder (%s)", GetID().filename.c_str()) );
+	m_DecoderThread.Create( DecoderThread_Start, this );
 
 	CHECKPOINT_M("Generic initialization completed. No errors found.");
 
@@ -72,6 +88,8 @@ RString MovieTexture_Generic::Init()
 
 MovieTexture_Generic::~MovieTexture_Generic()
 {
+	StopDecoderThread();
+
 	if( m_pDecoder )
 		m_pDecoder->Close();
 
@@ -81,6 +99,42 @@ MovieTexture_Generic::~MovieTexture_Generic()
 	DestroyTexture();
 
 	delete m_pDecoder;
+
+	FlushFrames();
+	for( RageSurface *pSurface : m_apFreeSurfaces )
+		delete pSurface;
+}
+
+void MovieTexture_Generic::StopDecoderThread()
+{
+	if( !m_DecoderThread.IsCreated() )
+		return;
+
+	m_Event.Lock();
+	m_State = DECODER_QUIT;
+	m_Event.Broadcast();
+	m_Event.Unlock();
+
+	m_DecoderThread.Wait();
+}
+
+/* Give the surfaces of every queued frame back, and drop the frame being
+ * decoded, if any. */
+void MovieTexture_Generic::FlushFrames()
+{
+	for( Frame const &f : m_Frames )
+		m_apFreeSurfaces.push_back( f.pSurface );
+	m_Frames.clear();
+	++m_iGeneration;
+}
+
+/* A surface for a decoded frame, in the same format as m_pSurface.  This is
+ * only memory, so it doesn't need DISPLAY. */
+RageSurface *MovieTexture_Generic::CreateFrameSurface() const
+{
+	const RageSurfaceFormat *pFormat = m_pSurface->format;
+	return CreateSurface( m_pSurface->w, m_pSurface->h, pFormat->BitsPerPixel,
+		pFormat->Mask[0], pFormat->Mask[1], pFormat->Mask[2], pFormat->Mask[3] );
 }
 
 /* Delete the surface and texture.  The decoding thread must be stopped, and this
@@ -300,149 +354,131 @@ void MovieTexture_Generic::CreateTexture()
 	m_uTexHandle = DISPLAY->CreateTexture( pixfmt, m_pSurface, false );
 }
 
-/* Handle decoding for a frame.  Return true if a frame was decoded, false if not
- * (due to quit, error, EOF, etc).  If true is returned, we'll be in FRAME_DECODED. */
-bool MovieTexture_Generic::DecodeFrame()
+/* Decode frames ahead of the clock into m_Frames, until told to quit. */
+void MovieTexture_Generic::DecoderThread()
 {
-	bool bTriedRewind = false;
-	do
+	/* If we fall this far behind, we're short on CPU.  Skip frames until
+	 * we've caught up. */
+	const float FrameSkipThreshold = 0.5f;
+
+	m_Event.Lock();
+	while( m_State != DECODER_QUIT )
 	{
 		if( m_bWantRewind )
 		{
-			if( bTriedRewind )
-			{
-				LOG->Trace( "File \"%s\" looped more than once in one frame", GetID().filename.c_str() );
-				return false;
-			}
 			m_bWantRewind = false;
-			bTriedRewind = true;
-
-			/* When resetting the clock, set it back by the length of the last frame,
-			 * so it has a proper delay. */
-			float fDelay = m_pDecoder->GetFrameDuration();
+			m_Event.Unlock();
 
-			/* Restart. */
 			m_pDecoder->Rewind();
+			m_fLoopStart = 0;
+			m_bFrameSkipMode = false;
 
-			m_fClock = -fDelay;
+			m_Event.Lock();
+			continue;
 		}
 
-		/* Read a frame. */
-		float fTargetTime = -1;
-		if( m_bFrameSkipMode && m_fClock > m_pDecoder->GetTimestamp() )
-			fTargetTime = m_fClock;
+		if( m_bDecoderDone || (int) m_Frames.size() >= MAX_QUEUED_FRAMES || m_apFreeSurfaces.empty() )
+		{
+			m_Event.Wait();
+			continue;
+		}
 
-		int ret = m_pDecoder->DecodeFrame( fTargetTime );
-		if( ret == -1 )
-			return false;
+		const float fBehind = m_fClock - (m_fLoopStart + m_pDecoder->GetTimestamp());
+		if( fBehind >= FrameSkipThreshold && !m_bFrameSkipMode )
+		{
+			LOG->Trace( "(%s) Time is %f, and the movie is at %f.  Entering frame skip mode.",
+				GetID().filename.c_str(), m_fClock, m_fLoopStart + m_pDecoder->GetTimestamp() );
+			m_bFrameSkipMode = true;
+		}
+		else if( fBehind <= 0 && m_bFrameSkipMode )
+		{
+			/* We're caught up; stop skipping frames. */
+			LOG->Trace( "stopped skipping frames" );
+			m_bFrameSkipMode = false;
+		}
 
-		if( m_bWantRewind && m_pDecoder->GetTimestamp() == 0 )
-			m_bWantRewind = false; /* ignore */
+		const float fTargetTime = m_bFrameSkipMode? m_fClock - m_fLoopStart: -1;
+		const bool bLoop = m_bLoop;
+		const int iGeneration = m_iGeneration;
+		RageSurface *pSurface = m_apFreeSurfaces.back();
+		m_apFreeSurfaces.pop_back();
+		m_Event.Unlock();
 
-		if( ret == 0 )
+		int ret = m_pDecoder->DecodeFrame( fTargetTime );
+		if( ret == 0 && bLoop )
 		{
-			/* EOF. */
-			if( !m_bLoop )
-				return false;
-
 			LOG->Trace( "File \"%s\" looping", GetID().filename.c_str() );
-			m_bWantRewind = true;
-			continue;
-		}
-
-		/* We got a frame. */
-	} while( m_bWantRewind );
 
-	return true;
-}
+			/* Start the next loop once the last frame has been shown for
+			 * its duration. */
+			m_fLoopStart += m_pDecoder->GetTimestamp() + m_pDecoder->GetFrameDuration();
+			m_pDecoder->Rewind();
+			ret = m_pDecoder->DecodeFrame( -1 );
+		}
 
-/*
- * Returns:
- *  == 0 if the currently decoded frame is ready to be displayed
- *   > 0 (seconds) if it's not yet time to display;
- */
-float MovieTexture_Generic::CheckFrameTime()
-{
-	if( m_fRate == 0 )
-		return 1;	// "a long time until the next frame"
+		if( ret == 1 )
+			m_pDecoder->GetFrame( pSurface );
 
-	const float fOffset = (m_pDecoder->GetTimestamp() - m_fClock) / m_fRate;
+		m_Event.Lock();
 
-	/* If we're ahead, we're decoding too fast; delay. */
-	if( fOffset > 0.00001f )
-	{
-		if( m_bFrameSkipMode )
+		/* If we were rewound while decoding, this frame, end of file or error
+		 * is from before; the rewind is still pending, so just drop it. */
+		if( iGeneration != m_iGeneration )
 		{
-			/* We're caught up; stop skipping frames. */
-			LOG->Trace( "stopped skipping frames" );
-			m_bFrameSkipMode = false;
+			m_apFreeSurfaces.push_back( pSurface );
+			continue;
 		}
-		return fOffset;
-	}
 
-	/*
-	 * We're behind by -Offset seconds.  
-	 *
-	 * If we're just slightly behind, don't worry about it; we'll simply
-	 * not sleep, so we'll move as fast as we can to catch up.
-	 *
-	 * If we're far behind, we're short on CPU.  Skip texture updates; this
-	 * is a big bottleneck on many systems.
-	 *
-	 * If we hit a threshold, start skipping frames via #1.  If we do that,
-	 * don't stop once we hit the threshold; keep doing it until we're fully
-	 * caught up.
-	 *
-	 * We should try to notice if we simply don't have enough CPU for the video;
-	 * it's better to just stay in frame skip mode than to enter and exit it
-	 * constantly, but we don't want to do that due to a single timing glitch.
-	 */
-	const float FrameSkipThreshold = 0.5f;
+		if( ret != 1 )
+		{
+			if( ret == -1 )
+				LOG->Trace( "File \"%s\": error decoding a frame", GetID().filename.c_str() );
+			m_bDecoderDone = true;
+			m_apFreeSurfaces.push_back( pSurface );
+			continue;
+		}
 
-	if( -fOffset >= FrameSkipThreshold && !m_bFrameSkipMode )
-	{
-		LOG->Trace( "(%s) Time is %f, and the movie is at %f.  Entering frame skip mode.",
-			GetID().filename.c_str(), m_fClock, m_pDecoder->GetTimestamp() );
-		m_bFrameSkipMode = true;
+		Frame f;
+		f.pSurface = pSurface;
+		f.fTime = m_fLoopStart + m_pDecoder->GetTimestamp();
+		m_Frames.push_back( f );
 	}
-
-	return 0;
+	m_Event.Unlock();
 }
 
-/* Decode data. */
+/* Show the frame for the new time, if it's been decoded. */
 void MovieTexture_Generic::DecodeSeconds( float fSeconds )
 {
-	m_fClock += fSeconds * m_fRate;
-
-	/* We might need to decode more than one frame per update.  However, there
-	 * have been bugs in ffmpeg that cause it to not handle EOF properly, which
-	 * could make this never return, so let's play it safe. */
-	int iMax = 4;
-	while( --iMax )
+	RageSurface *pFrame = nullptr;
 	{
-		/* If we don't have a frame decoded, decode one. */
-		if( m_ImageWaiting == FRAME_NONE )
-		{
-			if( !DecodeFrame() )
-				break;
-
-			m_ImageWaiting = FRAME_DECODED;
-		}
+		LockMut( m_Event );
+		m_fClock += fSeconds * m_fRate;
 
-		/* If we have a frame decoded, see if it's time to display it. */
-		float fTime = CheckFrameTime();
-		if ( fTime <= 0 )
+		/* Show the newest frame that's due.  If more than one is, we're
+		 * behind, so drop the older ones. */
+		while( !m_Frames.empty() && m_Frames.front().fTime <= m_fClock )
 		{
-			UpdateFrame();
-			m_ImageWaiting = FRAME_NONE;
+			if( pFrame != nullptr )
+				m_apFreeSurfaces.push_back( pFrame );
+			pFrame = m_Frames.front().pSurface;
+			m_Frames.pop_front();
 		}
-		return;
+
+		if( pFrame == nullptr )
+			return;
+
+		/* There's room in the queue now. */
+		m_Event.Broadcast();
 	}
 
-	LOG->MapLog( "movie_looping", "MovieTexture_Generic::Update looping" );
+	UpdateFrame( pFrame );
+
+	LockMut( m_Event );
+	m_apFreeSurfaces.push_back( pFrame );
+	m_Event.Broadcast();
 }
 
-void MovieTexture_Generic::UpdateFrame()
+void MovieTexture_Generic::UpdateFrame( RageSurface *pFrame )
 {
 	/* Just in case we were invalidated: */
 	CreateTexture();
@@ -451,11 +487,9 @@ void MovieTexture_Generic::UpdateFrame()
 	{
 		uintptr_t iHandle = m_pTextureIntermediate != nullptr? m_pTextureIntermediate->GetTexHandle(): this->GetTexHandle();
 		m_pTextureLock->Lock( iHandle, m_pSurface );
-	}
-
-	m_pDecoder->GetFrame( m_pSurface );
-	if( m_pTextureLock != nullptr )
+		RageSurfaceUtils::CopySurface( pFrame, m_pSurface );
 		m_pTextureLock->Unlock( m_pSurface, true );
+	}
 
 	if( m_pRenderTarget != nullptr )
 	{
@@ -466,9 +500,9 @@ void MovieTexture_Generic::UpdateFrame()
 		{
 			DISPLAY->UpdateTexture(
 				m_pTextureIntermediate->GetTexHandle(),
-				m_pSurface,
+				pFrame,
 				0, 0,
-				m_pSurface->w, m_pSurface->h );
+				pFrame->w, pFrame->h );
 		}
 		m_pRenderTarget->BeginRenderingTo( false );
 		m_pSprite->Draw();
@@ -480,7 +514,7 @@ void MovieTexture_Generic::UpdateFrame()
 		{
 			DISPLAY->UpdateTexture(
 				m_uTexHandle,
-				m_pSurface,
+				pFrame,
 				0, 0,
 				m_iImageWidth, m_iImageHeight );
 		}
@@ -515,7 +549,23 @@ void MovieTexture_Generic::SetPosition( float fSeconds )
 	}
 
 	LOG->Trace( "Seek to %f", fSeconds );
+	LockMut( m_Event );
+	FlushFrames();
 	m_bWantRewind = true;
+	m_bDecoderDone = false;
+	m_fClock = 0;
+	m_Event.Broadcast();
+}
+
+void MovieTexture_Generic::SetLooping( bool bLooping )
+{
+	LockMut( m_Event );
+	m_bLoop = bLooping;
+
+	/* If we stopped at the end, pick up again from there. */
+	if( bLooping )
+		m_bDecoderDone = false;
+	m_Event.Broadcast();
 }
 
 uintptr_t MovieTexture_Generic::GetTexHandle() const
@@ -2,6 +2,9 @@
 #define RAGE_MOVIE_TEXTURE_GENERIC_H
 
 #include "MovieTexture.h"
+#include "RageThreads.h"
+
+#include <deque>
 
 class FFMpeg_Helper;
 struct RageSurface;
@@ -92,7 +95,7 @@ public:
 	virtual void SetPosition( float fSeconds );
 	virtual void DecodeSeconds( float fSeconds );
 	virtual void SetPlaybackRate( float fRate ) { m_fRate = fRate; }
-	void SetLooping( bool bLooping=true ) { m_bLoop = bLooping; }
+	void SetLooping( bool bLooping=true );
 	uintptr_t GetTexHandle() const;
 
 	static EffectMode GetEffectMode( MovieDecoderPixelFormatYCbCr fmt );
@@ -101,12 +104,28 @@ private:
 	MovieDecoder *m_pDecoder;
 
 	float m_fRate;
-	enum {
-		FRAME_NONE, /* no frame available; call GetFrame to get one */
-		FRAME_DECODED /* frame decoded; waiting until it's time to display it */
-	} m_ImageWaiting;
+
+	/*
+	 * Frames are decoded and converted in m_DecoderThread, ahead of when
+	 * they're shown, so the main thread only has to upload them.  m_Event
+	 * protects everything from here to m_State, and m_fClock.
+	 */
+	RageThread m_DecoderThread;
+	RageEvent m_Event;
+	struct Frame
+	{
+		RageSurface *pSurface;
+		float fTime;	// on m_fClock
+	};
+	std::deque<Frame> m_Frames;
+	vector<RageSurface *> m_apFreeSurfaces;
 	bool m_bLoop;
 	bool m_bWantRewind;
+	/* Set when the movie ended and isn't looping, or failed. */
+	bool m_bDecoderDone;
+	/* Incremented when the queue is flushed, so a frame that was being
+	 * decoded at the time is dropped. */
+	int m_iGeneration;
 
 	enum State { DECODER_QUIT, DECODER_RUNNING } m_State;
 
@@ -119,17 +138,27 @@ private:
 
 	RageTextureLock *m_pTextureLock;
 
-	/* The time the movie is actually at: */
+	/* The time the movie is actually at.  This keeps counting when the movie
+	 * loops. */
 	float m_fClock;
+
+	/* Only used by the decoder thread: the time on m_fClock that the
+	 * current loop of the movie started. */
+	float m_fLoopStart;
 	bool m_bFrameSkipMode;
 
-	void UpdateFrame();
+	static int DecoderThread_Start( void *p ) { ((MovieTexture_Generic *) p)->DecoderThread(); return 0; }
+	void DecoderThread();
+	void StopDecoderThread();
+	/* m_Event must be locked. */
+	void FlushFrames();
+
+	void UpdateFrame( RageSurface *pFrame );
 
 	void CreateTexture();
 	void DestroyTexture();
 
-	bool DecodeFrame();
-	float CheckFrameTime();
+	RageSurface *CreateFrameSurface() const;
 };
 
 #endif
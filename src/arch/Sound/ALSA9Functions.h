@@ -43,6 +43,9 @@ FUNC(unsigned int, snd_pcm_info_get_subdevices_count, (const snd_pcm_info_t *obj
 FUNC(void, snd_pcm_info_set_device, (snd_pcm_info_t *obj, unsigned int val));
 FUNC(void, snd_pcm_info_set_stream, (snd_pcm_info_t *obj, snd_pcm_stream_t val));
 FUNC(snd_pcm_sframes_t, snd_pcm_mmap_writei, (snd_pcm_t *pcm, const void *buffer, snd_pcm_uframes_t size));
+FUNC(int, snd_pcm_mmap_begin, (snd_pcm_t *pcm, const snd_pcm_channel_area_t **areas, snd_pcm_uframes_t *offset, snd_pcm_uframes_t *frames));
+FUNC(snd_pcm_sframes_t, snd_pcm_mmap_commit, (snd_pcm_t *pcm, snd_pcm_uframes_t offset, snd_pcm_uframes_t frames));
+FUNC(int, snd_pcm_start, (snd_pcm_t *pcm));
 FUNC(int, snd_pcm_open, (snd_pcm_t **pcm, const char *name, snd_pcm_stream_t stream, int mode));
 FUNC(int, snd_pcm_prepare, (snd_pcm_t *pcm));
 FUNC(int, snd_pcm_resume, (snd_pcm_t *pcm));
@@ -217,6 +217,8 @@ Alsa9Buf::Alsa9Buf()
 	preferred_writeahead = 8192;
 	preferred_chunksize = 1024;
 	pcm = nullptr;
+	mmap_offset = 0;
+	can_write_directly = true;
 }
 
 RString Alsa9Buf::Init( int channels_,
@@ -358,6 +360,58 @@ void Alsa9Buf::Write( const int16_t *buffer, int frames )
 }
 
 
+int16_t *Alsa9Buf::BeginWrite( int &frames )
+{
+	if( !can_write_directly )
+		return nullptr;
+
+	const snd_pcm_channel_area_t *areas;
+	snd_pcm_uframes_t size = frames;
+	int err = dsnd_pcm_mmap_begin( pcm, &areas, &mmap_offset, &size );
+	if( err < 0 )
+	{
+		LOG->Trace( "RageSoundDriver_ALSA9::GetData: dsnd_pcm_mmap_begin: %s", dsnd_strerror(err) );
+		Recover( err );
+		return nullptr;
+	}
+
+	/* We can only mix straight into the buffer if it's the same interleaved
+	 * frames we'd have passed to Write. */
+	const unsigned bits_per_frame = samplebits * channels;
+	for( int c = 0; c < channels; ++c )
+	{
+		if( areas[c].addr != areas[0].addr || areas[c].first != c * (unsigned) samplebits || areas[c].step != bits_per_frame )
+		{
+			LOG->Info( "ALSA: device buffer isn't interleaved; copying sound into it" );
+			can_write_directly = false;
+			dsnd_pcm_mmap_commit( pcm, mmap_offset, 0 );
+			return nullptr;
+		}
+	}
+
+	frames = size;
+	return (int16_t *) ((char *) areas[0].addr + mmap_offset * bits_per_frame / 8);
+}
+
+void Alsa9Buf::CommitWrite( int frames )
+{
+	snd_pcm_sframes_t wrote = dsnd_pcm_mmap_commit( pcm, mmap_offset, frames );
+	if( wrote < 0 )
+	{
+		LOG->Trace( "RageSoundDriver_ALSA9::GetData: dsnd_pcm_mmap_commit: %s (%i)", dsnd_strerror(wrote), (int) wrote );
+		Recover( wrote );
+		return;
+	}
+
+	last_cursor_pos += wrote;
+
+	/* Unlike Write, committing doesn't start the stream. */
+	if( dsnd_pcm_state(pcm) == SND_PCM_STATE_PREPARED )
+	{
+		int err = dsnd_pcm_start( pcm );
+		ALSA_ASSERT("dsnd_pcm_start");
+	}
+}
 
 /*
  * When the play buffer underruns, subsequent writes to the buffer
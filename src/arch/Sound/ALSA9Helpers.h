@@ -18,6 +18,10 @@ private:
 
 	snd_pcm_t *pcm;
 
+	/* The area handed out by BeginWrite, until CommitWrite. */
+	snd_pcm_uframes_t mmap_offset;
+	bool can_write_directly;
+
 	bool Recover( int r );
 	bool SetHWParams();
 	bool SetSWParams();
@@ -39,11 +43,21 @@ public:
 	int GetNumFramesToFill();
 	bool WaitUntilFramesCanBeFilled( int timeout_ms );
 	void Write( const int16_t *buffer, int frames );
+
+	/* Write into the device buffer directly, instead of copying with Write.
+	 * frames is the number wanted, and is set to the number that can be
+	 * written, which may be fewer if the buffer wraps.  Returns nullptr if
+	 * the device's buffer isn't plain interleaved frames; use Write. */
+	int16_t *BeginWrite( int &frames );
+	void CommitWrite( int frames );
 	
 	void Play();
 	void Stop();
 	void SetVolume(float vol);
 	int GetSampleRate() const { return samplerate; }
+	/* The frames actually buffered ahead, after the hardware's adjustments. */
+	int GetWriteahead() const { return max( writeahead, chunksize*2 ); }
+	int GetChunkSize() const { return chunksize; }
 
 	int64_t GetPosition() const;
 	int64_t GetPlayPos() const { return last_cursor_pos; }
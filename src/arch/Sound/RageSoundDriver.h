@@ -7,6 +7,8 @@
 #include "RageTimer.h"
 #include "RageUtil_CircularBuffer.h"
 
+#include <atomic>
+
 class RageSoundBase;
 class RageTimer;
 class RageSoundMixBuffer;
@@ -67,6 +69,26 @@ public:
 
 	virtual int GetSampleRate() const { return 44100; }
 
+	struct DecodeStats
+	{
+		/** @brief Times a playing sound ran out of decoded data while mixing. */
+		int iUnderruns;
+		/** @brief Times the decoding thread was woken to refill buffers. */
+		int iDecodePasses;
+		/** @brief Time from the mixer waking the decoding thread to the
+		 * buffers being refilled. */
+		float fAverageDecodeLatency;
+		float fMaxDecodeLatency;
+		/** @brief Sounds started without a start time. */
+		int iSoundsStarted;
+		/** @brief Time from StartMixing to the sound's first frame being
+		 * heard, going by GetPosition.  This is the latency GetPlayLatency
+		 * should report. */
+		float fAverageStartLatency;
+		float fMaxStartLatency;
+	};
+	void GetDecodeStats( DecodeStats &out ) const;
+
 protected:
 	/* Start the decoding.  This should be called once the hardware is set up and
 	 * GetSampleRate will return the correct value. */
@@ -101,14 +123,11 @@ protected:
 	void MixDeinterlaced( float **pBufs, int channels, int iFrames, int64_t iFrameNumber, int64_t iCurrentFrame );
 
 private:
-	/* This mutex is used for serializing with the decoder thread.  Locking this mutex
-	 * can take a while. */
+	/* This mutex serializes Update, StopMixing and PauseMixing, in case they're
+	 * called from more than one thread.  The decoding and mixing threads never
+	 * lock it. */
 	RageMutex m_Mutex;
 
-	/* This mutex locks all sounds[] which are "available".  (Other sound may safely
-	 * be accessed, and sounds may be set to available, without locking this.) */
-	RageMutex m_SoundListMutex;
-
 	/*
 	 * Thread safety and state transitions:
 	 *
@@ -140,12 +159,25 @@ private:
 	 * data", some data will still be mixed.  This is OK; the data is valid, and the flush will
 	 * happen on the next iteration.
 	 * 
+	 * States are atomic, and no thread takes a lock to change them.  A state that more
+	 * than one thread may change is only changed with a compare-and-swap:
+	 *
+	 * StartMixing reserves a sound by swapping AVAILABLE for BUFFERING, so sounds can be
+	 * started from any thread.
+	 *
 	 * The only state change made by the decoding thread is on EOF: the state is changed
-	 * from PLAYING to STOPPING.  This is done while m_Mutex is held, to prevent
-	 * races with other threads.
+	 * from PLAYING to STOPPING, unless StopMixing got there first.
 	 *
 	 * The only state change made by the mixing thread is from HALTING to STOPPED.
-	 * This is done with no locks; no other thread can take a sound out of the HALTING state.
+	 * No other thread can take a sound out of the HALTING state.
+	 *
+	 * The decoding thread sets m_bDecoding while it's using m_pSound, and checks that the
+	 * sound is still PLAYING after setting it, and clears it after each block it decodes.
+	 * StopMixing sets HALTING and then waits for m_bDecoding to clear before letting go of
+	 * the sound, which is at most one block.
+	 *
+	 * m_Buffer and m_PosMapQueue each have one writer and one reader (the decoding thread
+	 * and the mixer, and the mixer and Update), so they need no locks either.
 	 *
 	 * Do not allocate or deallocate memory in the mixing thread since allocating memory
 	 * involves taking a lock. Instead, push the deallocation to the main thread.
@@ -168,9 +200,13 @@ private:
 
 		RageSoundBase *m_pSound;
 		RageTimer m_StartTime;
+		/* The frame being heard when the sound was started, until its first
+		 * frame is mixed, or -1. */
+		int64_t m_iStartedAtFrame;
 		CircBuf<sound_block> m_Buffer;
 
-		bool m_bPaused;
+		std::atomic<bool> m_bPaused;
+		std::atomic<bool> m_bDecoding;
 
 		struct QueuedPosMap
 		{
@@ -181,7 +217,7 @@ private:
 
 		CircBuf<QueuedPosMap> m_PosMapQueue;
 
-		enum
+		enum State
 		{
 			AVAILABLE,
 			BUFFERING,
@@ -194,7 +230,8 @@ private:
 
 			HALTING,	/* stop immediately */
 			PLAYING
-		} m_State;
+		};
+		std::atomic<State> m_State;
 	};
 
 	/* List of currently playing sounds: XXX no vector */
@@ -205,7 +242,26 @@ private:
 	mutable int64_t m_iVMaxHardwareFrame;
 	mutable int32_t soundDriverMaxSamples = 0;
 
-	bool m_bShutdownDecodeThread;
+	std::atomic<bool> m_bShutdownDecodeThread;
+
+	/* The mixer sets this when it has made room in the buffers, and signals
+	 * m_pDecodeWakeup, which the decoding thread sleeps on.  The mixer may run
+	 * at realtime priority, so it never takes a lock to do this.  Posting a
+	 * RageSemaphore would lock the semaphore's mutex, which the decoding thread
+	 * also takes. */
+	std::atomic<bool> m_bDecodeWakePending;
+	std::atomic<uint64_t> m_iDecodeWakeUsecs;
+	class DecodeWakeup;
+	DecodeWakeup *m_pDecodeWakeup;
+	void WakeDecodeThread();
+
+	std::atomic<int> m_iUnderruns;
+	std::atomic<int> m_iDecodePasses;
+	std::atomic<uint64_t> m_iTotalDecodeLatencyUsecs;
+	std::atomic<uint64_t> m_iMaxDecodeLatencyUsecs;
+	std::atomic<int> m_iSoundsStarted;
+	std::atomic<uint64_t> m_iTotalStartLatencyUsecs;
+	std::atomic<uint64_t> m_iMaxStartLatencyUsecs;
 
 	static int DecodeThread_start( void *p );
 	void DecodeThread();
@@ -13,6 +13,8 @@
 
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <pthread.h>
+#include <sched.h>
 
 REGISTER_SOUND_DRIVER_CLASS2( ALSA-sw, ALSA9_Software );
 
@@ -27,6 +29,11 @@ static const unsigned safe_writeahead = 1024*4;
 static unsigned g_iMaxWriteahead;
 const int num_chunks = 8;
 
+/* In low-latency mode, use periods of under 3ms at 44.1kHz, and only buffer
+ * a few of them; the mixing thread runs at realtime priority to keep up. */
+static const unsigned low_latency_period_frames = 128;
+static const unsigned low_latency_periods = 3;
+
 int RageSoundDriver_ALSA9_Software::MixerThread_start( void *p )
 {
 	((RageSoundDriver_ALSA9_Software *) p)->MixerThread();
@@ -35,7 +42,21 @@ int RageSoundDriver_ALSA9_Software::MixerThread_start( void *p )
 
 void RageSoundDriver_ALSA9_Software::MixerThread()
 {
-	setpriority( PRIO_PROCESS, 0, -15 );
+	bool bRealtime = false;
+	if( m_bLowLatency )
+	{
+		/* This usually needs rtkit or an rtprio limit for the user. */
+		sched_param param;
+		param.sched_priority = sched_get_priority_min( SCHED_FIFO ) + 10;
+		int iErr = pthread_setschedparam( pthread_self(), SCHED_FIFO, &param );
+		if( iErr == 0 )
+			bRealtime = true;
+		else
+			LOG->Info( "ALSA: couldn't run the mixer at realtime priority: %s", strerror(iErr) );
+	}
+
+	if( !bRealtime )
+		setpriority( PRIO_PROCESS, 0, -15 );
 
 	while( !m_bShutdown )
 	{
@@ -69,6 +90,20 @@ bool RageSoundDriver_ALSA9_Software::GetData()
 	const int64_t play_pos = m_pPCM->GetPlayPos();
 	const int64_t cur_play_pos = m_pPCM->GetPosition();
 
+	/* Mix straight into the device buffer.  If it wraps, the rest is
+	 * filled on the next call. */
+	if( m_bLowLatency )
+	{
+		int iFrames = frames_to_fill;
+		int16_t *pDest = m_pPCM->BeginWrite( iFrames );
+		if( pDest != nullptr )
+		{
+			this->Mix( pDest, iFrames, play_pos, cur_play_pos );
+			m_pPCM->CommitWrite( iFrames );
+			return true;
+		}
+	}
+
 	this->Mix( buf, frames_to_fill, play_pos, cur_play_pos );
 	m_pPCM->Write( buf, frames_to_fill );
 
@@ -91,6 +126,7 @@ RageSoundDriver_ALSA9_Software::RageSoundDriver_ALSA9_Software()
 {
 	m_pPCM = nullptr;
 	m_bShutdown = false;
+	m_bLowLatency = false;
 }
 
 RString RageSoundDriver_ALSA9_Software::Init()
@@ -107,18 +143,26 @@ RString RageSoundDriver_ALSA9_Software::Init()
 	if( sys == "Linux" && vers >= 20600 )
 		g_iMaxWriteahead = g_iMaxWriteahead_linux_26;
 
+	m_bLowLatency = PREFSMAN->m_bSoundLowLatency;
+	if( m_bLowLatency )
+		g_iMaxWriteahead = low_latency_period_frames * low_latency_periods;
+
 	if( PREFSMAN->m_iSoundWriteAhead )
 		g_iMaxWriteahead = PREFSMAN->m_iSoundWriteAhead;
+	const unsigned iChunkSize = m_bLowLatency? low_latency_period_frames: g_iMaxWriteahead / num_chunks;
 
 	m_pPCM = new Alsa9Buf();
 	sError = m_pPCM->Init( channels,
 			g_iMaxWriteahead,
-			g_iMaxWriteahead / num_chunks,
+			iChunkSize,
 			PREFSMAN->m_iSoundPreferredSampleRate );
 	if( sError != "" )
 		return sError;
 
 	m_iSampleRate = m_pPCM->GetSampleRate();
+	if( m_bLowLatency )
+		LOG->Info( "ALSA: low latency: %i frame periods, %.1fms buffered",
+			m_pPCM->GetChunkSize(), GetPlayLatency() * 1000 );
 	
 	StartDecodeThread();
 	
@@ -146,7 +190,7 @@ RageSoundDriver_ALSA9_Software::~RageSoundDriver_ALSA9_Software()
 
 float RageSoundDriver_ALSA9_Software::GetPlayLatency() const
 {
-	return float(g_iMaxWriteahead) / m_iSampleRate;
+	return float(m_pPCM->GetWriteahead()) / m_iSampleRate;
 }
 
 /*
@@ -27,6 +27,7 @@ private:
 	bool GetData();
 
 	bool m_bShutdown;
+	bool m_bLowLatency;
 	int m_iSampleRate;
 	Alsa9Buf *m_pPCM;
 	RageThread m_MixingThread;
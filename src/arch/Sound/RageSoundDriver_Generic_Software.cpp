@@ -7,20 +7,29 @@
 #include "RageSoundMixBuffer.h"
 #include "RageSoundReader.h"
 
+#include <thread>
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 static const int channels = 2;
 
 static int frames_to_buffer;
 
-/* 512 is about 10ms, which is big enough for the tolerance of most schedulers. */
-static int chunksize() { return 512; }
-
-static int underruns = 0, logged_underruns = 0;
+static int logged_underruns = 0;
 
 RageSoundDriver::Sound::Sound()
 {
 	m_pSound = nullptr;
+	m_iStartedAtFrame = -1;
 	m_State = AVAILABLE;
 	m_bPaused = false;
+	m_bDecoding = false;
 }
 
 void RageSoundDriver::Sound::Allocate( int iFrames )
@@ -59,6 +68,7 @@ RageSoundMixBuffer &RageSoundDriver::MixIntoBuffer( int iFrames, int64_t iFrameN
 	}
 
 	static RageSoundMixBuffer mix;
+	bool bRoomToDecode = false;
 
 	for( unsigned i = 0; i < ARRAYLEN(m_Sounds); ++i )
 	{
@@ -127,6 +137,17 @@ RageSoundMixBuffer &RageSoundDriver::MixIntoBuffer( int iFrames, int64_t iFrameN
 
 			/* Note that, until we call advance_read_pointer, we can safely write to p[0]. */
 			const int frames_to_read = min( iFramesLeft, p[0]->m_FramesInBuffer );
+			if( s.m_iStartedAtFrame != -1 )
+			{
+				const int64_t iFrames = max( iFrameNumber + iGotFrames - s.m_iStartedAtFrame, int64_t(0) );
+				const uint64_t iLatency = iFrames * 1000000 / GetSampleRate();
+				s.m_iStartedAtFrame = -1;
+				++m_iSoundsStarted;
+				m_iTotalStartLatencyUsecs += iLatency;
+				if( iLatency > m_iMaxStartLatencyUsecs )
+					m_iMaxStartLatencyUsecs = iLatency;
+			}
+
 			mix.SetWriteOffset( iGotFrames*channels );
 			mix.write( p[0]->m_BufferNext, frames_to_read * channels );
 
@@ -152,9 +173,15 @@ RageSoundMixBuffer &RageSoundDriver::MixIntoBuffer( int iFrames, int64_t iFrameN
 
 		/* If we don't have enough to fill the buffer, we've underrun. */
 		if( iGotFrames < iFrames && s.m_State == Sound::PLAYING )
-			++underruns;
+			++m_iUnderruns;
+
+		if( s.m_State == Sound::PLAYING && s.m_Buffer.num_writable() )
+			bRoomToDecode = true;
 	}
 
+	if( bRoomToDecode )
+		WakeDecodeThread();
+
 	return mix;
 }
 
@@ -177,49 +204,159 @@ void RageSoundDriver::MixDeinterlaced( float **pBufs, int channels, int iFrames,
 	MixIntoBuffer( iFrames, iFrameNumber, iCurrentFrame ).read_deinterlace( pBufs, channels );
 }
 
+/* Wakes the decoding thread.  Signal() is a single system call that takes no
+ * lock in this process, so the mixer can call it at realtime priority. */
+class RageSoundDriver::DecodeWakeup
+{
+public:
+	DecodeWakeup();
+	~DecodeWakeup();
+	void Signal();
+	void Wait();
+
+private:
+#if defined(WIN32)
+	HANDLE m_hEvent;
+#else
+	int m_iPipe[2];
+#endif
+};
+
+#if defined(WIN32)
+RageSoundDriver::DecodeWakeup::DecodeWakeup()
+{
+	m_hEvent = CreateEvent( nullptr, FALSE, FALSE, nullptr );
+	ASSERT_M( m_hEvent != nullptr, "DecodeWakeup: CreateEvent failed" );
+}
+
+RageSoundDriver::DecodeWakeup::~DecodeWakeup()
+{
+	CloseHandle( m_hEvent );
+}
+
+void RageSoundDriver::DecodeWakeup::Signal()
+{
+	SetEvent( m_hEvent );
+}
+
+void RageSoundDriver::DecodeWakeup::Wait()
+{
+	WaitForSingleObject( m_hEvent, INFINITE );
+}
+#else
+RageSoundDriver::DecodeWakeup::DecodeWakeup()
+{
+	int ret = pipe( m_iPipe );
+	ASSERT_M( ret == 0, ssprintf("DecodeWakeup: pipe: %s", strerror(errno)) );
+
+	/* If the pipe is full, the decoding thread has wakeups waiting already. */
+	fcntl( m_iPipe[1], F_SETFL, fcntl(m_iPipe[1], F_GETFL) | O_NONBLOCK );
+}
+
+RageSoundDriver::DecodeWakeup::~DecodeWakeup()
+{
+	close( m_iPipe[0] );
+	close( m_iPipe[1] );
+}
+
+void RageSoundDriver::DecodeWakeup::Signal()
+{
+	const char c = 0;
+	while( write(m_iPipe[1], &c, 1) == -1 && errno == EINTR )
+		;
+}
+
+void RageSoundDriver::DecodeWakeup::Wait()
+{
+	char buf[16];
+	while( read(m_iPipe[0], buf, sizeof(buf)) == -1 && errno == EINTR )
+		;
+}
+#endif
+
+void RageSoundDriver::WakeDecodeThread()
+{
+	if( m_bDecodeWakePending.load() )
+		return;
+	m_iDecodeWakeUsecs = RageTimer::GetUsecsSinceStart();
+	if( m_bDecodeWakePending.exchange(true) )
+		return;
+	m_pDecodeWakeup->Signal();
+}
+
 void RageSoundDriver::DecodeThread()
 {
 	SetupDecodingThread();
 
 	while( !m_bShutdownDecodeThread )
 	{
-		/* Fill each playing sound, round-robin. */
-		{
-			int iSampleRate = GetSampleRate();
-			ASSERT_M( iSampleRate > 0, ssprintf("%i", iSampleRate) );
-			int iUsecs = 1000000*chunksize() / iSampleRate;
-			usleep( iUsecs );
-		}
+		/* Sleep until the mixer has used up some of the buffered sound. */
+		m_pDecodeWakeup->Wait();
+		if( m_bShutdownDecodeThread )
+			break;
+		m_bDecodeWakePending = false;
+		const uint64_t iWokenAt = m_iDecodeWakeUsecs;
 
-		LockMut( m_Mutex );
 //		LOG->Trace("begin mix");
 
-		for( unsigned i = 0; i < ARRAYLEN(m_Sounds); ++i )
+		/* Fill the playing sounds round-robin, one block at a time, so StopMixing
+		 * never waits on more than one block. */
+		bool bDecoded;
+		do
 		{
-			if( m_Sounds[i].m_State != Sound::PLAYING )
-				continue;
+			bDecoded = false;
+			for( unsigned i = 0; i < ARRAYLEN(m_Sounds); ++i )
+			{
+				Sound *pSound = &m_Sounds[i];
+				if( pSound->m_State != Sound::PLAYING || !pSound->m_Buffer.num_writable() )
+					continue;
 
-			Sound *pSound = &m_Sounds[i];
+				/* Claim the sound, then make sure StopMixing didn't take it first. */
+				pSound->m_bDecoding = true;
+				if( pSound->m_State != Sound::PLAYING )
+				{
+					pSound->m_bDecoding = false;
+					continue;
+				}
 
-			CHECKPOINT_M("Processing the sound while buffers are available.");
-			while( pSound->m_Buffer.num_writable() )
-			{
+				CHECKPOINT_M("Processing the sound while buffers are available.");
 				int iWrote = GetDataForSound( *pSound );
-				if( iWrote == RageSoundReader::WOULD_BLOCK )
-					break;
-				if( iWrote < 0 )
+				if( iWrote > 0 )
+				{
+					bDecoded = true;
+				}
+				else if( iWrote != RageSoundReader::WOULD_BLOCK && iWrote < 0 )
 				{
 					/* This sound is finishing. */
-					pSound->m_State = Sound::STOPPING;
-					break;
+					Sound::State expected = Sound::PLAYING;
+					pSound->m_State.compare_exchange_strong( expected, Sound::STOPPING );
 //					LOG->Trace("mixer: (#%i) eof (%p)", i, pSound->m_pSound );
 				}
+
+				pSound->m_bDecoding = false;
 			}
-		}
+		} while( bDecoded && !m_bShutdownDecodeThread );
 //		LOG->Trace("end mix");
+
+		const uint64_t iLatency = RageTimer::GetUsecsSinceStart() - iWokenAt;
+		++m_iDecodePasses;
+		m_iTotalDecodeLatencyUsecs += iLatency;
+		if( iLatency > m_iMaxDecodeLatencyUsecs )
+			m_iMaxDecodeLatencyUsecs = iLatency;
 	}
 }
 
+void RageSoundDriver::GetDecodeStats( DecodeStats &out ) const
+{
+	out.iUnderruns = m_iUnderruns;
+	out.iDecodePasses = m_iDecodePasses;
+	out.fAverageDecodeLatency = m_iTotalDecodeLatencyUsecs / 1000000.0f / max( out.iDecodePasses, 1 );
+	out.fMaxDecodeLatency = m_iMaxDecodeLatencyUsecs / 1000000.0f;
+	out.iSoundsStarted = m_iSoundsStarted;
+	out.fAverageStartLatency = m_iTotalStartLatencyUsecs / 1000000.0f / max( out.iSoundsStarted, 1 );
+	out.fMaxStartLatency = m_iMaxStartLatencyUsecs / 1000000.0f;
+}
+
 /* Buffer a block of sound data for the given sound.  Return the number of
  * frames buffered, or a RageSoundReader return code. */
 int RageSoundDriver::GetDataForSound( Sound &s )
@@ -292,12 +429,15 @@ void RageSoundDriver::Update()
 	static float fNext = 0;
 	if( RageTimer::GetTimeSinceStart() >= fNext )
 	{
-		/* Lockless: only Mix() can write to underruns. */
-		int current_underruns = underruns;
+		int current_underruns = m_iUnderruns;
 		if( current_underruns > logged_underruns )
 		{
 			LOG->MapLog( "GenericMixingUnderruns", "Mixing underruns: %i", current_underruns - logged_underruns );
-			LOG->Trace( "Mixing underruns: %i", current_underruns - logged_underruns );
+			DecodeStats stats;
+			GetDecodeStats( stats );
+			LOG->Trace( "Mixing underruns: %i (decoding latency %.1fms average, %.1fms max)",
+				current_underruns - logged_underruns,
+				stats.fAverageDecodeLatency * 1000, stats.fMaxDecodeLatency * 1000 );
 			logged_underruns = current_underruns;
 
 			/* Don't log again for at least a second, or we'll burst output
@@ -311,30 +451,26 @@ void RageSoundDriver::Update()
 
 void RageSoundDriver::StartMixing( RageSoundBase *pSound )
 {
-	/* Lock available m_Sounds[], and reserve a slot. */
-	m_SoundListMutex.Lock();
-
+	/* Reserve a slot.  Once it's BUFFERING, no other thread will touch it. */
 	unsigned i;
 	for( i = 0; i < ARRAYLEN(m_Sounds); ++i )
-		if( m_Sounds[i].m_State == Sound::AVAILABLE )
+	{
+		Sound::State expected = Sound::AVAILABLE;
+		if( m_Sounds[i].m_State.compare_exchange_strong(expected, Sound::BUFFERING) )
 			break;
+	}
 	if( i == ARRAYLEN(m_Sounds) )
-	{
-		m_SoundListMutex.Unlock();
 		return;
-	}
 
 	Sound &s = m_Sounds[i];
-	s.m_State = Sound::BUFFERING;
-
-	/* We've reserved our slot; we can safely unlock now.  Don't hold onto it longer
-	 * than needed, since prebuffering might take some time. */
-	m_SoundListMutex.Unlock();
 
 	s.m_pSound = pSound;
 	s.m_StartTime = pSound->GetStartTime();
 	s.m_Buffer.clear();
 
+	/* Sounds with a start time are delayed on purpose; only time the rest. */
+	s.m_iStartedAtFrame = s.m_StartTime.IsZero()? GetPosition(): -1;
+
 	/* Initialize the sound buffer. */
 	int BufferSize = frames_to_buffer;
 
@@ -358,7 +494,6 @@ void RageSoundDriver::StartMixing( RageSoundBase *pSound )
 
 void RageSoundDriver::StopMixing( RageSoundBase *pSound )
 {
-	/* Lock, to make sure the decoder thread isn't running on this sound while we do this. */
 	m_Mutex.Lock();
 
 	/* Find the sound. */
@@ -383,9 +518,11 @@ void RageSoundDriver::StopMixing( RageSoundBase *pSound )
 
 //	LOG->Trace("StopMixing: set %p (%s) to HALTING", m_Sounds[i].m_pSound, m_Sounds[i].m_pSound->GetLoadedFilePath().c_str());
 
-	/* Tell the mixing thread to flush the buffer.  We don't have to worry about
-	 * the decoding thread, since we've locked m_Mutex. */
+	/* Tell the mixing thread to flush the buffer, and wait for the decoding
+	 * thread to finish the block it's decoding, if it's working on this sound. */
 	m_Sounds[i].m_State = Sound::HALTING;
+	while( m_Sounds[i].m_bDecoding )
+		std::this_thread::yield();
 
 	/* Invalidate the m_pSound pointer to guarantee we don't make any further references to
 	 * it.  Once this call returns, the sound may no longer exist. */
@@ -443,14 +580,23 @@ void RageSoundDriver::low_sample_count_workaround()
 }
 
 RageSoundDriver::RageSoundDriver():
-	m_Mutex("RageSoundDriver"),
-	m_SoundListMutex("SoundListMutex")
+	m_Mutex("RageSoundDriver")
 {
 	m_bShutdownDecodeThread = false;
+	m_bDecodeWakePending = false;
+	m_iDecodeWakeUsecs = 0;
+	m_iUnderruns = 0;
+	m_iDecodePasses = 0;
+	m_iTotalDecodeLatencyUsecs = 0;
+	m_iMaxDecodeLatencyUsecs = 0;
+	m_iSoundsStarted = 0;
+	m_iTotalStartLatencyUsecs = 0;
+	m_iMaxStartLatencyUsecs = 0;
 	m_iMaxHardwareFrame = 0;
 	m_iVMaxHardwareFrame = 0;
 	SetDecodeBufferSize( 4096 );
 	soundDriverMaxSamples = PREFSMAN->m_iRageSoundSampleCountClamp;
+	m_pDecodeWakeup = new DecodeWakeup;
 	m_DecodeThread.SetName("Decode thread");
 }
 
@@ -460,6 +606,7 @@ RageSoundDriver::~RageSoundDriver()
 	if( m_DecodeThread.IsCreated() )
 	{
 		m_bShutdownDecodeThread = true;
+		m_pDecodeWakeup->Signal();
 		LOG->Trace("Shutting down decode thread ...");
 		LOG->Flush();
 		m_DecodeThread.Wait();
@@ -468,7 +615,17 @@ RageSoundDriver::~RageSoundDriver()
 
 		LOG->Info( "Mixing %f ahead in %i Mix() calls",
 			float(g_iTotalAhead) / max( g_iTotalAheadCount, 1 ), g_iTotalAheadCount );
+
+		DecodeStats stats;
+		GetDecodeStats( stats );
+		LOG->Info( "%i mixing underruns; decoding latency %.2fms average, %.2fms max in %i passes",
+			stats.iUnderruns, stats.fAverageDecodeLatency * 1000, stats.fMaxDecodeLatency * 1000,
+			stats.iDecodePasses );
+		LOG->Info( "%i sounds started; start latency %.2fms average, %.2fms max",
+			stats.iSoundsStarted, stats.fAverageStartLatency * 1000, stats.fMaxStartLatency * 1000 );
 	}
+
+	delete m_pDecodeWakeup;
 }
 
 int64_t RageSoundDriver::ClampHardwareFrame( int64_t iHardwareFrame ) const
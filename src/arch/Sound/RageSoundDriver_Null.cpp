@@ -8,17 +8,35 @@ REGISTER_SOUND_DRIVER_CLASS( Null );
 
 const int channels = 2;
 
-void RageSoundDriver_Null::Update()
+/* In low-latency mode, buffer the way RageSoundDriver_ALSA9_Software does. */
+static const int writeahead = 1024*4;
+static const int period_frames = 256;
+static const int low_latency_period_frames = 128;
+static const int low_latency_periods = 3;
+
+int RageSoundDriver_Null::MixerThread_start( void *p )
 {
-	/* "Play" frames. */
-	while( m_iLastCursorPos < GetPosition()+1024*4 )
+	((RageSoundDriver_Null *) p)->MixerThread();
+	return 0;
+}
+
+void RageSoundDriver_Null::MixerThread()
+{
+	vector<int16_t> buf( m_iPeriodFrames*channels );
+	const int iPeriodUsecs = int( int64_t(m_iPeriodFrames) * 1000000 / m_iSampleRate );
+
+	while( !m_bShutdown )
 	{
-		int16_t buf[256*channels];
-		this->Mix( buf, 256, m_iLastCursorPos, GetPosition() );
-		m_iLastCursorPos += 256;
-	}
+		/* "Play" frames, a period at a time. */
+		const int64_t iPosition = GetPosition();
+		while( m_iLastCursorPos < iPosition+m_iWriteahead )
+		{
+			this->Mix( &buf[0], m_iPeriodFrames, m_iLastCursorPos, iPosition );
+			m_iLastCursorPos += m_iPeriodFrames;
+		}
 
-	RageSoundDriver::Update();
+		usleep( iPeriodUsecs );
+	}
 }
 
 int64_t RageSoundDriver_Null::GetPosition() const
@@ -32,7 +50,34 @@ RageSoundDriver_Null::RageSoundDriver_Null()
 	if( m_iSampleRate == 0 )
 		m_iSampleRate = 44100;
 	m_iLastCursorPos = GetPosition();
+
+	m_iPeriodFrames = period_frames;
+	m_iWriteahead = writeahead;
+	if( PREFSMAN->m_bSoundLowLatency )
+	{
+		m_iPeriodFrames = low_latency_period_frames;
+		m_iWriteahead = low_latency_period_frames * low_latency_periods;
+	}
+	if( PREFSMAN->m_iSoundWriteAhead )
+		m_iWriteahead = PREFSMAN->m_iSoundWriteAhead;
+	m_iWriteahead = max( m_iWriteahead, m_iPeriodFrames*2 );
+
 	StartDecodeThread();
+
+	m_bShutdown = false;
+	m_MixingThread.SetName( "RageSoundDriver_Null" );
+	m_MixingThread.Create( MixerThread_start, this );
+}
+
+RageSoundDriver_Null::~RageSoundDriver_Null()
+{
+	m_bShutdown = true;
+	m_MixingThread.Wait();
+}
+
+float RageSoundDriver_Null::GetPlayLatency() const
+{
+	return float(m_iWriteahead) / m_iSampleRate;
 }
 
 int RageSoundDriver_Null::GetSampleRate() const
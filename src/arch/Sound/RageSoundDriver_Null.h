@@ -2,18 +2,29 @@
 #define RAGE_SOUND_NULL
 
 #include "RageSoundDriver.h"
+#include "RageThreads.h"
 
+/* Plays to nowhere, like a sound card with the given writeahead would, so
+ * the latency of a writeahead can be measured without any hardware. */
 class RageSoundDriver_Null: public RageSoundDriver
 {
 public:
 	RageSoundDriver_Null();
+	~RageSoundDriver_Null();
 	int64_t GetPosition() const;
+	float GetPlayLatency() const;
 	int GetSampleRate() const;
-	void Update();
 
 private:
+	static int MixerThread_start( void *p );
+	void MixerThread();
+
 	int64_t m_iLastCursorPos;
 	int m_iSampleRate;
+	int m_iWriteahead;
+	int m_iPeriodFrames;
+	bool m_bShutdown;
+	RageThread m_MixingThread;
 };
 #define USE_RAGE_SOUND_NULL
 
@@ -151,7 +151,9 @@ static void parent_process( int to_child, const CrashData *crash )
 	if( !parent_write(to_child, p, size) )
 		return;
 	
-	/* 4. Write RecentLogs. */
+	/* 4. Write RecentLogs, including lines the async log writer hasn't
+	 * gotten to yet.  Those are added to log.txt, too. */
+	RageLog::DrainAsyncForCrash();
 	int cnt = 0;
 	const char *ps[1024];
 	while( cnt < 1024 && (ps[cnt] = RageLog::GetRecentLog( cnt )) != nullptr )
@@ -220,7 +220,9 @@ void RunChild()
 		WriteToChild( hToStdin, &iSize, sizeof(iSize) );
 		WriteToChild( hToStdin, p, iSize );
 
-		// 4. Write RecentLogs.
+		// 4. Write RecentLogs, including lines the async log writer hasn't
+		// gotten to yet.  Those are added to log.txt, too.
+		RageLog::DrainAsyncForCrash();
 		int cnt = 0;
 		const TCHAR *ps[1024];
 		while( cnt < 1024 && (ps[cnt] = RageLog::GetRecentLog( cnt )) != nullptr )
@@ -133,6 +133,9 @@ typedef std::make_signed<size_t>::type ssize_t;
 /* Defined to 1 if logging timing segment additions and removals. */
 #cmakedefine WITH_LOGGING_TIMING_DATA 1
 
+/* Defined to 1 if NoteData tracks are stored in sorted vectors. */
+#cmakedefine WITH_FLAT_NOTEDATA 1
+
 #if defined(__GNUC__)
 /** @brief Define a macro to tell the compiler that a function has printf()
  * semantics, to aid warning output. */
@@ -5,6 +5,8 @@
 #include "RageUtil.h"
 #include "RageSoundReader_Preload.h"
 #include "RageSoundReader_Resample_Good.h"
+#include "RageSoundMixKernels.h"
+#include "EnumHelper.h"
 
 #include "test_misc.h"
 #include <sys/types.h>
@@ -485,6 +487,102 @@ bool RunTests( RageSoundReader *snd, const TestFile &tf )
 }
 
 
+/* An endless stereo tone, so the resampler benchmark doesn't need any files. */
+class SineReader: public RageSoundReader
+{
+public:
+	SineReader( int iSampleRate ): m_iSampleRate(iSampleRate), m_iPosition(0) { }
+	SineReader *Copy() const { return new SineReader(*this); }
+	int GetLength() const { return 0; }
+	int SetPosition( int iFrame ) { m_iPosition = iFrame; return 1; }
+	int Read( float *pBuf, int iFrames )
+	{
+		for( int i = 0; i < iFrames; ++i, ++m_iPosition )
+		{
+			pBuf[i*2+0] = sinf( m_iPosition * 0.031f ) * 0.5f;
+			pBuf[i*2+1] = sinf( m_iPosition * 0.047f ) * 0.5f;
+		}
+		return iFrames;
+	}
+	int GetSampleRate() const { return m_iSampleRate; }
+	unsigned GetNumChannels() const { return 2; }
+	int GetNextSourceFrame() const { return m_iPosition; }
+	float GetStreamToSourceRatio() const { return 1.0f; }
+	RString GetError() const { return ""; }
+
+private:
+	int m_iSampleRate;
+	int m_iPosition;
+};
+
+/* Resample a few seconds of audio the way gameplay does: from 44.1kHz to
+ * 48kHz, and with a 1.5x rate mod.  Time it at each quality with each kernel
+ * set, and check that the vector kernels give (nearly) the scalar result. */
+bool BenchmarkResampler()
+{
+	const int SECONDS = 20;
+	const int FRAMES_PER_READ = 1024;
+	const float RATES[] = { 1.0f, 1.5f };
+
+	bool bOK = true;
+	const MixKernelSet best = RageSoundMixKernels::GetSelected();
+	for( int q = 0; q < RageSoundReader_Resample_Good::NUM_RESAMP; ++q )
+	{
+		for( float fRate : RATES )
+		{
+			vector<float> aExpected;
+			float fScalarTime = 0;
+			FOREACH_ENUM( MixKernelSet, s )
+			{
+				if( !RageSoundMixKernels::IsSupported(s) || (s != MixKernelSet_Scalar && s != best) )
+					continue;
+				RageSoundMixKernels::Select( s );
+
+				RageSoundReader_Resample_Good r( new SineReader(44100), 48000 );
+				r.SetQuality( (RageSoundReader_Resample_Good::ResampleQuality) q );
+				if( fRate != 1.0f )
+					r.SetRate( fRate );
+
+				vector<float> aBuf( FRAMES_PER_READ * 2 );
+				vector<float> aOut;
+				int iTotalFrames = 0;
+				RageTimer timer;
+				while( iTotalFrames < 48000 * SECONDS )
+				{
+					int iGot = r.Read( &aBuf[0], FRAMES_PER_READ );
+					ASSERT( iGot > 0 );
+					iTotalFrames += iGot;
+					// Keep a little of every read to compare.
+					aOut.insert( aOut.end(), aBuf.begin(), aBuf.begin() + 16 );
+				}
+				float fTime = timer.GetDeltaTime();
+
+				if( s == MixKernelSet_Scalar )
+				{
+					aExpected = aOut;
+					fScalarTime = fTime;
+				}
+				LOG->Trace( "quality %i, rate %.1f, %-6s %.3fs, %.1f Mframes/s (%.2fx)", q, fRate,
+					MixKernelSetToString(s).c_str(), fTime, iTotalFrames / fTime / 1000000,
+					fScalarTime / fTime );
+
+				for( size_t i = 0; i < aOut.size(); ++i )
+				{
+					if( fabsf(aOut[i] - aExpected[i]) > 1e-5f )
+					{
+						LOG->Warn( "%s resampling differs from scalar at %i: %f, %f",
+							MixKernelSetToString(s).c_str(), (int) i, aOut[i], aExpected[i] );
+						bOK = false;
+						break;
+					}
+				}
+			}
+		}
+	}
+	RageSoundMixKernels::Select( best );
+	return bOK;
+}
+
 bool test_file( const TestFile &tf, int filters )
 {
 	const char *fn = tf.fn;
@@ -573,6 +671,8 @@ int main( int argc, char *argv[] )
 		{ NULL,							0, {0,0,0,0}, {0,0,0,0} }
 	};
 	
+	bool bOK = BenchmarkResampler();
+
 	for( int i = 0; files[i].fn; ++i )
 	{
 		if( !test_file( files[i], 0 ) )
@@ -580,6 +680,6 @@ int main( int argc, char *argv[] )
 	}
 
 	test_deinit();
-	exit(0);
+	exit( bOK? 0:1 );
 }
 
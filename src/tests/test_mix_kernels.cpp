@@ -0,0 +1,135 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "EnumHelper.h"
+#include "RageSoundMixBuffer.h"
+#include "RageSoundMixKernels.h"
+#include "test_misc.h"
+
+/* Mix 32 keysounds at once, the way RageSoundDriver::MixIntoBuffer does for a
+ * dense keysounded chart: each sound is volume-scaled and added into the mix
+ * buffer at its own offset, and the mix is converted to int16 for the sound
+ * card.  Run it with every kernel set the CPU supports, check that they all
+ * give exactly the scalar result and time them. */
+
+static const int NUM_SOUNDS = 32;
+static const int CHANNELS = 2;
+static const int FRAMES_PER_MIX = 512;	// about 12ms at 44.1kHz
+static const int NUM_MIXES = 20000;
+static const int SOUND_FRAMES = 44100;
+
+struct Results
+{
+	vector<int16_t> aOut;
+	vector<float> aLeft, aRight;
+	float fMix, fDeinterleave;
+};
+
+static void Run( MixKernelSet s, const vector< vector<float> > &aSounds, Results &res )
+{
+	RageSoundMixKernels::Select( s );
+
+	RageSoundMixBuffer mix;
+	vector<float> aScratch( FRAMES_PER_MIX * CHANNELS );
+	vector<int16_t> aBlock( FRAMES_PER_MIX * CHANNELS );
+	res.aOut.clear();
+
+	RageTimer timer;
+	for( int m = 0; m < NUM_MIXES; ++m )
+	{
+		for( int i = 0; i < NUM_SOUNDS; ++i )
+		{
+			// Stagger the sounds, so they start partway into the block.
+			const int iStart = (i * 37) % FRAMES_PER_MIX;
+			const int iPos = ((m * FRAMES_PER_MIX + i * 1031) % (SOUND_FRAMES - FRAMES_PER_MIX)) * CHANNELS;
+			const int iFrames = FRAMES_PER_MIX - iStart;
+			memcpy( &aScratch[0], &aSounds[i][iPos], iFrames * CHANNELS * sizeof(float) );
+			RageSoundMixKernels::Scale( &aScratch[0], iFrames * CHANNELS, 0.1f + i * 0.02f );
+
+			mix.SetWriteOffset( iStart * CHANNELS );
+			mix.write( &aScratch[0], iFrames * CHANNELS );
+		}
+		mix.read( &aBlock[0] );
+
+		// Keep a little of every block to compare.
+		res.aOut.insert( res.aOut.end(), aBlock.begin(), aBlock.begin() + 16 );
+	}
+	res.fMix = timer.GetDeltaTime();
+
+	res.aLeft.resize( SOUND_FRAMES );
+	res.aRight.resize( SOUND_FRAMES );
+	float *pChannels[CHANNELS] = { &res.aLeft[0], &res.aRight[0] };
+	mix.SetWriteOffset( 0 );
+	for( int m = 0; m < NUM_MIXES / 20; ++m )
+	{
+		mix.write( &aSounds[m % NUM_SOUNDS][0], SOUND_FRAMES * CHANNELS );
+		mix.read_deinterlace( pChannels, CHANNELS );
+	}
+	res.fDeinterleave = timer.GetDeltaTime();
+}
+
+int main( int argc, char *argv[] )
+{
+	test_handle_args( argc, argv );
+	test_init();
+
+	// Loud enough that the mix clips, so saturation gets tested too.
+	vector< vector<float> > aSounds( NUM_SOUNDS );
+	for( int i = 0; i < NUM_SOUNDS; ++i )
+	{
+		aSounds[i].resize( SOUND_FRAMES * CHANNELS );
+		for( int f = 0; f < SOUND_FRAMES * CHANNELS; ++f )
+			aSounds[i][f] = sinf( f * (0.01f + i * 0.003f) ) * randomf( 0.5f, 1.0f );
+	}
+
+	Results scalar;
+	Run( MixKernelSet_Scalar, aSounds, scalar );
+	LOG->Trace( "%i sounds, %i mixes of %i frames:", NUM_SOUNDS, NUM_MIXES, FRAMES_PER_MIX );
+	LOG->Trace( "  %-6s mix %.4f  deinterleave %.4f", "Scalar", scalar.fMix, scalar.fDeinterleave );
+
+	bool bFailed = false;
+	FOREACH_ENUM( MixKernelSet, s )
+	{
+		if( s == MixKernelSet_Scalar || !RageSoundMixKernels::IsSupported(s) )
+			continue;
+
+		Results res;
+		Run( s, aSounds, res );
+		LOG->Trace( "  %-6s mix %.4f  deinterleave %.4f", MixKernelSetToString(s).c_str(), res.fMix, res.fDeinterleave );
+
+		if( res.aOut != scalar.aOut || res.aLeft != scalar.aLeft || res.aRight != scalar.aRight )
+		{
+			LOG->Warn( "%s doesn't match the scalar kernels", MixKernelSetToString(s).c_str() );
+			bFailed = true;
+		}
+	}
+
+	test_deinit();
+	exit( bFailed? 1:0 );
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
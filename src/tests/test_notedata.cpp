@@ -0,0 +1,317 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "NoteTypes.h"
+#include "NoteData.h"
+#include "NoteDataUtil.h"
+#include "FlatTrackMap.h"
+#include "test_misc.h"
+
+#include <map>
+
+/* Compare the two NoteData track backends, map<int,TapNote> and FlatTrackMap,
+ * on the operations NoteData spends its time in: loading, GetTapNote lookups,
+ * drawing a window of rows, walking all tracks in row order (what
+ * _all_tracks_iterator does during gameplay) and removing notes.  Before
+ * that, check that NoteDataUtil's packed note data survives a round trip. */
+
+static const int NUM_TRACKS = 8;
+static const int NUM_MEASURES = 4000;
+static const int NUM_ROWS = NUM_MEASURES * 4 * ROWS_PER_BEAT;
+static const int WINDOW_ROWS = ROWS_PER_BEAT * 16;
+
+/* A dense chart: 16ths in every track, with a few tracks skipping notes so
+ * the tracks don't line up perfectly. */
+static bool HasNote( int iTrack, int iRow )
+{
+	return (iRow / (ROWS_PER_BEAT/4) + iTrack) % (iTrack % 3 + 1) == 0;
+}
+
+template<typename Track>
+static void Fill( vector<Track> &tracks )
+{
+	tracks.resize( NUM_TRACKS );
+	for( int t = 0; t < NUM_TRACKS; ++t )
+		for( int r = 0; r < NUM_ROWS; r += ROWS_PER_BEAT/4 )
+			if( HasNote(t, r) )
+				tracks[t][r] = TAP_ORIGINAL_TAP;
+}
+
+template<typename Track>
+static int Lookups( const vector<Track> &tracks )
+{
+	int iFound = 0;
+	for( int r = 0; r < NUM_ROWS; r += ROWS_PER_BEAT/8 )
+		for( int t = 0; t < NUM_TRACKS; ++t )
+			if( tracks[t].find(r) != tracks[t].end() )
+				++iFound;
+	return iFound;
+}
+
+template<typename Track>
+static int DrawWindows( const vector<Track> &tracks )
+{
+	int iDrawn = 0;
+	for( int r = 0; r < NUM_ROWS; r += ROWS_PER_BEAT )
+	{
+		for( int t = 0; t < NUM_TRACKS; ++t )
+		{
+			typename Track::const_iterator it = tracks[t].lower_bound( r );
+			typename Track::const_iterator end = tracks[t].lower_bound( r + WINDOW_ROWS );
+			for( ; it != end; ++it )
+				iDrawn += it->second.type == TapNoteType_Tap;
+		}
+	}
+	return iDrawn;
+}
+
+template<typename Track>
+static int WalkAllTracks( const vector<Track> &tracks )
+{
+	vector<typename Track::const_iterator> cur, end;
+	for( int t = 0; t < NUM_TRACKS; ++t )
+	{
+		cur.push_back( tracks[t].begin() );
+		end.push_back( tracks[t].end() );
+	}
+
+	int iSum = 0;
+	for(;;)
+	{
+		int iBest = -1;
+		for( int t = 0; t < NUM_TRACKS; ++t )
+			if( cur[t] != end[t] && (iBest == -1 || cur[t]->first < cur[iBest]->first) )
+				iBest = t;
+		if( iBest == -1 )
+			break;
+		iSum += cur[iBest]->first & 0xFF;
+		++cur[iBest];
+	}
+	return iSum;
+}
+
+template<typename Track>
+static int RemoveEveryOther( vector<Track> &tracks )
+{
+	int iLeft = 0;
+	for( int t = 0; t < NUM_TRACKS; ++t )
+	{
+		bool bRemove = false;
+		for( typename Track::iterator it = tracks[t].begin(); it != tracks[t].end(); )
+		{
+			bRemove = !bRemove;
+			if( bRemove )
+				it = tracks[t].erase( it );
+			else
+				++it;
+		}
+		iLeft += tracks[t].size();
+	}
+	return iLeft;
+}
+
+struct Results
+{
+	int iFound, iDrawn, iWalked, iLeft;
+	float fFill, fLookups, fDraw, fWalk, fRemove;
+};
+
+template<typename Track>
+static Results Run()
+{
+	Results res;
+	vector<Track> tracks;
+	RageTimer timer;
+
+	Fill( tracks );
+	res.fFill = timer.GetDeltaTime();
+	res.iFound = Lookups( tracks );
+	res.fLookups = timer.GetDeltaTime();
+	res.iDrawn = DrawWindows( tracks );
+	res.fDraw = timer.GetDeltaTime();
+	res.iWalked = WalkAllTracks( tracks );
+	res.fWalk = timer.GetDeltaTime();
+	res.iLeft = RemoveEveryOther( tracks );
+	res.fRemove = timer.GetDeltaTime();
+	return res;
+}
+
+static void Report( const char *szName, const Results &res )
+{
+	LOG->Trace( "%-12s fill %.4f  lookup %.4f  draw %.4f  walk %.4f  remove %.4f",
+		szName, res.fFill, res.fLookups, res.fDraw, res.fWalk, res.fRemove );
+}
+
+/* A chart with one of everything GetPackedNoteData has to keep. */
+static void MakePackingChart( NoteData &nd )
+{
+	nd.SetNumTracks( NUM_TRACKS );
+	nd.SetTapNote( 0, 0, TAP_ORIGINAL_TAP );
+	nd.SetTapNote( 0, 7, TAP_ORIGINAL_MINE );
+	nd.SetTapNote( 1, ROWS_PER_BEAT, TAP_ORIGINAL_LIFT );
+	nd.SetTapNote( 1, ROWS_PER_BEAT*2, TAP_ORIGINAL_FAKE );
+	nd.SetTapNote( 2, ROWS_PER_BEAT*3, TAP_ADDITION_TAP );
+	nd.AddHoldNote( 3, 0, ROWS_PER_BEAT*4, TAP_ORIGINAL_HOLD_HEAD );
+	nd.AddHoldNote( 4, ROWS_PER_BEAT, ROWS_PER_BEAT*3, TAP_ORIGINAL_ROLL_HEAD );
+
+	TapNote tn = TAP_ORIGINAL_TAP;
+	tn.iKeysoundIndex = 300;
+	nd.SetTapNote( 5, ROWS_PER_BEAT*5, tn );
+
+	tn = TAP_ORIGINAL_AUTO_KEYSOUND;
+	tn.iKeysoundIndex = 0;
+	nd.SetTapNote( 6, ROWS_PER_BEAT*5, tn );
+
+	tn = TAP_ORIGINAL_ATTACK;
+	tn.sAttackModifiers = "2x, dark";
+	tn.fAttackDurationSeconds = 7.5f;
+	nd.SetTapNote( 7, ROWS_PER_BEAT*6, tn );
+
+	// Routine charts say whose note it is.
+	tn = TAP_ORIGINAL_TAP;
+	tn.pn = PLAYER_2;
+	nd.SetTapNote( 2, ROWS_PER_BEAT*8, tn );
+
+	tn = TAP_ORIGINAL_HOLD_HEAD;
+	tn.pn = PLAYER_1;
+	tn.iKeysoundIndex = 2;
+	nd.AddHoldNote( 5, ROWS_PER_BEAT*10, ROWS_PER_BEAT*11, tn );
+
+	// Far enough out for the row gap to take several bytes.
+	nd.SetTapNote( 0, NUM_ROWS, TAP_ORIGINAL_TAP );
+}
+
+static bool SameNotes( const NoteData &a, const NoteData &b )
+{
+	if( a.GetNumTracks() != b.GetNumTracks() )
+		return false;
+	for( int t = 0; t < a.GetNumTracks(); ++t )
+	{
+		NoteData::const_iterator ia = a.begin(t), ib = b.begin(t);
+		for( ; ia != a.end(t) && ib != b.end(t); ++ia, ++ib )
+			if( ia->first != ib->first || ia->second != ib->second )
+				return false;
+		if( ia != a.end(t) || ib != b.end(t) )
+			return false;
+	}
+	return true;
+}
+
+/* LoadFromPackedNoteData must give back exactly what GetPackedNoteData was
+ * given, and refuse damaged data without leaving anything behind. */
+static bool TestPackedNoteData()
+{
+	NoteData in;
+	MakePackingChart( in );
+
+	RString sPacked;
+	NoteDataUtil::GetPackedNoteData( in, sPacked );
+
+	NoteData out;
+	out.SetNumTracks( NUM_TRACKS );
+	if( !NoteDataUtil::LoadFromPackedNoteData(out, sPacked) || !SameNotes(in, out) )
+	{
+		LOG->Warn( "Packed notes didn't load back the same" );
+		return false;
+	}
+
+	RString sRepacked;
+	NoteDataUtil::GetPackedNoteData( out, sRepacked );
+	if( sRepacked != sPacked )
+	{
+		LOG->Warn( "Packing loaded notes gave different data" );
+		return false;
+	}
+
+	// Every way of cutting the data short has to be noticed.
+	for( size_t i = 0; i < sPacked.size(); ++i )
+	{
+		MakePackingChart( out );
+		if( NoteDataUtil::LoadFromPackedNoteData(out, sPacked.substr(0, i)) || !out.IsEmpty() )
+		{
+			LOG->Warn( "Packed notes cut to %i of %i bytes were accepted", (int) i, (int) sPacked.size() );
+			return false;
+		}
+	}
+
+	RString sBad = sPacked + '\0';
+	if( NoteDataUtil::LoadFromPackedNoteData(out, sBad) || !out.IsEmpty() )
+	{
+		LOG->Warn( "Packed notes with a byte left over were accepted" );
+		return false;
+	}
+
+	sBad = sPacked;
+	sBad[0] ^= 0x7F;
+	if( NoteDataUtil::LoadFromPackedNoteData(out, sBad) )
+	{
+		LOG->Warn( "Packed notes from another version were accepted" );
+		return false;
+	}
+
+	NoteData narrow;
+	narrow.SetNumTracks( NUM_TRACKS / 2 );
+	if( NoteDataUtil::LoadFromPackedNoteData(narrow, sPacked) )
+	{
+		LOG->Warn( "Packed notes were loaded into the wrong number of tracks" );
+		return false;
+	}
+
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	test_handle_args( argc, argv );
+	test_init();
+
+	if( !TestPackedNoteData() )
+	{
+		test_deinit();
+		exit( 1 );
+	}
+
+	Results map = Run< std::map<int,TapNote> >();
+	Results flat = Run<FlatTrackMap>();
+	Report( "map", map );
+	Report( "FlatTrackMap", flat );
+
+	if( map.iFound != flat.iFound || map.iDrawn != flat.iDrawn ||
+		map.iWalked != flat.iWalked || map.iLeft != flat.iLeft )
+	{
+		LOG->Warn( "Backends disagree: found %i/%i, drawn %i/%i, walked %i/%i, left %i/%i",
+			map.iFound, flat.iFound, map.iDrawn, flat.iDrawn,
+			map.iWalked, flat.iWalked, map.iLeft, flat.iLeft );
+		test_deinit();
+		exit( 1 );
+	}
+
+	test_deinit();
+	exit( 0 );
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
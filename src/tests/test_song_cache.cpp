@@ -0,0 +1,104 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "Song.h"
+#include "SongCacheBlob.h"
+#include "test_misc.h"
+
+/* Save a song into a SongCacheBlob and load it back the way
+ * Song::LoadFromSongDir does: into a song that only has its directory and
+ * group set.  What the record holds has to come back, and what it doesn't
+ * hold has to be left alone. */
+
+static const char *SONG_DIR = "/Songs/Test Group/Test Song/";
+static const char *GROUP_NAME = "Test Group";
+
+static bool TestLoadKeepsGroup()
+{
+	SongCacheBlob blob;
+
+	Song in;
+	in.SetSongDir( SONG_DIR );
+	in.m_sGroupName = GROUP_NAME;
+	in.m_sMainTitle = "Test Song";
+	in.m_sArtist = "Test Artist";
+	in.m_sMusicFile = "test.ogg";
+	blob.SaveSong( in );
+
+	Song out;
+	out.SetSongDir( SONG_DIR );
+	out.m_sGroupName = GROUP_NAME;
+	if( !blob.LoadSong(out) )
+	{
+		LOG->Warn( "The cached song didn't load" );
+		return false;
+	}
+
+	if( out.m_sGroupName != GROUP_NAME )
+	{
+		LOG->Warn( "Loading from the cache changed the group from \"%s\" to \"%s\"",
+			GROUP_NAME, out.m_sGroupName.c_str() );
+		return false;
+	}
+	if( out.GetSongDir() != SONG_DIR || out.WasLoadedFromProfile() )
+	{
+		LOG->Warn( "Loading from the cache changed where the song came from" );
+		return false;
+	}
+	if( out.m_sMainTitle != in.m_sMainTitle || out.m_sArtist != in.m_sArtist ||
+		out.m_sMusicFile != in.m_sMusicFile )
+	{
+		LOG->Warn( "The cached song didn't load back the same" );
+		return false;
+	}
+
+	// A song with no record must be left as it was.
+	Song other;
+	other.SetSongDir( "/Songs/Test Group/Other Song/" );
+	other.m_sGroupName = GROUP_NAME;
+	if( blob.LoadSong(other) || other.m_sGroupName != GROUP_NAME )
+	{
+		LOG->Warn( "A song with no cache record was changed" );
+		return false;
+	}
+
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	test_handle_args( argc, argv );
+	test_init();
+
+	const bool bPassed = TestLoadKeepsGroup();
+	if( bPassed )
+		LOG->Trace( "Songs load from the cache with their group" );
+
+	test_deinit();
+	exit( bPassed? 0:1 );
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
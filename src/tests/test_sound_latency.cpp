@@ -0,0 +1,111 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageSound.h"
+#include "RageUtil.h"
+#include "PrefsManager.h"
+#include "arch/Sound/RageSoundDriver_Null.h"
+#include "test_misc.h"
+
+/* Start short sounds on the Null driver, which plays to nowhere with the same
+ * buffering as a sound card, and compare the latency it reports with
+ * GetPlayLatency to the time it actually took each sound to be heard, with
+ * and without SoundLowLatency. */
+
+static const int NUM_SOUNDS = 50;
+static const int PLAY_USECS = 30000;
+
+/* Endless silence. */
+class SilentSound: public RageSoundBase
+{
+public:
+	SilentSound(): m_iStreamFrame(0) { }
+	void SoundIsFinishedPlaying() { }
+	int GetDataToPlay( float *pBuffer, int iFrames, int64_t &iStreamFrame, int &iFramesStored )
+	{
+		memset( pBuffer, 0, iFrames * 2 * sizeof(float) );
+		iStreamFrame = m_iStreamFrame;
+		iFramesStored = iFrames;
+		m_iStreamFrame += iFrames;
+		return iFrames;
+	}
+	void CommitPlayingPosition( int64_t iFrameno, int64_t iPosition, int iBytesRead ) { }
+	RString GetLoadedFilePath() const { return "silence"; }
+
+private:
+	int64_t m_iStreamFrame;
+};
+
+static bool Measure( bool bLowLatency )
+{
+	PREFSMAN->m_bSoundLowLatency.Set( bLowLatency );
+	RageSoundDriver_Null *pDriver = new RageSoundDriver_Null;
+
+	SilentSound sound;
+	for( int i = 0; i < NUM_SOUNDS; ++i )
+	{
+		pDriver->StartMixing( &sound );
+		for( int iSlept = 0; iSlept < PLAY_USECS; iSlept += 1000 )
+		{
+			pDriver->Update();
+			usleep( 1000 );
+		}
+		pDriver->StopMixing( &sound );
+		pDriver->Update();
+	}
+
+	RageSoundDriver::DecodeStats stats;
+	pDriver->GetDecodeStats( stats );
+	const float fReported = pDriver->GetPlayLatency();
+	delete pDriver;
+
+	LOG->Trace( "%-12s reported %.2fms, started %i: %.2fms average, %.2fms max, %i underruns",
+		bLowLatency? "low latency":"default", fReported * 1000, stats.iSoundsStarted,
+		stats.fAverageStartLatency * 1000, stats.fMaxStartLatency * 1000, stats.iUnderruns );
+
+	/* Sounds start on the next period mixed, so allow for a few of those. */
+	if( stats.iSoundsStarted != NUM_SOUNDS || fabsf(stats.fAverageStartLatency - fReported) > 0.005f )
+	{
+		LOG->Warn( "GetPlayLatency doesn't match the achieved latency" );
+		return false;
+	}
+	return true;
+}
+
+int main( int argc, char *argv[] )
+{
+	test_handle_args( argc, argv );
+	test_init();
+	PREFSMAN = new PrefsManager;
+
+	bool bOK = Measure( false );
+	bOK &= Measure( true );
+
+	delete PREFSMAN;
+	test_deinit();
+	exit( bOK? 0:1 );
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
@@ -0,0 +1,149 @@
+#include "global.h"
+#include "RageLog.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+#include "TimingData.h"
+#include "test_misc.h"
+
+/* Time TimingData's beat<->time conversions on a gimmick chart with thousands
+ * of BPM changes, stops, delays and warps: walking every segment from the
+ * start, the way TimingData did outside of gameplay, against the lookup
+ * tables, both on an unchanging chart and while segments are being edited
+ * between queries, like in the editor. */
+
+static const int NUM_BEATS = 4000;
+static const int NUM_QUERIES = 20000;
+static const int NUM_EDITS = 2000;
+
+static void MakeGimmickChart( TimingData &td )
+{
+	for( int b = 0; b < NUM_BEATS; ++b )
+	{
+		static const float fBPMs[] = { 120, 240, 60, 180, 90 };
+		td.AddSegment( BPMSegment(BeatToNoteRow((float) b), fBPMs[b % 5]) );
+		if( b % 2 == 1 )
+			td.AddSegment( StopSegment(BeatToNoteRow(b + 0.5f), 0.05f) );
+		if( b % 8 == 3 )
+			td.AddSegment( DelaySegment(BeatToNoteRow(b + 0.25f), 0.1f) );
+		if( b % 20 == 7 )
+			td.AddSegment( WarpSegment(BeatToNoteRow(b + 0.75f), 0.5f) );
+	}
+}
+
+/* What the lookups replace: start from the first segment every time. */
+static float WalkBeat( const TimingData &td, float fTime )
+{
+	TimingData::GetBeatStarts start;
+	start.last_time = -td.m_fBeat0OffsetInSeconds;
+	TimingData::GetBeatArgs args;
+	args.elapsed_time = fTime;
+	td.GetBeatInternal( start, args, INT_MAX );
+	return args.beat;
+}
+
+static float WalkTime( const TimingData &td, float fBeat )
+{
+	TimingData::GetBeatStarts start;
+	start.last_time = -td.m_fBeat0OffsetInSeconds;
+	return td.GetElapsedTimeInternal( start, fBeat, INT_MAX );
+}
+
+static int g_iMismatches = 0;
+static void Compare( const char *szWhat, float fIn, float fWalked, float fLookedUp )
+{
+	if( fabsf(fWalked - fLookedUp) < 0.001f )
+		return;
+	if( ++g_iMismatches <= 10 )
+		LOG->Warn( "%s(%f): walked %f, looked up %f", szWhat, fIn, fWalked, fLookedUp );
+}
+
+int main( int argc, char *argv[] )
+{
+	test_handle_args( argc, argv );
+	test_init();
+
+	TimingData td( 0.1f );
+	MakeGimmickChart( td );
+	const float fLastBeat = (float) NUM_BEATS;
+	const float fLastTime = WalkTime( td, fLastBeat );
+
+	vector<float> afWalked( NUM_QUERIES ), afLookedUp( NUM_QUERIES );
+	RageTimer timer;
+
+	for( int i = 0; i < NUM_QUERIES; ++i )
+		afWalked[i] = WalkBeat( td, fLastTime * i / NUM_QUERIES );
+	const float fWalkBeats = timer.GetDeltaTime();
+	for( int i = 0; i < NUM_QUERIES; ++i )
+		afLookedUp[i] = td.GetBeatFromElapsedTimeNoOffset( fLastTime * i / NUM_QUERIES );
+	const float fLookupBeats = timer.GetDeltaTime();
+	for( int i = 0; i < NUM_QUERIES; ++i )
+		Compare( "beat", fLastTime * i / NUM_QUERIES, afWalked[i], afLookedUp[i] );
+
+	timer.Touch();
+	for( int i = 0; i < NUM_QUERIES; ++i )
+		afWalked[i] = WalkTime( td, fLastBeat * i / NUM_QUERIES );
+	const float fWalkTimes = timer.GetDeltaTime();
+	for( int i = 0; i < NUM_QUERIES; ++i )
+		afLookedUp[i] = td.GetElapsedTimeFromBeatNoOffset( fLastBeat * i / NUM_QUERIES );
+	const float fLookupTimes = timer.GetDeltaTime();
+	for( int i = 0; i < NUM_QUERIES; ++i )
+		Compare( "time", fLastBeat * i / NUM_QUERIES, afWalked[i], afLookedUp[i] );
+
+	/* Change a BPM somewhere in the chart, then look at the time of a
+	 * beat near it, over and over. */
+	TimingData edited( td );
+	timer.Touch();
+	float fEditWalked = 0;
+	for( int i = 0; i < NUM_EDITS; ++i )
+	{
+		const int iBeat = (i * 7919) % NUM_BEATS;
+		edited.AddSegment( BPMSegment(BeatToNoteRow(iBeat + 0.5f), 100.0f + i % 50) );
+		fEditWalked += WalkTime( edited, iBeat + 1.0f );
+	}
+	const float fEditWalk = timer.GetDeltaTime();
+
+	TimingData edited2( td );
+	timer.Touch();
+	float fEditLookedUp = 0;
+	for( int i = 0; i < NUM_EDITS; ++i )
+	{
+		const int iBeat = (i * 7919) % NUM_BEATS;
+		edited2.AddSegment( BPMSegment(BeatToNoteRow(iBeat + 0.5f), 100.0f + i % 50) );
+		fEditLookedUp += edited2.GetElapsedTimeFromBeatNoOffset( iBeat + 1.0f );
+	}
+	const float fEditLookup = timer.GetDeltaTime();
+	Compare( "edited time sum", 0, fEditWalked / NUM_EDITS, fEditLookedUp / NUM_EDITS );
+
+	LOG->Trace( "%i queries on %i beats:", NUM_QUERIES, NUM_BEATS );
+	LOG->Trace( "  time->beat  walk %.4f  lookup %.4f", fWalkBeats, fLookupBeats );
+	LOG->Trace( "  beat->time  walk %.4f  lookup %.4f", fWalkTimes, fLookupTimes );
+	LOG->Trace( "  %i edits    walk %.4f  lookup %.4f", NUM_EDITS, fEditWalk, fEditLookup );
+
+	test_deinit();
+	exit( g_iMismatches? 1:0 );
+}
+
+/*
+ * (c) 2026 ITGmania team
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, and/or sell copies of the Software, and to permit persons to
+ * whom the Software is furnished to do so, provided that the above
+ * copyright notice(s) and this permission notice appear in all copies of
+ * the Software and that both the above copyright notice(s) and this
+ * permission notice appear in supporting documentation.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT OF
+ * THIRD PARTY RIGHTS. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR HOLDERS
+ * INCLUDED IN THIS NOTICE BE LIABLE FOR ANY CLAIM, OR ANY SPECIAL INDIRECT
+ * OR CONSEQUENTIAL DAMAGES, OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */